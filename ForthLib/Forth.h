@@ -387,6 +387,11 @@ typedef int(*streamStringInRoutine) (ForthCoreState* pCore, void *pData, ForthOb
 // stream line input routine type - returns number of chars gotten
 typedef int(*streamLineInRoutine) (ForthCoreState* pCore, void *pData, char *pBuff, int maxChars);
 
+// stream mapped input routine type - returns a pointer to the next numBytes bytes of a mapped stream
+//   and steps past them, numBytes is reduced to the number left if that is less.  Returns nullptr
+//   if the stream isn't mapped.
+typedef const char* (*streamMappedInRoutine) (ForthCoreState* pCore, void *pData, size_t& numBytes);
+
 // these routines allow code external to forth to redirect the forth output stream
 extern void GetForthConsoleOutStream( ForthCoreState* pCore, ForthObject& outObject );
 extern void CreateForthFileOutStream( ForthCoreState* pCore, ForthObject& outObject, FILE* pOutFile );
@@ -397,6 +402,18 @@ extern void ReleaseForthObject( ForthCoreState* pCore, ForthObject& inObject );
 extern void ForthConsoleCharOut( ForthCoreState* pCore, char ch );
 extern void ForthConsoleBytesOut( ForthCoreState* pCore, const char* pBuffer, int numChars );
 extern void ForthConsoleStringOut( ForthCoreState* pCore, const char* pBuffer );
+// write out buffered output for all streams with OUT_BUFFER_FLUSH_ON_YIELD the fiber has written to
+extern void ForthFlushPendingOutStreams( ForthCoreState* pCore );
+extern void ForthFlushOutStream( ForthCoreState* pCore, ForthObject& streamObject );
+
+// one of the pieces of output written by ForthStreamGatherOut
+struct ForthOutBlock
+{
+    const char*     pData;
+    int             numBytes;
+};
+// write a sequence of blocks to an output stream, local file streams get them with a single writev
+extern void ForthStreamGatherOut( ForthCoreState* pCore, ForthObject& streamObject, const ForthOutBlock* pBlocks, int numBlocks );
 
 // the bottom 24 bits of a forth opcode is a value field
 // the top 8 bits is the type field
@@ -756,7 +773,7 @@ typedef enum
 //   4          is field a pointer
 //   5          is field an array
 //   6          is this a method
-//   7          unused (except for class precedence ops)
+//   7          unused (except for class precedence ops and weak object fields)
 // 31...8       depends on base type:
 //      string      length
 //      struct      typeIndex
@@ -784,6 +801,8 @@ typedef enum
 #define CODE_IS_NATIVE( CODE )                              (((CODE) & 0xF) < kNumNativeTypes)
 #define CODE_IS_METHOD( CODE )                              (((CODE) & kDTIsMethod) != 0)
 #define CODE_IS_FUNKY( CODE )                               (((CODE) & kDTIsFunky) != 0)
+// object fields declared with 'weak' have the funky bit set, they hold no refcount on their object
+#define CODE_IS_WEAK_OBJECT( CODE )                         (((CODE) & (kDTIsFunky | kDTIsPtr | 0x0F)) == (kDTIsFunky | kBaseTypeObject))
 #define CODE_TO_BASE_TYPE( CODE )                           ((CODE) & 0x0F)
 #define CODE_TO_STRUCT_INDEX( CODE )                        ((CODE) >> 8)
 #define CODE_TO_CONTAINED_CLASS_INDEX( CODE )               (((CODE) >> 8) & 0xFFFF)
@@ -0,0 +1,718 @@
+//////////////////////////////////////////////////////////////////////
+//
+// ForthBinarySerializer.cpp: implementation of the binary object graph writer and reader.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "pch.h"
+#include <stdexcept>
+#include "ForthBinarySerializer.h"
+#include "ForthMemoryManager.h"
+
+// marks the byte order of the machine which wrote a file
+#define BINARY_OBJECTS_BYTE_ORDER_MARK  0xFEFF
+// pending output blocks are written when there are this many
+#define BINARY_OBJECTS_MAX_PENDING_BLOCKS   32
+// largest block handed to ForthStreamGatherOut, which takes int sizes
+#define BINARY_OBJECTS_MAX_BLOCK_BYTES  0x40000000
+
+namespace
+{
+    // returns the size of the Object header which starts every object
+    inline int objectHeaderSize()
+    {
+        return ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIObject)->GetSize();
+    }
+
+    // returns the builtin class in pVocab's ancestry which has no binary serializer, or the class
+    //   which has one if it isn't pVocab itself, or nullptr if objects of pVocab can be serialized
+    ForthClassVocabulary* findUnserializableClass(ForthClassVocabulary* pVocab)
+    {
+        for (ForthClassVocabulary* pClass = pVocab; pClass != nullptr; pClass = pClass->ParentClass())
+        {
+            if (pClass->GetCustomBinaryWriter() != nullptr)
+            {
+                // builtin serializers don't know about fields added by derived classes
+                return (pClass == pVocab) ? nullptr : pClass;
+            }
+            long typeIndex = pClass->GetTypeIndex();
+            if ((typeIndex < kNumBuiltinClasses) && (typeIndex != kBCIObject))
+            {
+                return pClass;
+            }
+        }
+        return nullptr;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     ForthBinaryWriter
+//
+
+ForthBinaryWriter::ForthBinaryWriter()
+: mOutStream(nullptr)
+, mpCore(nullptr)
+, mBufferFlushed(0)
+, mOffset(0)
+{
+}
+
+ForthBinaryWriter::~ForthBinaryWriter()
+{
+}
+
+bool ForthBinaryWriter::WriteObjects(ForthObject& root, ForthObject& outStream, ForthCoreState* pCore)
+{
+    mOutStream = outStream;
+    mpCore = pCore;
+    mObjects.clear();
+    mObjectIds.clear();
+    mClasses.clear();
+    mClassIndices.clear();
+    // the buffer never grows, so blocks which point into it stay valid until it is flushed
+    mBuffer.clear();
+    mBuffer.reserve(BINARY_OBJECTS_BUFFER_SIZE);
+    mBufferFlushed = 0;
+    mBlocks.clear();
+    mOffset = 0;
+    mError.clear();
+
+    bool itWorked = true;
+    try
+    {
+        if (outStream == nullptr)
+        {
+            throwError("null output stream");
+        }
+
+        // find every object reachable from root, object ids are positions in mObjects plus 1
+        if (root != nullptr)
+        {
+            collectObject(root, this);
+        }
+        std::vector<uint32_t> objectClasses;
+        objectClasses.reserve(mObjects.size());
+        for (size_t i = 0; i < mObjects.size(); i++)
+        {
+            ForthClassVocabulary* pVocab = getClass(mObjects[i]);
+            objectClasses.push_back(mClassIndices[pVocab]);
+            // objects only reachable through weak fields aren't written
+            ForthVisitObjectChildren(mObjects[i], collectObject, this);
+        }
+
+        ForthBinaryHeader header;
+        header.magic = BINARY_OBJECTS_MAGIC;
+        header.version = BINARY_OBJECTS_VERSION;
+        header.bytesPerCell = (uint16_t) sizeof(cell);
+        header.byteOrderMark = BINARY_OBJECTS_BYTE_ORDER_MARK;
+        header.numClasses = (uint32_t) mClasses.size();
+        header.numObjects = (uint32_t) mObjects.size();
+        header.rootId = (root == nullptr) ? 0 : 1;
+        WriteBytes(&header, sizeof(header));
+
+        for (ForthClassVocabulary* pVocab : mClasses)
+        {
+            const char* pName = pVocab->GetName();
+            WriteString(pName, strlen(pName));
+            // lets the reader reject a class whose fields changed since the file was written
+            WriteU32((uint32_t) pVocab->GetSize());
+        }
+        if (!objectClasses.empty())
+        {
+            WriteBytes(&(objectClasses[0]), objectClasses.size() * sizeof(uint32_t));
+        }
+
+        for (ForthObject& obj : mObjects)
+        {
+            writeBody(obj);
+        }
+        flush();
+    }
+    catch (const std::exception& ex)
+    {
+        mError.assign(ex.what());
+        itWorked = false;
+    }
+
+    mBlocks.clear();
+    return itWorked;
+}
+
+void ForthBinaryWriter::collectObject(ForthObject& obj, void* pUserData)
+{
+    ForthBinaryWriter* pWriter = (ForthBinaryWriter *) pUserData;
+    if (pWriter->mObjectIds.find(obj) == pWriter->mObjectIds.end())
+    {
+        pWriter->mObjects.push_back(obj);
+        pWriter->mObjectIds[obj] = (uint32_t) pWriter->mObjects.size();
+    }
+}
+
+void ForthBinaryWriter::writeChildRef(ForthObject& obj, void* pUserData)
+{
+    ((ForthBinaryWriter *) pUserData)->WriteObjectRef(obj);
+}
+
+void ForthBinaryWriter::writeWeakChildRef(ForthObject& obj, void* pUserData)
+{
+    ((ForthBinaryWriter *) pUserData)->WriteObjectRef(obj, true);
+}
+
+ForthClassVocabulary* ForthBinaryWriter::getClass(ForthObject& obj)
+{
+    ForthClassObject* pClassObject = GET_CLASS_OBJECT(obj);
+    ForthClassVocabulary* pVocab = pClassObject->pVocab;
+    if (mClassIndices.find(pVocab) == mClassIndices.end())
+    {
+        ForthClassVocabulary* pBadClass = findUnserializableClass(pVocab);
+        if (pBadClass != nullptr)
+        {
+            std::string message("no binary format for class ");
+            message.append(pVocab->GetName());
+            if (pBadClass != pVocab)
+            {
+                message.append(" derived from ").append(pBadClass->GetName());
+            }
+            throwError(message.c_str());
+        }
+        mClassIndices[pVocab] = (uint32_t) mClasses.size();
+        mClasses.push_back(pVocab);
+    }
+    return pVocab;
+}
+
+void ForthBinaryWriter::writeBody(ForthObject& obj)
+{
+    ForthClassObject* pClassObject = GET_CLASS_OBJECT(obj);
+    ForthClassVocabulary* pVocab = pClassObject->pVocab;
+    CustomBinaryWriter customWriter = pVocab->GetCustomBinaryWriter();
+    if (customWriter != nullptr)
+    {
+        customWriter(obj, this);
+    }
+    else
+    {
+        // the object refs are written after the raw bytes, the reader replaces the stale pointers
+        //   in the raw bytes with them in the same order
+        int headerSize = objectHeaderSize();
+        WriteBytes(((const char *) obj) + headerSize, pVocab->GetSize() - headerSize);
+        ForthVisitObjectChildren(obj, writeChildRef, this, writeWeakChildRef);
+    }
+}
+
+void ForthBinaryWriter::WriteBytes(const void* pSrc, size_t numBytes)
+{
+    if ((mBuffer.size() + numBytes) > mBuffer.capacity())
+    {
+        flush();
+        if (numBytes > mBuffer.capacity())
+        {
+            // too big for the buffer, write it without copying, it only needs to last until the flush
+            addBlocks((const char *) pSrc, numBytes);
+            flush();
+            return;
+        }
+    }
+    const char* pBytes = (const char *) pSrc;
+    mBuffer.insert(mBuffer.end(), pBytes, pBytes + numBytes);
+    mOffset += numBytes;
+}
+
+void ForthBinaryWriter::WriteU32(uint32_t val)
+{
+    WriteBytes(&val, sizeof(val));
+}
+
+void ForthBinaryWriter::WriteU64(uint64_t val)
+{
+    WriteBytes(&val, sizeof(val));
+}
+
+void ForthBinaryWriter::WriteString(const char* pChars, size_t numChars)
+{
+    WriteU32((uint32_t) numChars);
+    WriteBytes(pChars, numChars);
+}
+
+void ForthBinaryWriter::WritePayload(const void* pSrc, size_t numBytes)
+{
+    static const char zeroes[BINARY_OBJECTS_PAYLOAD_ALIGN] = { 0 };
+    size_t padding = (size_t)((BINARY_OBJECTS_PAYLOAD_ALIGN - (mOffset & (BINARY_OBJECTS_PAYLOAD_ALIGN - 1))) & (BINARY_OBJECTS_PAYLOAD_ALIGN - 1));
+    WriteBytes(zeroes, padding);
+    if (numBytes == 0)
+    {
+        return;
+    }
+
+    // payload goes out as its own blocks, after whatever is in the buffer
+    addBufferBlock();
+    addBlocks((const char *) pSrc, numBytes);
+    if (mBlocks.size() >= BINARY_OBJECTS_MAX_PENDING_BLOCKS)
+    {
+        flush();
+    }
+}
+
+void ForthBinaryWriter::WriteObjectRef(const ForthObject& obj, bool isWeak)
+{
+    uint32_t id = 0;
+    if (obj != nullptr)
+    {
+        std::unordered_map<ForthObject, uint32_t>::const_iterator iter = mObjectIds.find(obj);
+        if (iter != mObjectIds.end())
+        {
+            id = iter->second;
+        }
+        else if (!isWeak)
+        {
+            // only happens if a class writes references its child visitor doesn't visit
+            throwError("reference to object which wasn't visited");
+        }
+    }
+    WriteU32(id);
+}
+
+void ForthBinaryWriter::WriteStructObjectRefs(ForthStructVocabulary* pVocab, const char* pData)
+{
+    for (ForthStructVocabulary* pStruct = pVocab; pStruct != nullptr; pStruct = pStruct->BaseVocabulary())
+    {
+        pStruct->VisitObjectFields((void *) pData, writeChildRef, this, writeWeakChildRef);
+    }
+}
+
+void ForthBinaryWriter::addBufferBlock()
+{
+    if (mBuffer.size() > mBufferFlushed)
+    {
+        ForthOutBlock block;
+        block.pData = &(mBuffer[mBufferFlushed]);
+        block.numBytes = (int)(mBuffer.size() - mBufferFlushed);
+        mBlocks.push_back(block);
+        mBufferFlushed = mBuffer.size();
+    }
+}
+
+void ForthBinaryWriter::addBlocks(const char* pBytes, size_t numBytes)
+{
+    while (numBytes > 0)
+    {
+        size_t blockBytes = (numBytes > BINARY_OBJECTS_MAX_BLOCK_BYTES) ? BINARY_OBJECTS_MAX_BLOCK_BYTES : numBytes;
+        ForthOutBlock block;
+        block.pData = pBytes;
+        block.numBytes = (int) blockBytes;
+        mBlocks.push_back(block);
+        pBytes += blockBytes;
+        numBytes -= blockBytes;
+        mOffset += blockBytes;
+    }
+}
+
+void ForthBinaryWriter::flush()
+{
+    addBufferBlock();
+    if (!mBlocks.empty())
+    {
+        ForthStreamGatherOut(mpCore, mOutStream, &(mBlocks[0]), (int) mBlocks.size());
+        mBlocks.clear();
+    }
+    mBuffer.clear();
+    mBufferFlushed = 0;
+}
+
+void ForthBinaryWriter::throwError(const char* message)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s at object %d", message, (int) mObjects.size());
+    throw std::runtime_error(buffer);
+}
+
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     ForthBinaryReader
+//
+
+ForthBinaryReader::ForthBinaryReader()
+: mpCore(nullptr)
+, mpMappedData(nullptr)
+, mMappedSize(0)
+, mpInStream(nullptr)
+, mBufferPos(0)
+, mBufferLimit(0)
+, mOffset(0)
+{
+    mpEngine = ForthEngine::GetInstance();
+}
+
+ForthBinaryReader::~ForthBinaryReader()
+{
+}
+
+bool ForthBinaryReader::ReadObjects(ForthObject& inStream, ForthObject& root, ForthCoreState* pCore)
+{
+    mpCore = pCore;
+    mpInStream = reinterpret_cast<oInStreamStruct *>(inStream);
+    mpMappedData = nullptr;
+    mMappedSize = 0;
+    mError.clear();
+    if ((mpInStream == nullptr) || (mpInStream->pInFuncs == nullptr) || (mpInStream->pInFuncs->inBytes == nullptr))
+    {
+        mError.assign("unusable input stream");
+        return false;
+    }
+    mBuffer.resize(BINARY_OBJECTS_BUFFER_SIZE);
+    return readAll(root);
+}
+
+bool ForthBinaryReader::LoadObjects(const char* pPath, ForthObject& root, ForthCoreState* pCore)
+{
+    mpCore = pCore;
+    mpInStream = nullptr;
+    mError.clear();
+    FILE* pFile = fopen(pPath, "rb");
+    if (pFile == nullptr)
+    {
+        mError.assign("failed to open ").append(pPath);
+        return false;
+    }
+    ForthMappedFile mappedFile;
+    bool isMapped = mappedFile.Map(pFile);
+    fclose(pFile);
+    if (!isMapped)
+    {
+        mError.assign("failed to map ").append(pPath);
+        return false;
+    }
+    mpMappedData = mappedFile.Data();
+    mMappedSize = mappedFile.Size();
+    bool itWorked = readAll(root);
+    mpMappedData = nullptr;
+    mMappedSize = 0;
+    return itWorked;
+}
+
+bool ForthBinaryReader::readAll(ForthObject& root)
+{
+    mObjects.clear();
+    mBufferPos = 0;
+    mBufferLimit = 0;
+    mOffset = 0;
+    root = nullptr;
+
+    bool itWorked = true;
+    try
+    {
+        ForthBinaryHeader header;
+        ReadBytes(&header, sizeof(header));
+        if (header.magic != BINARY_OBJECTS_MAGIC)
+        {
+            throwError("not a binary object file");
+        }
+        if (header.version != BINARY_OBJECTS_VERSION)
+        {
+            throwError("unsupported binary object file version");
+        }
+        if ((header.bytesPerCell != sizeof(cell)) || (header.byteOrderMark != BINARY_OBJECTS_BYTE_ORDER_MARK))
+        {
+            throwError("binary object file was written by an incompatible build");
+        }
+        if (header.rootId > header.numObjects)
+        {
+            throwError("bad root object id");
+        }
+
+        // each class entry is at least its name length and instance size
+        CheckCount(header.numClasses, 2 * sizeof(uint32_t));
+        std::vector<ForthClassVocabulary*> classes;
+        std::string className;
+        for (uint32_t i = 0; i < header.numClasses; i++)
+        {
+            ReadString(className);
+            uint32_t instanceSize = ReadU32();
+            ForthStructVocabulary* pVocab = ForthTypesManager::GetInstance()->GetStructVocabulary(className.c_str());
+            if ((pVocab == nullptr) || !pVocab->IsClass())
+            {
+                throwError(std::string("unknown class ").append(className).c_str());
+            }
+            ForthClassVocabulary* pClassVocab = (ForthClassVocabulary *) pVocab;
+            if (findUnserializableClass(pClassVocab) != nullptr)
+            {
+                throwError(std::string("no binary format for class ").append(className).c_str());
+            }
+            if (instanceSize != (uint32_t) pClassVocab->GetSize())
+            {
+                throwError(std::string("instance size of class ").append(className).append(" has changed").c_str());
+            }
+            classes.push_back(pClassVocab);
+        }
+
+        // all objects are created before any are read, so references never need fixing up
+        CheckCount(header.numObjects, sizeof(uint32_t));
+        std::vector<uint32_t> objectClasses(header.numObjects);
+        if (header.numObjects != 0)
+        {
+            ReadBytes(&(objectClasses[0]), header.numObjects * sizeof(uint32_t));
+        }
+        for (uint32_t classIndex : objectClasses)
+        {
+            if (classIndex >= classes.size())
+            {
+                throwError("bad class index");
+            }
+            mObjects.push_back(createObject(classes[classIndex]));
+        }
+
+        for (uint32_t i = 0; i < header.numObjects; i++)
+        {
+            readBody(mObjects[i], classes[objectClasses[i]]);
+        }
+
+        if (header.rootId != 0)
+        {
+            root = mObjects[header.rootId - 1];
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        mError.assign(ex.what());
+        itWorked = false;
+        releaseObjects();
+    }
+
+    return itWorked;
+}
+
+void ForthBinaryReader::releaseObjects()
+{
+    // bodies which weren't completely read can hold stale pointers, and the objects reference
+    //   each other in ways their refcounts don't reflect yet, so every reference between them
+    //   is dropped before each object is deleted on its own
+    for (ForthObject& obj : mObjects)
+    {
+        ForthVisitObjectChildren(obj, clearChildRef, nullptr, clearChildRef);
+    }
+    for (ForthObject& obj : mObjects)
+    {
+        obj->refCount = 0;
+        ReleaseDeadObject(mpCore, obj);
+    }
+    mObjects.clear();
+}
+
+ForthObject ForthBinaryReader::createObject(ForthClassVocabulary* pVocab)
+{
+    ForthCoreState* pCore = mpCore;
+    SPUSH((cell) pVocab);
+    mpEngine->FullyExecuteOp(pCore, pVocab->GetClassObject()->newOp);
+    ForthObject newObject;
+    POP_OBJECT(newObject);
+    if (pVocab->GetCustomBinaryReader() == nullptr)
+    {
+        // the whole body is about to be overwritten, so init isn't run, since anything it
+        //   allocated would be leaked.  Until the body is read, its object fields are null
+        int headerSize = objectHeaderSize();
+        memset(((char *) newObject) + headerSize, 0, pVocab->GetSize() - headerSize);
+    }
+    else
+    {
+        forthop initOpcode = pVocab->GetInitOpcode();
+        if (initOpcode != 0)
+        {
+            PUSH_OBJECT(newObject);
+            mpEngine->FullyExecuteOp(pCore, initOpcode);
+        }
+    }
+    return newObject;
+}
+
+void ForthBinaryReader::readBody(ForthObject& obj, ForthClassVocabulary* pVocab)
+{
+    CustomBinaryReader customReader = pVocab->GetCustomBinaryReader();
+    if (customReader != nullptr)
+    {
+        customReader(obj, this);
+    }
+    else
+    {
+        // object fields which were non-null when written now hold stale pointers, they are
+        //   visited in the same order they were written in and replaced
+        int headerSize = objectHeaderSize();
+        ReadBytes(((char *) obj) + headerSize, pVocab->GetSize() - headerSize);
+        ForthVisitObjectChildren(obj, readChildRef, this, readWeakChildRef);
+    }
+}
+
+void ForthBinaryReader::readChildRef(ForthObject& obj, void* pUserData)
+{
+    ((ForthBinaryReader *) pUserData)->ReadObjectRef(obj);
+}
+
+void ForthBinaryReader::readWeakChildRef(ForthObject& obj, void* pUserData)
+{
+    ((ForthBinaryReader *) pUserData)->ReadObjectRef(obj, true);
+}
+
+void ForthBinaryReader::clearChildRef(ForthObject& obj, void* pUserData)
+{
+    obj = nullptr;
+}
+
+void ForthBinaryReader::ReadBytes(void* pDst, size_t numBytes)
+{
+    char* pBytes = (char *) pDst;
+    if (mpInStream == nullptr)
+    {
+        if ((mMappedSize - mOffset) < numBytes)
+        {
+            throwError("unexpected end of input");
+        }
+        memcpy(pBytes, mpMappedData + mOffset, numBytes);
+        mOffset += numBytes;
+        return;
+    }
+
+    mOffset += numBytes;
+    while (numBytes > 0)
+    {
+        size_t available = mBufferLimit - mBufferPos;
+        if (available == 0)
+        {
+            if (numBytes >= mBuffer.size())
+            {
+                // big reads go straight to their destination
+                int numRead = mpInStream->pInFuncs->inBytes(mpCore, mpInStream, pBytes, (int)((numBytes > BINARY_OBJECTS_MAX_BLOCK_BYTES) ? BINARY_OBJECTS_MAX_BLOCK_BYTES : numBytes));
+                if (numRead <= 0)
+                {
+                    throwError("unexpected end of input");
+                }
+                pBytes += numRead;
+                numBytes -= numRead;
+                continue;
+            }
+            int numRead = mpInStream->pInFuncs->inBytes(mpCore, mpInStream, &(mBuffer[0]), (int) mBuffer.size());
+            if (numRead <= 0)
+            {
+                throwError("unexpected end of input");
+            }
+            mBufferPos = 0;
+            mBufferLimit = numRead;
+            available = numRead;
+        }
+        size_t numToCopy = (available < numBytes) ? available : numBytes;
+        memcpy(pBytes, &(mBuffer[mBufferPos]), numToCopy);
+        mBufferPos += numToCopy;
+        pBytes += numToCopy;
+        numBytes -= numToCopy;
+    }
+}
+
+uint32_t ForthBinaryReader::ReadU32()
+{
+    uint32_t val;
+    ReadBytes(&val, sizeof(val));
+    return val;
+}
+
+uint64_t ForthBinaryReader::ReadU64()
+{
+    uint64_t val;
+    ReadBytes(&val, sizeof(val));
+    return val;
+}
+
+void ForthBinaryReader::ReadString(std::string& str)
+{
+    uint32_t numChars = ReadU32();
+    CheckCount(numChars, 1);
+    str.resize(numChars);
+    if (numChars != 0)
+    {
+        ReadBytes(&(str[0]), numChars);
+    }
+}
+
+void ForthBinaryReader::ReadPayload(void* pDst, size_t numBytes)
+{
+    char padding[BINARY_OBJECTS_PAYLOAD_ALIGN];
+    size_t numPadding = (size_t)((BINARY_OBJECTS_PAYLOAD_ALIGN - (mOffset & (BINARY_OBJECTS_PAYLOAD_ALIGN - 1))) & (BINARY_OBJECTS_PAYLOAD_ALIGN - 1));
+    ReadBytes(padding, numPadding);
+    ReadBytes(pDst, numBytes);
+}
+
+void ForthBinaryReader::CheckCount(uint64_t count, size_t bytesPerItem)
+{
+    if ((bytesPerItem != 0) && (count > (UINT64_MAX / bytesPerItem)))
+    {
+        throwError("count is too big");
+    }
+    uint64_t numBytes = count * bytesPerItem;
+    bool haveBytes = (mpInStream == nullptr) ? (numBytes <= (mMappedSize - mOffset)) : bufferAhead(numBytes);
+    if (!haveBytes)
+    {
+        throwError("count is bigger than the rest of the input");
+    }
+}
+
+// the size of stream input isn't known, so the bytes are read ahead, and the buffer only
+//   grows as far as the input actually goes
+bool ForthBinaryReader::bufferAhead(uint64_t numBytes)
+{
+    size_t available = mBufferLimit - mBufferPos;
+    if (available >= numBytes)
+    {
+        return true;
+    }
+    if (mBufferPos != 0)
+    {
+        memmove(&(mBuffer[0]), &(mBuffer[mBufferPos]), available);
+        mBufferPos = 0;
+        mBufferLimit = available;
+    }
+    while (mBufferLimit < numBytes)
+    {
+        if (mBufferLimit == mBuffer.size())
+        {
+            uint64_t newSize = (uint64_t) mBuffer.size() * 2;
+            mBuffer.resize((size_t)((newSize < numBytes) ? newSize : numBytes));
+        }
+        size_t room = mBuffer.size() - mBufferLimit;
+        int numRead = mpInStream->pInFuncs->inBytes(mpCore, mpInStream, &(mBuffer[mBufferLimit]), (int)((room > BINARY_OBJECTS_MAX_BLOCK_BYTES) ? BINARY_OBJECTS_MAX_BLOCK_BYTES : room));
+        if (numRead <= 0)
+        {
+            return false;
+        }
+        mBufferLimit += numRead;
+    }
+    return true;
+}
+
+void ForthBinaryReader::ReadObjectRef(ForthObject& dst, bool isWeak)
+{
+    uint32_t id = ReadU32();
+    if (id > mObjects.size())
+    {
+        throwError("bad object id");
+    }
+    dst = (id == 0) ? nullptr : mObjects[id - 1];
+    if ((dst != nullptr) && !isWeak)
+    {
+        INCREMENT_REFCOUNT(dst);
+    }
+}
+
+void ForthBinaryReader::ReadStructObjectRefs(ForthStructVocabulary* pVocab, char* pData)
+{
+    for (ForthStructVocabulary* pStruct = pVocab; pStruct != nullptr; pStruct = pStruct->BaseVocabulary())
+    {
+        pStruct->VisitObjectFields(pData, readChildRef, this, readWeakChildRef);
+    }
+}
+
+void ForthBinaryReader::throwError(const char* message)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s at offset %llu", message, (unsigned long long) mOffset);
+    throw std::runtime_error(buffer);
+}
@@ -0,0 +1,153 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// ForthBinarySerializer.h: interfaces for the binary object graph writer and reader.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "ForthEngine.h"
+#include "ForthBuiltinClasses.h"
+
+class ForthStructVocabulary;
+class ForthMappedFile;
+
+// A binary object file is:
+//   header         - ForthBinaryHeader
+//   classes        - numClasses of (u32 length, name chars, u32 instance size)
+//   object classes - numObjects u32 class indices
+//   object bodies  - numObjects bodies, in object id order
+// Object ids start at 1, a reference to object id 0 is a null reference.
+// User-defined class bodies are the raw object bytes after the Object header, followed
+//   by the ids of the non-null objects the object references, in the order
+//   ForthVisitObjectChildren visits them.  Weak fields are written as the id of the object
+//   if it is in the file, or as 0.  Builtin classes write their own bodies.
+// Numbers and raw blocks are in host byte order, which is little-endian on every supported
+//   platform.  Payloads, like numeric array elements, start at 8 byte aligned file offsets,
+//   so a mapped file could be used in place.
+#define BINARY_OBJECTS_MAGIC            0x4a424f46      // "FOBJ"
+#define BINARY_OBJECTS_VERSION          2
+#define BINARY_OBJECTS_PAYLOAD_ALIGN    8
+// input is read and output is gathered in blocks of about this size
+#define BINARY_OBJECTS_BUFFER_SIZE      65536
+
+struct ForthBinaryHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    // files are only readable by builds with the same cell size and byte order
+    uint16_t    bytesPerCell;
+    uint16_t    byteOrderMark;
+    uint32_t    numClasses;
+    uint32_t    numObjects;
+    uint32_t    rootId;
+};
+
+class ForthBinaryWriter
+{
+public:
+    ForthBinaryWriter();
+    ~ForthBinaryWriter();
+
+    // writes root and every object reachable from it, returns true if there were no errors
+    bool WriteObjects(ForthObject& root, ForthObject& outStream, ForthCoreState* pCore);
+    const std::string& GetError() const { return mError; }
+
+    void WriteBytes(const void* pSrc, size_t numBytes);
+    void WriteU32(uint32_t val);
+    void WriteU64(uint64_t val);
+    void WriteString(const char* pChars, size_t numChars);
+    // pSrc is written without being copied, it must not change until WriteObjects returns
+    void WritePayload(const void* pSrc, size_t numBytes);
+    // a weak reference to an object which isn't being written is written as null
+    void WriteObjectRef(const ForthObject& obj, bool isWeak = false);
+    // writes the ids of objects referenced by the object fields of a struct
+    void WriteStructObjectRefs(ForthStructVocabulary* pVocab, const char* pData);
+    void throwError(const char* message);
+    ForthCoreState* GetCoreState() { return mpCore; }
+
+private:
+    static void collectObject(ForthObject& obj, void* pUserData);
+    static void writeChildRef(ForthObject& obj, void* pUserData);
+    static void writeWeakChildRef(ForthObject& obj, void* pUserData);
+    ForthClassVocabulary* getClass(ForthObject& obj);
+    void writeBody(ForthObject& obj);
+    // adds the part of mBuffer which isn't in mBlocks yet to mBlocks
+    void addBufferBlock();
+    // adds blocks which write pBytes directly
+    void addBlocks(const char* pBytes, size_t numBytes);
+    void flush();
+
+    ForthObject mOutStream;
+    ForthCoreState* mpCore;
+    std::vector<ForthObject> mObjects;
+    std::unordered_map<ForthObject, uint32_t> mObjectIds;
+    std::vector<ForthClassVocabulary*> mClasses;
+    std::unordered_map<ForthClassVocabulary*, uint32_t> mClassIndices;
+
+    // output not yet written is a list of blocks, which are either in mBuffer or are payloads
+    std::vector<char> mBuffer;
+    size_t mBufferFlushed;
+    std::vector<ForthOutBlock> mBlocks;
+    uint64_t mOffset;
+
+    std::string mError;
+};
+
+class ForthBinaryReader
+{
+public:
+    ForthBinaryReader();
+    ~ForthBinaryReader();
+
+    // returns true if there were no errors, root is a new object with no references
+    bool ReadObjects(ForthObject& inStream, ForthObject& root, ForthCoreState* pCore);
+    // maps file pPath and reads from it
+    bool LoadObjects(const char* pPath, ForthObject& root, ForthCoreState* pCore);
+    const std::string& GetError() const { return mError; }
+
+    void ReadBytes(void* pDst, size_t numBytes);
+    uint32_t ReadU32();
+    uint64_t ReadU64();
+    void ReadString(std::string& str);
+    void ReadPayload(void* pDst, size_t numBytes);
+    // throws unless the rest of the input holds count items of bytesPerItem bytes, counts are
+    //   checked before anything is allocated for them, so a damaged file can't exhaust memory
+    void CheckCount(uint64_t count, size_t bytesPerItem);
+    // sets dst to the object whose id is next in the input, adding a reference to it unless isWeak
+    void ReadObjectRef(ForthObject& dst, bool isWeak = false);
+    // replaces the object fields of a struct which were read as raw bytes, counterpart of
+    //   ForthBinaryWriter::WriteStructObjectRefs
+    void ReadStructObjectRefs(ForthStructVocabulary* pVocab, char* pData);
+    void throwError(const char* message);
+    ForthCoreState* GetCoreState() { return mpCore; }
+
+private:
+    static void readChildRef(ForthObject& obj, void* pUserData);
+    static void readWeakChildRef(ForthObject& obj, void* pUserData);
+    static void clearChildRef(ForthObject& obj, void* pUserData);
+    bool readAll(ForthObject& root);
+    ForthObject createObject(ForthClassVocabulary* pVocab);
+    void readBody(ForthObject& obj, ForthClassVocabulary* pVocab);
+    // deletes every object created so far, used when the input can't be read
+    void releaseObjects();
+    // reads stream input into mBuffer until numBytes are buffered, returns false at end of input
+    bool bufferAhead(uint64_t numBytes);
+
+    ForthCoreState* mpCore;
+    ForthEngine* mpEngine;
+    std::vector<ForthObject> mObjects;
+
+    // input is either a mapped file or a stream read through mBuffer
+    const char* mpMappedData;
+    size_t mMappedSize;
+    oInStreamStruct* mpInStream;
+    std::vector<char> mBuffer;
+    size_t mBufferPos;
+    size_t mBufferLimit;
+    uint64_t mOffset;
+
+    std::string mError;
+};
@@ -5,8 +5,16 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "pch.h"
+
+#if defined(WINDOWS_BUILD)
+#include <process.h>
+#else
+#include <sys/types.h>
+#endif
+
 #include "ForthBlockFileManager.h"
 #include "ForthEngine.h"
+#include "ForthMemoryManager.h"
 
 // TODO:
 // \
@@ -32,7 +40,26 @@
 // 
 
 #define INVALID_BLOCK_NUMBER ((unsigned int) ~0)
-// INVALID_BLOCK_NUMBER is also used to indicate 'no current buffer'
+// INVALID_BLOCK_NUMBER is also used to indicate 'no current buffer' and as the end of the LRU list
+
+// block files can be bigger than a long can address, so file positions are 64 bits
+static bool seekBlockFile( FILE* pFile, uint64_t offset, int whence )
+{
+#if defined(WINDOWS_BUILD)
+    return _fseeki64( pFile, (__int64)offset, whence ) == 0;
+#else
+    return fseeko( pFile, (off_t)offset, whence ) == 0;
+#endif
+}
+
+static uint64_t tellBlockFile( FILE* pFile )
+{
+#if defined(WINDOWS_BUILD)
+    return (uint64_t)_ftelli64( pFile );
+#else
+    return (uint64_t)ftello( pFile );
+#endif
+}
 
 
 ForthBlockFileManager::ForthBlockFileManager( const char* pBlockFilename , ucell numBuffers, ucell bytesPerBlock )
@@ -40,6 +67,14 @@ ForthBlockFileManager::ForthBlockFileManager( const char* pBlockFilename , ucell
 ,   mBytesPerBlock(bytesPerBlock)
 ,   mCurrentBuffer( INVALID_BLOCK_NUMBER )
 ,   mNumBlocksInFile( 0 )
+,   mBlockNumber( 0 )
+,   mpBlockFile( nullptr )
+,   mbFileWritable( false )
+,   mpMappedFile( nullptr )
+,   mbWriteBehind( false )
+,   mWritingBlock( INVALID_BLOCK_NUMBER )
+,   mbWriterExiting( false )
+,   mbWriteFailed( false )
 {
     if ( pBlockFilename == NULL )
     {
@@ -48,11 +83,25 @@ ForthBlockFileManager::ForthBlockFileManager( const char* pBlockFilename , ucell
 	mpBlockFilename = (char *)__MALLOC(strlen(pBlockFilename) + 1);
     strcpy( mpBlockFilename, pBlockFilename );
 
-	mLRUBuffers = (unsigned int *)__MALLOC(sizeof(unsigned int) * numBuffers);
+	mLRUPrev = (unsigned int *)__MALLOC(sizeof(unsigned int) * numBuffers);
+	mLRUNext = (unsigned int *)__MALLOC(sizeof(unsigned int) * numBuffers);
 	mAssignedBlocks = (unsigned int *)__MALLOC(sizeof(unsigned int) * numBuffers);
 	mUpdatedBlocks = (bool *)__MALLOC(sizeof(bool) * numBuffers);
 
 	mpBlocks = (char *)__MALLOC(mBytesPerBlock * numBuffers);
+    mBlockBuffers.reserve( numBuffers );
+
+#if defined(WINDOWS_BUILD)
+    InitializeCriticalSection( &mFileLock );
+    InitializeCriticalSection( &mWriteLock );
+    InitializeConditionVariable( &mWriteReady );
+    InitializeConditionVariable( &mWriteDone );
+#else
+    pthread_mutex_init( &mFileLock, nullptr );
+    pthread_mutex_init( &mWriteLock, nullptr );
+    pthread_cond_init( &mWriteReady, nullptr );
+    pthread_cond_init( &mWriteDone, nullptr );
+#endif
 
     EmptyBuffers();
 }
@@ -60,9 +109,26 @@ ForthBlockFileManager::ForthBlockFileManager( const char* pBlockFilename , ucell
 ForthBlockFileManager::~ForthBlockFileManager()
 {
     SaveBuffers( false );
+    SetWriteBehind( false );
+    delete mpMappedFile;
+    if ( mpBlockFile != nullptr )
+    {
+        fclose( mpBlockFile );
+    }
+
+#if defined(WINDOWS_BUILD)
+    DeleteCriticalSection( &mFileLock );
+    DeleteCriticalSection( &mWriteLock );
+#else
+    pthread_mutex_destroy( &mFileLock );
+    pthread_mutex_destroy( &mWriteLock );
+    pthread_cond_destroy( &mWriteReady );
+    pthread_cond_destroy( &mWriteDone );
+#endif
 
     __FREE( mpBlockFilename );
-    __FREE( mLRUBuffers );
+    __FREE( mLRUPrev );
+    __FREE( mLRUNext );
     __FREE( mAssignedBlocks );
     __FREE( mUpdatedBlocks );
     __FREE( mpBlocks );
@@ -71,19 +137,26 @@ ForthBlockFileManager::~ForthBlockFileManager()
 unsigned int
 ForthBlockFileManager::GetNumBlocksInFile()
 {
+    if ( mpMappedFile != nullptr )
+    {
+        return (unsigned int)(mpMappedFile->Size() / mBytesPerBlock);
+    }
+
+    LockFile();
     if ( mNumBlocksInFile == 0 )
     {
-        FILE* pBlockFile = fopen( mpBlockFilename, "rb" );
+        FILE* pBlockFile = GetBlockFile( false );
         if ( pBlockFile != NULL )
         {
-            if ( !fseek( pBlockFile, 0, SEEK_END ) )
+            if ( seekBlockFile( pBlockFile, 0, SEEK_END ) )
             {
-                mNumBlocksInFile = ftell( pBlockFile ) / mBytesPerBlock;
+                mNumBlocksInFile = (unsigned int)(tellBlockFile( pBlockFile ) / mBytesPerBlock);
             }
-            fclose( pBlockFile );
         }
     }
-    return mNumBlocksInFile;
+    unsigned int numBlocksInFile = mNumBlocksInFile;
+    UnlockFile();
+    return numBlocksInFile;
 }
 
 const char*
@@ -111,18 +184,217 @@ ForthBlockFileManager::OpenBlockFile( bool forWrite )
     return pBlockFile;
 }
 
+// caller must hold mFileLock
+FILE*
+ForthBlockFileManager::GetBlockFile( bool forWrite )
+{
+    if ( (mpBlockFile != nullptr) && (mbFileWritable || !forWrite) )
+    {
+        return mpBlockFile;
+    }
+
+    if ( mpBlockFile != nullptr )
+    {
+        fclose( mpBlockFile );
+    }
+    mpBlockFile = OpenBlockFile( forWrite );
+    mbFileWritable = forWrite && (mpBlockFile != nullptr);
+    return mpBlockFile;
+}
+
+bool
+ForthBlockFileManager::ReadBlocks( unsigned int firstBlock, unsigned int numBlocks, char* pDst )
+{
+    LockFile();
+    FILE* pInFile = GetBlockFile( false );
+    bool success = false;
+    if ( pInFile != NULL )
+    {
+        SPEW_IO( "ForthBlockFileManager::ReadBlocks reading %d blocks starting at %d\n", numBlocks, firstBlock );
+        success = seekBlockFile( pInFile, (uint64_t)mBytesPerBlock * firstBlock, SEEK_SET )
+            && (fread( pDst, mBytesPerBlock, numBlocks, pInFile ) == numBlocks);
+    }
+    UnlockFile();
+    return success;
+}
+
+// called from the writer thread when write behind is enabled
+bool
+ForthBlockFileManager::WriteBlock( unsigned int blockNum, const char* pSrc )
+{
+    LockFile();
+    FILE* pOutFile = GetBlockFile( true );
+    bool success = false;
+    if ( pOutFile != NULL )
+    {
+        SPEW_IO( "ForthBlockFileManager::WriteBlock writing block %d\n", blockNum );
+        success = seekBlockFile( pOutFile, (uint64_t)mBytesPerBlock * blockNum, SEEK_SET )
+            && (fwrite( pSrc, mBytesPerBlock, 1, pOutFile ) == 1);
+        if ( success && (blockNum >= mNumBlocksInFile) )
+        {
+            mNumBlocksInFile = blockNum + 1;
+        }
+    }
+    UnlockFile();
+    return success;
+}
+
 char*
 ForthBlockFileManager::GetBlock( unsigned int blockNum, bool readContents )
 {
+    if ( mpMappedFile != nullptr )
+    {
+        return GetMappedBlock( blockNum );
+    }
+
     mCurrentBuffer = AssignBuffer( blockNum, readContents );
     UpdateLRU();
     return &(mpBlocks[mBytesPerBlock * mCurrentBuffer]);
 }
 
+char*
+ForthBlockFileManager::GetMappedBlock( unsigned int blockNum )
+{
+    size_t blockEnd = (size_t)mBytesPerBlock * (blockNum + 1);
+    if ( mpMappedFile->Size() < blockEnd )
+    {
+        // grow the file to hold the block, this moves the mapping
+        LockFile();
+        bool mapped = mpMappedFile->MapWritable( GetBlockFile( true ), blockEnd );
+        UnlockFile();
+        if ( !mapped )
+        {
+            delete mpMappedFile;
+            mpMappedFile = nullptr;
+            ReportError( kForthErrorIO, "GetBlock - failed to extend mapped block file" );
+            return nullptr;
+        }
+    }
+    return mpMappedFile->WritableData() + ((size_t)mBytesPerBlock * blockNum);
+}
+
+bool
+ForthBlockFileManager::CopyBlock( unsigned int blockNum, char* pDst, unsigned int numBytes )
+{
+    unsigned int numToCopy = (numBytes < mBytesPerBlock) ? numBytes : mBytesPerBlock;
+    bool success = true;
+    if ( mpMappedFile != nullptr )
+    {
+        size_t blockStart = (size_t)mBytesPerBlock * blockNum;
+        if ( (blockStart + numToCopy) <= mpMappedFile->Size() )
+        {
+            memcpy( pDst, mpMappedFile->Data() + blockStart, numToCopy );
+        }
+        else
+        {
+            success = false;
+        }
+    }
+    else
+    {
+        std::unordered_map<unsigned int, unsigned int>::iterator iter = mBlockBuffers.find( blockNum );
+        if ( iter != mBlockBuffers.end() )
+        {
+            // buffer may have been updated, so it is newer than the file
+            memcpy( pDst, &(mpBlocks[mBytesPerBlock * iter->second]), numToCopy );
+        }
+        else
+        {
+            std::vector<char> block( mBytesPerBlock );
+            success = GetPendingWrite( blockNum, &(block[0]) ) || ReadBlocks( blockNum, 1, &(block[0]) );
+            if ( success )
+            {
+                memcpy( pDst, &(block[0]), numToCopy );
+            }
+        }
+    }
+
+    if ( success && (numToCopy < numBytes) )
+    {
+        memset( pDst + numToCopy, ' ', numBytes - numToCopy );
+    }
+    return success;
+}
+
+void
+ForthBlockFileManager::ReadAhead( unsigned int firstBlock, unsigned int lastBlock )
+{
+    if ( (mpMappedFile != nullptr) || (lastBlock < firstBlock) )
+    {
+        return;
+    }
+
+    // leave at least half the buffers alone, so reading ahead doesn't flush out the whole cache
+    unsigned int maxBlocks = mNumBuffers >> 1;
+    if ( maxBlocks > MAX_READ_AHEAD_BLOCKS )
+    {
+        maxBlocks = MAX_READ_AHEAD_BLOCKS;
+    }
+    unsigned int numBlocksInFile = GetNumBlocksInFile();
+    if ( lastBlock >= numBlocksInFile )
+    {
+        lastBlock = numBlocksInFile - 1;
+    }
+    if ( (maxBlocks == 0) || (firstBlock >= numBlocksInFile) )
+    {
+        return;
+    }
+    if ( (lastBlock - firstBlock) >= maxBlocks )
+    {
+        lastBlock = firstBlock + maxBlocks - 1;
+    }
+
+    // read each run of blocks which aren't in buffers with a single read
+    std::vector<char> runBlocks( (size_t)mBytesPerBlock * (lastBlock + 1 - firstBlock) );
+    unsigned int blockNum = firstBlock;
+    while ( blockNum <= lastBlock )
+    {
+        if ( mBlockBuffers.find( blockNum ) != mBlockBuffers.end() )
+        {
+            blockNum++;
+            continue;
+        }
+
+        unsigned int runStart = blockNum;
+        char* pRun = &(runBlocks[0]);
+        while ( (blockNum <= lastBlock) && (mBlockBuffers.find( blockNum ) == mBlockBuffers.end()) )
+        {
+            blockNum++;
+        }
+        if ( !ReadBlocks( runStart, blockNum - runStart, pRun ) )
+        {
+            // read ahead is only a hint, the block reads will report the error
+            return;
+        }
+
+        for ( unsigned int runBlock = runStart; runBlock < blockNum; runBlock++ )
+        {
+            unsigned int bufferNum = GetFreeBuffer();
+            char* pBuffer = &(mpBlocks[mBytesPerBlock * bufferNum]);
+            char* pBlock = pRun + ((size_t)mBytesPerBlock * (runBlock - runStart));
+            // a block waiting to be written is newer than what was just read
+            if ( !GetPendingWrite( runBlock, pBuffer ) )
+            {
+                memcpy( pBuffer, pBlock, mBytesPerBlock );
+            }
+            mAssignedBlocks[bufferNum] = runBlock;
+            mBlockBuffers[runBlock] = bufferNum;
+            UnlinkBuffer( bufferNum );
+            LinkBufferAtHead( bufferNum );
+        }
+    }
+}
+
 void
 ForthBlockFileManager::UpdateCurrentBuffer()
 {
-    if ( mCurrentBuffer > mNumBuffers )
+    if ( mpMappedFile != nullptr )
+    {
+        // mapped blocks are written back to the file by the OS
+        return;
+    }
+
+    if ( mCurrentBuffer >= mNumBuffers )
     {
         ReportError( kForthErrorBadParameter, "UpdateCurrentBuffer - no current buffer" );
         return;
@@ -134,14 +406,7 @@ ForthBlockFileManager::UpdateCurrentBuffer()
 bool
 ForthBlockFileManager::SaveBuffer( unsigned int bufferNum )
 {
-    FILE* pBlockFile = OpenBlockFile( true );
-    if ( pBlockFile == NULL )
-    {
-        ReportError( kForthErrorIO, "SaveBuffer - failed to open block file" );
-        return false;
-    }
-
-    if ( bufferNum > mNumBuffers )
+    if ( bufferNum >= mNumBuffers )
     {
         ReportError( kForthErrorBadParameter, "SaveBuffer - invalid buffer number" );
         return false;
@@ -153,15 +418,21 @@ ForthBlockFileManager::SaveBuffer( unsigned int bufferNum )
         return false;
     }
 
-    SPEW_IO( "ForthBlockFileManager::AssignBuffer writing block %d from buffer %d\n", mAssignedBlocks[bufferNum], bufferNum );
-    fseek( pBlockFile, mBytesPerBlock * mAssignedBlocks[bufferNum], SEEK_SET );
-    size_t numWritten = fwrite( &(mpBlocks[mBytesPerBlock * bufferNum]), mBytesPerBlock, 1, pBlockFile );
-    if ( numWritten != 1 )
+    const char* pBuffer = &(mpBlocks[mBytesPerBlock * bufferNum]);
+    if ( mbWriteBehind )
     {
-        ReportError( kForthErrorIO, "SaveBuffer - failed to write block file" );
-        return false;
+        SPEW_IO( "ForthBlockFileManager::SaveBuffer queueing block %d from buffer %d\n", mAssignedBlocks[bufferNum], bufferNum );
+        QueueWrite( mAssignedBlocks[bufferNum], pBuffer );
+    }
+    else
+    {
+        SPEW_IO( "ForthBlockFileManager::SaveBuffer writing block %d from buffer %d\n", mAssignedBlocks[bufferNum], bufferNum );
+        if ( !WriteBlock( mAssignedBlocks[bufferNum], pBuffer ) )
+        {
+            ReportError( kForthErrorIO, "SaveBuffer - failed to write block file" );
+            return false;
+        }
     }
-    fclose( pBlockFile );
 
     mUpdatedBlocks[bufferNum] = false;
     return true;
@@ -171,91 +442,148 @@ unsigned int
 ForthBlockFileManager::AssignBuffer( unsigned int blockNum, bool readContents )
 {
     SPEW_IO( "ForthBlockFileManager::AssignBuffer to block %d\n", blockNum );
-    unsigned int availableBuffer = INVALID_BLOCK_NUMBER;
-    for ( unsigned int i = 0; i < mNumBuffers; ++i )
+    std::unordered_map<unsigned int, unsigned int>::iterator iter = mBlockBuffers.find( blockNum );
+    if ( iter != mBlockBuffers.end() )
     {
-        unsigned int bufferBlockNum = mAssignedBlocks[i];
-        if ( bufferBlockNum == blockNum )
-        {
-            return i;
-        }
-        else if ( bufferBlockNum == INVALID_BLOCK_NUMBER )
+        return iter->second;
+    }
+
+    // block is not in a buffer, assign it one
+    unsigned int availableBuffer = GetFreeBuffer();
+    mAssignedBlocks[ availableBuffer ] = blockNum;
+    mBlockBuffers[ blockNum ] = availableBuffer;
+
+    if ( readContents )
+    {
+        char* pBuffer = &(mpBlocks[mBytesPerBlock * availableBuffer]);
+        SPEW_IO( "ForthBlockFileManager::AssignBuffer reading block %d into buffer %d\n", blockNum, availableBuffer );
+        if ( !GetPendingWrite( blockNum, pBuffer ) && !ReadBlocks( blockNum, 1, pBuffer ) )
         {
-            availableBuffer = i;
+            ReportError( kForthErrorIO, "AssignBuffer - failed to read block file" );
         }
     }
 
-    // block is not in a buffer, assign it one
-    if ( availableBuffer >= mNumBuffers )
+    return availableBuffer;
+}
+
+unsigned int
+ForthBlockFileManager::GetFreeBuffer()
+{
+    // unassigned buffers are kept at the tail of the LRU list, so the tail is
+    //   either unassigned or the least recently used buffer
+    unsigned int bufferNum = mLRUTail;
+    unsigned int oldBlockNum = mAssignedBlocks[ bufferNum ];
+    if ( oldBlockNum == INVALID_BLOCK_NUMBER )
     {
-        // there are no unassigned buffers, assign the least recently used one
-        availableBuffer = mLRUBuffers[ mNumBuffers - 1 ];
+        SPEW_IO( "ForthBlockFileManager::GetFreeBuffer using unassigned buffer %d\n", bufferNum );
     }
     else
     {
-        SPEW_IO( "ForthBlockFileManager::AssignBuffer using unassigned buffer %d\n", availableBuffer );
+        if ( mUpdatedBlocks[ bufferNum ] )
+        {
+            SaveBuffer( bufferNum );
+        }
+        mBlockBuffers.erase( oldBlockNum );
+        mAssignedBlocks[ bufferNum ] = INVALID_BLOCK_NUMBER;
+        mUpdatedBlocks[ bufferNum ] = false;
     }
+    if ( bufferNum == mCurrentBuffer )
+    {
+        mCurrentBuffer = INVALID_BLOCK_NUMBER;
+    }
+    return bufferNum;
+}
 
-    if ( mUpdatedBlocks[ availableBuffer ] )
+void
+ForthBlockFileManager::UnassignBuffer( unsigned int bufferNum )
+{
+    if ( mAssignedBlocks[ bufferNum ] != INVALID_BLOCK_NUMBER )
     {
-        SaveBuffer( availableBuffer );
+        mBlockBuffers.erase( mAssignedBlocks[ bufferNum ] );
+        mAssignedBlocks[ bufferNum ] = INVALID_BLOCK_NUMBER;
     }
+    mUpdatedBlocks[ bufferNum ] = false;
+    UnlinkBuffer( bufferNum );
+    LinkBufferAtTail( bufferNum );
+}
 
-    mAssignedBlocks[ availableBuffer ] = blockNum;
+void
+ForthBlockFileManager::UnlinkBuffer( unsigned int bufferNum )
+{
+    unsigned int prev = mLRUPrev[ bufferNum ];
+    unsigned int next = mLRUNext[ bufferNum ];
+    if ( prev == INVALID_BLOCK_NUMBER )
+    {
+        mLRUHead = next;
+    }
+    else
+    {
+        mLRUNext[ prev ] = next;
+    }
+    if ( next == INVALID_BLOCK_NUMBER )
+    {
+        mLRUTail = prev;
+    }
+    else
+    {
+        mLRUPrev[ next ] = prev;
+    }
+    mLRUPrev[ bufferNum ] = INVALID_BLOCK_NUMBER;
+    mLRUNext[ bufferNum ] = INVALID_BLOCK_NUMBER;
+}
 
-    if ( readContents )
+void
+ForthBlockFileManager::LinkBufferAtHead( unsigned int bufferNum )
+{
+    mLRUPrev[ bufferNum ] = INVALID_BLOCK_NUMBER;
+    mLRUNext[ bufferNum ] = mLRUHead;
+    if ( mLRUHead == INVALID_BLOCK_NUMBER )
     {
-        FILE* pInFile = OpenBlockFile( false );
-        if ( pInFile == NULL )
-        {
-            ReportError( kForthErrorIO, "AssignBuffer - failed to open block file" );
-        }
-        else
-        {
-            SPEW_IO( "ForthBlockFileManager::AssignBuffer reading block %d into buffer %d\n", blockNum, availableBuffer );
-            fseek( pInFile, mBytesPerBlock * blockNum, SEEK_SET );
-            size_t numRead = fread( &(mpBlocks[mBytesPerBlock * availableBuffer]), mBytesPerBlock, 1, pInFile );
-            if ( numRead != 1 )
-            {
-                ReportError( kForthErrorIO, "AssignBuffer - failed to read block file" );
-            }
-            fclose( pInFile );
-        }
+        mLRUTail = bufferNum;
+    }
+    else
+    {
+        mLRUPrev[ mLRUHead ] = bufferNum;
     }
+    mLRUHead = bufferNum;
+}
 
-    return availableBuffer;
+void
+ForthBlockFileManager::LinkBufferAtTail( unsigned int bufferNum )
+{
+    mLRUNext[ bufferNum ] = INVALID_BLOCK_NUMBER;
+    mLRUPrev[ bufferNum ] = mLRUTail;
+    if ( mLRUTail == INVALID_BLOCK_NUMBER )
+    {
+        mLRUHead = bufferNum;
+    }
+    else
+    {
+        mLRUNext[ mLRUTail ] = bufferNum;
+    }
+    mLRUTail = bufferNum;
 }
 
 void
 ForthBlockFileManager::UpdateLRU()
 {
     SPEW_IO( "ForthBlockFileManager::UpdateLRU current=%d\n", mCurrentBuffer );
-    if ( mCurrentBuffer < mNumBuffers )
+    if ( (mCurrentBuffer < mNumBuffers) && (mCurrentBuffer != mLRUHead) )
     {
-        for ( unsigned int i = 0; i < mNumBuffers; ++i )
-        {
-            if ( mLRUBuffers[i] == mCurrentBuffer )
-            {
-                if ( i != 0 )
-                {
-                    for ( int j = i; j != 0; j-- )
-                    {
-                        mLRUBuffers[j] = mLRUBuffers[j - 1];
-                    }
-                    mLRUBuffers[0] = mCurrentBuffer;
-                }
-            }
-        }
+        UnlinkBuffer( mCurrentBuffer );
+        LinkBufferAtHead( mCurrentBuffer );
     }
 }
 
 void ForthBlockFileManager::SaveBuffers( bool unassignAfterSaving )
 {
     SPEW_IO( "ForthBlockFileManager::SaveBuffers\n" );
-    FILE* pOutFile = OpenBlockFile( true );
-    if ( pOutFile == NULL )
+    if ( mpMappedFile != nullptr )
     {
-        // TODO: report error
+        if ( !mpMappedFile->Sync() )
+        {
+            ReportError( kForthErrorIO, "SaveBuffers - failed to write mapped block file" );
+        }
         return;
     }
 
@@ -265,33 +593,302 @@ void ForthBlockFileManager::SaveBuffers( bool unassignAfterSaving )
         {
             SaveBuffer( i );
         }
-        if ( unassignAfterSaving )
-        {
-            mAssignedBlocks[i] = INVALID_BLOCK_NUMBER;
-        }
     }
 
     if ( unassignAfterSaving )
     {
-        mCurrentBuffer = INVALID_BLOCK_NUMBER;
+        EmptyBuffers();
+    }
+
+    if ( mbWriteBehind )
+    {
+        WaitForPendingWrites();
     }
 
-    fclose( pOutFile );
+    LockFile();
+    if ( mpBlockFile != nullptr )
+    {
+        fflush( mpBlockFile );
+    }
+    UnlockFile();
 }
 
 void
 ForthBlockFileManager::EmptyBuffers()
 {
     SPEW_IO( "ForthBlockFileManager::EmptyBuffers\n" );
+    mBlockBuffers.clear();
     for ( unsigned int i = 0; i < mNumBuffers; ++i )
     {
-        mLRUBuffers[i] = i;
+        mLRUPrev[i] = i - 1;
+        mLRUNext[i] = i + 1;
         mAssignedBlocks[i] = INVALID_BLOCK_NUMBER;
         mUpdatedBlocks[i] = false;
     }
+    // buffer 0 is the head, its prev is already INVALID_BLOCK_NUMBER
+    mLRUNext[mNumBuffers - 1] = INVALID_BLOCK_NUMBER;
+    mLRUHead = 0;
+    mLRUTail = mNumBuffers - 1;
     mCurrentBuffer = INVALID_BLOCK_NUMBER;
 }
 
+bool
+ForthBlockFileManager::SetMapped( bool enable )
+{
+    if ( enable == (mpMappedFile != nullptr) )
+    {
+        return true;
+    }
+
+    if ( enable )
+    {
+        // everything in buffers must be in the file before the file is mapped
+        SaveBuffers( true );
+        LockFile();
+        mpMappedFile = new ForthMappedFile;
+        bool mapped = mpMappedFile->MapWritable( GetBlockFile( true ), 0 );
+        if ( !mapped )
+        {
+            delete mpMappedFile;
+            mpMappedFile = nullptr;
+        }
+        UnlockFile();
+        return mapped;
+    }
+    else
+    {
+        SaveBuffers( false );
+        LockFile();
+        mNumBlocksInFile = (unsigned int)(mpMappedFile->Size() / mBytesPerBlock);
+        delete mpMappedFile;
+        mpMappedFile = nullptr;
+        UnlockFile();
+    }
+    return true;
+}
+
+void
+ForthBlockFileManager::SetWriteBehind( bool enable )
+{
+    if ( enable == mbWriteBehind )
+    {
+        return;
+    }
+
+    if ( enable )
+    {
+        mbWriterExiting = false;
+#if defined(WINDOWS_BUILD)
+        mWriter = (HANDLE)_beginthreadex( nullptr, 0, WriterRoutine, this, 0, nullptr );
+        if ( mWriter == 0 )
+        {
+            ReportError( kForthErrorIO, "SetWriteBehind - failed to start writer thread" );
+            return;
+        }
+#else
+        if ( pthread_create( &mWriter, nullptr, WriterRoutine, this ) != 0 )
+        {
+            ReportError( kForthErrorIO, "SetWriteBehind - failed to start writer thread" );
+            return;
+        }
+#endif
+        mbWriteBehind = true;
+    }
+    else
+    {
+        WaitForPendingWrites();
+        LockWrites();
+        mbWriterExiting = true;
+#if defined(WINDOWS_BUILD)
+        WakeConditionVariable( &mWriteReady );
+        UnlockWrites();
+        WaitForSingleObject( mWriter, INFINITE );
+        CloseHandle( mWriter );
+#else
+        pthread_cond_signal( &mWriteReady );
+        UnlockWrites();
+        pthread_join( mWriter, nullptr );
+#endif
+        mbWriteBehind = false;
+    }
+}
+
+#if defined(WINDOWS_BUILD)
+unsigned __stdcall ForthBlockFileManager::WriterRoutine( void* pUserData )
+{
+    ((ForthBlockFileManager*)pUserData)->WriterLoop();
+    return 0;
+}
+#else
+void* ForthBlockFileManager::WriterRoutine( void* pUserData )
+{
+    ((ForthBlockFileManager*)pUserData)->WriterLoop();
+    return nullptr;
+}
+#endif
+
+void
+ForthBlockFileManager::LockFile()
+{
+#if defined(WINDOWS_BUILD)
+    EnterCriticalSection( &mFileLock );
+#else
+    pthread_mutex_lock( &mFileLock );
+#endif
+}
+
+void
+ForthBlockFileManager::UnlockFile()
+{
+#if defined(WINDOWS_BUILD)
+    LeaveCriticalSection( &mFileLock );
+#else
+    pthread_mutex_unlock( &mFileLock );
+#endif
+}
+
+void
+ForthBlockFileManager::LockWrites()
+{
+#if defined(WINDOWS_BUILD)
+    EnterCriticalSection( &mWriteLock );
+#else
+    pthread_mutex_lock( &mWriteLock );
+#endif
+}
+
+void
+ForthBlockFileManager::UnlockWrites()
+{
+#if defined(WINDOWS_BUILD)
+    LeaveCriticalSection( &mWriteLock );
+#else
+    pthread_mutex_unlock( &mWriteLock );
+#endif
+}
+
+void
+ForthBlockFileManager::WaitForWriteReady()
+{
+#if defined(WINDOWS_BUILD)
+    SleepConditionVariableCS( &mWriteReady, &mWriteLock, INFINITE );
+#else
+    pthread_cond_wait( &mWriteReady, &mWriteLock );
+#endif
+}
+
+void
+ForthBlockFileManager::WaitForWriteDone()
+{
+#if defined(WINDOWS_BUILD)
+    SleepConditionVariableCS( &mWriteDone, &mWriteLock, INFINITE );
+#else
+    pthread_cond_wait( &mWriteDone, &mWriteLock );
+#endif
+}
+
+void
+ForthBlockFileManager::QueueWrite( unsigned int blockNum, const char* pSrc )
+{
+    LockWrites();
+    // a block which is still waiting to be written just gets its data replaced
+    mPendingWrites[blockNum].assign( pSrc, pSrc + mBytesPerBlock );
+    bool writeFailed = mbWriteFailed;
+    mbWriteFailed = false;
+#if defined(WINDOWS_BUILD)
+    WakeConditionVariable( &mWriteReady );
+#else
+    pthread_cond_signal( &mWriteReady );
+#endif
+    UnlockWrites();
+    if ( writeFailed )
+    {
+        ReportError( kForthErrorIO, "SaveBuffer - failed to write block file" );
+    }
+}
+
+bool
+ForthBlockFileManager::GetPendingWrite( unsigned int blockNum, char* pDst )
+{
+    if ( !mbWriteBehind )
+    {
+        return false;
+    }
+
+    LockWrites();
+    // once the writer finishes with the block, the file is up to date
+    while ( mWritingBlock == blockNum )
+    {
+        WaitForWriteDone();
+    }
+    std::map<unsigned int, std::vector<char>>::iterator iter = mPendingWrites.find( blockNum );
+    bool found = (iter != mPendingWrites.end());
+    if ( found )
+    {
+        memcpy( pDst, &(iter->second[0]), mBytesPerBlock );
+    }
+    UnlockWrites();
+    return found;
+}
+
+void
+ForthBlockFileManager::WaitForPendingWrites()
+{
+    LockWrites();
+    while ( !mPendingWrites.empty() || (mWritingBlock != INVALID_BLOCK_NUMBER) )
+    {
+        WaitForWriteDone();
+    }
+    bool writeFailed = mbWriteFailed;
+    mbWriteFailed = false;
+    UnlockWrites();
+    if ( writeFailed )
+    {
+        ReportError( kForthErrorIO, "SaveBuffers - failed to write block file" );
+    }
+}
+
+// runs on the writer thread, pending blocks are written in block number order
+void
+ForthBlockFileManager::WriterLoop()
+{
+    LockWrites();
+    while ( true )
+    {
+        while ( mPendingWrites.empty() && !mbWriterExiting )
+        {
+            WaitForWriteReady();
+        }
+        if ( mPendingWrites.empty() )
+        {
+            break;
+        }
+
+        std::map<unsigned int, std::vector<char>>::iterator iter = mPendingWrites.begin();
+        unsigned int blockNum = iter->first;
+        std::vector<char> block;
+        block.swap( iter->second );
+        mPendingWrites.erase( iter );
+        mWritingBlock = blockNum;
+
+        UnlockWrites();
+        bool success = WriteBlock( blockNum, &(block[0]) );
+        LockWrites();
+
+        if ( !success )
+        {
+            mbWriteFailed = true;
+        }
+        mWritingBlock = INVALID_BLOCK_NUMBER;
+#if defined(WINDOWS_BUILD)
+        WakeAllConditionVariable( &mWriteDone );
+#else
+        pthread_cond_broadcast( &mWriteDone );
+#endif
+    }
+    UnlockWrites();
+}
+
 void
 ForthBlockFileManager::ReportError( eForthError errorCode, const char* pErrorMessage )
 {
@@ -360,6 +957,10 @@ namespace OBlockFile
             numBuffers = NUM_BLOCK_BUFFERS;
         }
         const char* pBlockFileName = (const char *)(SPOP);
+        if (pBlockFile->pManager != nullptr)
+        {
+            delete pBlockFile->pManager;
+        }
         pBlockFile->pManager = new ForthBlockFileManager(pBlockFileName, numBuffers, bytesPerBlock);
         METHOD_RETURN;
     }
@@ -452,10 +1053,56 @@ namespace OBlockFile
         METHOD_RETURN;
     }
 
+    FORTHOP(oBlockFileReadAheadMethod)
+    {
+        GET_THIS(oBlockFileStruct, pBlockFile);
+        unsigned int lastBlock = (unsigned int)SPOP;
+        unsigned int firstBlock = (unsigned int)SPOP;
+        pBlockFile->pManager->ReadAhead(firstBlock, lastBlock);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oBlockFileSetWriteBehindMethod)
+    {
+        GET_THIS(oBlockFileStruct, pBlockFile);
+        pBlockFile->pManager->SetWriteBehind(SPOP != 0);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oBlockFileIsWriteBehindMethod)
+    {
+        GET_THIS(oBlockFileStruct, pBlockFile);
+        SPUSH(pBlockFile->pManager->IsWriteBehind() ? ~0 : 0);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oBlockFileSetMappedMethod)
+    {
+        GET_THIS(oBlockFileStruct, pBlockFile);
+        bool enable = (SPOP != 0);
+        SPUSH(pBlockFile->pManager->SetMapped(enable) ? ~0 : 0);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oBlockFileIsMappedMethod)
+    {
+        GET_THIS(oBlockFileStruct, pBlockFile);
+        SPUSH(pBlockFile->pManager->IsMapped() ? ~0 : 0);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oBlockFileNumBlocksMethod)
+    {
+        GET_THIS(oBlockFileStruct, pBlockFile);
+        SPUSH(pBlockFile->pManager->GetNumBlocksInFile());
+        METHOD_RETURN;
+    }
+
     baseMethodEntry oBlockFileMembers[] =
     {
         METHOD("__newOp", oBlockFileNew),
         METHOD("delete", oBlockFileDeleteMethod),
+        METHOD("init", oBlockFileInitMethod),
 
         METHOD_RET("blk", oBlockFileBlkMethod, RETURNS_NATIVE(kBaseTypeInt | kDTIsPtr)),
         METHOD_RET("block", oBlockFileBlockMethod, RETURNS_NATIVE(kBaseTypeByte | kDTIsPtr)),
@@ -465,6 +1112,12 @@ namespace OBlockFile
         METHOD("saveBuffers", oBlockFileSaveBuffersMethod),
         METHOD("update", oBlockFileUpdateMethod),
         METHOD("thru", oBlockFileThruMethod),
+        METHOD("readAhead", oBlockFileReadAheadMethod),
+        METHOD("setWriteBehind", oBlockFileSetWriteBehindMethod),
+        METHOD_RET("isWriteBehind", oBlockFileIsWriteBehindMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("setMapped", oBlockFileSetMappedMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("isMapped", oBlockFileIsMappedMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("numBlocks", oBlockFileNumBlocksMethod, RETURNS_NATIVE(kBaseTypeInt)),
 
         METHOD("bytesPerBlock", oBlockFileBytesPerBlockMethod),
         METHOD("numBuffers", oBlockFileNumBuffersMethod),
@@ -7,14 +7,31 @@
 
 #include "Forth.h"
 
+#include <unordered_map>
+#include <map>
+#include <vector>
+#if !defined(WINDOWS_BUILD)
+#include <pthread.h>
+#endif
+
 #ifndef NUM_BLOCK_BUFFERS
-#define NUM_BLOCK_BUFFERS 8
+#define NUM_BLOCK_BUFFERS 64
 #endif
 #define BYTES_PER_BLOCK 1024
+// most blocks read in one go when a range of blocks is about to be read in order
+#define MAX_READ_AHEAD_BLOCKS 64
 
 class ForthBlockInputStream;
 class ForthEngine;
+class ForthMappedFile;
 
+// ForthBlockFileManager caches blocks of a block file in a set of buffers.
+// A hash table maps block numbers to buffers, and the buffers are kept on a doubly linked
+//   list from most to least recently used, so finding a block and picking the buffer to
+//   reuse don't depend on the number of buffers.
+// With write behind enabled, updated blocks which are pushed out of the cache are written by a
+//   background thread.  In mapped mode the whole block file is mapped into memory, and blocks
+//   are accessed directly in the mapping instead of being copied into buffers.
 class ForthBlockFileManager
 {
 public:
@@ -23,6 +40,11 @@ public:
 
     const char*     GetBlockFilename();
     char*           GetBlock( unsigned int blockNum, bool readContents );
+    // copies up to numBytes of a block into pDst without changing the current buffer,
+    //   if the block is shorter the rest of pDst is filled with blanks.  Returns false on failure
+    bool            CopyBlock( unsigned int blockNum, char* pDst, unsigned int numBytes );
+    // loads the blocks in [firstBlock, lastBlock] which aren't in buffers yet
+    void            ReadAhead( unsigned int firstBlock, unsigned int lastBlock );
     void            UpdateCurrentBuffer();
     void            SaveBuffers( bool unassignAfterSaving );
     void            EmptyBuffers();
@@ -32,23 +54,90 @@ public:
     unsigned int    GetBytesPerBlock() const;
     unsigned int    GetNumBuffers() const;
 
+    void            SetWriteBehind( bool enable );
+    inline bool     IsWriteBehind() const { return mbWriteBehind; }
+    // returns false if the block file couldn't be mapped
+    bool            SetMapped( bool enable );
+    inline bool     IsMapped() const { return mpMappedFile != nullptr; }
+
 private:
 
     unsigned int    AssignBuffer( unsigned int blockNum, bool readContents );
+    // returns a buffer for a block which isn't in the cache, saving the block it held if needed
+    unsigned int    GetFreeBuffer();
+    void            UnassignBuffer( unsigned int bufferNum );
+    // LRU list operations
+    void            UnlinkBuffer( unsigned int bufferNum );
+    void            LinkBufferAtHead( unsigned int bufferNum );
+    void            LinkBufferAtTail( unsigned int bufferNum );
     void            UpdateLRU();
     bool            SaveBuffer( unsigned int bufferNum );
+    // reads/writes numBlocks consecutive blocks directly from/to the file
+    bool            ReadBlocks( unsigned int firstBlock, unsigned int numBlocks, char* pDst );
+    bool            WriteBlock( unsigned int blockNum, const char* pSrc );
+    // get the open block file, reopening it for writing if needed
+    FILE*           GetBlockFile( bool forWrite );
+    char*           GetMappedBlock( unsigned int blockNum );
+    // write behind
+    void            QueueWrite( unsigned int blockNum, const char* pSrc );
+    bool            GetPendingWrite( unsigned int blockNum, char* pDst );
+    void            WaitForPendingWrites();
+    void            WriterLoop();
+#if defined(WINDOWS_BUILD)
+    static unsigned __stdcall WriterRoutine( void* pUserData );
+#else
+    static void*    WriterRoutine( void* pUserData );
+#endif
+    void            LockFile();
+    void            UnlockFile();
+    void            LockWrites();
+    void            UnlockWrites();
+    // wait on a write signal, must be called with the write lock held
+    void            WaitForWriteReady();
+    void            WaitForWriteDone();
     void            ReportError( eForthError errorCode, const char* pErrorMessage );
 
     char*           mpBlockFilename;
     unsigned int    mNumBlocksInFile;
     unsigned int    mNumBuffers;
     unsigned int    mCurrentBuffer;
-    unsigned int*   mLRUBuffers;
+    // buffers are on a list from mLRUHead (most recently used) to mLRUTail
+    unsigned int*   mLRUPrev;
+    unsigned int*   mLRUNext;
+    unsigned int    mLRUHead;
+    unsigned int    mLRUTail;
     unsigned int*   mAssignedBlocks;
+    std::unordered_map<unsigned int, unsigned int> mBlockBuffers;
     char*           mpBlocks;
     bool*           mUpdatedBlocks;
     long            mBlockNumber;       // number returned by 'blk'
     unsigned int    mBytesPerBlock;
+
+    // the block file is kept open, mFileLock is held while it is used
+    FILE*           mpBlockFile;
+    bool            mbFileWritable;
+
+    ForthMappedFile* mpMappedFile;
+
+    // blocks waiting to be written by the writer thread, newer data for a block replaces older
+    bool            mbWriteBehind;
+#if defined(WINDOWS_BUILD)
+    CRITICAL_SECTION    mFileLock;
+    HANDLE              mWriter;
+    CRITICAL_SECTION    mWriteLock;
+    CONDITION_VARIABLE  mWriteReady;
+    CONDITION_VARIABLE  mWriteDone;
+#else
+    pthread_mutex_t     mFileLock;
+    pthread_t           mWriter;
+    pthread_mutex_t     mWriteLock;
+    pthread_cond_t      mWriteReady;
+    pthread_cond_t      mWriteDone;
+#endif
+    std::map<unsigned int, std::vector<char>> mPendingWrites;
+    unsigned int    mWritingBlock;
+    bool            mbWriterExiting;
+    bool            mbWriteFailed;
 };
 
 namespace OBlockFile
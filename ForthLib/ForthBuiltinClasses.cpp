@@ -21,10 +21,14 @@
 #include "OList.h"
 #include "OString.h"
 #include "OMap.h"
+#include "OHashMap.h"
+#include "OTreeMap.h"
+#include "OCsvReader.h"
 #include "OStream.h"
 #include "ONumber.h"
 #include "OSystem.h"
 #include "OSocket.h"
+#include "ForthThread.h"
 
 #ifdef TRACK_OBJECT_ALLOCATIONS
 long gStatNews = 0;
@@ -77,13 +81,13 @@ void unrefObject(ForthObject& fobj)
 	ForthEngine *pEngine = ForthEngine::GetInstance();
 	if (fobj != nullptr)
 	{
-		if (fobj->refCount == 0)
+		if (OBJECT_REFCOUNT(fobj) == 0)
 		{
 			pEngine->SetError(kForthErrorBadReferenceCount, " unref with refcount already zero");
 		}
 		else
 		{
-			fobj->refCount -= 1;
+			DECREMENT_REFCOUNT(fobj);
 		}
 	}
 }
@@ -194,7 +198,7 @@ namespace
 	FORTHOP(objectKeepMethod)
 	{
         ForthObject obj = GET_TP;
-		obj->refCount += 1;
+		INCREMENT_REFCOUNT(obj);
 		TRACK_KEEP;
 		METHOD_RETURN;
 	}
@@ -202,14 +206,21 @@ namespace
 	FORTHOP(objectReleaseMethod)
 	{
         ForthObject obj = GET_TP;
-		obj->refCount -= 1;
 		TRACK_RELEASE;
-		if (obj->refCount != 0)
+		if (DECREMENT_REFCOUNT(obj) != 0)
 		{
 			METHOD_RETURN;
 		}
 		else
 		{
+			ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+			ForthThread* pThread = (pFiber != nullptr) ? pFiber->GetParent() : nullptr;
+			if (pThread != nullptr && pThread->GetDeferReleases())
+			{
+				pThread->ReleaseObject(pCore, obj);
+				METHOD_RETURN;
+				return;
+			}
 			ForthEngine *pEngine = ForthEngine::GetInstance();
 			ulong deleteOp = obj->pMethods[kMethodDelete];
 			pEngine->ExecuteOp(pCore, deleteOp);
@@ -424,6 +435,403 @@ void ForthShowObject(ForthObject& obj, ForthCoreState* pCore)
 }
 
 
+void ForthVisitObjectChildren(ForthObject& obj, ObjectVisitor visitor, void* pUserData, ObjectVisitor weakVisitor)
+{
+    if (obj == nullptr)
+    {
+        return;
+    }
+
+    ForthClassObject* pClassObject = GET_CLASS_OBJECT(obj);
+    ForthClassVocabulary* pClassVocab = pClassObject->pVocab;
+    while (pClassVocab != nullptr)
+    {
+        CustomChildVisitor customVisitor = pClassVocab->GetCustomChildVisitor();
+        if (customVisitor != nullptr)
+        {
+            // custom visitor handles all object references in this class and its base classes
+            customVisitor(obj, visitor, pUserData);
+            break;
+        }
+        pClassVocab->VisitObjectFields(obj, visitor, pUserData, weakVisitor);
+        pClassVocab = (ForthClassVocabulary *)pClassVocab->BaseVocabulary();
+    }
+}
+
+static void addUnsharedObject(ForthObject& obj, void* pUserData)
+{
+    if ((obj != nullptr) && !OBJECT_IS_SHARED(obj))
+    {
+        ((std::vector<ForthObject> *)pUserData)->push_back(obj);
+    }
+}
+
+void ForthShareObject(ForthObject& obj)
+{
+    // this must be done before the objects are handed to another thread, since setting
+    //  the shared flag is not itself atomic
+    std::vector<ForthObject> pending;
+    if (obj != nullptr)
+    {
+        pending.push_back(obj);
+    }
+    while (!pending.empty())
+    {
+        ForthObject next = pending.back();
+        pending.pop_back();
+        if ((next != nullptr) && !OBJECT_IS_SHARED(next))
+        {
+            next->refCount |= SHARED_OBJECT_FLAG;
+            // objects only reachable through weak fields are still visible to other threads
+            ForthVisitObjectChildren(next, addUnsharedObject, &pending, addUnsharedObject);
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////
+////
+///     ForthCycleCollector - trial deletion collector for garbage cycles
+//
+//
+
+bool gCycleCollectorEnabled = false;
+
+void AddPossibleCycleRoot(ForthCoreState* pCore, ForthObject obj)
+{
+    ForthCycleCollector::GetInstance()->AddPossibleRoot(pCore, obj);
+}
+
+void CycleCollectorFreeObject(void* pObj)
+{
+    ForthCycleCollector::GetInstance()->FreeObject(pObj);
+}
+
+#define DEFAULT_CYCLE_ROOT_THRESHOLD 10000
+
+ForthCycleCollector* ForthCycleCollector::mpInstance = nullptr;
+
+ForthCycleCollector::ForthCycleCollector()
+    : mRootThreshold(DEFAULT_CYCLE_ROOT_THRESHOLD)
+    , mCollectionPending(false)
+    , mCollecting(false)
+    , mNumCollections(0)
+    , mTotalDeleted(0)
+{
+#if defined(WINDOWS_BUILD)
+    mpLock = new CRITICAL_SECTION();
+    InitializeCriticalSection(mpLock);
+#else
+    mpLock = new pthread_mutex_t;
+    pthread_mutex_init(mpLock, nullptr);
+#endif
+}
+
+ForthCycleCollector::~ForthCycleCollector()
+{
+#if defined(WINDOWS_BUILD)
+    DeleteCriticalSection(mpLock);
+#else
+    pthread_mutex_destroy(mpLock);
+#endif
+    delete mpLock;
+}
+
+ForthCycleCollector* ForthCycleCollector::GetInstance()
+{
+    if (mpInstance == nullptr)
+    {
+        mpInstance = new ForthCycleCollector;
+    }
+    return mpInstance;
+}
+
+void ForthCycleCollector::Lock()
+{
+#if defined(WINDOWS_BUILD)
+    EnterCriticalSection(mpLock);
+#else
+    pthread_mutex_lock(mpLock);
+#endif
+}
+
+void ForthCycleCollector::Unlock()
+{
+#if defined(WINDOWS_BUILD)
+    LeaveCriticalSection(mpLock);
+#else
+    pthread_mutex_unlock(mpLock);
+#endif
+}
+
+void ForthCycleCollector::SetEnabled(bool enabled)
+{
+    Lock();
+    gCycleCollectorEnabled = enabled;
+    if (!enabled)
+    {
+        mPossibleRoots.clear();
+        mCollectionPending = false;
+    }
+    Unlock();
+}
+
+// objects whose class doesn't opt in may hold uncounted references in ordinary fields, which would
+//  make trial deletion think their targets are garbage, so like shared objects they are always live
+static bool IsCycleCollectable(ForthObject obj)
+{
+    if (OBJECT_IS_SHARED(obj))
+    {
+        return false;
+    }
+    ForthClassObject* pClassObject = GET_CLASS_OBJECT(obj);
+    return pClassObject->pVocab->IsCycleCollectable();
+}
+
+void ForthCycleCollector::AddPossibleRoot(ForthCoreState* pCore, ForthObject obj)
+{
+    if (!IsCycleCollectable(obj))
+    {
+        return;
+    }
+    ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+    ForthThread* pThread = (pFiber != nullptr) ? pFiber->GetParent() : nullptr;
+    Lock();
+    mPossibleRoots[obj] = pThread;
+    if (mPossibleRoots.size() >= mRootThreshold)
+    {
+        mCollectionPending = true;
+    }
+    Unlock();
+}
+
+void ForthCycleCollector::FreeObject(void* pObj)
+{
+    Lock();
+    if (!mPossibleRoots.empty())
+    {
+        mPossibleRoots.erase((ForthObject)pObj);
+    }
+    if (mCollecting)
+    {
+        // garbage objects can still be referenced by other garbage objects until all
+        //  garbage delete methods have run, so don't free memory until then
+        mDeferredFrees.push_back(pObj);
+        pObj = nullptr;
+    }
+    Unlock();
+    if (pObj != nullptr)
+    {
+        __FREE(pObj);
+    }
+}
+
+namespace
+{
+    typedef std::map<ForthObject, cell> trialCountMap;
+
+    struct trialDeletionState
+    {
+        trialCountMap               counts;
+        std::vector<ForthObject>    pending;
+    };
+
+    // subtract references from inside the subgraph being examined from its trial refcounts
+    void trialDecrementVisitor(ForthObject& child, void* pUserData)
+    {
+        if (!IsCycleCollectable(child))
+        {
+            return;
+        }
+        trialDeletionState* pState = (trialDeletionState *)pUserData;
+        trialCountMap::iterator iter = pState->counts.find(child);
+        if (iter == pState->counts.end())
+        {
+            iter = pState->counts.insert(std::make_pair(child, (cell)OBJECT_REFCOUNT(child))).first;
+            pState->pending.push_back(child);
+        }
+        iter->second -= 1;
+    }
+
+    // mark objects reachable from live objects as live
+    void markLiveVisitor(ForthObject& child, void* pUserData)
+    {
+        trialDeletionState* pState = (trialDeletionState *)pUserData;
+        trialCountMap::iterator iter = pState->counts.find(child);
+        if (iter != pState->counts.end() && iter->second <= 0)
+        {
+            iter->second = 1;
+            pState->pending.push_back(child);
+        }
+    }
+
+    void countStackReferences(trialCountMap& counts, const cell* pStart, const cell* pEnd)
+    {
+        while (pStart < pEnd)
+        {
+            trialCountMap::iterator iter = counts.find((ForthObject)(*pStart));
+            if (iter != counts.end())
+            {
+                iter->second += 1;
+            }
+            pStart++;
+        }
+    }
+}
+
+ucell ForthCycleCollector::Collect(ForthCoreState* pCore)
+{
+    ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+    ForthThread* pThread = (pFiber != nullptr) ? pFiber->GetParent() : nullptr;
+    trialDeletionState state;
+
+    Lock();
+    if (mCollecting)
+    {
+        Unlock();
+        return 0;
+    }
+    mCollectionPending = false;
+    std::map<ForthObject, ForthThread*>::iterator rootIter = mPossibleRoots.begin();
+    while (rootIter != mPossibleRoots.end())
+    {
+        if (rootIter->second == pThread)
+        {
+            ForthObject root = rootIter->first;
+            if (IsCycleCollectable(root) && state.counts.find(root) == state.counts.end())
+            {
+                state.counts[root] = (cell)OBJECT_REFCOUNT(root);
+                state.pending.push_back(root);
+            }
+            rootIter = mPossibleRoots.erase(rootIter);
+        }
+        else
+        {
+            ++rootIter;
+        }
+    }
+    mCollecting = true;
+    Unlock();
+
+    // find the subgraph reachable from the possible roots, and for each object in it compute
+    //  its refcount minus the references from inside the subgraph
+    while (!state.pending.empty())
+    {
+        ForthObject obj = state.pending.back();
+        state.pending.pop_back();
+        ForthVisitObjectChildren(obj, trialDecrementVisitor, &state);
+    }
+
+    // objects on the stacks aren't refcounted, so treat any stack cell which
+    //  matches an object in the subgraph as an outside reference to it
+    if (pThread != nullptr)
+    {
+        int fiberIndex = 0;
+        ForthFiber* pStackFiber;
+        while ((pStackFiber = pThread->GetFiber(fiberIndex++)) != nullptr)
+        {
+            ForthCoreState* pStackCore = pStackFiber->GetCore();
+            countStackReferences(state.counts, pStackCore->SP, pStackCore->ST);
+            countStackReferences(state.counts, pStackCore->RP, pStackCore->RT);
+            countStackReferences(state.counts, (cell *)&(pStackCore->TP), ((cell *)&(pStackCore->TP)) + 1);
+        }
+    }
+    else
+    {
+        countStackReferences(state.counts, pCore->SP, pCore->ST);
+        countStackReferences(state.counts, pCore->RP, pCore->RT);
+        countStackReferences(state.counts, (cell *)&(pCore->TP), ((cell *)&(pCore->TP)) + 1);
+    }
+
+    // objects with outside references are live, and so is everything they reference
+    for (trialCountMap::iterator iter = state.counts.begin(); iter != state.counts.end(); ++iter)
+    {
+        if (iter->second > 0)
+        {
+            state.pending.push_back(iter->first);
+        }
+    }
+    while (!state.pending.empty())
+    {
+        ForthObject obj = state.pending.back();
+        state.pending.pop_back();
+        ForthVisitObjectChildren(obj, markLiveVisitor, &state);
+    }
+
+    // what remains is garbage which is only referenced by other garbage
+    std::vector<ForthObject> garbage;
+    for (trialCountMap::iterator iter = state.counts.begin(); iter != state.counts.end(); ++iter)
+    {
+        if (iter->second <= 0)
+        {
+            garbage.push_back(iter->first);
+        }
+    }
+
+    if (!garbage.empty())
+    {
+        mLastDeletedClasses.clear();
+        // give garbage objects huge refcounts so that releases done by garbage delete methods
+        //  on other garbage objects don't delete them a second time
+        for (ucell i = 0; i < garbage.size(); i++)
+        {
+            ForthObject obj = garbage[i];
+            ForthClassObject* pClassObject = GET_CLASS_OBJECT(obj);
+            mLastDeletedClasses[pClassObject->pVocab->GetName()] += 1;
+            obj->refCount = UNDELETABLE_OBJECT_REFCOUNT;
+        }
+        for (ucell i = 0; i < garbage.size(); i++)
+        {
+            FULLY_EXECUTE_METHOD(pCore, garbage[i], kMethodDelete);
+        }
+    }
+
+    Lock();
+    mCollecting = false;
+    std::vector<void*> deferredFrees;
+    deferredFrees.swap(mDeferredFrees);
+    // garbage delete methods releasing other garbage objects may have re-added them as roots
+    for (ucell i = 0; i < deferredFrees.size(); i++)
+    {
+        mPossibleRoots.erase((ForthObject)(deferredFrees[i]));
+    }
+    mNumCollections++;
+    mTotalDeleted += garbage.size();
+    Unlock();
+
+    for (ucell i = 0; i < deferredFrees.size(); i++)
+    {
+        __FREE(deferredFrees[i]);
+    }
+
+    return garbage.size();
+}
+
+void ForthCycleCollector::ShowStats(ForthCoreState* pCore)
+{
+    ForthEngine* pEngine = ForthEngine::GetInstance();
+    char buffer[256];
+
+    Lock();
+    sprintf(buffer, "cycle collector %s: %d possible roots, %d collections, %d objects deleted\n",
+        (gCycleCollectorEnabled ? "enabled" : "disabled"), (int)mPossibleRoots.size(),
+        (int)mNumCollections, (int)mTotalDeleted);
+    std::map<std::string, ucell> lastDeleted(mLastDeletedClasses);
+    Unlock();
+
+    pEngine->ConsoleOut(buffer);
+    if (!lastDeleted.empty())
+    {
+        pEngine->ConsoleOut("last objects deleted:\n");
+        for (std::map<std::string, ucell>::iterator iter = lastDeleted.begin(); iter != lastDeleted.end(); ++iter)
+        {
+            sprintf(buffer, "  %s: %d\n", iter->first.c_str(), (int)iter->second);
+            pEngine->ConsoleOut(buffer);
+        }
+    }
+}
+
+
 //////////////////////////////////////////////////////////////////////
 ////
 ///     ForthForgettableGlobalObject - handles forgetting of global forth objects
@@ -511,6 +919,9 @@ ForthTypesManager::AddBuiltinClasses(ForthEngine* pEngine)
     ODeque::AddClasses(pEngine);
     OList::AddClasses(pEngine);
 	OMap::AddClasses(pEngine);
+    OHashMap::AddClasses(pEngine);
+    OTreeMap::AddClasses(pEngine);
+    OCsvReader::AddClasses(pEngine);
 	OString::AddClasses(pEngine);
 	OStream::AddClasses(pEngine);
     OBlockFile::AddClasses(pEngine);
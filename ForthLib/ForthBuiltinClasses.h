@@ -6,6 +6,11 @@
 //////////////////////////////////////////////////////////////////////
 
 #include <vector>
+#include <map>
+#include <string>
+#if defined(LINUX) || defined(MACOSX)
+#include <pthread.h>
+#endif
 
 #include "ForthForgettable.h"
 #include "ForthObject.h"
@@ -94,6 +99,31 @@ typedef enum
     kBCIBagIter,
     kBCISocket,
     kBCIShellStack,
+    kBCIHashMap,
+    kBCIHashMapIter,
+    kBCIIntHashMap,
+    kBCIIntHashMapIter,
+    kBCILongHashMap,
+    kBCILongHashMapIter,
+    kBCIStringHashMap,
+    kBCIStringHashMapIter,
+    kBCIColumnArray,
+    kBCIIntTreeMap,
+    kBCIIntTreeMapIter,
+    kBCILongTreeMap,
+    kBCILongTreeMapIter,
+    kBCIDoubleTreeMap,
+    kBCIDoubleTreeMapIter,
+    kBCIStringTreeMap,
+    kBCIStringTreeMapIter,
+    kBCIQueue,
+    kBCISPSCQueue,
+    kBCILongPriorityQueue,
+    kBCIDoublePriorityQueue,
+    kBCIStringView,
+    kBCIStringBuilder,
+    kBCICsvReader,
+    kBCIInternedString,
 	kNumBuiltinClasses		// must be last
 } eBuiltinClassIndex;
 
@@ -101,6 +131,64 @@ typedef enum
 bool ForthShowAlreadyShownObject(ForthObject obj, ForthCoreState* pCore, bool addIfUnshown);
 void ForthShowObject(ForthObject& obj, ForthCoreState* pCore);
 
+// ObjectVisitor is called on each object which is directly referenced by another object
+typedef void(*ObjectVisitor)(ForthObject& child, void* pUserData);
+// a CustomChildVisitor calls visitor on all objects directly referenced by a builtin class object,
+//  it is needed for classes whose object references are not declared as member vars (container classes)
+typedef void(*CustomChildVisitor)(ForthObject& obj, ObjectVisitor visitor, void* pUserData);
+
+// call visitor on each non-null object directly referenced by obj
+//  objects in weak member fields are passed to weakVisitor instead, and are skipped if it is null
+void ForthVisitObjectChildren(ForthObject& obj, ObjectVisitor visitor, void* pUserData, ObjectVisitor weakVisitor = nullptr);
+// mark obj and all objects reachable from it as shared between threads
+void ForthShareObject(ForthObject& obj);
+
+class ForthThread;
+
+// ForthCycleCollector finds and deletes cycles of garbage objects which refcounting can't reclaim,
+//   using synchronous trial deletion (Bacon & Rajan).  While it is enabled, objects whose refcount
+//   is decremented to nonzero are recorded as possible roots of garbage cycles, when the number of
+//   possible roots reaches the threshold a collection is done at the next safe point (fiber switch
+//   or end of interpreted line).  Only roots recorded by the collecting thread are considered, and
+//   shared objects and objects of classes which haven't opted in with cycleCollectable are treated
+//   as always live.
+class ForthCycleCollector
+{
+public:
+    ForthCycleCollector();
+    ~ForthCycleCollector();
+    static ForthCycleCollector* GetInstance();
+
+    void                SetEnabled(bool enabled);
+    inline void         SetRootThreshold(ucell numRoots) { mRootThreshold = numRoots; }
+    void                AddPossibleRoot(ForthCoreState* pCore, ForthObject obj);
+    void                FreeObject(void* pObj);
+    // returns number of objects deleted
+    ucell               Collect(ForthCoreState* pCore);
+    inline void         CollectIfPending(ForthCoreState* pCore) { if (mCollectionPending) { Collect(pCore); } }
+    void                ShowStats(ForthCoreState* pCore);
+
+protected:
+    void                Lock();
+    void                Unlock();
+
+    std::map<ForthObject, ForthThread*> mPossibleRoots;
+    std::vector<void*>  mDeferredFrees;
+    ucell               mRootThreshold;
+    volatile bool       mCollectionPending;
+    bool                mCollecting;
+    ucell               mNumCollections;
+    ucell               mTotalDeleted;
+    // object counts by class name for the last collection which found garbage
+    std::map<std::string, ucell> mLastDeletedClasses;
+#if defined(WINDOWS_BUILD)
+    CRITICAL_SECTION*   mpLock;
+#else
+    pthread_mutex_t*    mpLock;
+#endif
+    static ForthCycleCollector* mpInstance;
+};
+
 extern "C"
 {
     extern FORTHOP(unimplementedMethodOp);
@@ -128,6 +216,26 @@ struct OutStreamFuncs
 };
 
 
+// output streams with native output routines can have a user space buffer which is written
+//   out with a single outBytes call when it fills up or is flushed
+#define OUT_BUFFER_FLUSH_ON_NEWLINE     1
+// flush when the fiber which wrote to the buffer yields, blocks or exits
+#define OUT_BUFFER_FLUSH_ON_YIELD       2
+
+struct oOutStreamStruct;
+
+struct ForthOutBuffer
+{
+	char*				pData;
+	int					size;
+	int					used;
+	int					flags;
+	// fiber whose pending list this buffer is on, and next buffer in that list
+	ForthFiber*			pPendingFiber;
+	ForthOutBuffer*		pNextPending;
+	oOutStreamStruct*	pStream;
+};
+
 struct oOutStreamStruct
 {
     forthop*            pMethods;
@@ -135,6 +243,7 @@ struct oOutStreamStruct
 	void*               pUserData;
 	OutStreamFuncs*     pOutFuncs;
 	char				eolChars[4];
+	ForthOutBuffer*		pOutBuffer;
 };
 
 struct oStringOutStreamStruct
@@ -149,6 +258,8 @@ struct InStreamFuncs
     streamBytesInRoutine		inBytes;
     streamLineInRoutine		    inLine;
     streamStringInRoutine		inString;
+    // optional, null for streams which can't be mapped
+    streamMappedInRoutine       inMapped;
 };
 
 
@@ -182,19 +293,26 @@ struct oArrayStruct
 	oArray*     elements;
 };
 
+// lists are unrolled, each node holds up to LIST_NODE_CAPACITY objects in objs[0 ... count-1],
+//   nodes are never empty.  With 13 objects a node is 128 bytes in 64-bit builds.
+#define LIST_NODE_CAPACITY 13
+
 struct oListElement
 {
 	oListElement*	prev;
 	oListElement*	next;
-	ForthObject		obj;
+	ucell			count;
+	ForthObject		objs[LIST_NODE_CAPACITY];
 };
 
+// modCount changes whenever objects are removed from the list or moved to other positions
 struct oListStruct
 {
     forthop*        pMethods;
     ucell			refCount;
 	oListElement*	head;
 	oListElement*	tail;
+	ucell			modCount;
 };
 
 struct oArrayIterStruct
@@ -350,6 +350,7 @@ ForthEngine::ForthEngine()
 #endif
 
 	mDictionary.pBase = nullptr;
+    mDictionaryHugePages = false;
 
     // At this point, the main thread does not exist, it will be created later in Initialize, this
     // is fairly screwed up, it is becauses originally ForthEngine was the center of the universe,
@@ -376,13 +377,20 @@ ForthEngine::~ForthEngine()
 
     if (mDictionary.pBase)
     {
+        if (mDictionaryHugePages)
+        {
+            freeHugePages(mDictionary.pBase, mDictionary.len * sizeof(forthop));
+        }
+        else
+        {
 #ifdef WIN32
-		VirtualFree( mDictionary.pBase, 0, MEM_RELEASE );
+            VirtualFree( mDictionary.pBase, 0, MEM_RELEASE );
 #elif MACOSX
-        munmap(mDictionary.pBase, mDictionary.len * sizeof(long));
+            munmap(mDictionary.pBase, mDictionary.len * sizeof(long));
 #else
-        __FREE( mDictionary.pBase );
+            __FREE( mDictionary.pBase );
 #endif
+        }
 		delete mpForthVocab;
         delete mpLiteralsVocab;
         delete mpLocalVocab;
@@ -462,15 +470,24 @@ ForthEngine::Initialize( ForthShell*        pShell,
     mBlockFileManager = new ForthBlockFileManager(mpShell->GetBlockfilePath());
 
     size_t dictionarySize = totalLongs * sizeof(forthop);
+    if (__useHugePages)
+    {
+        // dictionary must be executable for code generated by the forth assembler
+        mDictionary.pBase = (forthop *) allocateHugePages( dictionarySize, true );
+        mDictionaryHugePages = (mDictionary.pBase != nullptr);
+    }
+    if (!mDictionaryHugePages)
+    {
 #ifdef WIN32
-	void* dictionaryAddress = NULL;
-	// we need to allocate memory that is immune to Data Execution Prevention
-	mDictionary.pBase = (forthop *) VirtualAlloc( dictionaryAddress, dictionarySize, (MEM_COMMIT | MEM_RESERVE), PAGE_EXECUTE_READWRITE );
+        void* dictionaryAddress = NULL;
+        // we need to allocate memory that is immune to Data Execution Prevention
+        mDictionary.pBase = (forthop *) VirtualAlloc( dictionaryAddress, dictionarySize, (MEM_COMMIT | MEM_RESERVE), PAGE_EXECUTE_READWRITE );
 #elif MACOSX
-    mDictionary.pBase = (forthop *) mmap(NULL, dictionarySize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, -1, 0);
+        mDictionary.pBase = (forthop *) mmap(NULL, dictionarySize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, -1, 0);
 #else
-	 mDictionary.pBase = (forthop *) __MALLOC( dictionarySize );
+        mDictionary.pBase = (forthop *) __MALLOC( dictionarySize );
 #endif
+    }
     mDictionary.pCurrent = mDictionary.pBase;
     mDictionary.len = totalLongs;
 
@@ -723,6 +740,8 @@ ForthEngine::AddBuiltinClass(const char* pClassName, eBuiltinClassIndex classInd
         // do "extends" - tie into parent class
         pManager->GetNewestClass()->Extends( pParentClass );
     }
+    // all object references held by builtin classes are refcounted, so they can be cycle collected
+    pVocab->SetCycleCollectable( true );
 
     // loop through pEntries, adding ops to builtinOps table and adding methods to class
     while ( pEntries->name != NULL )
@@ -2540,7 +2559,17 @@ ForthEngine::ExecuteOps(ForthCoreState* pCore, forthop *pOps)
 
     savedIP = pCore->IP;
     pCore->IP = pOps;
-    mpMainThread->InnerLoop();
+    // the ops must run on the fiber which owns pCore, which is not the main fiber when
+    //   ops like new are used by other threads
+    ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+    if (pFiber != nullptr)
+    {
+        pFiber->GetParent()->InnerLoop(pFiber);
+    }
+    else
+    {
+        mpMainThread->InnerLoop(mpMainThread->GetFiber(0));
+    }
     eForthResult exitStatus = (eForthResult)pCore->state;
 
 	pCore->IP = savedIP;
@@ -43,6 +43,7 @@ typedef enum {
     kEngineFlagInClassDefinition         = 0x20,
     //kEngineFlagAnsiMode                = 0x40,
     kEngineFlagNoNameDefinition          = 0x80,
+    kEngineFlagIsWeak                    = 0x100,
 } FECompileFlags;
 
     //long                *DP;            // dictionary pointer
@@ -327,6 +328,7 @@ public:
     void					SetAuxOut(ForthCoreState* pCore, ForthObject& newOutStream);
     void					PushConsoleOut( ForthCoreState* pCore );
 	void					PushDefaultConsoleOut( ForthCoreState* pCore );
+    inline ForthObject&     GetDefaultConsoleOut() { return mDefaultConsoleOutStream; }
     void                    PushAuxOut(ForthCoreState* pCore);
 	void					ResetConsoleOut( ForthCoreState& core );
 
@@ -387,6 +389,7 @@ protected:
     ForthCoreState*  mpCore;             // core inner interpreter state
 
     ForthMemorySection mDictionary;
+    bool        mDictionaryHugePages;   // true if dictionary was allocated with allocateHugePages
 
 	ForthEngineTokenStack mTokenStack;		// contains tokens which will be gotten by GetNextSimpleToken instead of from input stream
 
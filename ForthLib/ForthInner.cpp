@@ -1529,9 +1529,9 @@ static void _doObjectVarop( ForthCoreState* pCore, ForthObject* pVar )
 			PUSH_OBJECT(oldObj);
 			if (oldObj != nullptr)
 			{
-				if (oldObj->refCount > 0)
+				if (OBJECT_REFCOUNT(oldObj) > 0)
 				{
-                    oldObj->refCount -= 1;
+                    DECREMENT_REFCOUNT(oldObj);
 				}
 				else
 				{
@@ -476,9 +476,16 @@ ForthFileInputStream::ForthFileInputStream( FILE *pInFile, const char *pFilename
 , mpInFile( pInFile )
 , mLineNumber( 0 )
 , mLineStartOffset( 0 )
+, mMappedPos( 0 )
 {
 	mpName = (char *)__MALLOC(strlen(pFilename) + 1);
     strcpy( mpName, pFilename );
+    // internal files start partway into the file
+    long startPos = ftell( mpInFile );
+    if ( (startPos >= 0) && mMappedFile.Map( mpInFile ) )
+    {
+        mMappedPos = (size_t) startPos;
+    }
 }
 
 ForthFileInputStream::~ForthFileInputStream()
@@ -498,11 +505,49 @@ ForthFileInputStream::GetName( void )
 }
 
 
+char *
+ForthFileInputStream::GetMappedLine()
+{
+    size_t fileSize = mMappedFile.Size();
+    if ( mMappedPos >= fileSize )
+    {
+        return NULL;
+    }
+    mLineStartOffset = (unsigned int) mMappedPos;
+
+    // like fgets, a line longer than the buffer comes back in pieces
+    const char* pSrc = mMappedFile.Data() + mMappedPos;
+    size_t numBytes = fileSize - mMappedPos;
+    if ( numBytes > (size_t)(mBufferLen - 1) )
+    {
+        numBytes = mBufferLen - 1;
+    }
+    const char* pEOL = (const char *) memchr( pSrc, '\n', numBytes );
+    size_t lineBytes = (pEOL != NULL) ? (pEOL - pSrc) : numBytes;
+    mMappedPos += (pEOL != NULL) ? (lineBytes + 1) : lineBytes;
+    if ( (pEOL != NULL) && (lineBytes > 0) && (pSrc[lineBytes - 1] == '\r') )
+    {
+        // files are mapped in binary mode, so DOS line ends are still there
+        --lineBytes;
+    }
+    memcpy( mpBufferBase, pSrc, lineBytes );
+    mpBufferBase[ lineBytes ] = '\0';
+    mReadOffset = 0;
+    mWriteOffset = (int) lineBytes;
+    mLineNumber++;
+    return mpBufferBase;
+}
+
 char *
 ForthFileInputStream::GetLine( const char *pPrompt )
 {
     char *pBuffer;
 
+    if ( mMappedFile.IsMapped() )
+    {
+        return GetMappedLine();
+    }
+
     mLineStartOffset = ftell( mpInFile );
 
     pBuffer = fgets( mpBufferBase, mBufferLen, mpInFile );
@@ -577,7 +622,11 @@ ForthFileInputStream::SetInputState( cell* pState)
         // TODO: report restore-input error - input object mismatch
         return false;
     }
-    if ( fseek( mpInFile, pState[5], SEEK_SET )  != 0 )
+    if ( mMappedFile.IsMapped() )
+    {
+        mMappedPos = (size_t) pState[5];
+    }
+    else if ( fseek( mpInFile, pState[5], SEEK_SET )  != 0 )
     {
         // TODO: report restore-input error - error seeking to beginning of line
         return false;
@@ -855,6 +904,8 @@ ForthBlockInputStream::ForthBlockInputStream(ForthBlockFileManager* pManager, un
 {
     mReadOffset = BYTES_PER_BLOCK;
     mWriteOffset = BYTES_PER_BLOCK;
+    // blocks are about to be read in order, get them into the cache together
+    mpManager->ReadAhead( firstBlock, lastBlock );
     ReadBlock();
 }
 
@@ -965,23 +1016,11 @@ ForthBlockInputStream::ReadBlock()
 {
     bool success = true;
     ForthEngine* pEngine = ForthEngine::GetInstance();
-    FILE * pInFile = mpManager->OpenBlockFile(false);
-    if ( pInFile == NULL )
+    if ( !mpManager->CopyBlock( mCurrentBlock, mpBufferBase, BYTES_PER_BLOCK ) )
     {
-        pEngine->SetError( kForthErrorIO, "BlockInputStream - failed to open block file" );
+        pEngine->SetError( kForthErrorIO, "BlockInputStream - failed to read block file" );
         success = false;
     }
-    else
-    {
-        fseek( pInFile, BYTES_PER_BLOCK * mCurrentBlock, SEEK_SET );
-        int numRead = fread( mpBufferBase, BYTES_PER_BLOCK, 1, pInFile );
-        if ( numRead != 1 )
-        {
-            pEngine->SetError( kForthErrorIO, "BlockInputStream - failed to read block file" );
-            success = false;
-        }
-        fclose( pInFile );
-    }
     return success;
 }
 
@@ -105,11 +105,16 @@ public:
     virtual bool	IsFile();
 
 protected:
+    // regular files are read through a mapping, others with fgets
+    char*           GetMappedLine();
+
     FILE            *mpInFile;
     char*           mpName;
     int             mLineNumber;
     unsigned int    mLineStartOffset;
     cell            mState[8];
+    ForthMappedFile mMappedFile;
+    size_t          mMappedPos;
 };
 
 // save-input items:
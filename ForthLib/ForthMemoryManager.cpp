@@ -9,14 +9,25 @@
 #include "ForthEngine.h"
 
 #if defined(LINUX) || defined(MACOSX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#elif defined(WIN32)
+#include <io.h>
 #endif
 
 bool __useStandardMemoryAllocation = true;
+bool __useHugePages = false;
 
 ForthMemoryManager* s_memoryManager = nullptr;
 
 void initMemoryAllocation()
 {
+    const char* pHugePages = getenv("FORTH_HUGE_PAGES");
+    if ((pHugePages != nullptr) && (atoi(pHugePages) != 0))
+    {
+        __useHugePages = true;
+    }
+
     if (__useStandardMemoryAllocation)
     {
         s_memoryManager = new PassThruMemoryManager;
@@ -89,3 +100,406 @@ void DebugPassThruMemoryManager::free(void* pBlock)
     ::free(pBlock);
 }
 
+
+
+//////////////////////////////////////////////////////////////////////
+////
+///     huge page allocation
+//
+//
+
+static size_t roundUpToHugePages(size_t numBytes)
+{
+    return (numBytes + (HUGE_PAGE_BYTES - 1)) & ~((size_t)(HUGE_PAGE_BYTES - 1));
+}
+
+void* allocateHugePages(size_t numBytes, bool executable)
+{
+    size_t mappedBytes = roundUpToHugePages(numBytes);
+    void* pBlock = nullptr;
+#if defined(WIN32)
+    DWORD protection = executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+    SIZE_T largePageBytes = GetLargePageMinimum();
+    if (largePageBytes != 0)
+    {
+        // this only succeeds if the process has SeLockMemoryPrivilege
+        SIZE_T largeBytes = (numBytes + (largePageBytes - 1)) & ~(largePageBytes - 1);
+        pBlock = VirtualAlloc(NULL, largeBytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, protection);
+    }
+    if (pBlock == nullptr)
+    {
+        pBlock = VirtualAlloc(NULL, mappedBytes, MEM_RESERVE | MEM_COMMIT, protection);
+    }
+#elif defined(LINUX) || defined(MACOSX)
+    int protection = PROT_READ | PROT_WRITE | (executable ? PROT_EXEC : 0);
+#ifdef MAP_HUGETLB
+    // explicit huge pages only exist if they have been reserved through /proc/sys/vm/nr_hugepages
+    pBlock = mmap(NULL, mappedBytes, protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (pBlock == MAP_FAILED)
+    {
+        pBlock = nullptr;
+    }
+#endif
+    if (pBlock == nullptr)
+    {
+        // over-allocate so the block can be aligned on a huge page boundary, which is
+        //  needed for the kernel to back it with transparent huge pages
+        size_t reservedBytes = mappedBytes + HUGE_PAGE_BYTES;
+        char* pReserved = (char*)mmap(NULL, reservedBytes, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pReserved != (char*)MAP_FAILED)
+        {
+            char* pAligned = (char*)(((size_t)pReserved + (HUGE_PAGE_BYTES - 1)) & ~((size_t)(HUGE_PAGE_BYTES - 1)));
+            size_t headBytes = pAligned - pReserved;
+            size_t tailBytes = reservedBytes - (headBytes + mappedBytes);
+            if (headBytes != 0)
+            {
+                munmap(pReserved, headBytes);
+            }
+            if (tailBytes != 0)
+            {
+                munmap(pAligned + mappedBytes, tailBytes);
+            }
+#ifdef MADV_HUGEPAGE
+            madvise(pAligned, mappedBytes, MADV_HUGEPAGE);
+#endif
+            pBlock = pAligned;
+        }
+    }
+#else
+    pBlock = ::malloc(numBytes);
+#endif
+    return pBlock;
+}
+
+void freeHugePages(void* pBlock, size_t numBytes)
+{
+    if (pBlock == nullptr)
+    {
+        return;
+    }
+#if defined(WIN32)
+    VirtualFree(pBlock, 0, MEM_RELEASE);
+#elif defined(LINUX) || defined(MACOSX)
+    munmap(pBlock, roundUpToHugePages(numBytes));
+#else
+    ::free(pBlock);
+#endif
+}
+
+ForthMappedFile::ForthMappedFile()
+    : mpData(nullptr)
+    , mSize(0)
+    , mbMapped(false)
+    , mbWritable(false)
+    , mbCopyOnWrite(false)
+{
+}
+
+ForthMappedFile::~ForthMappedFile()
+{
+    Unmap();
+}
+
+bool ForthMappedFile::Map(FILE* pFile)
+{
+    return MapFile(pFile, 0, false, false);
+}
+
+bool ForthMappedFile::MapWritable(FILE* pFile, size_t minSize)
+{
+    return MapFile(pFile, minSize, true, false);
+}
+
+bool ForthMappedFile::MapCopyOnWrite(FILE* pFile)
+{
+    return MapFile(pFile, 0, false, true);
+}
+
+bool ForthMappedFile::MapFile(FILE* pFile, size_t minSize, bool writable, bool copyOnWrite)
+{
+    Unmap();
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+    if (writable)
+    {
+        // anything stdio is holding must be in the file before it is mapped
+        fflush(pFile);
+    }
+#if defined(WIN32)
+    HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(pFile));
+    LARGE_INTEGER fileSize;
+    if ((hFile == INVALID_HANDLE_VALUE) || (GetFileType(hFile) != FILE_TYPE_DISK)
+        || !GetFileSizeEx(hFile, &fileSize))
+    {
+        return false;
+    }
+    mSize = (size_t)fileSize.QuadPart;
+    if (writable && (mSize < minSize))
+    {
+        // a read-write mapping larger than the file extends the file
+        mSize = minSize;
+    }
+    if (mSize != 0)
+    {
+        HANDLE hMapping = CreateFileMapping(hFile, NULL, writable ? PAGE_READWRITE : (copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY),
+            (DWORD)(((uint64_t)mSize) >> 32), (DWORD)mSize, NULL);
+        if (hMapping == NULL)
+        {
+            mSize = 0;
+            return false;
+        }
+        // the view keeps the mapping object alive
+        mpData = (const char*)MapViewOfFile(hMapping, writable ? FILE_MAP_WRITE : (copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ), 0, 0, 0);
+        CloseHandle(hMapping);
+        if (mpData == nullptr)
+        {
+            mSize = 0;
+            return false;
+        }
+    }
+#elif defined(LINUX) || defined(MACOSX)
+    struct stat fileStat;
+    if ((fstat(fileno(pFile), &fileStat) != 0) || !S_ISREG(fileStat.st_mode))
+    {
+        return false;
+    }
+    mSize = (size_t)fileStat.st_size;
+    if (writable && (mSize < minSize))
+    {
+        if (ftruncate(fileno(pFile), (off_t)minSize) != 0)
+        {
+            mSize = 0;
+            return false;
+        }
+        mSize = minSize;
+    }
+    if (mSize != 0)
+    {
+        void* pMapping = mmap(NULL, mSize, (writable || copyOnWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ,
+            copyOnWrite ? MAP_PRIVATE : MAP_SHARED, fileno(pFile), 0);
+        if (pMapping == MAP_FAILED)
+        {
+            mSize = 0;
+            return false;
+        }
+#ifdef MADV_SEQUENTIAL
+        if (!writable && !copyOnWrite)
+        {
+            // files are mostly read front to back, let the kernel read ahead aggressively
+            madvise(pMapping, mSize, MADV_SEQUENTIAL);
+        }
+#endif
+        mpData = (const char*)pMapping;
+    }
+#else
+    return false;
+#endif
+    mbMapped = true;
+    mbWritable = writable;
+    mbCopyOnWrite = copyOnWrite;
+    return true;
+}
+
+bool ForthMappedFile::Sync()
+{
+    if (!mbWritable || (mpData == nullptr))
+    {
+        return true;
+    }
+#if defined(WIN32)
+    return FlushViewOfFile(mpData, 0) != 0;
+#elif defined(LINUX) || defined(MACOSX)
+    return msync((void*)mpData, mSize, MS_SYNC) == 0;
+#else
+    return false;
+#endif
+}
+
+void ForthMappedFile::Unmap()
+{
+    if (mpData != nullptr)
+    {
+#if defined(WIN32)
+        UnmapViewOfFile(mpData);
+#elif defined(LINUX) || defined(MACOSX)
+        munmap((void*)mpData, mSize);
+#endif
+    }
+    mpData = nullptr;
+    mSize = 0;
+    mbMapped = false;
+    mbWritable = false;
+    mbCopyOnWrite = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     ForthMappedArrayStorage
+//
+
+ForthMappedArrayStorage::ForthMappedArrayStorage()
+    : mpFile(nullptr)
+    , mbWritable(false)
+    , mFileSize(0)
+    , mpOpenedView(nullptr)
+{
+}
+
+ForthMappedArrayStorage::~ForthMappedArrayStorage()
+{
+    Close(mFileSize);
+}
+
+bool ForthMappedArrayStorage::Open(const char* pPath, bool writable)
+{
+    Close(mFileSize);
+    mpFile = fopen(pPath, writable ? "r+b" : "rb");
+    if ((mpFile == nullptr) && writable)
+    {
+        mpFile = fopen(pPath, "w+b");
+    }
+    if (mpFile == nullptr)
+    {
+        return false;
+    }
+
+    mbWritable = writable;
+    mpOpenedView = new ForthMappedFile;
+    bool isMapped = writable ? mpOpenedView->MapWritable(mpFile, 0) : mpOpenedView->MapCopyOnWrite(mpFile);
+    if (!isMapped)
+    {
+        Close(0);
+        return false;
+    }
+    mFileSize = mpOpenedView->Size();
+    if (!writable)
+    {
+        // a copy-on-write mapping stays valid after the file is closed, and never changes the file
+        fclose(mpFile);
+        mpFile = nullptr;
+    }
+    return true;
+}
+
+void ForthMappedArrayStorage::Close(size_t numUsedBytes)
+{
+    delete mpOpenedView;
+    mpOpenedView = nullptr;
+    for (ForthMappedFile* pView : mViews)
+    {
+        delete pView;
+    }
+    mViews.clear();
+
+    if (mpFile != nullptr)
+    {
+        if (mbWritable && (numUsedBytes < mFileSize))
+        {
+            // the file was extended in steps as the vector grew, cut off the unused part
+#if defined(WIN32)
+            _chsize_s(_fileno(mpFile), (__int64)numUsedBytes);
+#elif defined(LINUX) || defined(MACOSX)
+            if (ftruncate(fileno(mpFile), (off_t)numUsedBytes) == 0)
+            {
+                mFileSize = numUsedBytes;
+            }
+#endif
+        }
+        fclose(mpFile);
+        mpFile = nullptr;
+    }
+    mbWritable = false;
+    mFileSize = 0;
+}
+
+bool ForthMappedArrayStorage::Sync(size_t numUsedBytes)
+{
+    if (!mbWritable)
+    {
+        return true;
+    }
+    bool itWorked = true;
+    for (ForthMappedFile* pView : mViews)
+    {
+        itWorked = pView->Sync() && itWorked;
+    }
+#if defined(LINUX) || defined(MACOSX)
+    // windows can't cut a file which is mapped, there the file is cut when it is closed
+    if (numUsedBytes < mFileSize)
+    {
+        if (ftruncate(fileno(mpFile), (off_t)numUsedBytes) == 0)
+        {
+            mFileSize = numUsedBytes;
+        }
+        else
+        {
+            itWorked = false;
+        }
+    }
+#endif
+    return itWorked;
+}
+
+void* ForthMappedArrayStorage::Allocate(size_t numBytes)
+{
+    if (mpOpenedView != nullptr)
+    {
+        ForthMappedFile* pView = mpOpenedView;
+        mpOpenedView = nullptr;
+        if ((numBytes <= pView->Size()) && (pView->WritableData() != nullptr))
+        {
+            mViews.push_back(pView);
+            return pView->WritableData();
+        }
+        delete pView;
+    }
+    if (!mbWritable || (mpFile == nullptr))
+    {
+        return nullptr;
+    }
+
+    // map the whole file again, extended if needed - the vector copies its elements to the
+    //   new mapping, but they are the same file pages, so only the page tables change
+    ForthMappedFile* pView = new ForthMappedFile;
+    if (!pView->MapWritable(mpFile, numBytes) || (pView->WritableData() == nullptr))
+    {
+        delete pView;
+        throw std::bad_alloc();
+    }
+    if (pView->Size() > mFileSize)
+    {
+        mFileSize = pView->Size();
+    }
+    mViews.push_back(pView);
+    return pView->WritableData();
+}
+
+bool ForthMappedArrayStorage::Contains(const void* pData) const
+{
+    for (ForthMappedFile* pView : mViews)
+    {
+        const char* pStart = pView->Data();
+        if (((const char*)pData >= pStart) && ((const char*)pData < (pStart + pView->Size())))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ForthMappedArrayStorage::Deallocate(void* pBlock)
+{
+    for (size_t i = 0; i < mViews.size(); i++)
+    {
+        if (mViews[i]->Data() == (const char*)pBlock)
+        {
+            delete mViews[i];
+            mViews.erase(mViews.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
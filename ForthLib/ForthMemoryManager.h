@@ -1,5 +1,8 @@
 #pragma once
 
+#include <new>
+#include <utility>
+#include <vector>
 #include "Forth.h"
 
 // memory allocation wrappers
@@ -45,3 +48,185 @@ public:
     void* resize(void *pMemory, size_t numBytes) override;
     void free(void* pBlock) override;
 };
+
+// huge page mode is turned on by setting the FORTH_HUGE_PAGES environment variable to nonzero,
+//   in huge page mode the dictionary, big fiber stacks and big numeric array element blocks are
+//   allocated with allocateHugePages, which uses explicit huge pages (MAP_HUGETLB, MEM_LARGE_PAGES)
+//   if the system has any available, otherwise it uses page-aligned memory marked for transparent
+//   huge pages - blocks from allocateHugePages must be freed with freeHugePages
+extern bool __useHugePages;
+
+#define HUGE_PAGE_BYTES             (2 * 1024 * 1024)
+// numeric arrays whose elements take at least this many bytes use huge pages
+#define HUGE_PAGE_ARRAY_THRESHOLD   (HUGE_PAGE_BYTES / 2)
+
+void* allocateHugePages(size_t numBytes, bool executable = false);
+void freeHugePages(void* pBlock, size_t numBytes);
+
+class ForthMappedFile;
+
+// ForthMappedArrayStorage lets a vector which uses ForthHugePageAllocator keep its elements in
+//   a mapped file instead of on the heap.  A writable file is mapped shared, element changes go
+//   to the file and growing the vector extends the file.  A read-only file is mapped copy-on-write,
+//   element changes stay private and the file is never changed, growing the vector past the end
+//   of the file moves the elements to the heap.
+class ForthMappedArrayStorage
+{
+public:
+    ForthMappedArrayStorage();
+    ~ForthMappedArrayStorage();
+
+    // opens and maps pPath, a writable file is created if it doesn't exist
+    bool            Open(const char* pPath, bool writable);
+    // unmaps and closes the file, a writable file is cut to numUsedBytes - the vector
+    //   using this storage must already be deleted
+    void            Close(size_t numUsedBytes);
+    // writes changed elements back to a writable file and cuts it to numUsedBytes - the vector
+    //   using this storage must have no spare capacity
+    bool            Sync(size_t numUsedBytes);
+
+    inline bool     IsWritable() const { return mbWritable; }
+    inline size_t   FileSize() const { return mFileSize; }
+
+    // returns nullptr if numBytes is more than a read-only file holds, throws std::bad_alloc
+    //   if a writable file can't be extended
+    void*           Allocate(size_t numBytes);
+    // returns false if pBlock isn't a mapping of the file
+    bool            Deallocate(void* pBlock);
+    // returns true if pData is inside a mapping of the file
+    bool            Contains(const void* pData) const;
+
+private:
+    FILE*                           mpFile;
+    bool                            mbWritable;
+    size_t                          mFileSize;
+    // the mapping made by Open, until a vector asks for it
+    ForthMappedFile*                mpOpenedView;
+    // mappings in use, there are two while a vector is moving to a bigger one
+    std::vector<ForthMappedFile*>   mViews;
+};
+
+// ForthHugePageAllocator is a std container allocator which uses huge pages for big blocks,
+//   or the mapped file of a ForthMappedArrayStorage if it is constructed with one
+template <class T>
+class ForthHugePageAllocator
+{
+public:
+    typedef T value_type;
+
+    ForthHugePageAllocator() : mpStorage(nullptr) {}
+    explicit ForthHugePageAllocator(ForthMappedArrayStorage* pStorage) : mpStorage(pStorage) {}
+    template <class U> ForthHugePageAllocator(const ForthHugePageAllocator<U>& other) : mpStorage(other.GetMappedStorage()) {}
+
+    // copies of a vector with mapped elements are on the heap
+    ForthHugePageAllocator select_on_container_copy_construction() const { return ForthHugePageAllocator(); }
+
+    T* allocate(size_t numElements)
+    {
+        size_t numBytes = numElements * sizeof(T);
+        if (mpStorage != nullptr)
+        {
+            void* pMapped = mpStorage->Allocate(numBytes);
+            if (pMapped != nullptr)
+            {
+                return (T*) pMapped;
+            }
+        }
+        if (__useHugePages && (numBytes >= HUGE_PAGE_ARRAY_THRESHOLD))
+        {
+            void* pBlock = allocateHugePages(numBytes);
+            if (pBlock == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            return (T*) pBlock;
+        }
+        return (T*) ::operator new(numBytes);
+    }
+
+    void deallocate(T* pBlock, size_t numElements)
+    {
+        if ((mpStorage != nullptr) && mpStorage->Deallocate(pBlock))
+        {
+            return;
+        }
+        size_t numBytes = numElements * sizeof(T);
+        if (__useHugePages && (numBytes >= HUGE_PAGE_ARRAY_THRESHOLD))
+        {
+            freeHugePages(pBlock, numBytes);
+        }
+        else
+        {
+            ::operator delete(pBlock);
+        }
+    }
+
+    // elements added inside a mapping keep what is in the file, so a vector can be resized
+    //   to take over the file contents, elements anywhere else are zeroed as usual
+    template <class U>
+    void construct(U* pElement)
+    {
+        if ((mpStorage != nullptr) && mpStorage->Contains(pElement))
+        {
+            ::new((void*) pElement) U;
+        }
+        else
+        {
+            ::new((void*) pElement) U();
+        }
+    }
+
+    template <class U, class... Args>
+    void construct(U* pElement, Args&&... args)
+    {
+        ::new((void*) pElement) U(std::forward<Args>(args)...);
+    }
+
+    inline ForthMappedArrayStorage* GetMappedStorage() const { return mpStorage; }
+
+private:
+    ForthMappedArrayStorage* mpStorage;
+};
+
+template <class T, class U>
+bool operator==(const ForthHugePageAllocator<T>& a, const ForthHugePageAllocator<U>& b) { return a.GetMappedStorage() == b.GetMappedStorage(); }
+template <class T, class U>
+bool operator!=(const ForthHugePageAllocator<T>& a, const ForthHugePageAllocator<U>& b) { return a.GetMappedStorage() != b.GetMappedStorage(); }
+
+// ForthMappedFile maps a whole regular file into memory, so it can be accessed
+//   with pointer arithmetic instead of stdio calls.  Mapping fails for pipes, terminals
+//   and other files which aren't regular files, callers should fall back to stdio.
+class ForthMappedFile
+{
+public:
+    ForthMappedFile();
+    ~ForthMappedFile();
+
+    // returns false if pFile can't be mapped, the mapping stays valid after pFile is closed
+    bool            Map(FILE* pFile);
+    // maps pFile for reading and writing, pFile must be open for writing and is first
+    //   extended with zeroes to minSize bytes if it is shorter than that
+    bool            MapWritable(FILE* pFile, size_t minSize);
+    // maps pFile for reading and writing, but changes are private and never reach the file
+    bool            MapCopyOnWrite(FILE* pFile);
+    void            Unmap();
+    // write changed pages of a writable mapping back to the file
+    bool            Sync();
+
+    inline bool         IsMapped() const { return mbMapped; }
+    inline bool         IsWritable() const { return mbWritable; }
+    // Data() is null for an empty file
+    inline const char*  Data() const { return mpData; }
+    // WritableData() is null unless the file was mapped with MapWritable or MapCopyOnWrite
+    inline char*        WritableData() const { return (mbWritable || mbCopyOnWrite) ? (char*)mpData : nullptr; }
+    inline size_t       Size() const { return mSize; }
+
+private:
+    bool            MapFile(FILE* pFile, size_t minSize, bool writable, bool copyOnWrite);
+
+    const char*     mpData;
+    size_t          mSize;
+    bool            mbMapped;
+    bool            mbWritable;
+    bool            mbCopyOnWrite;
+};
@@ -0,0 +1,832 @@
+//////////////////////////////////////////////////////////////////////
+//
+// ForthNumberFormat.cpp: number to text conversion used by the print ops and string formatting
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "pch.h"
+
+#include <limits>
+#include <cmath>
+#include <stddef.h>
+
+#include "Forth.h"
+
+#include "ForthNumberFormat.h"
+
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     integers
+//
+
+static const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char kDigitChars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+static inline int CountDecimalDigits(uint64_t val)
+{
+    int numDigits = 1;
+    while (val >= 10000)
+    {
+        val /= 10000;
+        numDigits += 4;
+    }
+    if (val >= 1000)
+    {
+        return numDigits + 3;
+    }
+    if (val >= 100)
+    {
+        return numDigits + 2;
+    }
+    return (val >= 10) ? numDigits + 1 : numDigits;
+}
+
+// decimal digits are written back to front two at a time, directly into pDst
+static inline int FormatDecimal(char* pDst, uint64_t val)
+{
+    int numDigits = CountDecimalDigits(val);
+    char* pNext = pDst + numDigits;
+    while (val >= 100)
+    {
+        int ix = (int)(val % 100) << 1;
+        val /= 100;
+        *--pNext = kDigitPairs[ix + 1];
+        *--pNext = kDigitPairs[ix];
+    }
+    if (val >= 10)
+    {
+        int ix = (int)val << 1;
+        *--pNext = kDigitPairs[ix + 1];
+        *--pNext = kDigitPairs[ix];
+    }
+    else
+    {
+        *--pNext = (char)('0' + val);
+    }
+    return numDigits;
+}
+
+int FormatUnsignedNumber(char* pDst, uint64_t val, int base)
+{
+    if ((base < 2) || (base > 36) || (base == 10))
+    {
+        return FormatDecimal(pDst, val);
+    }
+
+    char buff[NUMBER_FORMAT_MAX_CHARS];
+    char* pEnd = &buff[NUMBER_FORMAT_MAX_CHARS];
+    char* pNext = pEnd;
+    if ((base & (base - 1)) == 0)
+    {
+        // power of 2 bases just need shifts and masks
+        int shift = 0;
+        while ((1 << shift) != base)
+        {
+            shift++;
+        }
+        uint64_t mask = (uint64_t)(base - 1);
+        do
+        {
+            *--pNext = kDigitChars[val & mask];
+            val >>= shift;
+        } while (val != 0);
+    }
+    else
+    {
+        uint64_t ubase = (uint64_t)base;
+        do
+        {
+            *--pNext = kDigitChars[val % ubase];
+            val /= ubase;
+        } while (val != 0);
+    }
+    int numChars = (int)(pEnd - pNext);
+    memcpy(pDst, pNext, numChars);
+    return numChars;
+}
+
+int FormatSignedNumber(char* pDst, int64_t val, int base)
+{
+    if (val < 0)
+    {
+        *pDst = '-';
+        // negating in unsigned works for the most negative value too
+        return 1 + FormatUnsignedNumber(pDst + 1, ((uint64_t)0) - ((uint64_t)val), base);
+    }
+    return FormatUnsignedNumber(pDst, (uint64_t)val, base);
+}
+
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     floating point
+//
+// This is the Grisu2 algorithm from Florian Loitsch's paper "Printing Floating-Point Numbers
+//   Quickly and Accurately with Integers".  The output always reads back as the same value,
+//   and is the shortest possible text for nearly all values, without the bignum arithmetic
+//   which snprintf needs for exact output.
+//
+
+namespace
+{
+    // a "do it yourself floating point" number f * 2^e
+    struct DiyFp
+    {
+        uint64_t    f;
+        int         e;
+
+        DiyFp(uint64_t f_, int e_) : f(f_), e(e_) {}
+    };
+
+    inline DiyFp Sub(const DiyFp& x, const DiyFp& y)
+    {
+        return DiyFp(x.f - y.f, x.e);
+    }
+
+    // returns the upper 64 bits of the 128 bit product, rounded
+    inline DiyFp Mul(const DiyFp& x, const DiyFp& y)
+    {
+        const uint64_t lowMask = 0xFFFFFFFFu;
+        uint64_t xLo = x.f & lowMask;
+        uint64_t xHi = x.f >> 32;
+        uint64_t yLo = y.f & lowMask;
+        uint64_t yHi = y.f >> 32;
+
+        uint64_t p0 = xLo * yLo;
+        uint64_t p1 = xLo * yHi;
+        uint64_t p2 = xHi * yLo;
+        uint64_t p3 = xHi * yHi;
+
+        uint64_t mid = (p0 >> 32) + (p1 & lowMask) + (p2 & lowMask);
+        mid += ((uint64_t)1) << 31;
+
+        return DiyFp(p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32), x.e + y.e + 64);
+    }
+
+    inline DiyFp Normalize(DiyFp x)
+    {
+        while ((x.f >> 63) == 0)
+        {
+            x.f <<= 1;
+            x.e--;
+        }
+        return x;
+    }
+
+    inline DiyFp NormalizeTo(const DiyFp& x, int targetExponent)
+    {
+        return DiyFp(x.f << (x.e - targetExponent), targetExponent);
+    }
+
+    // value and the lower and upper boundaries of the interval of reals which round to value
+    struct Boundaries
+    {
+        DiyFp   w;
+        DiyFp   minus;
+        DiyFp   plus;
+    };
+
+    template <class FLOAT_TYPE, class BITS_TYPE>
+    Boundaries ComputeBoundaries(FLOAT_TYPE value)
+    {
+        // precision includes the hidden bit
+        const int kPrecision = std::numeric_limits<FLOAT_TYPE>::digits;
+        const int kBias = std::numeric_limits<FLOAT_TYPE>::max_exponent - 1 + (kPrecision - 1);
+        const int kMinExp = 1 - kBias;
+        const uint64_t kHiddenBit = ((uint64_t)1) << (kPrecision - 1);
+
+        BITS_TYPE bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint64_t biasedExp = ((uint64_t)bits) >> (kPrecision - 1);
+        uint64_t fraction = ((uint64_t)bits) & (kHiddenBit - 1);
+
+        DiyFp v = (biasedExp == 0) ? DiyFp(fraction, kMinExp)
+            : DiyFp(fraction + kHiddenBit, (int)biasedExp - kBias);
+
+        // the gap below a power of 2 is half the gap above it
+        bool lowerBoundaryIsCloser = (fraction == 0) && (biasedExp > 1);
+        DiyFp mPlus(2 * v.f + 1, v.e - 1);
+        DiyFp mMinus = lowerBoundaryIsCloser ? DiyFp(4 * v.f - 1, v.e - 2) : DiyFp(2 * v.f - 1, v.e - 1);
+
+        DiyFp wPlus = Normalize(mPlus);
+        Boundaries result = { Normalize(v), NormalizeTo(mMinus, wPlus.e), wPlus };
+        return result;
+    }
+
+    // the cached power c = f * 2^e ~= 10^k is picked so the product with the upper
+    //   boundary has a binary exponent in [kAlpha, -32], which leaves its integer part
+    //   fitting in 32 bits
+    const int kAlpha = -60;
+
+    struct CachedPower
+    {
+        uint64_t    f;
+        int         e;
+        int         k;
+    };
+
+    const int kCachedPowersMinDecExp = -300;
+    const int kCachedPowersDecStep = 8;
+
+    const CachedPower kCachedPowers[] =
+    {
+        { 0xAB70FE17C79AC6CA, -1060, -300 },
+        { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+        { 0xBE5691EF416BD60C, -1007, -284 },
+        { 0x8DD01FAD907FFC3C,  -980, -276 },
+        { 0xD3515C2831559A83,  -954, -268 },
+        { 0x9D71AC8FADA6C9B5,  -927, -260 },
+        { 0xEA9C227723EE8BCB,  -901, -252 },
+        { 0xAECC49914078536D,  -874, -244 },
+        { 0x823C12795DB6CE57,  -847, -236 },
+        { 0xC21094364DFB5637,  -821, -228 },
+        { 0x9096EA6F3848984F,  -794, -220 },
+        { 0xD77485CB25823AC7,  -768, -212 },
+        { 0xA086CFCD97BF97F4,  -741, -204 },
+        { 0xEF340A98172AACE5,  -715, -196 },
+        { 0xB23867FB2A35B28E,  -688, -188 },
+        { 0x84C8D4DFD2C63F3B,  -661, -180 },
+        { 0xC5DD44271AD3CDBA,  -635, -172 },
+        { 0x936B9FCEBB25C996,  -608, -164 },
+        { 0xDBAC6C247D62A584,  -582, -156 },
+        { 0xA3AB66580D5FDAF6,  -555, -148 },
+        { 0xF3E2F893DEC3F126,  -529, -140 },
+        { 0xB5B5ADA8AAFF80B8,  -502, -132 },
+        { 0x87625F056C7C4A8B,  -475, -124 },
+        { 0xC9BCFF6034C13053,  -449, -116 },
+        { 0x964E858C91BA2655,  -422, -108 },
+        { 0xDFF9772470297EBD,  -396, -100 },
+        { 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+        { 0xF8A95FCF88747D94,  -343,  -84 },
+        { 0xB94470938FA89BCF,  -316,  -76 },
+        { 0x8A08F0F8BF0F156B,  -289,  -68 },
+        { 0xCDB02555653131B6,  -263,  -60 },
+        { 0x993FE2C6D07B7FAC,  -236,  -52 },
+        { 0xE45C10C42A2B3B06,  -210,  -44 },
+        { 0xAA242499697392D3,  -183,  -36 },
+        { 0xFD87B5F28300CA0E,  -157,  -28 },
+        { 0xBCE5086492111AEB,  -130,  -20 },
+        { 0x8CBCCC096F5088CC,  -103,  -12 },
+        { 0xD1B71758E219652C,   -77,   -4 },
+        { 0x9C40000000000000,   -50,    4 },
+        { 0xE8D4A51000000000,   -24,   12 },
+        { 0xAD78EBC5AC620000,     3,   20 },
+        { 0x813F3978F8940984,    30,   28 },
+        { 0xC097CE7BC90715B3,    56,   36 },
+        { 0x8F7E32CE7BEA5C70,    83,   44 },
+        { 0xD5D238A4ABE98068,   109,   52 },
+        { 0x9F4F2726179A2245,   136,   60 },
+        { 0xED63A231D4C4FB27,   162,   68 },
+        { 0xB0DE65388CC8ADA8,   189,   76 },
+        { 0x83C7088E1AAB65DB,   216,   84 },
+        { 0xC45D1DF942711D9A,   242,   92 },
+        { 0x924D692CA61BE758,   269,  100 },
+        { 0xDA01EE641A708DEA,   295,  108 },
+        { 0xA26DA3999AEF774A,   322,  116 },
+        { 0xF209787BB47D6B85,   348,  124 },
+        { 0xB454E4A179DD1877,   375,  132 },
+        { 0x865B86925B9BC5C2,   402,  140 },
+        { 0xC83553C5C8965D3D,   428,  148 },
+        { 0x952AB45CFA97A0B3,   455,  156 },
+        { 0xDE469FBD99A05FE3,   481,  164 },
+        { 0xA59BC234DB398C25,   508,  172 },
+        { 0xF6C69A72A3989F5C,   534,  180 },
+        { 0xB7DCBF5354E9BECE,   561,  188 },
+        { 0x88FCF317F22241E2,   588,  196 },
+        { 0xCC20CE9BD35C78A5,   614,  204 },
+        { 0x98165AF37B2153DF,   641,  212 },
+        { 0xE2A0B5DC971F303A,   667,  220 },
+        { 0xA8D9D1535CE3B396,   694,  228 },
+        { 0xFB9B7CD9A4A7443C,   720,  236 },
+        { 0xBB764C4CA7A44410,   747,  244 },
+        { 0x8BAB8EEFB6409C1A,   774,  252 },
+        { 0xD01FEF10A657842C,   800,  260 },
+        { 0x9B10A4E5E9913129,   827,  268 },
+        { 0xE7109BFBA19C0C9D,   853,  276 },
+        { 0xAC2820D9623BF429,   880,  284 },
+        { 0x80444B5E7AA7CF85,   907,  292 },
+        { 0xBF21E44003ACDD2D,   933,  300 },
+        { 0x8E679C2F5E44FF8F,   960,  308 },
+        { 0xD433179D9C8CB841,   986,  316 },
+        { 0x9E19DB92B4E31BA9,  1013,  324 },
+        { 0xEB96BF6EBADF77D9,  1039,  332 },
+        { 0xAF87023B9BF0EE6B,  1066,  340 },
+    };
+
+    const CachedPower& GetCachedPowerForBinaryExponent(int e)
+    {
+        // k = ceil((kAlpha - e - 1) * log10(2)), 78913 / 2^18 is just over log10(2)
+        int f = kAlpha - e - 1;
+        int k = (f * 78913) / (1 << 18) + ((f > 0) ? 1 : 0);
+        int index = (-kCachedPowersMinDecExp + k + (kCachedPowersDecStep - 1)) / kCachedPowersDecStep;
+        return kCachedPowers[index];
+    }
+
+    // returns number of decimal digits in n, and sets pow10 to 10^(digits - 1)
+    inline int FindLargestPow10(uint32_t n, uint32_t& pow10)
+    {
+        int numDigits = 10;
+        pow10 = 1000000000;
+        while ((numDigits > 1) && (n < pow10))
+        {
+            pow10 /= 10;
+            numDigits--;
+        }
+        return numDigits;
+    }
+
+    // nudge the last digit down while that gets closer to the exact value and stays in range
+    inline void Grisu2Round(char* pBuffer, int length, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t tenK)
+    {
+        while ((rest < dist) && ((delta - rest) >= tenK)
+            && (((rest + tenK) < dist) || ((dist - rest) > (rest + tenK - dist))))
+        {
+            pBuffer[length - 1]--;
+            rest += tenK;
+        }
+    }
+
+    // generates the shortest digits of a number in [mMinus, mPlus], as close as possible to w
+    void Grisu2DigitGen(char* pBuffer, int& length, int& decimalExponent, DiyFp mMinus, DiyFp w, DiyFp mPlus)
+    {
+        uint64_t delta = Sub(mPlus, mMinus).f;
+        uint64_t dist = Sub(mPlus, w).f;
+
+        // split mPlus into integer part p1 and fraction part p2
+        DiyFp one(((uint64_t)1) << -mPlus.e, mPlus.e);
+        uint32_t p1 = (uint32_t)(mPlus.f >> -one.e);
+        uint64_t p2 = mPlus.f & (one.f - 1);
+
+        uint32_t pow10;
+        int n = FindLargestPow10(p1, pow10);
+        while (n > 0)
+        {
+            uint32_t digit = p1 / pow10;
+            p1 = p1 % pow10;
+            pBuffer[length++] = (char)('0' + digit);
+            n--;
+
+            uint64_t rest = (((uint64_t)p1) << -one.e) + p2;
+            if (rest <= delta)
+            {
+                decimalExponent += n;
+                Grisu2Round(pBuffer, length, dist, delta, rest, ((uint64_t)pow10) << -one.e);
+                return;
+            }
+            pow10 /= 10;
+        }
+
+        int m = 0;
+        while (true)
+        {
+            p2 *= 10;
+            delta *= 10;
+            dist *= 10;
+            pBuffer[length++] = (char)('0' + (p2 >> -one.e));
+            p2 &= one.f - 1;
+            m++;
+            if (p2 <= delta)
+            {
+                break;
+            }
+        }
+        decimalExponent -= m;
+        Grisu2Round(pBuffer, length, dist, delta, p2, one.f);
+    }
+
+    // value must be finite and positive, the digits go in pBuffer and the value
+    //   is digits * 10^decimalExponent
+    template <class FLOAT_TYPE, class BITS_TYPE>
+    int Grisu2(char* pBuffer, int& decimalExponent, FLOAT_TYPE value)
+    {
+        Boundaries b = ComputeBoundaries<FLOAT_TYPE, BITS_TYPE>(value);
+        const CachedPower& cached = GetCachedPowerForBinaryExponent(b.plus.e);
+        DiyFp cMinusK(cached.f, cached.e);
+
+        DiyFp w = Mul(b.w, cMinusK);
+        DiyFp wMinus = Mul(b.minus, cMinusK);
+        DiyFp wPlus = Mul(b.plus, cMinusK);
+
+        // the products may be off by one ulp, so shrink the interval to stay inside it
+        DiyFp mMinus(wMinus.f + 1, wMinus.e);
+        DiyFp mPlus(wPlus.f - 1, wPlus.e);
+
+        int length = 0;
+        decimalExponent = -cached.k;
+        Grisu2DigitGen(pBuffer, length, decimalExponent, mMinus, w, mPlus);
+        return length;
+    }
+
+    int AppendExponent(char* pDst, int exponent)
+    {
+        char* pNext = pDst;
+        *pNext++ = 'e';
+        if (exponent < 0)
+        {
+            *pNext++ = '-';
+            exponent = -exponent;
+        }
+        else
+        {
+            *pNext++ = '+';
+        }
+        if (exponent < 10)
+        {
+            *pNext++ = '0';
+        }
+        pNext += FormatDecimal(pNext, (uint64_t)exponent);
+        return (int)(pNext - pDst);
+    }
+
+    // turns numDigits digits times 10^decimalExponent into fixed or scientific notation in place,
+    //   fixed is used for decimal points between minExp and maxExp digits from the left
+    int PlaceDecimalPoint(char* pBuffer, int numDigits, int decimalExponent, int minExp, int maxExp)
+    {
+        int k = numDigits;
+        // the decimal point goes after the nth digit
+        int n = numDigits + decimalExponent;
+
+        if ((k <= n) && (n <= maxExp))
+        {
+            // digits then zeros then ".0"
+            memset(pBuffer + k, '0', n - k);
+            pBuffer[n] = '.';
+            pBuffer[n + 1] = '0';
+            return n + 2;
+        }
+
+        if ((0 < n) && (n <= maxExp))
+        {
+            // digits with a decimal point in the middle
+            memmove(pBuffer + (n + 1), pBuffer + n, k - n);
+            pBuffer[n] = '.';
+            return k + 1;
+        }
+
+        if ((minExp < n) && (n <= 0))
+        {
+            // "0." then zeros then digits
+            memmove(pBuffer + (2 + -n), pBuffer, k);
+            pBuffer[0] = '0';
+            pBuffer[1] = '.';
+            memset(pBuffer + 2, '0', -n);
+            return 2 + (-n) + k;
+        }
+
+        // d.ddde+xx
+        if (k == 1)
+        {
+            pBuffer[1] = '.';
+            pBuffer[2] = '0';
+            k = 3;
+        }
+        else
+        {
+            memmove(pBuffer + 2, pBuffer + 1, k - 1);
+            pBuffer[1] = '.';
+            k++;
+        }
+        return k + AppendExponent(pBuffer + k, n - 1);
+    }
+
+    template <class FLOAT_TYPE, class BITS_TYPE>
+    int FormatShortest(char* pDst, FLOAT_TYPE val)
+    {
+        char* pNext = pDst;
+        if (val != val)
+        {
+            memcpy(pDst, "nan", 3);
+            return 3;
+        }
+        if (std::signbit(val))
+        {
+            *pNext++ = '-';
+            val = -val;
+        }
+        if (val == std::numeric_limits<FLOAT_TYPE>::infinity())
+        {
+            memcpy(pNext, "inf", 3);
+            return (int)(pNext - pDst) + 3;
+        }
+        if (val == 0)
+        {
+            memcpy(pNext, "0.0", 3);
+            return (int)(pNext - pDst) + 3;
+        }
+
+        int decimalExponent;
+        int numDigits = Grisu2<FLOAT_TYPE, BITS_TYPE>(pNext, decimalExponent, val);
+        return (int)(pNext - pDst) + PlaceDecimalPoint(pNext, numDigits, decimalExponent,
+            -4, std::numeric_limits<FLOAT_TYPE>::digits10);
+    }
+}
+
+int FormatShortestDouble(char* pDst, double val)
+{
+    return FormatShortest<double, uint64_t>(pDst, val);
+}
+
+int FormatShortestFloat(char* pDst, float val)
+{
+    return FormatShortest<float, uint32_t>(pDst, val);
+}
+
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     formatted output
+//
+
+namespace
+{
+    // keeps count of all output, but only stores what fits in the buffer
+    struct FormatSink
+    {
+        char*   pDst;
+        int     room;
+        int     count;
+
+        void PutBytes(const char* pSrc, int numBytes)
+        {
+            int numToCopy = room - count;
+            if (numToCopy > numBytes)
+            {
+                numToCopy = numBytes;
+            }
+            if (numToCopy > 0)
+            {
+                memcpy(pDst + count, pSrc, numToCopy);
+            }
+            count += numBytes;
+        }
+
+        void PutFill(char ch, int numBytes)
+        {
+            int numToFill = room - count;
+            if (numToFill > numBytes)
+            {
+                numToFill = numBytes;
+            }
+            if (numToFill > 0)
+            {
+                memset(pDst + count, ch, numToFill);
+            }
+            count += numBytes;
+        }
+    };
+
+    inline int64_t SignExtendArg(cell arg, int argBytes)
+    {
+        switch (argBytes)
+        {
+        case 1:     return (int64_t)(signed char)arg;
+        case 2:     return (int64_t)(short)arg;
+        case 4:     return (int64_t)(int32_t)arg;
+        default:    return (int64_t)arg;
+        }
+    }
+
+    inline uint64_t ZeroExtendArg(cell arg, int argBytes)
+    {
+        switch (argBytes)
+        {
+        case 1:     return (uint64_t)(unsigned char)arg;
+        case 2:     return (uint64_t)(unsigned short)arg;
+        case 4:     return (uint64_t)(uint32_t)arg;
+        default:    return (uint64_t)(ucell)arg;
+        }
+    }
+}
+
+int ForthFastFormat(char* pBuffer, int bufferSize, const char* pFormat, const cell* pArgs, int numArgs)
+{
+    // check the whole format first, since nothing can be written if snprintf is needed
+    int numArgsNeeded = 0;
+    for (const char* pSrc = strchr(pFormat, '%'); pSrc != nullptr; pSrc = strchr(pSrc, '%'))
+    {
+        pSrc++;
+        if (*pSrc == '%')
+        {
+            pSrc++;
+            continue;
+        }
+        while ((*pSrc == '-') || (*pSrc == '0'))
+        {
+            pSrc++;
+        }
+        while ((*pSrc >= '0') && (*pSrc <= '9'))
+        {
+            pSrc++;
+        }
+        int argBytes = sizeof(int);
+        bool hasLength = true;
+        switch (*pSrc)
+        {
+        case 'h':
+            pSrc++;
+            argBytes = (*pSrc == 'h') ? 1 : 2;
+            if (*pSrc == 'h')
+            {
+                pSrc++;
+            }
+            break;
+        case 'l':
+            pSrc++;
+            argBytes = (*pSrc == 'l') ? (int)sizeof(long long) : (int)sizeof(long);
+            if (*pSrc == 'l')
+            {
+                pSrc++;
+            }
+            break;
+        case 'z':   pSrc++;  argBytes = sizeof(size_t);      break;
+        case 't':   pSrc++;  argBytes = sizeof(ptrdiff_t);   break;
+        case 'j':   pSrc++;  argBytes = sizeof(intmax_t);    break;
+        default:    hasLength = false;                       break;
+        }
+        // longer args would take more than one cell
+        if (argBytes > (int)sizeof(cell))
+        {
+            return FAST_FORMAT_UNHANDLED;
+        }
+        switch (*pSrc)
+        {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+            break;
+        case 'c': case 's':
+            if (hasLength)
+            {
+                // wide chars and strings
+                return FAST_FORMAT_UNHANDLED;
+            }
+            break;
+        default:
+            return FAST_FORMAT_UNHANDLED;
+        }
+        pSrc++;
+        numArgsNeeded++;
+    }
+    if (numArgsNeeded > numArgs)
+    {
+        return FAST_FORMAT_UNHANDLED;
+    }
+
+    FormatSink sink;
+    sink.pDst = pBuffer;
+    sink.room = (bufferSize > 0) ? bufferSize - 1 : 0;
+    sink.count = 0;
+    int argIx = 0;
+    const char* pSrc = pFormat;
+    while (*pSrc != '\0')
+    {
+        const char* pPercent = strchr(pSrc, '%');
+        if (pPercent == nullptr)
+        {
+            sink.PutBytes(pSrc, (int)strlen(pSrc));
+            break;
+        }
+        sink.PutBytes(pSrc, (int)(pPercent - pSrc));
+        pSrc = pPercent + 1;
+        if (*pSrc == '%')
+        {
+            sink.PutBytes(pSrc, 1);
+            pSrc++;
+            continue;
+        }
+
+        bool leftJustify = false;
+        bool zeroPad = false;
+        while ((*pSrc == '-') || (*pSrc == '0'))
+        {
+            if (*pSrc == '-')
+            {
+                leftJustify = true;
+            }
+            else
+            {
+                zeroPad = true;
+            }
+            pSrc++;
+        }
+        int width = 0;
+        while ((*pSrc >= '0') && (*pSrc <= '9'))
+        {
+            width = (width * 10) + (*pSrc - '0');
+            pSrc++;
+        }
+        int argBytes = sizeof(int);
+        switch (*pSrc)
+        {
+        case 'h':
+            pSrc++;
+            argBytes = 2;
+            if (*pSrc == 'h')
+            {
+                pSrc++;
+                argBytes = 1;
+            }
+            break;
+        case 'l':
+            pSrc++;
+            argBytes = sizeof(long);
+            if (*pSrc == 'l')
+            {
+                pSrc++;
+                argBytes = sizeof(long long);
+            }
+            break;
+        case 'z':   pSrc++;  argBytes = sizeof(size_t);      break;
+        case 't':   pSrc++;  argBytes = sizeof(ptrdiff_t);   break;
+        case 'j':   pSrc++;  argBytes = sizeof(intmax_t);    break;
+        default:                                             break;
+        }
+
+        cell arg = pArgs[argIx++];
+        char numBuff[NUMBER_FORMAT_MAX_CHARS];
+        const char* pChars = numBuff;
+        int numChars = 0;
+        bool isNumber = true;
+        switch (*pSrc++)
+        {
+        case 'd':
+        case 'i':
+            numChars = FormatSignedNumber(numBuff, SignExtendArg(arg, argBytes), 10);
+            break;
+        case 'u':
+            numChars = FormatUnsignedNumber(numBuff, ZeroExtendArg(arg, argBytes), 10);
+            break;
+        case 'x':
+            numChars = FormatUnsignedNumber(numBuff, ZeroExtendArg(arg, argBytes), 16);
+            break;
+        case 'X':
+            numChars = FormatUnsignedNumber(numBuff, ZeroExtendArg(arg, argBytes), 16);
+            for (int i = 0; i < numChars; i++)
+            {
+                if (numBuff[i] >= 'a')
+                {
+                    numBuff[i] -= 'a' - 'A';
+                }
+            }
+            break;
+        case 'o':
+            numChars = FormatUnsignedNumber(numBuff, ZeroExtendArg(arg, argBytes), 8);
+            break;
+        case 'c':
+            numBuff[0] = (char)arg;
+            numChars = 1;
+            isNumber = false;
+            break;
+        default:
+            // 's'
+            pChars = (arg == 0) ? "(null)" : (const char*)arg;
+            numChars = (int)strlen(pChars);
+            isNumber = false;
+            break;
+        }
+
+        int padChars = width - numChars;
+        if (padChars <= 0)
+        {
+            sink.PutBytes(pChars, numChars);
+        }
+        else if (leftJustify)
+        {
+            sink.PutBytes(pChars, numChars);
+            sink.PutFill(' ', padChars);
+        }
+        else if (zeroPad && isNumber)
+        {
+            // zeros go between the sign and the digits
+            if (*pChars == '-')
+            {
+                sink.PutBytes(pChars, 1);
+                pChars++;
+                numChars--;
+            }
+            sink.PutFill('0', padChars);
+            sink.PutBytes(pChars, numChars);
+        }
+        else
+        {
+            sink.PutFill(' ', padChars);
+            sink.PutBytes(pChars, numChars);
+        }
+    }
+
+    if (bufferSize > 0)
+    {
+        pBuffer[(sink.count < sink.room) ? sink.count : sink.room] = '\0';
+    }
+    return sink.count;
+}
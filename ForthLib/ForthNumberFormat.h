@@ -0,0 +1,31 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// ForthNumberFormat.h: number to text conversion used by the print ops and string formatting
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+
+// most chars FormatUnsignedNumber or FormatSignedNumber can produce - 64 binary digits and a sign
+#define NUMBER_FORMAT_MAX_CHARS         72
+// most chars FormatShortestDouble or FormatShortestFloat can produce
+#define NUMBER_FORMAT_MAX_FLOAT_CHARS   32
+// ForthFastFormat returns this when the format needs snprintf
+#define FAST_FORMAT_UNHANDLED           (-2)
+
+// write val in base 2 to 36 to pDst, digits over 9 are lower case letters, a base outside
+//   that range is treated as 10.  Returns number of chars written, no nul is added.
+extern int FormatUnsignedNumber(char* pDst, uint64_t val, int base);
+extern int FormatSignedNumber(char* pDst, int64_t val, int base);
+
+// write the shortest decimal text which reads back as exactly val, like "0.1", "1.0e+30" or "-25.0".
+//   Returns number of chars written, no nul is added.
+extern int FormatShortestDouble(char* pDst, double val);
+extern int FormatShortestFloat(char* pDst, float val);
+
+// snprintf for formats which only have %d %i %u %x %X %o %c %s and %% conversions, with optional
+//   '-' and '0' flags, width and h/l/z/t/j length modifiers.  Returns number of chars the
+//   full output takes like C99 snprintf, or FAST_FORMAT_UNHANDLED without writing anything
+//   if the format has anything else, or needs more than numArgs arguments.
+extern int ForthFastFormat(char* pBuffer, int bufferSize, const char* pFormat, const cell* pArgs, int numArgs);
@@ -27,13 +27,52 @@
 
 #define GET_THIS( THIS_TYPE, THIS_NAME ) THIS_TYPE* THIS_NAME = reinterpret_cast<THIS_TYPE *>(GET_TP);
 
+// ReleaseDeadObject is called when an object's refcount drops to zero, it deletes the object
+//   now or puts it on the thread release queue if deferred releases are enabled
+void ReleaseDeadObject( ForthCoreState* pCore, ForthObject obj );
+
+// ObjectRefCountDropped is called by the assembler inner interpreter after it decrements an
+//   object's refcount to zero, or to nonzero while the cycle collector is enabled, and does
+//   what SAFE_RELEASE does after its decrement
+extern "C" void ObjectRefCountDropped( ForthCoreState* pCore, ForthObject obj, ucell newRefCount );
+
+// while the cycle collector is enabled, objects whose refcount is decremented to nonzero are
+//   recorded as possible garbage cycle roots, and freed objects must be removed from those roots
+// gCycleCollectorEnabled has C linkage so the assembler inner interpreter can test it
+extern "C" bool gCycleCollectorEnabled;
+void AddPossibleCycleRoot( ForthCoreState* pCore, ForthObject obj );
+void CycleCollectorFreeObject( void* pObj );
+
+// objects which are shared between OS threads have SHARED_OBJECT_FLAG set in their refcount,
+//   their refcounts are updated with atomic ops, thread-local objects use plain increment/decrement
+#define SHARED_OBJECT_FLAG              (((ucell) 1) << ((sizeof(ucell) * 8) - 1))
+#define OBJECT_IS_SHARED( _obj )        (((_obj)->refCount & SHARED_OBJECT_FLAG) != 0)
+#define OBJECT_REFCOUNT( _obj )         ((_obj)->refCount & ~SHARED_OBJECT_FLAG)
+
+// ATOMIC_ADD_REFCOUNT returns the new refcount
+#if defined(WIN32)
+#if defined(FORTH64)
+#define ATOMIC_ADD_REFCOUNT( _obj, _delta ) ((ucell)(InterlockedExchangeAdd64( (volatile LONG64 *) &((_obj)->refCount), (_delta) ) + (_delta)))
+#else
+#define ATOMIC_ADD_REFCOUNT( _obj, _delta ) ((ucell)(InterlockedExchangeAdd( (volatile LONG *) &((_obj)->refCount), (_delta) ) + (_delta)))
+#endif
+#else
+#define ATOMIC_ADD_REFCOUNT( _obj, _delta ) __atomic_add_fetch( &((_obj)->refCount), (ucell)(_delta), __ATOMIC_ACQ_REL )
+#endif
+
+// INCREMENT_REFCOUNT and DECREMENT_REFCOUNT both evaluate to the new refcount, without the shared flag
+#define INCREMENT_REFCOUNT( _obj ) \
+    (OBJECT_IS_SHARED( _obj ) ? (ATOMIC_ADD_REFCOUNT( (_obj), 1 ) & ~SHARED_OBJECT_FLAG) : ((_obj)->refCount += 1))
+#define DECREMENT_REFCOUNT( _obj ) \
+    (OBJECT_IS_SHARED( _obj ) ? (ATOMIC_ADD_REFCOUNT( (_obj), -1 ) & ~SHARED_OBJECT_FLAG) : ((_obj)->refCount -= 1))
+
 #define SAFE_RELEASE( _pCore, _obj ) \
 	if ( _obj != nullptr ) { \
-		_obj->refCount -= 1; \
-		if ( _obj->refCount == 0 ) { FULLY_EXECUTE_METHOD( (_pCore), (_obj), kMethodDelete ); } \
+		if ( DECREMENT_REFCOUNT( _obj ) == 0 ) { ReleaseDeadObject( (_pCore), (_obj) ); } \
+		else if ( gCycleCollectorEnabled ) { AddPossibleCycleRoot( (_pCore), (_obj) ); } \
 	} TRACK_RELEASE
 
-#define SAFE_KEEP( _obj )       if ( _obj != nullptr ) { _obj->refCount += 1; } TRACK_KEEP
+#define SAFE_KEEP( _obj )       if ( _obj != nullptr ) { INCREMENT_REFCOUNT( _obj ); } TRACK_KEEP
 
 #define OBJECTS_DIFFERENT( OLDOBJ, NEWOBJ ) (OLDOBJ != NEWOBJ)
 #define OBJECTS_SAME( OLDOBJ, NEWOBJ ) (OLDOBJ == NEWOBJ)
@@ -94,7 +133,7 @@ extern long gStatReleases;
 #define MALLOCATE( _type, _ptr ) _type* _ptr = (_type *) __MALLOC( sizeof(_type) );
 
 #define MALLOCATE_OBJECT( _type, _ptr, _vocab )   _type* _ptr = (_type *) __MALLOC( _vocab->GetSize() );  TRACK_NEW
-#define FREE_OBJECT( _obj )  __FREE( _obj );  TRACK_DELETE
+#define FREE_OBJECT( _obj )  if ( gCycleCollectorEnabled ) { CycleCollectorFreeObject( _obj ); } else { __FREE( _obj ); }  TRACK_DELETE
 #define MALLOCATE_LINK( _type, _ptr )  MALLOCATE( _type, _ptr );  TRACK_LINK_NEW
 #define FREE_LINK( _link )  __FREE( _link );  TRACK_LINK_DELETE
 #define MALLOCATE_ITER( _type, _ptr, _vocab )  MALLOCATE_OBJECT( _type, _ptr, _vocab );  TRACK_ITER_NEW
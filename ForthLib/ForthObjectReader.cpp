@@ -6,6 +6,7 @@
 
 #include "pch.h"
 #include <stdexcept>
+#include <stdlib.h>
 #include "ForthObjectReader.h"
 //#include "ForthEngine.h"
 
@@ -17,8 +18,23 @@
     ? look for elements in same order as they would be printed, or just search for them?
 */
 
+namespace
+{
+    inline bool isWhitespaceChar(char ch)
+    {
+        return (ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n');
+    }
+
+    inline bool isNumberChar(char ch)
+    {
+        return ((ch >= '0') && (ch <= '9')) || (ch == '-') || (ch == '+') || (ch == '.') || (ch == 'e') || (ch == 'E');
+    }
+}
+
 ForthObjectReader::ForthObjectReader()
 : mInStream(nullptr)
+, mpCursor(nullptr)
+, mpLimit(nullptr)
 , mSavedChar('\0')
 , mHaveSavedChar(false)
 , mOutArrayObject(nullptr)
@@ -40,6 +56,9 @@ bool ForthObjectReader::ReadObjects(ForthObject& inStream, ForthObject& outArray
     mContextStack.clear();
     mLineNum = 1;
     mCharOffset = 0;
+    mHaveSavedChar = false;
+    mBuffer.resize(OBJECT_READER_BUFFER_SIZE);
+    mpCursor = mpLimit = &(mBuffer[0]);
 
     mContext.pVocab = nullptr;
     mContext.objIndex = -1;
@@ -50,7 +69,8 @@ bool ForthObjectReader::ReadObjects(ForthObject& inStream, ForthObject& outArray
 
     try
     {
-        if ((mInStream->pInFuncs == nullptr) || (mInStream->pInFuncs->inChar == nullptr))
+        if ((mInStream->pInFuncs == nullptr)
+            || ((mInStream->pInFuncs->inBytes == nullptr) && (mInStream->pInFuncs->inChar == nullptr)))
         {
             throwError("unusable input stream");
         }
@@ -73,15 +93,54 @@ bool ForthObjectReader::ReadObjects(ForthObject& inStream, ForthObject& outArray
 }
 
 
+bool ForthObjectReader::fillBuffer()
+{
+    char* pBuffer = &(mBuffer[0]);
+    int numRead = 0;
+    if (mInStream->pInFuncs->inBytes != nullptr)
+    {
+        numRead = mInStream->pInFuncs->inBytes(mpCore, mInStream, pBuffer, (int)mBuffer.size());
+    }
+    else
+    {
+        // stream can only supply a char at a time
+        while (numRead < (int)mBuffer.size())
+        {
+            int ch = -1;
+            if ((mInStream->pInFuncs->inChar(mpCore, mInStreamObject, ch) == 0) || (ch == -1))
+            {
+                break;
+            }
+            pBuffer[numRead++] = (char)ch;
+        }
+    }
+
+    mpCursor = pBuffer;
+    mpLimit = pBuffer + ((numRead > 0) ? numRead : 0);
+    return numRead > 0;
+}
+
+void ForthObjectReader::advancePosition(const char* pStart, const char* pEnd)
+{
+    const char* pLineStart = pStart;
+    const char* pNewline;
+    while ((pNewline = (const char*)memchr(pLineStart, '\n', pEnd - pLineStart)) != nullptr)
+    {
+        mLineNum++;
+        mCharOffset = 0;
+        pLineStart = pNewline + 1;
+    }
+    mCharOffset += (int)(pEnd - pLineStart);
+}
+
 char ForthObjectReader::getRawChar()
 {
-    int ch;
-    mInStream->pInFuncs->inChar(mpCore, mInStreamObject, ch);
-    if (ch == -1)
+    if (!haveInput())
     {
         throwError("unexpected EOF");
     }
 
+    char ch = *mpCursor++;
     if (ch == '\n')
     {
         mLineNum++;
@@ -92,7 +151,7 @@ char ForthObjectReader::getRawChar()
         mCharOffset++;
     }
 
-    return (char)ch;
+    return ch;
 }
 
 
@@ -144,38 +203,90 @@ void ForthObjectReader::getString(std::string& str)
 {
     getRequiredChar('\"');
     str.clear();
-    char ch;
-    while ((ch = getRawChar()) != '\"')
+    // append the string in runs up to the closing quote, an escape or the end of the buffer
+    while (true)
+    {
+        if (!haveInput())
+        {
+            throwError("unexpected EOF");
+        }
+        const char* pStart = mpCursor;
+        const char* pEnd = pStart;
+        while ((pEnd != mpLimit) && (*pEnd != '\"') && (*pEnd != '\\'))
+        {
+            pEnd++;
+        }
+        str.append(pStart, pEnd - pStart);
+        advancePosition(pStart, pEnd);
+        mpCursor = pEnd;
+        if (pEnd != mpLimit)
+        {
+            // skip closing quote or backslash
+            mpCursor++;
+            mCharOffset++;
+            if (*pEnd == '\"')
+            {
+                break;
+            }
+            str.push_back(getEscapedChar());
+        }
+    }
+}
+
+// the char after a backslash, escapes are the ones ForthShowContext::ShowQuotedText writes
+char ForthObjectReader::getEscapedChar()
+{
+    char ch = getRawChar();
+    switch (ch)
     {
-        str.push_back(ch);
+    case 'n':   return '\n';
+    case 'r':   return '\r';
+    case 't':   return '\t';
+    case 'b':   return '\b';
+    case 'f':   return '\f';
+    default:    break;
     }
+    // quote, backslash and slash stand for themselves
+    return ch;
 }
 
 void ForthObjectReader::getNumber(std::string& str)
 {
     str.clear();
     skipWhitespace();
-    while (true)
+    if (mHaveSavedChar)
     {
-        char ch = getChar();
-        if (ch < '0' || ch > '9')
+        if (!isNumberChar(mSavedChar))
         {
-            if (ch != '-' && ch != '.' && ch != 'e')
-            {
-                ungetChar(ch);
-                break;
-            }
+            return;
+        }
+        mHaveSavedChar = false;
+        str.push_back(mSavedChar);
+    }
+
+    while (haveInput())
+    {
+        const char* pStart = mpCursor;
+        const char* pEnd = pStart;
+        while ((pEnd != mpLimit) && isNumberChar(*pEnd))
+        {
+            pEnd++;
+        }
+        str.append(pStart, pEnd - pStart);
+        mCharOffset += (int)(pEnd - pStart);
+        mpCursor = pEnd;
+        if (pEnd != mpLimit)
+        {
+            break;
         }
-        str.push_back(ch);
     }
 }
 
 void ForthObjectReader::skipWhitespace()
 {
-    const char* whitespace = " \t\r\n";
     if (mHaveSavedChar)
     {
-        if (strchr(whitespace, mSavedChar) == nullptr)
+        if (!isWhitespaceChar(mSavedChar))
         {
             // there is a saved non-whitespace character, nothing to skip
             return;
@@ -185,15 +296,75 @@ void ForthObjectReader::skipWhitespace()
 
     while (true)
     {
-        char ch = getRawChar();
-        if (strchr(whitespace, ch) == nullptr)
+        if (!haveInput())
+        {
+            throwError("unexpected EOF");
+        }
+        const char* pStart = mpCursor;
+        const char* pEnd = pStart;
+        while ((pEnd != mpLimit) && isWhitespaceChar(*pEnd))
+        {
+            pEnd++;
+        }
+        advancePosition(pStart, pEnd);
+        mpCursor = pEnd;
+        if (pEnd != mpLimit)
         {
-            ungetChar(ch);
             break;
         }
     }
 }
 
+int64_t ForthObjectReader::parseInteger(const std::string& str, const char* pErrorMessage)
+{
+    const char* pStart = str.c_str();
+    char* pEnd;
+    int64_t val = strtoll(pStart, &pEnd, 10);
+    if (pEnd == pStart)
+    {
+        throwError(pErrorMessage);
+    }
+    return val;
+}
+
+double ForthObjectReader::parseDouble(const std::string& str, const char* pErrorMessage)
+{
+    const char* pStart = str.c_str();
+    char* pEnd;
+    double val = strtod(pStart, &pEnd);
+    if (pEnd == pStart)
+    {
+        throwError(pErrorMessage);
+    }
+    return val;
+}
+
+forthop* ForthObjectReader::findField(const std::string& name)
+{
+    fieldMap& fields = mFieldCache[mContext.pVocab];
+    fieldMap::iterator iter = fields.find(name);
+    if (iter != fields.end())
+    {
+        return iter->second;
+    }
+    // names which aren't fields are cached too, they go to the custom readers
+    forthop* pEntry = mContext.pVocab->FindSymbol(name.c_str());
+    fields[name] = pEntry;
+    return pEntry;
+}
+
+ForthStructVocabulary* ForthObjectReader::findClassVocabulary(const std::string& className)
+{
+    std::unordered_map<std::string, ForthStructVocabulary*>::iterator iter = mClassVocabCache.find(className);
+    if (iter != mClassVocabCache.end())
+    {
+        return iter->second;
+    }
+    ForthStructVocabulary* pVocab = ForthTypesManager::GetInstance()->GetStructVocabulary(className.c_str());
+    mClassVocabCache[className] = pVocab;
+    return pVocab;
+}
+
 void ForthObjectReader::getObject(ForthObject* pDst)
 {
     getRequiredChar('{');
@@ -201,7 +372,7 @@ void ForthObjectReader::getObject(ForthObject* pDst)
     mContext.pVocab = nullptr;
     mContext.pData = nullptr;
     mContext.objIndex = -1;
-    pDst = nullptr;
+    *pDst = nullptr;
 
     bool done = false;
     while (!done)
@@ -272,7 +443,7 @@ void ForthObjectReader::getObjectOrLink(ForthObject* pDst)
             *pDst = linkedObject;
 
             // bump linked object refcount
-            linkedObject->refCount += 1;
+            INCREMENT_REFCOUNT(linkedObject);
         }
         else
         {
@@ -352,8 +523,8 @@ void ForthObjectReader::processElement(const std::string& name)
             std::string className = classId.substr(0, lastUnderscore);
 
             ForthCoreState *pCore = mpCore;
-            ForthStructVocabulary* newClassVocab = ForthTypesManager::GetInstance()->GetStructVocabulary(className.c_str());
-            if (newClassVocab->IsClass())
+            ForthStructVocabulary* newClassVocab = findClassVocabulary(className);
+            if ((newClassVocab != nullptr) && newClassVocab->IsClass())
             {
                 mContext.pVocab = newClassVocab;
                 mContext.objIndex = (int) mObjects.size();
@@ -361,16 +532,15 @@ void ForthObjectReader::processElement(const std::string& name)
                 long initOpcode = mContext.pVocab->GetInitOpcode();
                 SPUSH((long)mContext.pVocab);
                 mpEngine->FullyExecuteOp(pCore, (static_cast<ForthClassVocabulary *>(mContext.pVocab))->GetClassObject()->newOp);
+
+                ForthObject newObject;
+                POP_OBJECT(newObject);
                 if (initOpcode != 0)
                 {
-                    // copy object data pointer to TOS to be used by init 
-                    long a = (GET_SP)[1];
-                    SPUSH(a);
+                    // init op consumes the object pointer
+                    PUSH_OBJECT(newObject);
                     mpEngine->FullyExecuteOp(pCore, initOpcode);
                 }
-
-                ForthObject newObject;
-                POP_OBJECT(newObject);
                 // new object has refcount of 1
                 newObject->refCount = 1;
                 mObjects.push_back(newObject);
@@ -405,7 +575,7 @@ void ForthObjectReader::processElement(const std::string& name)
         else
         {
             // lookup name in current vocabulary to see how to process
-            forthop* pEntry = mContext.pVocab->FindSymbol(name.c_str());
+            forthop* pEntry = findField(name);
             if (pEntry != nullptr)
             {
                 // TODO - handle number, string, object, array
@@ -425,11 +595,7 @@ void ForthObjectReader::processElement(const std::string& name)
                     baseType = kBaseTypeCell;
                     isArray = false;
                 }
-                float fval;
-                double dval;
-                int ival;
-                int64_t lval;
-                std::string str;
+                std::string& str = mValueText;
                 char *pDst = mContext.pData + byteOffset;
                 int roomLeft = mContext.pVocab->GetSize() - byteOffset;
 
@@ -452,11 +618,7 @@ void ForthObjectReader::processElement(const std::string& name)
                         {
                             throwError("data would overrun object end");
                         }
-                        if (sscanf(str.c_str(), "%d", &ival) != 1)
-                        {
-                            throwError("failed to parse byte");
-                        }
-                        *pDst = (char)ival;
+                        *pDst = (char)parseInteger(str, "failed to parse byte");
                         bytesConsumed = 1;
                         break;
                     }
@@ -469,11 +631,7 @@ void ForthObjectReader::processElement(const std::string& name)
                         {
                             throwError("data would overrun object end");
                         }
-                        if (sscanf(str.c_str(), "%d", &ival) != 1)
-                        {
-                            throwError("failed to parse short");
-                        }
-                        *(short *)pDst = (short)ival;
+                        *(short *)pDst = (short)parseInteger(str, "failed to parse short");
                         bytesConsumed = 2;
                         break;
                     }
@@ -487,11 +645,7 @@ void ForthObjectReader::processElement(const std::string& name)
                         {
                             throwError("data would overrun object end");
                         }
-                        if (sscanf(str.c_str(), "%d", &ival) != 1)
-                        {
-                            throwError("failed to parse int");
-                        }
-                        *(int *)pDst = ival;
+                        *(int *)pDst = (int)parseInteger(str, "failed to parse int");
                         bytesConsumed = 4;
                         break;
                     }
@@ -504,11 +658,7 @@ void ForthObjectReader::processElement(const std::string& name)
                         {
                             throwError("data would overrun object end");
                         }
-                        if (sscanf(str.c_str(), "%lld", &lval) != 1)
-                        {
-                            throwError("failed to parse long");
-                        }
-                        *(int64_t *)pDst = lval;
+                        *(int64_t *)pDst = parseInteger(str, "failed to parse long");
                         bytesConsumed = 8;
                         break;
                     }
@@ -520,11 +670,7 @@ void ForthObjectReader::processElement(const std::string& name)
                         {
                             throwError("data would overrun object end");
                         }
-                        if (sscanf(str.c_str(), "%g", &fval) != 1)
-                        {
-                            throwError("failed to parse float");
-                        }
-                        *(float *)pDst = (short)fval;
+                        *(float *)pDst = (float)parseDouble(str, "failed to parse float");
                         bytesConsumed = 4;
                         break;
                     }
@@ -536,11 +682,7 @@ void ForthObjectReader::processElement(const std::string& name)
                         {
                             throwError("data would overrun object end");
                         }
-                        if (sscanf(str.c_str(), "%g", &dval) != 1)
-                        {
-                            throwError("failed to parse double");
-                        }
-                        *(double *)pDst = dval;
+                        *(double *)pDst = parseDouble(str, "failed to parse double");
                         bytesConsumed = 8;
                         break;
                     }
@@ -5,13 +5,17 @@
 //
 //////////////////////////////////////////////////////////////////////
 
-#include <map>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include "ForthEngine.h"
 #include "ForthBuiltinClasses.h"
 
 class ForthClassVocabulary;
 
+// size of the block the reader fills from its input stream with one inBytes call
+#define OBJECT_READER_BUFFER_SIZE   65536
+
 typedef struct
 {
     ForthStructVocabulary* pVocab;
@@ -19,6 +23,8 @@ typedef struct
     char* pData;
 } CustomReaderContext;
 
+// ForthObjectReader reads its input stream in large blocks and scans the text in its buffer,
+//   so it may read past the end of the objects it returns
 class ForthObjectReader
 {
 public:
@@ -34,6 +40,7 @@ public:
     void getRequiredChar(char ch);
     void ungetChar(char ch);
     void getName(std::string& name);
+    // string with backslash escapes decoded
     void getString(std::string& str);
     void getNumber(std::string& str);
     void skipWhitespace();
@@ -49,7 +56,20 @@ public:
 
 private:
 
-    typedef std::map<std::string, int> knownObjectMap;
+    typedef std::unordered_map<std::string, int> knownObjectMap;
+    typedef std::unordered_map<std::string, forthop*> fieldMap;
+
+    // refills the buffer when it is empty, returns false at end of input
+    inline bool haveInput() { return (mpCursor != mpLimit) || fillBuffer(); }
+    bool fillBuffer();
+    // updates line number and char offset for chars [pStart, pEnd) which have been consumed
+    void advancePosition(const char* pStart, const char* pEnd);
+    char getEscapedChar();
+    // number parsing, throws pErrorMessage if str doesn't start with a number
+    int64_t parseInteger(const std::string& str, const char* pErrorMessage);
+    double parseDouble(const std::string& str, const char* pErrorMessage);
+    forthop* findField(const std::string& name);
+    ForthStructVocabulary* findClassVocabulary(const std::string& className);
 
     ForthObject mInStreamObject;
     ForthObject mOutArrayObject;
@@ -60,6 +80,15 @@ private:
     std::vector<CustomReaderContext> mContextStack;
 
     knownObjectMap mKnownObjects;
+    // vocabulary lookups are cached, since every object of a class has the same fields
+    std::unordered_map<ForthStructVocabulary*, fieldMap> mFieldCache;
+    std::unordered_map<std::string, ForthStructVocabulary*> mClassVocabCache;
+
+    std::vector<char> mBuffer;
+    const char* mpCursor;
+    const char* mpLimit;
+    // numbers and strings are parsed from here, to avoid allocating a string per value
+    std::string mValueText;
 
     ForthEngine *mpEngine;
     ForthCoreState* mpCore;
@@ -36,6 +36,8 @@
 #include "ForthBlockFileManager.h"
 #include "ForthShowContext.h"
 #include "ForthObjectReader.h"
+#include "ForthBinarySerializer.h"
+#include "ForthNumberFormat.h"
 
 #if defined(LINUX) || defined(MACOSX)
 #include <strings.h>
@@ -2031,6 +2033,15 @@ FORTHOP( ptrToOp )
     pEngine->SetFlag( kEngineFlagIsPointer );
 }
 
+// weak ( -- )
+// the next object field declared in a struct or class holds a reference which is not refcounted,
+//   it must be stored with ->o and is ignored by the cycle collector
+FORTHOP( weakOp )
+{
+    ForthEngine *pEngine = GET_ENGINE;
+    pEngine->SetFlag( kEngineFlagIsWeak );
+}
+
 FORTHOP( structOp )
 {
     ForthEngine* pEngine = GET_ENGINE;
@@ -2695,6 +2706,77 @@ FORTHOP(readObjectsOp)
     }
 }
 
+// writeBinaryObjects ( ROOT_OBJ OUT_STREAM -- )
+FORTHOP(writeBinaryObjectsOp)
+{
+    ForthObject outStream;
+    ForthObject rootObj;
+    POP_OBJECT(outStream);
+    POP_OBJECT(rootObj);
+    ForthBinaryWriter writer;
+
+    bool itWorked = writer.WriteObjects(rootObj, outStream, pCore);
+    if (!itWorked)
+    {
+        ForthEngine *pEngine = GET_ENGINE;
+        pEngine->SetError(kForthErrorIO, writer.GetError().c_str());
+    }
+}
+
+// readBinaryObjects ( IN_STREAM -- ROOT_OBJ )
+FORTHOP(readBinaryObjectsOp)
+{
+    ForthObject inStream;
+    ForthObject rootObj;
+    POP_OBJECT(inStream);
+    ForthBinaryReader reader;
+
+    bool itWorked = reader.ReadObjects(inStream, rootObj, pCore);
+    if (!itWorked)
+    {
+        ForthEngine *pEngine = GET_ENGINE;
+        pEngine->SetError(kForthErrorIO, reader.GetError().c_str());
+        rootObj = nullptr;
+    }
+    PUSH_OBJECT(rootObj);
+}
+
+// loadBinaryObjects ( PATH_STRING -- ROOT_OBJ )
+FORTHOP(loadBinaryObjectsOp)
+{
+    const char* pPath = (const char*)(SPOP);
+    ForthObject rootObj;
+    ForthBinaryReader reader;
+
+    bool itWorked = reader.LoadObjects(pPath, rootObj, pCore);
+    if (!itWorked)
+    {
+        ForthEngine *pEngine = GET_ENGINE;
+        pEngine->SetError(kForthErrorIO, reader.GetError().c_str());
+        rootObj = nullptr;
+    }
+    PUSH_OBJECT(rootObj);
+}
+
+// tryLoadBinaryObjects ( PATH_STRING -- ROOT_OBJ ERROR_STRING )
+// like loadBinaryObjects, but a file which can't be read doesn't stop execution,
+//   ERROR_STRING is null if the file was read
+FORTHOP(tryLoadBinaryObjectsOp)
+{
+    const char* pPath = (const char*)(SPOP);
+    ForthObject rootObj;
+    ForthBinaryReader reader;
+
+    const char* pError = nullptr;
+    if (!reader.LoadObjects(pPath, rootObj, pCore))
+    {
+        pError = GET_ENGINE->AddTempString(reader.GetError().c_str());
+        rootObj = nullptr;
+    }
+    PUSH_OBJECT(rootObj);
+    SPUSH((cell)pError);
+}
+
 FORTHOP(enumOp)
 {
     ForthEngine *pEngine = GET_ENGINE;
@@ -3239,6 +3321,15 @@ consoleOutToOp( ForthCoreState   *pCore,
     pEngine->ExecuteOneOp(pCore,  op );
 }
 */
+// signed unless the print signed mode says otherwise
+static inline bool
+printNumSigned( ForthCoreState   *pCore,
+                long             base )
+{
+    ePrintSignedMode signMode = (ePrintSignedMode) GET_PRINT_SIGNED_NUM_MODE;
+    return (signMode == kPrintAllSigned) || ((base == 10) && (signMode == kPrintSignedDecimal));
+}
+
 static void
 printNumInCurrentBase( ForthCoreState   *pCore,
                        long             val )
@@ -3246,81 +3337,24 @@ printNumInCurrentBase( ForthCoreState   *pCore,
     NEEDS(1);
 #define PRINT_NUM_BUFF_CHARS 68
     char buff[ PRINT_NUM_BUFF_CHARS ];
-    char *pNext = &buff[ PRINT_NUM_BUFF_CHARS ];
-    ldiv_t v;
-    long base;
-    bool bIsNegative, bPrintUnsigned;
-    ulong urem;
-    ePrintSignedMode signMode;
+    long base = *(GET_BASE_REF);
+    int numChars;
 
-    if ( val == 0 )
+    if ( printNumSigned( pCore, base ) )
     {
-        strcpy( buff, "0 " );
-        pNext = buff;
+        numChars = FormatSignedNumber( buff, val, (int) base );
     }
     else
     {
-        base = *(GET_BASE_REF);
-
-        signMode = (ePrintSignedMode) GET_PRINT_SIGNED_NUM_MODE;
-        if ( (base == 10) && (signMode == kPrintSignedDecimal) )
-        {
-
-            // most common case - print signed decimal
-            SNPRINTF( buff, sizeof(buff), "%d ", val );
-            pNext = buff;
-
-        }
-        else
-        {
-
-            // unsigned or any base other than 10
-
-            *--pNext = 0;
-            *--pNext = ' ';
-            bPrintUnsigned = !(signMode == kPrintAllSigned);
-            if ( bPrintUnsigned )
-            {
-                // since div is defined as signed divide/mod, make sure
-                //   that the number is not negative by generating the bottom digit
-                bIsNegative = false;
-                urem = ((ulong) val) % ((ulong) base);
-                *--pNext = (char) ( (urem < 10) ? (urem + '0') : ((urem - 10) + 'a') );
-                val = ((ulong) val) / ((ulong) base);
-            }
-            else
-            {
-                bIsNegative = ( val < 0 );
-                if ( bIsNegative )
-                {
-                    val = (-val);
-                }
-            }
-            while ( val != 0 )
-            {
-#if defined(WINDOWS_BUILD)
-#if defined(MSDEV)
-                v = div( val, base );
-#else
-                v = ldiv( val, base );
-#endif
-#elif defined(LINUX) || defined(MACOSX)
-                v = ldiv( val, base );
-#endif
-                *--pNext = (char) ( (v.rem < 10) ? (v.rem + '0') : ((v.rem - 10) + 'a') );
-                val = v.quot;
-            }
-            if ( bIsNegative )
-            {
-                *--pNext = '-';
-            }
-        }
+        numChars = FormatUnsignedNumber( buff, (ulong) val, (int) base );
     }
+    buff[numChars++] = ' ';
+    buff[numChars] = '\0';
 #ifdef TRACE_PRINTS
-    SPEW_PRINTS( "printed %s\n", pNext );
+    SPEW_PRINTS( "printed %s\n", buff );
 #endif
 
-    CONSOLE_STRING_OUT( pNext );
+    CONSOLE_BYTES_OUT( buff, numChars );
 }
 
 
@@ -3329,88 +3363,25 @@ printLongNumInCurrentBase( ForthCoreState   *pCore,
 						   int64_t        val )
 {
     NEEDS(1);
-#define PRINT_NUM_BUFF_CHARS 68
     char buff[ PRINT_NUM_BUFF_CHARS ];
-    char *pNext = &buff[ PRINT_NUM_BUFF_CHARS ];
-    ulong base;
-    bool bIsNegative, bPrintUnsigned;
-    ulong urem;
-	uint64_t uval;
-    ePrintSignedMode signMode;
+    long base = *(GET_BASE_REF);
+    int numChars;
 
-    if ( val == 0L )
+    if ( printNumSigned( pCore, base ) )
     {
-        strcpy( buff, "0 " );
-        pNext = buff;
+        numChars = FormatSignedNumber( buff, val, (int) base );
     }
     else
     {
-        base = (ulong) *(GET_BASE_REF);
-
-        signMode = (ePrintSignedMode) GET_PRINT_SIGNED_NUM_MODE;
-        if ( base == 10 ) 
-        {
-
-            // most common case - print signed decimal
-			switch ( signMode )
-			{
-			case kPrintAllUnsigned:
-	            SNPRINTF( buff, sizeof(buff), "%ulld ", val );
-				break;
-			default:
-	            SNPRINTF( buff, sizeof(buff), "%lld ", val );
-				break;
-			}
-            pNext = buff;
-
-        }
-        else
-        {
-
-            // unsigned or any base other than 10
-
-            *--pNext = 0;
-            *--pNext = ' ';
-            bPrintUnsigned = !(signMode == kPrintAllSigned);
-            if ( bPrintUnsigned )
-            {
-                // since div is defined as signed divide/mod, make sure
-                //   that the number is not negative by generating the bottom digit
-                bIsNegative = false;
-				uval = (uint64_t) val;
-                urem = uval % base;
-                *--pNext = (char) ( (urem < 10) ? (urem + '0') : ((urem - 10) + 'a') );
-                uval = uval / base;
-            }
-            else
-            {
-                bIsNegative = ( val < 0 );
-                if ( bIsNegative )
-                {
-                    uval = (-val);
-                }
-				else
-				{
-					uval = val;
-				}
-            }
-            while ( uval != 0 )
-            {
-                urem = uval % base;
-                *--pNext = (char) ( (urem < 10) ? (urem + '0') : ((urem - 10) + 'a') );
-                uval = uval / base;
-            }
-            if ( bIsNegative )
-            {
-                *--pNext = '-';
-            }
-        }
+        numChars = FormatUnsignedNumber( buff, (uint64_t) val, (int) base );
     }
+    buff[numChars++] = ' ';
+    buff[numChars] = '\0';
 #ifdef TRACE_PRINTS
-    SPEW_PRINTS( "printed %s\n", pNext );
+    SPEW_PRINTS( "printed %s\n", buff );
 #endif
 
-    CONSOLE_STRING_OUT( pNext );
+    CONSOLE_BYTES_OUT( buff, numChars );
 }
 
 
@@ -3439,45 +3410,39 @@ FORTHOP( printLongNumOp )
 FORTHOP( printNumDecimalOp )
 {
     NEEDS(1);
-    char buff[40];
+    char buff[NUMBER_FORMAT_MAX_CHARS];
 
     cell val = SPOP;
-#if defined(FORTH64)
-    SNPRINTF(buff, sizeof(buff), "%lld", val);
-#else
-    SNPRINTF(buff, sizeof(buff), "%d", val);
-#endif
+    int numChars = FormatSignedNumber( buff, val, 10 );
 
 #ifdef TRACE_PRINTS
+    buff[numChars] = '\0';
     SPEW_PRINTS( "printed %s\n", buff );
 #endif
 
-    CONSOLE_STRING_OUT( buff );
+    CONSOLE_BYTES_OUT( buff, numChars );
 }
 
 FORTHOP( printNumHexOp )
 {
     NEEDS(1);
-    char buff[20];
+    char buff[NUMBER_FORMAT_MAX_CHARS];
 
     cell val = SPOP;
-#if defined(FORTH64)
-    SNPRINTF(buff, sizeof(buff), "%llx", val);
-#else
-    SNPRINTF(buff, sizeof(buff), "%x", val);
-#endif
+    int numChars = FormatUnsignedNumber( buff, (ucell) val, 16 );
 
 #ifdef TRACE_PRINTS
+    buff[numChars] = '\0';
     SPEW_PRINTS( "printed %s\n", buff );
 #endif
 
-    CONSOLE_STRING_OUT( buff );
+    CONSOLE_BYTES_OUT( buff, numChars );
 }
 
 FORTHOP( printLongDecimalOp )
 {
     NEEDS(2);
-    char buff[40];
+    char buff[NUMBER_FORMAT_MAX_CHARS];
 
     int64_t val;
 #if defined(FORTH64)
@@ -3487,22 +3452,19 @@ FORTHOP( printLongDecimalOp )
     LPOP(sval);
     val = sval.s64;
 #endif
-#if defined(WINDOWS_BUILD)
-    SNPRINTF( buff, sizeof(buff), "%I64d", val );
-#else
-    SNPRINTF( buff, sizeof(buff), "%lld", val);
-#endif
+    int numChars = FormatSignedNumber( buff, val, 10 );
 #ifdef TRACE_PRINTS
+    buff[numChars] = '\0';
     SPEW_PRINTS( "printed %s\n", buff );
 #endif
 
-    CONSOLE_STRING_OUT( buff );
+    CONSOLE_BYTES_OUT( buff, numChars );
 }
 
 FORTHOP( printLongHexOp )
 {
     NEEDS(1);
-    char buff[20];
+    char buff[NUMBER_FORMAT_MAX_CHARS];
 
     int64_t val;
 #if defined(FORTH64)
@@ -3512,16 +3474,13 @@ FORTHOP( printLongHexOp )
     LPOP(sval);
     val = sval.s64;
 #endif
-#if defined(WINDOWS_BUILD)
-    SNPRINTF( buff, sizeof(buff), "%I64x", val );
-#else
-    SNPRINTF( buff, sizeof(buff), "%llx", val );
-#endif
+    int numChars = FormatUnsignedNumber( buff, (uint64_t) val, 16 );
 #ifdef TRACE_PRINTS
+    buff[numChars] = '\0';
     SPEW_PRINTS( "printed %s\n", buff );
 #endif
 
-    CONSOLE_STRING_OUT( buff );
+    CONSOLE_BYTES_OUT( buff, numChars );
 }
 
 FORTHOP( printFloatOp )
@@ -3580,6 +3539,37 @@ FORTHOP(printDoubleGOp)
 	CONSOLE_STRING_OUT(buff);
 }
 
+// %rf and %2rf print the shortest text which reads back as exactly the same number
+FORTHOP(printFloatShortestOp)
+{
+	NEEDS(1);
+	char buff[NUMBER_FORMAT_MAX_FLOAT_CHARS];
+
+	float fval = FPOP;
+	int numChars = FormatShortestFloat(buff, fval);
+#ifdef TRACE_PRINTS
+	buff[numChars] = '\0';
+	SPEW_PRINTS("printed %s\n", buff);
+#endif
+
+	CONSOLE_BYTES_OUT(buff, numChars);
+}
+
+FORTHOP(printDoubleShortestOp)
+{
+	NEEDS(2);
+	char buff[NUMBER_FORMAT_MAX_FLOAT_CHARS];
+	double dval = DPOP;
+
+	int numChars = FormatShortestDouble(buff, dval);
+#ifdef TRACE_PRINTS
+	buff[numChars] = '\0';
+	SPEW_PRINTS("printed %s\n", buff);
+#endif
+
+	CONSOLE_BYTES_OUT(buff, numChars);
+}
+
 FORTHOP(format32Op)
 {
     NEEDS(2);
@@ -3910,7 +3900,12 @@ cell oStringFormatSub(ForthCoreState* pCore, char* pBuffer, int bufferSize)
 		a[i] = SPOP;
 	}
 	const char* fmt = (const char *)SPOP;
-    cell result = 0;
+    // simple formats are done without snprintf
+    cell result = ForthFastFormat(pBuffer, bufferSize, fmt, a, (int)numArgs);
+    if (result != FAST_FORMAT_UNHANDLED)
+    {
+        return result;
+    }
     switch (numArgs)
     {
     case 0:
@@ -5844,6 +5839,100 @@ FORTHOP(getCurrentThreadOp)
 	PUSH_OBJECT(pThread->GetThreadObject());
 }
 
+// share ( OBJ -- )
+// mark object and everything reachable from it as shared between threads, so that
+//   their refcounts are updated atomically
+FORTHOP(shareOp)
+{
+	ForthObject obj;
+	POP_OBJECT(obj);
+	ForthShareObject(obj);
+}
+
+// enableCycleCollector ( FLAG -- )
+// when enabled, garbage cycles of objects are found and deleted when the number of
+//   possible cycle roots reaches the threshold, or when collectCycles is executed
+FORTHOP(enableCycleCollectorOp)
+{
+	ForthCycleCollector::GetInstance()->SetEnabled(SPOP != 0);
+}
+
+// cycleCollectable ( -- )
+// used inside a class definition to let the cycle collector examine objects of the class,
+//   only do this if every object field which doesn't hold a refcount is marked weak
+FORTHOP(cycleCollectableOp)
+{
+	ForthEngine *pEngine = GET_ENGINE;
+	if ( pEngine->CheckFlag( kEngineFlagInClassDefinition ) )
+	{
+		ForthTypesManager::GetInstance()->GetNewestClass()->SetCycleCollectable( true );
+	}
+	else
+	{
+		pEngine->SetError( kForthErrorBadSyntax, "cycleCollectable is only legal in a class definition" );
+	}
+}
+
+// setCycleThreshold ( NUM_ROOTS -- )
+FORTHOP(setCycleThresholdOp)
+{
+	ForthCycleCollector::GetInstance()->SetRootThreshold((ucell)(SPOP));
+}
+
+// collectCycles ( -- NUM_OBJECTS_DELETED )
+FORTHOP(collectCyclesOp)
+{
+	ucell numDeleted = ForthCycleCollector::GetInstance()->Collect(pCore);
+	SPUSH((cell)numDeleted);
+}
+
+// cycleStats ( -- )
+FORTHOP(cycleStatsOp)
+{
+	ForthCycleCollector::GetInstance()->ShowStats(pCore);
+}
+
+// deferReleases ( FLAG -- )
+// when enabled, objects whose refcount drops to zero are put on the thread release queue
+//   instead of being deleted immediately
+FORTHOP(deferReleasesOp)
+{
+	ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+	ForthThread* pThread = pFiber->GetParent();
+	bool deferReleases = (SPOP != 0);
+	if (!deferReleases)
+	{
+		pThread->DrainReleaseQueue(pCore, true);
+	}
+	pThread->SetDeferReleases(deferReleases);
+}
+
+// setReleaseBudget ( MILLISECONDS -- )
+// limit time spent deleting queued objects at each yield point, 0 means no limit
+FORTHOP(setReleaseBudgetOp)
+{
+	ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+	ForthThread* pThread = pFiber->GetParent();
+	pThread->SetReleaseBudget((ulong)(SPOP));
+}
+
+// drainReleases ( -- )
+// delete all objects on the thread release queue, ignoring the release budget
+FORTHOP(drainReleasesOp)
+{
+	ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+	ForthThread* pThread = pFiber->GetParent();
+	pThread->DrainReleaseQueue(pCore, true);
+}
+
+// pendingReleases ( -- NUM_OBJECTS )
+FORTHOP(pendingReleasesOp)
+{
+	ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+	ForthThread* pThread = pFiber->GetParent();
+	SPUSH((cell)(pThread->GetNumPendingReleases()));
+}
+
 #ifdef WIN32
 ///////////////////////////////////////////
 //  Windows support
@@ -8131,17 +8220,14 @@ FORTHOP( noopBop )
 
 FORTHOP(odropBop)
 {
-    ForthEngine *pEngine = GET_ENGINE;
     ForthObject obj;
 
-    // if object on TOS has refcount 0, invoke its delete method
+    // if object on TOS has refcount 0, delete it (or queue it for deletion if releases are deferred)
     //  otherwise just drop it
     POP_OBJECT(obj);
-    if ((obj != nullptr) && (obj->refCount == 0))
+    if ((obj != nullptr) && (OBJECT_REFCOUNT(obj) == 0))
     {
-        RPUSH(((cell)GET_TP));
-        SET_TP(obj);
-        pEngine->ExecuteOp(pCore, obj->pMethods[0]);
+        ReleaseDeadObject(pCore, obj);
     }
 }
 
@@ -9849,6 +9935,7 @@ baseDictionaryEntry baseDictionary[] =
     PRECOP_DEF(voidOp,                 "void" ),
     PRECOP_DEF(arrayOfOp,              "arrayOf" ),
     PRECOP_DEF(ptrToOp,                "ptrTo" ),
+    PRECOP_DEF(weakOp,                 "weak" ),
     OP_DEF(    structOp,               "struct:" ),
     OP_DEF(    endstructOp,            ";struct" ),
     OP_DEF(    classOp,                "class:" ),
@@ -9872,6 +9959,10 @@ baseDictionaryEntry baseDictionary[] =
     PRECOP_DEF(makeObjectOp,           "makeObject" ),
     PRECOP_DEF(initMemberStringOp,     "initMemberString"),
     OP_DEF(    readObjectsOp,          "readObjects" ),
+    OP_DEF(    writeBinaryObjectsOp,   "writeBinaryObjects" ),
+    OP_DEF(    readBinaryObjectsOp,    "readBinaryObjects" ),
+    OP_DEF(    loadBinaryObjectsOp,    "loadBinaryObjects" ),
+    OP_DEF(    tryLoadBinaryObjectsOp, "tryLoadBinaryObjects" ),
     OP_DEF(    enumOp,                 "enum:" ),
     OP_DEF(    endenumOp,              ";enum" ),
     OP_DEF(    findEnumSymbolOp,       "findEnumSymbol" ),
@@ -9940,6 +10031,8 @@ baseDictionaryEntry baseDictionary[] =
     OP_DEF(    printDoubleOp,          "%2f" ),
     OP_DEF(    printFloatGOp,          "%g" ),
     OP_DEF(    printDoubleGOp,         "%2g" ),
+    OP_DEF(    printFloatShortestOp,   "%rf" ),
+    OP_DEF(    printDoubleShortestOp,  "%2rf" ),
     OP_DEF(    format32Op,             "format" ),
     OP_DEF(    format64Op,             "2format" ),
     OP_DEF(    scanIntOp,              "scanInt" ),
@@ -10123,6 +10216,16 @@ baseDictionaryEntry baseDictionary[] =
     OP_DEF( exitFiberOp,				"exitFiber" ),
 	OP_DEF( getCurrentFiberOp,          "getCurrentFiber"),
 	OP_DEF( getCurrentThreadOp,         "getCurrentThread"),
+	OP_DEF( shareOp,                    "share"),
+	OP_DEF( enableCycleCollectorOp,     "enableCycleCollector"),
+	OP_DEF( cycleCollectableOp,         "cycleCollectable"),
+	OP_DEF( setCycleThresholdOp,        "setCycleThreshold"),
+	OP_DEF( collectCyclesOp,            "collectCycles"),
+	OP_DEF( cycleStatsOp,               "cycleStats"),
+	OP_DEF( deferReleasesOp,            "deferReleases"),
+	OP_DEF( setReleaseBudgetOp,         "setReleaseBudget"),
+	OP_DEF( drainReleasesOp,            "drainReleases"),
+	OP_DEF( pendingReleasesOp,          "pendingReleases"),
 
     ///////////////////////////////////////////
     //  exception handling
@@ -515,7 +515,10 @@ ForthShell::Run( ForthInputStream *pInStream )
             }
         }
     } // while !bQuit
-    
+
+    ForthFlushPendingOutStreams(mpEngine->GetCoreState());
+    ForthFlushOutStream(mpEngine->GetCoreState(), mpEngine->GetCoreState()->consoleOutStream);
+
     return retVal;
 }
 
@@ -722,6 +725,7 @@ ForthShell::InterpretLine( const char *pSrcLine )
             if ( result == kResultOk )
 			{
                 result = mpEngine->CheckStacks();
+                ForthCycleCollector::GetInstance()->CollectIfPending(mpEngine->GetCoreState());
             }
         }
         if (result != kResultOk)
@@ -746,6 +750,8 @@ ForthShell::InterpretLine( const char *pSrcLine )
             }
         }
     }
+    // don't leave buffered output behind the next prompt
+    ForthFlushPendingOutStreams(mpEngine->GetCoreState());
 
     return result;
 }
@@ -201,7 +201,7 @@ void ForthShowContext::ShowHeader(ForthCoreState* pCore, const char* pTypeName,
 
         ShowIndent();
         ShowText(mShowSpaces ? "\"__refCount\" : " : "\"__refCount\":");
-		sprintf(buffer, "%d,", *(int *)(pData));
+		sprintf(buffer, "%d,", (int) OBJECT_REFCOUNT((ForthObject)pData));
 		EndElement(buffer);
         mNumShown++;
 	}
@@ -239,13 +239,27 @@ void ForthShowContext::ShowText(const char* pText)
     }
 }
 
+// quotes, backslashes and line breaks are escaped so the object reader can read the text back
 void ForthShowContext::ShowQuotedText(const char* pText)
 {
     if (pText != NULL)
     {
-        mpEngine->ConsoleOut("\"");
-        mpEngine->ConsoleOut(pText);
-        mpEngine->ConsoleOut("\"");
+        std::string quoted("\"");
+        for (const char* pSrc = pText; *pSrc != '\0'; pSrc++)
+        {
+            char ch = *pSrc;
+            switch (ch)
+            {
+            case '\"':  quoted.append("\\\"");  break;
+            case '\\':  quoted.append("\\\\");  break;
+            case '\n':  quoted.append("\\n");   break;
+            case '\r':  quoted.append("\\r");   break;
+            case '\t':  quoted.append("\\t");   break;
+            default:    quoted.push_back(ch);   break;
+            }
+        }
+        quoted.push_back('\"');
+        mpEngine->ConsoleOut(quoted.c_str());
     }
 }
 
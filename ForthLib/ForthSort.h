@@ -0,0 +1,483 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// ForthSort.h: native sorting routines used by the builtin array classes
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <string.h>
+
+#include "ForthWorkerPool.h"
+
+// arrays with fewer elements than this are sorted on the calling thread
+#define PARALLEL_SORT_THRESHOLD     (1 << 20)
+// arrays with fewer elements than this are sorted with std::stable_sort instead of radix sort
+#define RADIX_SORT_THRESHOLD        256
+
+// radix key traits map each element to an unsigned key which sorts in the same order as the
+//   element, the radix sort sorts on the bytes of the key, lowest byte first
+template <class T, class UKEY>
+struct ForthUnsignedRadixKey
+{
+    typedef UKEY KeyType;
+    static inline UKEY ToKey(T val) { return (UKEY)val; }
+};
+
+// flipping the sign bit makes two's complement values sort as unsigned
+template <class T, class UKEY>
+struct ForthSignedRadixKey
+{
+    typedef UKEY KeyType;
+    static inline UKEY ToKey(T val) { return ((UKEY)val) ^ (((UKEY)1) << ((sizeof(UKEY) * 8) - 1)); }
+};
+
+// IEEE floats sort as unsigned after flipping all bits of negative values and just
+//   the sign bit of positive values
+template <class T, class UKEY>
+struct ForthFloatRadixKey
+{
+    typedef UKEY KeyType;
+    static inline UKEY ToKey(T val)
+    {
+        UKEY bits;
+        memcpy(&bits, &val, sizeof(bits));
+        UKEY signBit = ((UKEY)1) << ((sizeof(UKEY) * 8) - 1);
+        return (bits & signBit) ? ~bits : (bits ^ signBit);
+    }
+};
+
+template <class T, class KEYTRAITS>
+struct ForthRadixKeyLess
+{
+    inline bool operator()(T a, T b) const { return KEYTRAITS::ToKey(a) < KEYTRAITS::ToKey(b); }
+};
+
+// LSD radix sort of pData, pTemp must have room for numElements, sorted result ends up in pData
+template <class T, class KEYTRAITS>
+void ForthRadixSort(T* pData, T* pTemp, size_t numElements)
+{
+    typedef typename KEYTRAITS::KeyType UKEY;
+    const int numPasses = sizeof(UKEY);
+    if (numElements < RADIX_SORT_THRESHOLD)
+    {
+        // the radix sort is stable, so this must be too, sortByKey keeps the order of equal keys
+        std::stable_sort(pData, pData + numElements, ForthRadixKeyLess<T, KEYTRAITS>());
+        return;
+    }
+
+    // count all digits in one pass over the data
+    std::vector<size_t> counts(numPasses * 256, 0);
+    for (size_t i = 0; i < numElements; i++)
+    {
+        UKEY key = KEYTRAITS::ToKey(pData[i]);
+        for (int pass = 0; pass < numPasses; pass++)
+        {
+            counts[(pass << 8) + ((key >> (pass << 3)) & 0xFF)]++;
+        }
+    }
+
+    T* pSrc = pData;
+    T* pDst = pTemp;
+    for (int pass = 0; pass < numPasses; pass++)
+    {
+        size_t* pCounts = &(counts[pass << 8]);
+        // skip passes where every element has the same digit
+        bool allSame = false;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            if (pCounts[digit] != 0)
+            {
+                allSame = (pCounts[digit] == numElements);
+                break;
+            }
+        }
+        if (allSame)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            size_t count = pCounts[digit];
+            pCounts[digit] = offset;
+            offset += count;
+        }
+        int shift = pass << 3;
+        for (size_t i = 0; i < numElements; i++)
+        {
+            T val = pSrc[i];
+            pDst[pCounts[(KEYTRAITS::ToKey(val) >> shift) & 0xFF]++] = val;
+        }
+        std::swap(pSrc, pDst);
+    }
+
+    if (pSrc != pData)
+    {
+        memcpy(pData, pSrc, numElements * sizeof(T));
+    }
+}
+
+template <class T, class KEYTRAITS>
+struct ForthParallelSortJob
+{
+    T*                  pData;
+    T*                  pTemp;
+    size_t              numElements;
+    int                 numChunks;
+    // current merge round, runs of (chunkSize << round) elements are merged in pairs
+    int                 round;
+    size_t              chunkSize;
+    T*                  pSrc;
+    T*                  pDst;
+
+    inline size_t RunStart(int runIndex, size_t runSize)
+    {
+        size_t start = runIndex * runSize;
+        return (start < numElements) ? start : numElements;
+    }
+
+    static void SortChunk(int taskIndex, void* pUserData)
+    {
+        ForthParallelSortJob* pJob = (ForthParallelSortJob*)pUserData;
+        size_t start = pJob->RunStart(taskIndex, pJob->chunkSize);
+        size_t end = pJob->RunStart(taskIndex + 1, pJob->chunkSize);
+        ForthRadixSort<T, KEYTRAITS>(pJob->pData + start, pJob->pTemp + start, end - start);
+    }
+
+    static void MergeRuns(int taskIndex, void* pUserData)
+    {
+        ForthParallelSortJob* pJob = (ForthParallelSortJob*)pUserData;
+        size_t runSize = pJob->chunkSize << pJob->round;
+        size_t start = pJob->RunStart(taskIndex * 2, runSize);
+        size_t mid = pJob->RunStart((taskIndex * 2) + 1, runSize);
+        size_t end = pJob->RunStart((taskIndex * 2) + 2, runSize);
+        std::merge(pJob->pSrc + start, pJob->pSrc + mid, pJob->pSrc + mid, pJob->pSrc + end,
+            pJob->pDst + start, ForthRadixKeyLess<T, KEYTRAITS>());
+    }
+};
+
+// sort numElements at pData, big arrays are split into chunks which are radix sorted in
+//   parallel on the worker pool, and then merged in parallel
+template <class T, class KEYTRAITS>
+void ForthParallelSort(T* pData, size_t numElements)
+{
+    std::vector<T> temp(numElements);
+    if (numElements < PARALLEL_SORT_THRESHOLD)
+    {
+        ForthRadixSort<T, KEYTRAITS>(pData, temp.data(), numElements);
+        return;
+    }
+
+    ForthWorkerPool* pPool = ForthWorkerPool::GetInstance();
+    int numChunks = 1;
+    int numThreads = pPool->GetNumThreads();
+    while ((numChunks < numThreads) && ((numElements / (numChunks << 1)) >= (PARALLEL_SORT_THRESHOLD >> 2)))
+    {
+        numChunks <<= 1;
+    }
+
+    ForthParallelSortJob<T, KEYTRAITS> job;
+    job.pData = pData;
+    job.pTemp = temp.data();
+    job.numElements = numElements;
+    job.numChunks = numChunks;
+    job.round = 0;
+    job.chunkSize = (numElements + numChunks - 1) / numChunks;
+    pPool->RunTasks(numChunks, ForthParallelSortJob<T, KEYTRAITS>::SortChunk, &job);
+
+    job.pSrc = pData;
+    job.pDst = temp.data();
+    for (int numRuns = numChunks; numRuns > 1; numRuns >>= 1)
+    {
+        pPool->RunTasks(numRuns >> 1, ForthParallelSortJob<T, KEYTRAITS>::MergeRuns, &job);
+        std::swap(job.pSrc, job.pDst);
+        job.round++;
+    }
+    if (job.pSrc != pData)
+    {
+        memcpy(pData, job.pSrc, numElements * sizeof(T));
+    }
+}
+
+//
+// pattern defeating quicksort, based on Orson Peters' pdqsort
+// Quicksort with median of 3 (or ninther for big ranges) pivots, which detects already
+//   partitioned ranges and finishes them with insertion sort, puts elements equal to the
+//   pivot into their own partition, shuffles elements around after badly unbalanced
+//   partitions, and falls back to heapsort after too many of them, so it is never O(N^2).
+// All scans are bounds checked, so a LESS which isn't a strict weak ordering (like a
+//   buggy forth compare method) leaves the range unsorted but doesn't run outside it.
+//
+
+#define PDQSORT_INSERTION_SORT_THRESHOLD    24
+#define PDQSORT_NINTHER_THRESHOLD           128
+#define PDQSORT_PARTIAL_INSERTION_LIMIT     8
+
+template <class ITER, class LESS>
+void ForthInsertionSort(ITER begin, ITER end, LESS& less)
+{
+    typedef typename std::iterator_traits<ITER>::value_type T;
+    if (begin == end)
+    {
+        return;
+    }
+    for (ITER cur = begin + 1; cur != end; ++cur)
+    {
+        ITER sift = cur;
+        ITER sift1 = cur - 1;
+        if (less(*sift, *sift1))
+        {
+            T tmp = std::move(*sift);
+            do
+            {
+                *sift-- = std::move(*sift1);
+            } while ((sift != begin) && less(tmp, *--sift1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// insertion sort which gives up after moving too many elements, returns true if range got sorted
+template <class ITER, class LESS>
+bool ForthPartialInsertionSort(ITER begin, ITER end, LESS& less)
+{
+    typedef typename std::iterator_traits<ITER>::value_type T;
+    if (begin == end)
+    {
+        return true;
+    }
+    size_t numMoved = 0;
+    for (ITER cur = begin + 1; cur != end; ++cur)
+    {
+        ITER sift = cur;
+        ITER sift1 = cur - 1;
+        if (less(*sift, *sift1))
+        {
+            T tmp = std::move(*sift);
+            do
+            {
+                *sift-- = std::move(*sift1);
+            } while ((sift != begin) && less(tmp, *--sift1));
+            *sift = std::move(tmp);
+            numMoved += cur - sift;
+        }
+        if (numMoved > PDQSORT_PARTIAL_INSERTION_LIMIT)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class ITER, class LESS>
+inline void ForthSort2(ITER a, ITER b, LESS& less)
+{
+    if (less(*b, *a))
+    {
+        std::iter_swap(a, b);
+    }
+}
+
+template <class ITER, class LESS>
+inline void ForthSort3(ITER a, ITER b, ITER c, LESS& less)
+{
+    ForthSort2(a, b, less);
+    ForthSort2(b, c, less);
+    ForthSort2(a, b, less);
+}
+
+// partition around pivot *begin, elements equal to pivot go in the right partition
+// returns pivot position, and sets alreadyPartitioned if no elements were swapped
+template <class ITER, class LESS>
+ITER ForthPartitionRight(ITER begin, ITER end, LESS& less, bool& alreadyPartitioned)
+{
+    typedef typename std::iterator_traits<ITER>::value_type T;
+    T pivot = std::move(*begin);
+    ITER first = begin;
+    ITER last = end;
+
+    while ((++first < end) && less(*first, pivot))
+    {
+    }
+    if ((first - 1) == begin)
+    {
+        while ((first < last) && !less(*--last, pivot))
+        {
+        }
+    }
+    else
+    {
+        while ((--last > begin) && !less(*last, pivot))
+        {
+        }
+    }
+
+    alreadyPartitioned = (first >= last);
+    while (first < last)
+    {
+        std::iter_swap(first, last);
+        while ((++first < end) && less(*first, pivot))
+        {
+        }
+        while ((--last > begin) && !less(*last, pivot))
+        {
+        }
+    }
+
+    ITER pivotPos = first - 1;
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+    return pivotPos;
+}
+
+// partition around pivot *begin, elements equal to pivot go in the left partition, this
+//   is used when the element before begin is equal to the pivot, so the left partition
+//   ends up holding only elements equal to the pivot, which are then done
+template <class ITER, class LESS>
+ITER ForthPartitionLeft(ITER begin, ITER end, LESS& less)
+{
+    typedef typename std::iterator_traits<ITER>::value_type T;
+    T pivot = std::move(*begin);
+    ITER first = begin;
+    ITER last = end;
+
+    while ((--last > begin) && less(pivot, *last))
+    {
+    }
+    if ((last + 1) == end)
+    {
+        while ((first < last) && !less(pivot, *++first))
+        {
+        }
+    }
+    else
+    {
+        while ((++first < end) && !less(pivot, *first))
+        {
+        }
+    }
+
+    while (first < last)
+    {
+        std::iter_swap(first, last);
+        while ((--last > begin) && less(pivot, *last))
+        {
+        }
+        while ((++first < end) && !less(pivot, *first))
+        {
+        }
+    }
+
+    ITER pivotPos = last;
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+    return pivotPos;
+}
+
+template <class ITER, class LESS>
+void ForthPdqSortLoop(ITER begin, ITER end, LESS& less, int badAllowed, bool leftmost)
+{
+    typedef typename std::iterator_traits<ITER>::difference_type diff_t;
+    while (true)
+    {
+        diff_t size = end - begin;
+        if (size < PDQSORT_INSERTION_SORT_THRESHOLD)
+        {
+            ForthInsertionSort(begin, end, less);
+            return;
+        }
+
+        // choose pivot as median of 3 or pseudomedian of 9, and move it to begin
+        diff_t s2 = size / 2;
+        if (size > PDQSORT_NINTHER_THRESHOLD)
+        {
+            ForthSort3(begin, begin + s2, end - 1, less);
+            ForthSort3(begin + 1, begin + (s2 - 1), end - 2, less);
+            ForthSort3(begin + 2, begin + (s2 + 1), end - 3, less);
+            ForthSort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), less);
+            std::iter_swap(begin, begin + s2);
+        }
+        else
+        {
+            ForthSort3(begin + s2, begin, end - 1, less);
+        }
+
+        // if pivot equals the element before this range, lots of elements are probably equal,
+        //   so put all the ones equal to pivot on the left, they don't need any more sorting
+        if (!leftmost && !less(*(begin - 1), *begin))
+        {
+            begin = ForthPartitionLeft(begin, end, less) + 1;
+            continue;
+        }
+
+        bool alreadyPartitioned;
+        ITER pivotPos = ForthPartitionRight(begin, end, less, alreadyPartitioned);
+        diff_t leftSize = pivotPos - begin;
+        diff_t rightSize = end - (pivotPos + 1);
+        if ((leftSize < (size / 8)) || (rightSize < (size / 8)))
+        {
+            // too many bad partitions means we are probably hitting a pattern, use heapsort
+            if (--badAllowed == 0)
+            {
+                std::make_heap(begin, end, less);
+                std::sort_heap(begin, end, less);
+                return;
+            }
+            if (leftSize >= PDQSORT_INSERTION_SORT_THRESHOLD)
+            {
+                std::iter_swap(begin, begin + (leftSize / 4));
+                std::iter_swap(pivotPos - 1, pivotPos - (leftSize / 4));
+                if (leftSize > PDQSORT_NINTHER_THRESHOLD)
+                {
+                    std::iter_swap(begin + 1, begin + ((leftSize / 4) + 1));
+                    std::iter_swap(begin + 2, begin + ((leftSize / 4) + 2));
+                    std::iter_swap(pivotPos - 2, pivotPos - ((leftSize / 4) + 1));
+                    std::iter_swap(pivotPos - 3, pivotPos - ((leftSize / 4) + 2));
+                }
+            }
+            if (rightSize >= PDQSORT_INSERTION_SORT_THRESHOLD)
+            {
+                std::iter_swap(pivotPos + 1, pivotPos + (1 + (rightSize / 4)));
+                std::iter_swap(end - 1, end - (rightSize / 4));
+                if (rightSize > PDQSORT_NINTHER_THRESHOLD)
+                {
+                    std::iter_swap(pivotPos + 2, pivotPos + (2 + (rightSize / 4)));
+                    std::iter_swap(pivotPos + 3, pivotPos + (3 + (rightSize / 4)));
+                    std::iter_swap(end - 2, end - (1 + (rightSize / 4)));
+                    std::iter_swap(end - 3, end - (2 + (rightSize / 4)));
+                }
+            }
+        }
+        else if (alreadyPartitioned
+            && ForthPartialInsertionSort(begin, pivotPos, less)
+            && ForthPartialInsertionSort(pivotPos + 1, end, less))
+        {
+            // range was already sorted, or very nearly
+            return;
+        }
+
+        // recurse on left partition, loop on right partition
+        ForthPdqSortLoop(begin, pivotPos, less, badAllowed, leftmost);
+        begin = pivotPos + 1;
+        leftmost = false;
+    }
+}
+
+template <class ITER, class LESS>
+void ForthPdqSort(ITER begin, ITER end, LESS& less)
+{
+    if ((end - begin) < 2)
+    {
+        return;
+    }
+    int log2Size = 0;
+    for (size_t size = end - begin; size > 1; size >>= 1)
+    {
+        log2Size++;
+    }
+    ForthPdqSortLoop(begin, end, less, log2Size, true);
+}
@@ -695,6 +695,8 @@ ForthStructVocabulary::DefineInstance( void )
     mpEngine->SetArraySize( 0 );
     typeCode = STRUCT_TYPE_TO_CODE( arrayFlag, mTypeIndex );
 
+    // weak only applies to object fields
+    mpEngine->ClearFlag( kEngineFlagIsWeak );
     if ( mpEngine->CheckFlag( kEngineFlagIsPointer ) )
     {
         mpEngine->ClearFlag( kEngineFlagIsPointer );
@@ -1322,6 +1324,63 @@ ForthStructVocabulary::ShowDataInner(const void* pData, ForthCoreState* pCore, F
     return pShowContext->GetNumShown();
 }
 
+void
+ForthStructVocabulary::VisitObjectFields(void* pData, ObjectVisitor visitor, void* pUserData, ObjectVisitor weakVisitor)
+{
+    char* pStruct = (char*)pData;
+    forthop* pEntry = GetNewestEntry();
+    if (pEntry == nullptr)
+    {
+        return;
+    }
+
+    forthop* pEntriesEnd = GetEntriesEnd();
+    int previousOffset = GetSize();
+    while (pEntry < pEntriesEnd)
+    {
+        long elementSize = VOCABENTRY_TO_ELEMENT_SIZE(pEntry);
+        if (elementSize != 0)
+        {
+            long typeCode = VOCABENTRY_TO_TYPECODE(pEntry);
+            long byteOffset = VOCABENTRY_TO_FIELD_OFFSET(pEntry);
+            // this relies on the fact that entries come up in reverse order of base offset
+            long numElements = CODE_IS_ARRAY(typeCode) ? ((previousOffset - byteOffset) / elementSize) : 1;
+            previousOffset = byteOffset;
+            long baseType = CODE_TO_BASE_TYPE(typeCode);
+            if (!CODE_IS_PTR(typeCode))
+            {
+                if (baseType == kBaseTypeObject)
+                {
+                    // weak fields hold no refcount, so they are skipped unless the caller asks for them
+                    ObjectVisitor fieldVisitor = CODE_IS_WEAK_OBJECT(typeCode) ? weakVisitor : visitor;
+                    for (int i = 0; (fieldVisitor != nullptr) && (i < numElements); i++)
+                    {
+                        ForthObject& obj = *((ForthObject*)(pStruct + byteOffset + (i * elementSize)));
+                        if (obj != nullptr)
+                        {
+                            fieldVisitor(obj, pUserData);
+                        }
+                    }
+                }
+                else if (baseType == kBaseTypeStruct)
+                {
+                    ForthTypeInfo* pStructInfo = ForthTypesManager::GetInstance()->GetTypeInfo(CODE_TO_STRUCT_INDEX(typeCode));
+                    for (int i = 0; i < numElements; i++)
+                    {
+                        ForthStructVocabulary* pVocab = pStructInfo->pVocab;
+                        while (pVocab != nullptr)
+                        {
+                            pVocab->VisitObjectFields(pStruct + byteOffset + (i * elementSize), visitor, pUserData, weakVisitor);
+                            pVocab = pVocab->BaseVocabulary();
+                        }
+                    }
+                }
+            }
+        }
+        pEntry = NextEntry(pEntry);
+    }
+}
+
 void ForthStructVocabulary::SetInitOpcode(forthop op)
 {
 	mInitOpcode = op;
@@ -1340,6 +1399,10 @@ ForthClassVocabulary::ForthClassVocabulary( const char*     pName,
 , mpParentClass( NULL )
 , mCurrentInterface( 0 )
 , mCustomReader(nullptr)
+, mCustomChildVisitor(nullptr)
+, mCustomBinaryWriter(nullptr)
+, mCustomBinaryReader(nullptr)
+, mCycleCollectable(false)
 , mpClassObject(nullptr)
 {
     mpClassObject = new ForthClassObject;
@@ -1436,6 +1499,8 @@ ForthClassVocabulary::DefineInstance(const char* pInstanceName, const char* pCon
     mpEngine->SetArraySize( 0 );
     typeCode = OBJECT_TYPE_TO_CODE( arrayFlag, typeIndex );
 
+    bool isWeak = mpEngine->CheckFlag( kEngineFlagIsWeak );
+    mpEngine->ClearFlag( kEngineFlagIsWeak );
     if ( mpEngine->CheckFlag( kEngineFlagIsPointer ) )
     {
         mpEngine->ClearFlag( kEngineFlagIsPointer );
@@ -1472,6 +1537,10 @@ ForthClassVocabulary::DefineInstance(const char* pInstanceName, const char* pCon
     {
 		if ( mpEngine->CheckFlag( kEngineFlagInStructDefinition ) )
 		{
+            if ( isWeak && !isPtr )
+            {
+                typeCode |= kDTIsFunky;
+            }
 			pManager->GetNewestStruct()->AddField( pInstanceName, typeCode, numElements );
 			return;
 		}
@@ -1525,7 +1594,7 @@ ForthClassVocabulary::DefineInstance(const char* pInstanceName, const char* pCon
 					// bump objects refcount
 					if (srcObj != nullptr)
 					{
-                        srcObj->refCount += 1;
+                        INCREMENT_REFCOUNT(srcObj);
 					}
                     *pHere = srcObj;
                 }
@@ -1861,7 +1930,8 @@ ForthClassVocabulary::PrintEntry(forthop*   pEntry )
 ForthClassVocabulary*
 ForthClassVocabulary::ParentClass( void )
 {
-	return mpSearchNext->IsClass() ? (ForthClassVocabulary *) mpSearchNext : NULL;
+	// the root class has nothing after it in its search chain
+	return ((mpSearchNext != NULL) && mpSearchNext->IsClass()) ? (ForthClassVocabulary *) mpSearchNext : NULL;
 }
 
 const char *
@@ -1880,6 +1950,32 @@ CustomObjectReader ForthClassVocabulary::GetCustomObjectReader()
     return mCustomReader;
 }
 
+void ForthClassVocabulary::SetCustomChildVisitor(CustomChildVisitor visitor)
+{
+    mCustomChildVisitor = visitor;
+}
+
+CustomChildVisitor ForthClassVocabulary::GetCustomChildVisitor()
+{
+    return mCustomChildVisitor;
+}
+
+void ForthClassVocabulary::SetCustomBinarySerializer(CustomBinaryWriter writer, CustomBinaryReader reader)
+{
+    mCustomBinaryWriter = writer;
+    mCustomBinaryReader = reader;
+}
+
+CustomBinaryWriter ForthClassVocabulary::GetCustomBinaryWriter()
+{
+    return mCustomBinaryWriter;
+}
+
+CustomBinaryReader ForthClassVocabulary::GetCustomBinaryReader()
+{
+    return mCustomBinaryReader;
+}
+
 // TBD: implement FindSymbol which iterates over all interfaces
 
 //////////////////////////////////////////////////////////////////////
@@ -2128,6 +2224,7 @@ ForthNativeType::DefineInstance( ForthEngine *pEngine, void *pInitialVal, long f
         typeCode = NATIVE_TYPE_TO_CODE( flags, baseType );
     }
 
+    pEngine->ClearFlag(kEngineFlagIsWeak);
     bool isPointer = pEngine->CheckFlag(kEngineFlagIsPointer);
     if (isPointer)
     {
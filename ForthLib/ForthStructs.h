@@ -19,6 +19,8 @@ class ForthNativeType;
 class ForthTypesManager;
 class ForthStructCodeGenerator;
 class ForthObjectReader;
+class ForthBinaryWriter;
+class ForthBinaryReader;
 
 // each new structure type definition is assigned a unique index
 // the struct type index is:
@@ -54,6 +56,10 @@ typedef struct
 } ForthClassObject;
 
 typedef bool(*CustomObjectReader)(const std::string& elementName, ForthObjectReader* reader);
+// binary writers and readers handle the whole contents of a builtin class object, a binary
+//   reader is passed an object which was just created with the class new op
+typedef void(*CustomBinaryWriter)(ForthObject& obj, ForthBinaryWriter* writer);
+typedef void(*CustomBinaryReader)(ForthObject& obj, ForthBinaryReader* reader);
 
 ///////////////////////////////////////
 
@@ -209,6 +215,9 @@ public:
     // pass optional pEndVocab to prevent showing items from that vocab or lower
     virtual int		    ShowDataInner(const void* pData, ForthCoreState* pCore,
         ForthStructVocabulary* pEndVocab = nullptr);
+    // call visitor on each object field declared in this vocabulary, including those in nested structs
+    //  weak fields are passed to weakVisitor instead, and are skipped if it is null
+    void                VisitObjectFields(void* pData, ObjectVisitor visitor, void* pUserData, ObjectVisitor weakVisitor = nullptr);
 
 	inline forthop			GetInitOpcode() { return mInitOpcode;  }
 	void				SetInitOpcode(forthop op);
@@ -253,6 +262,15 @@ public:
     virtual void        PrintEntry(forthop*   pEntry);
     void                SetCustomObjectReader(CustomObjectReader reader);
     CustomObjectReader  GetCustomObjectReader();
+    void                SetCustomChildVisitor(CustomChildVisitor visitor);
+    CustomChildVisitor  GetCustomChildVisitor();
+    void                SetCustomBinarySerializer(CustomBinaryWriter writer, CustomBinaryReader reader);
+    CustomBinaryWriter  GetCustomBinaryWriter();
+    CustomBinaryReader  GetCustomBinaryReader();
+    // the cycle collector only examines objects of classes which opt in, a class can opt in
+    //   if every object field which doesn't hold a refcount is marked weak
+    inline void         SetCycleCollectable(bool collectable) { mCycleCollectable = collectable; }
+    inline bool         IsCycleCollectable() { return mCycleCollectable; }
 
 protected:
     long                        mCurrentInterface;
@@ -260,6 +278,10 @@ protected:
 	std::vector<ForthInterface *>	mInterfaces;
     ForthClassObject*           mpClassObject;
     CustomObjectReader          mCustomReader;
+    CustomChildVisitor          mCustomChildVisitor;
+    CustomBinaryWriter          mCustomBinaryWriter;
+    CustomBinaryReader          mCustomBinaryReader;
+    bool                        mCycleCollectable;
 	static ForthClassVocabulary* smpObjectClass;
 };
 
@@ -13,12 +13,19 @@
 #include <cstdint>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <errno.h>
+#include <time.h>
 #endif
 #include <deque>
 #include "ForthThread.h"
 #include "ForthEngine.h"
 #include "ForthShowContext.h"
 #include "ForthBuiltinClasses.h"
+#ifdef GUARD_PAGE_STACKS
+#include <atomic>
+#include <signal.h>
+#include <sys/mman.h>
+#endif
 
 // this is the number of extra longs to allocate at top and
 //    bottom of stacks
@@ -28,6 +35,10 @@
 #define GAURD_AREA 4
 #endif
 
+// a thread whose fibers are all blocked rechecks them this often, so a missed wakeup
+//   can only stall it briefly
+#define BLOCKED_FIBER_WAIT_MILLISECONDS 50
+
 struct oThreadStruct
 {
     forthop*            pMethods;
@@ -44,6 +55,240 @@ struct oFiberStruct
 	ForthFiber			*pFiber;
 };
 
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     stack allocation
+// 
+
+#ifdef GUARD_PAGE_STACKS
+// each guarded stack is a single mapping laid out as [guard page][stack pages][guard page]
+// stacks grow downwards, so a fault in the low guard page is an overflow and
+//   a fault in the high guard page is an underflow
+// guarded stacks are kept in a fixed table which is never freed, so the fault handler can
+//   search it without taking a lock - a slot is in use while its pMapping is non-null,
+//   pMapping is published after the other fields are set, and cleared before the stack
+//   is unmapped
+#define MAX_GUARDED_STACKS  1024
+
+struct ForthGuardedStack
+{
+    std::atomic<char*>  pMapping;
+    ForthCoreState*     pCore;
+    size_t              mappingBytes;
+    bool                isReturnStack;
+    volatile bool       tripped;
+};
+
+static ForthGuardedStack gGuardedStacks[MAX_GUARDED_STACKS];
+// slots at or past gNumGuardedSlots have never been used
+static std::atomic<int> gNumGuardedSlots(0);
+static pthread_mutex_t gGuardedStacksMutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t gGuardPageSize = 0;
+static struct sigaction gOldSegvAction;
+static struct sigaction gOldBusAction;
+
+static void GuardPageFaultHandler(int sig, siginfo_t* pInfo, void* pContext)
+{
+    char* pFault = (char *)(pInfo->si_addr);
+    int numSlots = gNumGuardedSlots.load(std::memory_order_acquire);
+    for (int i = 0; i < numSlots; i++)
+    {
+        ForthGuardedStack* pStack = &(gGuardedStacks[i]);
+        char* pMapping = pStack->pMapping.load(std::memory_order_acquire);
+        if (pMapping == nullptr)
+        {
+            continue;
+        }
+        char* pLowGuard = pMapping;
+        char* pHighGuard = pMapping + pStack->mappingBytes - gGuardPageSize;
+        bool inLowGuard = (pFault >= pLowGuard) && (pFault < (pLowGuard + gGuardPageSize));
+        bool inHighGuard = (pFault >= pHighGuard) && (pFault < (pHighGuard + gGuardPageSize));
+        // skip the slot if it was freed or reused while we were looking at it
+        if ((inLowGuard || inHighGuard) && (pStack->pMapping.load(std::memory_order_acquire) == pMapping))
+        {
+            // open up the guard page so the faulting op can complete, setting the error state
+            //   will stop the inner interpreter, and ForthFiber::Reset will close it up again
+            mprotect(inLowGuard ? pLowGuard : pHighGuard, gGuardPageSize, PROT_READ | PROT_WRITE);
+            pStack->tripped = true;
+            eForthError err;
+            if (pStack->isReturnStack)
+            {
+                err = inLowGuard ? kForthErrorReturnStackOverflow : kForthErrorReturnStackUnderflow;
+            }
+            else
+            {
+                err = inLowGuard ? kForthErrorParamStackOverflow : kForthErrorParamStackUnderflow;
+            }
+            CoreSetError(pStack->pCore, err, false);
+            return;
+        }
+    }
+
+    // not one of our guard pages - hand it to whoever had the signal before us
+    struct sigaction* pOldAction = (sig == SIGBUS) ? &gOldBusAction : &gOldSegvAction;
+    if ((pOldAction->sa_flags & SA_SIGINFO) != 0)
+    {
+        pOldAction->sa_sigaction(sig, pInfo, pContext);
+    }
+    else if ((pOldAction->sa_handler == SIG_DFL) || (pOldAction->sa_handler == SIG_IGN))
+    {
+        // restore the old disposition, the faulting instruction will fault again when we return
+        sigaction(sig, pOldAction, nullptr);
+    }
+    else
+    {
+        pOldAction->sa_handler(sig);
+    }
+}
+
+static void InitGuardPages()
+{
+    // caller must hold gGuardedStacksMutex
+    if (gGuardPageSize == 0)
+    {
+        gGuardPageSize = (size_t) sysconf(_SC_PAGESIZE);
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = GuardPageFaultHandler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &gOldSegvAction);
+        // some systems report protection faults as SIGBUS
+        sigaction(SIGBUS, &action, &gOldBusAction);
+    }
+}
+
+// returns a free slot, or null if the table is full - caller must hold gGuardedStacksMutex
+static ForthGuardedStack* FindFreeGuardedStack()
+{
+    int numSlots = gNumGuardedSlots.load(std::memory_order_relaxed);
+    for (int i = 0; i < numSlots; i++)
+    {
+        if (gGuardedStacks[i].pMapping.load(std::memory_order_relaxed) == nullptr)
+        {
+            return &(gGuardedStacks[i]);
+        }
+    }
+    if (numSlots < MAX_GUARDED_STACKS)
+    {
+        // the slot's pMapping is still null, so publishing the larger count is safe
+        gNumGuardedSlots.store(numSlots + 1, std::memory_order_release);
+        return &(gGuardedStacks[numSlots]);
+    }
+    return nullptr;
+}
+#endif
+
+// numCells is rounded up to a whole number of pages for guarded stacks
+static cell* AllocateStack(ForthCoreState* pCore, ucell& numCells, bool isReturnStack)
+{
+#ifdef GUARD_PAGE_STACKS
+    pthread_mutex_lock(&gGuardedStacksMutex);
+    InitGuardPages();
+    ForthGuardedStack* pStack = FindFreeGuardedStack();
+    if (pStack != nullptr)
+    {
+        size_t stackBytes = ((numCells * sizeof(cell)) + gGuardPageSize - 1) & ~(gGuardPageSize - 1);
+        size_t mappingBytes = stackBytes + (2 * gGuardPageSize);
+        char* pMapping = (char *) mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (pMapping != MAP_FAILED)
+        {
+            mprotect(pMapping, gGuardPageSize, PROT_NONE);
+            mprotect(pMapping + mappingBytes - gGuardPageSize, gGuardPageSize, PROT_NONE);
+#ifdef MADV_HUGEPAGE
+            if (__useHugePages && (stackBytes >= HUGE_PAGE_BYTES))
+            {
+                // only the huge page aligned parts of the stack can be backed by huge pages,
+                //  the guard pages stay small
+                madvise(pMapping + gGuardPageSize, stackBytes, MADV_HUGEPAGE);
+            }
+#endif
+
+            pStack->pCore = pCore;
+            pStack->mappingBytes = mappingBytes;
+            pStack->isReturnStack = isReturnStack;
+            pStack->tripped = false;
+            // fully initialize the slot before publishing it to the fault handler
+            pStack->pMapping.store(pMapping, std::memory_order_release);
+            pthread_mutex_unlock(&gGuardedStacksMutex);
+
+            numCells = stackBytes / sizeof(cell);
+            return (cell *)(pMapping + gGuardPageSize);
+        }
+    }
+    bool tableFull = (pStack == nullptr);
+    pthread_mutex_unlock(&gGuardedStacksMutex);
+    // couldn't map the stack or the guarded stack table is full, fall back to an unguarded stack,
+    //   overflows of it will no longer be caught so say so the first time it happens
+    static std::atomic<bool> reportedUnguardedStack(false);
+    if (!reportedUnguardedStack.exchange(true))
+    {
+        if (tableFull)
+        {
+            printf("AllocateStack: all %d guarded stack slots are in use, falling back to unguarded stacks\n", MAX_GUARDED_STACKS);
+        }
+        else
+        {
+            printf("AllocateStack: couldn't map a guarded %s stack, falling back to unguarded stacks\n", isReturnStack ? "return" : "param");
+        }
+    }
+#endif
+    // leave a few extra words above top of stacks, so that underflows don't
+    //   tromp on the memory allocator info
+    cell* pBase = new cell[numCells + (GAURD_AREA * 2)];
+    return pBase + GAURD_AREA;
+}
+
+static void FreeStack(cell* pBase)
+{
+#ifdef GUARD_PAGE_STACKS
+    char* pMapping = ((char *) pBase) - gGuardPageSize;
+    pthread_mutex_lock(&gGuardedStacksMutex);
+    int numSlots = gNumGuardedSlots.load(std::memory_order_relaxed);
+    for (int i = 0; i < numSlots; i++)
+    {
+        ForthGuardedStack* pStack = &(gGuardedStacks[i]);
+        if (pStack->pMapping.load(std::memory_order_relaxed) == pMapping)
+        {
+            // unpublish the slot before unmapping, the slot itself is never freed so
+            //   a fault handler running on another thread can still safely read it
+            pStack->pMapping.store(nullptr, std::memory_order_release);
+            size_t mappingBytes = pStack->mappingBytes;
+            pthread_mutex_unlock(&gGuardedStacksMutex);
+            munmap(pMapping, mappingBytes);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&gGuardedStacksMutex);
+#endif
+    pBase -= GAURD_AREA;
+    delete [] pBase;
+}
+
+// reprotect any guard pages of this core's stacks which were opened up by the fault handler
+static void RearmStackGuards(ForthCoreState* pCore)
+{
+#ifdef GUARD_PAGE_STACKS
+    pthread_mutex_lock(&gGuardedStacksMutex);
+    int numSlots = gNumGuardedSlots.load(std::memory_order_relaxed);
+    for (int i = 0; i < numSlots; i++)
+    {
+        ForthGuardedStack* pStack = &(gGuardedStacks[i]);
+        char* pMapping = pStack->pMapping.load(std::memory_order_relaxed);
+        if ((pMapping != nullptr) && pStack->tripped && (pStack->pCore == pCore))
+        {
+            mprotect(pMapping, gGuardPageSize, PROT_NONE);
+            mprotect(pMapping + pStack->mappingBytes - gGuardPageSize, gGuardPageSize, PROT_NONE);
+            pStack->tripped = false;
+        }
+    }
+    pthread_mutex_unlock(&gGuardedStacksMutex);
+#endif
+}
+
+
 //////////////////////////////////////////////////////////////////////
 ////
 ///
@@ -54,14 +299,10 @@ ForthCoreState::ForthCoreState(int paramStackSize, int returnStackSize)
     : SLen(paramStackSize)
     , RLen(returnStackSize)
 {
-    // leave a few extra words above top of stacks, so that underflows don't
-    //   tromp on the memory allocator info
-    SB = new cell[SLen + (GAURD_AREA * 2)];
-    SB += GAURD_AREA;
+    SB = AllocateStack(this, SLen, false);
     ST = SB + SLen;
 
-    RB = new cell[RLen + (GAURD_AREA * 2)];
-    RB += GAURD_AREA;
+    RB = AllocateStack(this, RLen, true);
     RT = RB + RLen;
 
 #ifdef CHECK_GAURD_AREAS
@@ -131,7 +372,10 @@ void ForthCoreState::InitializeFromEngine(void* engineIn)
         innerExecute = pEngineCore->innerExecute;
     }
 
-    engine->ResetConsoleOut(*this);
+    // the aux out stream belongs to the engine and may be redirected, as the test scripts do,
+    //   so only the console out of this core is reset
+    CLEAR_OBJECT(consoleOutStream);
+    OBJECT_ASSIGN(this, consoleOutStream, engine->GetDefaultConsoleOut());
 }
 
 
@@ -150,6 +394,7 @@ ForthFiber::ForthFiber(ForthEngine *pEngine, ForthThread *pParentThread, int fib
 , mpShowContext(NULL)
 , mpJoinHead(nullptr)
 , mpNextJoiner(nullptr)
+, mpPendingOutBuffers(nullptr)
 , mObject(nullptr)
 , mCore(paramStackLongs, returnStackLongs)
 {
@@ -169,11 +414,10 @@ ForthFiber::~ForthFiber()
         WakeAllJoiningFibers();
     }
     // TODO: warn if mpNextJoiner is not null
+    ForthFlushPendingOutStreams(&mCore);
 
-    mCore.SB -= GAURD_AREA;
-    delete [] mCore.SB;
-    mCore.RB -= GAURD_AREA;
-    delete [] mCore.RB;
+    FreeStack(mCore.SB);
+    FreeStack(mCore.RB);
 
 	if (mpShowContext != NULL)
 	{
@@ -247,6 +491,7 @@ void ForthFiber::InitTables(ForthFiber* pSourceThread)
 void
 ForthFiber::Reset( void )
 {
+    RearmStackGuards(&mCore);
     mCore.SP = mCore.ST;
     mCore.RP = mCore.RT;
     mCore.FP = nullptr;
@@ -346,8 +591,11 @@ ForthShowContext* ForthFiber::GetShowContext()
 
 void ForthFiber::SetRunState(eForthFiberRunState newState)
 {
-	// TODO!
 	mRunState = newState;
+	if ((newState == kFTRSReady) && (mpParentThread != nullptr))
+	{
+		mpParentThread->SignalFiberReady();
+	}
 }
 
 void ForthFiber::Sleep(ulong sleepMilliSeconds)
@@ -370,6 +618,11 @@ void ForthFiber::Wake()
 {
 	mRunState = kFTRSReady;
 	mWakeupTime = 0;
+	// the fiber may belong to another OS thread which is parked waiting for it
+	if (mpParentThread != nullptr)
+	{
+		mpParentThread->SignalFiberReady();
+	}
 }
 
 void ForthFiber::Stop()
@@ -379,6 +632,7 @@ void ForthFiber::Stop()
 
 void ForthFiber::Exit()
 {
+	ForthFlushPendingOutStreams(&mCore);
 	mRunState = kFTRSExited;
     WakeAllJoiningFibers();
 }
@@ -409,7 +663,18 @@ ForthThread::ForthThread(ForthEngine *pEngine, int paramStackLongs, int returnSt
 	, mActiveFiberIndex(0)
 	, mRunState(kFTRSStopped)
     , mObject(nullptr)
+    , mDeferReleases(false)
+    , mDrainingReleases(false)
+    , mReleaseBudget(0)
 {
+    // making the primary fiber ready signals mWakeSignal, so it must be set up first
+#ifdef WIN32
+    InitializeCriticalSection(&mWakeLock);
+    InitializeConditionVariable(&mWakeSignal);
+#else
+    pthread_mutex_init(&mWakeLock, nullptr);
+    pthread_cond_init(&mWakeSignal, nullptr);
+#endif
 	ForthFiber* pPrimaryFiber = new ForthFiber(pEngine, this, 0, paramStackLongs, returnStackLongs);
     pPrimaryFiber->SetRunState(kFTRSReady);
 	mFibers.push_back(pPrimaryFiber);
@@ -434,11 +699,19 @@ ForthThread::~ForthThread()
 		CloseHandle(mHandle);
 	}
     CloseHandle(mExitSignal);
+    DeleteCriticalSection(&mWakeLock);
 #else
     pthread_mutex_destroy(&mExitMutex);
     pthread_cond_destroy(&mExitSignal);
+    pthread_mutex_destroy(&mWakeLock);
+    pthread_cond_destroy(&mWakeSignal);
 #endif
 
+    // delete objects still waiting on the release queue while the fibers and their cores exist
+    if (!mFibers.empty() && (mFibers[0] != nullptr))
+    {
+        DrainReleaseQueue(mFibers[0]->GetCore(), true);
+    }
 
     for (ForthFiber* pFiber : mFibers)
 	{
@@ -502,6 +775,9 @@ void* ForthThread::RunLoop(void *pUserData)
 
 		if (switchActiveThread)
 		{
+			ForthFlushPendingOutStreams(pCore);
+			pParentThread->DrainReleaseQueue(pCore);
+			ForthCycleCollector::GetInstance()->CollectIfPending(pCore);
 			// TODO!
 			// - switch to next runnable thread
 			// - sleep if all threads are sleeping
@@ -526,15 +802,26 @@ void* ForthThread::RunLoop(void *pUserData)
 					}
 					else
 					{
-						// TODO: don't always sleep until wakeupTime, since threads which are blocked or stopped
-						//  could be unblocked or started by other async threads
-						int sleepMilliseconds = wakeupTime - now;
-#ifdef WIN32
-						::Sleep((DWORD)sleepMilliseconds);
-#else
-						usleep(sleepMilliseconds * 1000);
-#endif
-						pActiveFiber = pNextFiber;
+						// sleep until wakeupTime, unless a blocked fiber is woken by another thread first
+						ForthFiber* pReadyFiber = pParentThread->WaitForReadyFiber(wakeupTime - now);
+						pActiveFiber = (pReadyFiber != nullptr) ? pReadyFiber : pNextFiber;
+					}
+				}
+				else if (pParentThread->HasBlockedFiber())
+				{
+					// park until another thread wakes one of the blocked fibers
+					ForthFiber* pReadyFiber = nullptr;
+					while ((pReadyFiber == nullptr) && pParentThread->HasBlockedFiber())
+					{
+						pReadyFiber = pParentThread->WaitForReadyFiber(BLOCKED_FIBER_WAIT_MILLISECONDS);
+					}
+					if (pReadyFiber != nullptr)
+					{
+						pActiveFiber = pReadyFiber;
+					}
+					else
+					{
+						checkForAllDone = true;
 					}
 				}
 				else
@@ -577,12 +864,17 @@ void* ForthThread::RunLoop(void *pUserData)
 #endif
 }
 
-void ForthThread::InnerLoop()
+void ForthThread::InnerLoop(ForthFiber* pMainFiber)
 {
-    ForthFiber* pMainFiber = mFibers[0];
     ForthFiber* pActiveFiber = pMainFiber;
     ForthEngine* pEngine = pActiveFiber->GetEngine();
-    pMainFiber->SetRunState(kFTRSReady);
+    // InnerLoop is reentered when the fiber switch code runs a forth method, such as a stream
+    //   flush, and a blocked or sleeping main fiber must only be made ready by whatever wakes it
+    eForthFiberRunState mainRunState = pMainFiber->GetRunState();
+    if ((mainRunState != kFTRSBlocked) && (mainRunState != kFTRSSleeping))
+    {
+        pMainFiber->SetRunState(kFTRSReady);
+    }
 
     eForthResult exitStatus = kResultOk;
     bool keepRunning = true;
@@ -624,6 +916,9 @@ void ForthThread::InnerLoop()
 
         if (switchActiveFiber)
         {
+            ForthFlushPendingOutStreams(pCore);
+            DrainReleaseQueue(pCore);
+            ForthCycleCollector::GetInstance()->CollectIfPending(pCore);
             // TODO!
             // - switch to next runnable thread
             // - sleep if all threads are sleeping
@@ -652,15 +947,23 @@ void ForthThread::InnerLoop()
                     }
                     else
                     {
-                        // TODO: don't always sleep until wakeupTime, since threads which are blocked or stopped
-                        //  could be unblocked or started by other async threads
-                        int sleepMilliseconds = wakeupTime - now;
-#ifdef WIN32
-                        ::Sleep((DWORD)sleepMilliseconds);
-#else
-                        usleep(sleepMilliseconds * 1000);
-#endif
-                        pActiveFiber = pNextFiber;
+                        // sleep until wakeupTime, unless a blocked fiber is woken by another thread first
+                        ForthFiber* pReadyFiber = WaitForReadyFiber(wakeupTime - now);
+                        pActiveFiber = (pReadyFiber != nullptr) ? pReadyFiber : pNextFiber;
+                        SetActiveFiber(pActiveFiber);
+                    }
+                }
+                else if (HasBlockedFiber())
+                {
+                    // park until another thread wakes one of the blocked fibers
+                    ForthFiber* pReadyFiber = nullptr;
+                    while ((pReadyFiber == nullptr) && HasBlockedFiber())
+                    {
+                        pReadyFiber = WaitForReadyFiber(BLOCKED_FIBER_WAIT_MILLISECONDS);
+                    }
+                    if (pReadyFiber != nullptr)
+                    {
+                        pActiveFiber = pReadyFiber;
                         SetActiveFiber(pActiveFiber);
                     }
                 }
@@ -769,6 +1072,77 @@ ForthFiber* ForthThread::GetNextSleepingFiber()
 	return pFiberToWake;
 }
 
+bool ForthThread::HasBlockedFiber()
+{
+	for (ForthFiber* pFiber : mFibers)
+	{
+		if (pFiber->GetRunState() == kFTRSBlocked)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+ForthFiber* ForthThread::WaitForReadyFiber(int timeoutMilliseconds)
+{
+	// fibers are made ready before SignalFiberReady takes mWakeLock, so a wakeup can't
+	//   slip in between looking for a ready fiber and waiting
+	ForthFiber* pFiber = nullptr;
+#ifdef WIN32
+	ULONGLONG deadline = GetTickCount64() + timeoutMilliseconds;
+	EnterCriticalSection(&mWakeLock);
+	pFiber = GetNextReadyFiber();
+	while (pFiber == nullptr)
+	{
+		ULONGLONG now = GetTickCount64();
+		if (now >= deadline)
+		{
+			break;
+		}
+		SleepConditionVariableCS(&mWakeSignal, &mWakeLock, (DWORD)(deadline - now));
+		pFiber = GetNextReadyFiber();
+	}
+	LeaveCriticalSection(&mWakeLock);
+#else
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeoutMilliseconds / 1000;
+	deadline.tv_nsec += (timeoutMilliseconds % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	pthread_mutex_lock(&mWakeLock);
+	pFiber = GetNextReadyFiber();
+	while (pFiber == nullptr)
+	{
+		int waitResult = pthread_cond_timedwait(&mWakeSignal, &mWakeLock, &deadline);
+		pFiber = GetNextReadyFiber();
+		if (waitResult == ETIMEDOUT)
+		{
+			break;
+		}
+	}
+	pthread_mutex_unlock(&mWakeLock);
+#endif
+	return pFiber;
+}
+
+void ForthThread::SignalFiberReady()
+{
+#ifdef WIN32
+	EnterCriticalSection(&mWakeLock);
+	WakeAllConditionVariable(&mWakeSignal);
+	LeaveCriticalSection(&mWakeLock);
+#else
+	pthread_mutex_lock(&mWakeLock);
+	pthread_cond_broadcast(&mWakeSignal);
+	pthread_mutex_unlock(&mWakeLock);
+#endif
+}
+
 long ForthThread::Start()
 {
 #ifdef WIN32
@@ -875,6 +1249,85 @@ void ForthThread::SetName(const char* newName)
     mName.assign(newName);
 }
 
+// number of objects to delete between checks of the release budget
+#define RELEASES_PER_BUDGET_CHECK 64
+
+void ForthThread::ReleaseObject(ForthCoreState* pCore, ForthObject obj)
+{
+    if (!mDeferReleases)
+    {
+        FULLY_EXECUTE_METHOD(pCore, obj, kMethodDelete);
+        return;
+    }
+
+    mReleaseQueue.push_back(obj);
+    // if we are already draining, the outer drain loop will get to this object, this keeps
+    //  the C stack depth constant no matter how deep the graph of objects being deleted is
+    if (!mDrainingReleases)
+    {
+        DrainReleaseQueue(pCore);
+    }
+}
+
+void ForthThread::DrainReleaseQueue(ForthCoreState* pCore, bool ignoreBudget)
+{
+    if (mDrainingReleases || mReleaseQueue.empty())
+    {
+        return;
+    }
+
+    ForthEngine* pEngine = ForthEngine::GetInstance();
+    bool checkBudget = !ignoreBudget && (mReleaseBudget != 0);
+    ulong startTime = checkBudget ? pEngine->GetElapsedTime() : 0;
+    int releasesUntilCheck = RELEASES_PER_BUDGET_CHECK;
+
+    mDrainingReleases = true;
+    while (!mReleaseQueue.empty())
+    {
+        ForthObject obj = mReleaseQueue.back();
+        mReleaseQueue.pop_back();
+        // deleting obj may release objects it refers to, which will be pushed on the queue
+        FULLY_EXECUTE_METHOD(pCore, obj, kMethodDelete);
+
+        if (checkBudget && (--releasesUntilCheck == 0))
+        {
+            if ((pEngine->GetElapsedTime() - startTime) >= mReleaseBudget)
+            {
+                // leave remaining objects to be deleted at a later yield point
+                break;
+            }
+            releasesUntilCheck = RELEASES_PER_BUDGET_CHECK;
+        }
+    }
+    mDrainingReleases = false;
+}
+
+void ReleaseDeadObject(ForthCoreState* pCore, ForthObject obj)
+{
+    ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+    ForthThread* pThread = (pFiber != nullptr) ? pFiber->GetParent() : nullptr;
+    if (pThread != nullptr)
+    {
+        pThread->ReleaseObject(pCore, obj);
+    }
+    else
+    {
+        FULLY_EXECUTE_METHOD(pCore, obj, kMethodDelete);
+    }
+}
+
+void ObjectRefCountDropped(ForthCoreState* pCore, ForthObject obj, ucell newRefCount)
+{
+    if (newRefCount == 0)
+    {
+        ReleaseDeadObject(pCore, obj);
+    }
+    else if (gCycleCollectorEnabled)
+    {
+        AddPossibleCycleRoot(pCore, obj);
+    }
+}
+
 
 namespace OThread
 {
@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
 
 #include "Forth.h"
 #include "ForthInner.h"
@@ -18,6 +19,7 @@
 class ForthEngine;
 class ForthShowContext;
 class ForthThread;
+struct ForthOutBuffer;
 
 #define DEFAULT_PSTACK_SIZE 128
 #define DEFAULT_RSTACK_SIZE 128
@@ -32,6 +34,13 @@ class ForthThread;
 #define CHECK_STACKS(THREAD_PTR)
 #endif
 
+// GUARD_PAGE_STACKS allocates param and return stacks with inaccessible pages immediately
+//   above and below them, touching a guard page sets a stack overflow/underflow error on the
+//   fiber which owns the stack - this costs nothing per op, unlike CHECK_GAURD_AREAS
+#if (defined(LINUX) || defined(MACOSX)) && !defined(CHECK_GAURD_AREAS)
+#define GUARD_PAGE_STACKS
+#endif
+
 class ForthFiber
 {
 public:
@@ -86,6 +95,9 @@ public:
     const char* GetName() const;
     void SetName(const char* newName);
 
+    // head of the list of stream buffers this fiber has written to which flush on yield
+    inline ForthOutBuffer*& PendingOutBuffers() { return mpPendingOutBuffers; }
+
 protected:
     void    WakeAllJoiningFibers();
 
@@ -97,9 +109,11 @@ protected:
     ForthCoreState      mCore;
     forthop             mOps[2];
     ulong				mWakeupTime;
-	eForthFiberRunState mRunState;
+    // fibers on other threads wake blocked fibers, so run state is atomic
+	std::atomic<eForthFiberRunState> mRunState;
     ForthFiber*         mpJoinHead;
     ForthFiber*         mpNextJoiner;
+    ForthOutBuffer*     mpPendingOutBuffers;
     int                 mIndex;
     std::string         mName;
 };
@@ -115,6 +129,12 @@ public:
 	void                Exit();
 	ForthFiber*		    GetNextReadyFiber();
 	ForthFiber*		    GetNextSleepingFiber();
+    bool                HasBlockedFiber();
+    // park the OS thread until one of its fibers is ready, or until timeoutMilliseconds have
+    //   passed, returns the ready fiber or nullptr if the wait timed out
+    ForthFiber*         WaitForReadyFiber(int timeoutMilliseconds);
+    // wake the OS thread if it is parked in WaitForReadyFiber, this can be called from any OS thread
+    void                SignalFiberReady();
 	ForthFiber*		    GetFiber(int fiberIndex);
 	ForthFiber*		    GetActiveFiber();
     void                SetActiveFiber(ForthFiber *pThread);
@@ -123,7 +143,8 @@ public:
 
     void                Join();
 
-    void                InnerLoop();
+    // run pMainFiber until its ops are done, other fibers of this thread run while it is not ready
+    void                InnerLoop(ForthFiber* pMainFiber);
 
 	ForthFiber*		    CreateFiber(ForthEngine *pEngine, forthop fiberOp, int paramStackLongs = DEFAULT_PSTACK_SIZE, int returnStackLongs = DEFAULT_RSTACK_SIZE);
 	void				DeleteFiber(ForthFiber* pFiber);
@@ -134,6 +155,18 @@ public:
     const char* GetName() const;
     void SetName(const char* newName);
 
+    // objects whose refcount has dropped to zero are passed to ReleaseObject, which deletes them
+    //   immediately unless deferred releases are enabled, in which case they are put on a release
+    //   queue which is drained iteratively, so deleting a big object graph doesn't recurse
+    void                ReleaseObject(ForthCoreState* pCore, ForthObject obj);
+    // drain the release queue, stopping when release budget is used up unless ignoreBudget is set
+    void                DrainReleaseQueue(ForthCoreState* pCore, bool ignoreBudget = false);
+    inline void         SetDeferReleases(bool deferReleases) { mDeferReleases = deferReleases; }
+    inline bool         GetDeferReleases() const { return mDeferReleases; }
+    // budget is in milliseconds, 0 means no limit
+    inline void         SetReleaseBudget(ulong milliseconds) { mReleaseBudget = milliseconds; }
+    inline ucell        GetNumPendingReleases() const { return mReleaseQueue.size(); }
+
 #if defined(LINUX) || defined(MACOSX)
 	static void* RunLoop(void *pThis);
 #else
@@ -147,9 +180,15 @@ protected:
 	std::vector<ForthFiber*> mFibers;
 	ForthThread*   mpNext;
 	int					mActiveFiberIndex;
-	eForthFiberRunState mRunState;
+	std::atomic<eForthFiberRunState> mRunState;
     std::string         mName;
+    std::vector<ForthObject> mReleaseQueue;
+    bool                mDeferReleases;
+    bool                mDrainingReleases;
+    ulong               mReleaseBudget;
 #if defined(LINUX) || defined(MACOSX)
+    pthread_mutex_t		mWakeLock;
+    pthread_cond_t		mWakeSignal;
 	int                 mHandle;
 	pthread_t           mThread;
 	int					mExitStatus;
@@ -159,6 +198,8 @@ protected:
     HANDLE              mHandle;
 	ulong               mThreadId;
     HANDLE              mExitSignal;
+    CRITICAL_SECTION    mWakeLock;
+    CONDITION_VARIABLE  mWakeSignal;
 #endif
 };
 
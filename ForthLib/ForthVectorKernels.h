@@ -0,0 +1,222 @@
+//////////////////////////////////////////////////////////////////////
+//
+// ForthVectorKernels.h: SIMD kernels for ForthVectorOps
+//
+// This is included by ForthVectorOps.cpp once for each instruction set, inside a namespace
+//   which defines the vector traits classes, and with the compiler target set to that
+//   instruction set, so it has no include guard and must not include anything.
+// Scalar leftovers use WrapAdd, WrapSub and WrapMul from ForthVectorOps.cpp, so integer
+//   overflow wraps like it does in the vector ops.
+//
+// A vector traits class VT has:
+//   T, V           element type and vector type holding kLanes elements
+//   Acc, AccV      sum type and vector type holding kAccLanes partial sums
+//   Load, Store, Set1, Add, Sub, Mul, Min, Max     element vector ops
+//   AccZero, AccAdd(acc, v), AccDot(acc, a, b), AccCombine(accA, accB), AccStore
+//
+//////////////////////////////////////////////////////////////////////
+
+template <class VT>
+typename VT::Acc ReduceAcc(typename VT::AccV acc)
+{
+    typename VT::Acc lanes[VT::kAccLanes];
+    VT::AccStore(lanes, acc);
+    typename VT::Acc result = lanes[0];
+    for (int i = 1; i < VT::kAccLanes; i++)
+    {
+        result = WrapAdd<typename VT::Acc>(result, lanes[i]);
+    }
+    return result;
+}
+
+template <class VT>
+typename VT::Acc Sum(const typename VT::T* pSrc, size_t numElements)
+{
+    const size_t kLanes = VT::kLanes;
+    typename VT::AccV acc0 = VT::AccZero();
+    typename VT::AccV acc1 = VT::AccZero();
+    size_t i = 0;
+    for (; (i + (2 * kLanes)) <= numElements; i += 2 * kLanes)
+    {
+        acc0 = VT::AccAdd(acc0, VT::Load(pSrc + i));
+        acc1 = VT::AccAdd(acc1, VT::Load(pSrc + i + kLanes));
+    }
+    if ((i + kLanes) <= numElements)
+    {
+        acc0 = VT::AccAdd(acc0, VT::Load(pSrc + i));
+        i += kLanes;
+    }
+    typename VT::Acc result = ReduceAcc<VT>(VT::AccCombine(acc0, acc1));
+    for (; i < numElements; i++)
+    {
+        result = WrapAdd<typename VT::Acc>(result, pSrc[i]);
+    }
+    return result;
+}
+
+template <class VT>
+typename VT::Acc Dot(const typename VT::T* pSrcA, const typename VT::T* pSrcB, size_t numElements)
+{
+    const size_t kLanes = VT::kLanes;
+    typename VT::AccV acc0 = VT::AccZero();
+    typename VT::AccV acc1 = VT::AccZero();
+    size_t i = 0;
+    for (; (i + (2 * kLanes)) <= numElements; i += 2 * kLanes)
+    {
+        acc0 = VT::AccDot(acc0, VT::Load(pSrcA + i), VT::Load(pSrcB + i));
+        acc1 = VT::AccDot(acc1, VT::Load(pSrcA + i + kLanes), VT::Load(pSrcB + i + kLanes));
+    }
+    if ((i + kLanes) <= numElements)
+    {
+        acc0 = VT::AccDot(acc0, VT::Load(pSrcA + i), VT::Load(pSrcB + i));
+        i += kLanes;
+    }
+    typename VT::Acc result = ReduceAcc<VT>(VT::AccCombine(acc0, acc1));
+    for (; i < numElements; i++)
+    {
+        result = WrapAdd<typename VT::Acc>(result, WrapMul<typename VT::Acc>(pSrcA[i], pSrcB[i]));
+    }
+    return result;
+}
+
+template <class VT>
+typename VT::T Min(const typename VT::T* pSrc, size_t numElements)
+{
+    typedef typename VT::T T;
+    const size_t kLanes = VT::kLanes;
+    T result = pSrc[0];
+    size_t i = 0;
+    if (numElements >= kLanes)
+    {
+        typename VT::V minVec = VT::Load(pSrc);
+        for (i = kLanes; (i + kLanes) <= numElements; i += kLanes)
+        {
+            minVec = VT::Min(minVec, VT::Load(pSrc + i));
+        }
+        T lanes[VT::kLanes];
+        VT::Store(lanes, minVec);
+        for (size_t lane = 0; lane < kLanes; lane++)
+        {
+            result = (lanes[lane] < result) ? lanes[lane] : result;
+        }
+    }
+    for (; i < numElements; i++)
+    {
+        result = (pSrc[i] < result) ? pSrc[i] : result;
+    }
+    return result;
+}
+
+template <class VT>
+typename VT::T Max(const typename VT::T* pSrc, size_t numElements)
+{
+    typedef typename VT::T T;
+    const size_t kLanes = VT::kLanes;
+    T result = pSrc[0];
+    size_t i = 0;
+    if (numElements >= kLanes)
+    {
+        typename VT::V maxVec = VT::Load(pSrc);
+        for (i = kLanes; (i + kLanes) <= numElements; i += kLanes)
+        {
+            maxVec = VT::Max(maxVec, VT::Load(pSrc + i));
+        }
+        T lanes[VT::kLanes];
+        VT::Store(lanes, maxVec);
+        for (size_t lane = 0; lane < kLanes; lane++)
+        {
+            result = (lanes[lane] > result) ? lanes[lane] : result;
+        }
+    }
+    for (; i < numElements; i++)
+    {
+        result = (pSrc[i] > result) ? pSrc[i] : result;
+    }
+    return result;
+}
+
+template <class VT>
+void Add(typename VT::T* pDst, const typename VT::T* pSrc, size_t numElements)
+{
+    size_t i = 0;
+    for (; (i + VT::kLanes) <= numElements; i += VT::kLanes)
+    {
+        VT::Store(pDst + i, VT::Add(VT::Load(pDst + i), VT::Load(pSrc + i)));
+    }
+    for (; i < numElements; i++)
+    {
+        pDst[i] = WrapAdd<typename VT::T>(pDst[i], pSrc[i]);
+    }
+}
+
+template <class VT>
+void Sub(typename VT::T* pDst, const typename VT::T* pSrc, size_t numElements)
+{
+    size_t i = 0;
+    for (; (i + VT::kLanes) <= numElements; i += VT::kLanes)
+    {
+        VT::Store(pDst + i, VT::Sub(VT::Load(pDst + i), VT::Load(pSrc + i)));
+    }
+    for (; i < numElements; i++)
+    {
+        pDst[i] = WrapSub<typename VT::T>(pDst[i], pSrc[i]);
+    }
+}
+
+template <class VT>
+void Mul(typename VT::T* pDst, const typename VT::T* pSrc, size_t numElements)
+{
+    size_t i = 0;
+    for (; (i + VT::kLanes) <= numElements; i += VT::kLanes)
+    {
+        VT::Store(pDst + i, VT::Mul(VT::Load(pDst + i), VT::Load(pSrc + i)));
+    }
+    for (; i < numElements; i++)
+    {
+        pDst[i] = WrapMul<typename VT::T>(pDst[i], pSrc[i]);
+    }
+}
+
+template <class VT>
+void Scale(typename VT::T* pDst, typename VT::T factor, size_t numElements)
+{
+    typename VT::V factorVec = VT::Set1(factor);
+    size_t i = 0;
+    for (; (i + VT::kLanes) <= numElements; i += VT::kLanes)
+    {
+        VT::Store(pDst + i, VT::Mul(VT::Load(pDst + i), factorVec));
+    }
+    for (; i < numElements; i++)
+    {
+        pDst[i] = WrapMul<typename VT::T>(pDst[i], factor);
+    }
+}
+
+template <class VT>
+void Offset(typename VT::T* pDst, typename VT::T offset, size_t numElements)
+{
+    typename VT::V offsetVec = VT::Set1(offset);
+    size_t i = 0;
+    for (; (i + VT::kLanes) <= numElements; i += VT::kLanes)
+    {
+        VT::Store(pDst + i, VT::Add(VT::Load(pDst + i), offsetVec));
+    }
+    for (; i < numElements; i++)
+    {
+        pDst[i] = WrapAdd<typename VT::T>(pDst[i], offset);
+    }
+}
+
+template <class VT>
+void FillVectorKernels(ForthVectorKernels<typename VT::T>& kernels)
+{
+    kernels.sum = Sum<VT>;
+    kernels.dot = Dot<VT>;
+    kernels.min = Min<VT>;
+    kernels.max = Max<VT>;
+    kernels.add = Add<VT>;
+    kernels.sub = Sub<VT>;
+    kernels.mul = Mul<VT>;
+    kernels.scale = Scale<VT>;
+    kernels.offset = Offset<VT>;
+}
@@ -0,0 +1,643 @@
+//////////////////////////////////////////////////////////////////////
+//
+// ForthVectorOps.cpp: native bulk arithmetic used by the builtin numeric array classes
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "ForthVectorOps.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FORTH_VECTOR_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+enum
+{
+    kVectorLevelScalar,
+    kVectorLevelSSE41,
+    kVectorLevelAVX2
+};
+
+// ops which have SIMD versions are called thru a table which is filled in
+//   the first time ForthVectorOps<T> is used
+template <class T>
+struct ForthVectorKernels
+{
+    typedef typename ForthVectorAccum<T>::Type AccType;
+
+    AccType     (*sum)(const T* pSrc, size_t numElements);
+    AccType     (*dot)(const T* pSrcA, const T* pSrcB, size_t numElements);
+    T           (*min)(const T* pSrc, size_t numElements);
+    T           (*max)(const T* pSrc, size_t numElements);
+    void        (*add)(T* pDst, const T* pSrc, size_t numElements);
+    void        (*sub)(T* pDst, const T* pSrc, size_t numElements);
+    void        (*mul)(T* pDst, const T* pSrc, size_t numElements);
+    void        (*scale)(T* pDst, T factor, size_t numElements);
+    void        (*offset)(T* pDst, T offset, size_t numElements);
+};
+
+// integer arithmetic is done in an unsigned type, so that overflow wraps instead of being
+//   undefined, char and short use unsigned int since smaller types are promoted to int
+template <class T> struct ForthVectorWrap { typedef T Type; };
+template <> struct ForthVectorWrap<char> { typedef unsigned int Type; };
+template <> struct ForthVectorWrap<short> { typedef unsigned int Type; };
+template <> struct ForthVectorWrap<int> { typedef unsigned int Type; };
+template <> struct ForthVectorWrap<int64_t> { typedef uint64_t Type; };
+
+template <class T>
+inline T WrapAdd(T a, T b)
+{
+    typedef typename ForthVectorWrap<T>::Type W;
+    return (T)((W) a + (W) b);
+}
+
+template <class T>
+inline T WrapSub(T a, T b)
+{
+    typedef typename ForthVectorWrap<T>::Type W;
+    return (T)((W) a - (W) b);
+}
+
+template <class T>
+inline T WrapMul(T a, T b)
+{
+    typedef typename ForthVectorWrap<T>::Type W;
+    return (T)((W) a * (W) b);
+}
+
+//////////////////////////////////////////////////////////////////////
+///
+//                 scalar kernels
+//
+
+namespace ForthScalarKernels
+{
+    template <class T>
+    typename ForthVectorAccum<T>::Type Sum(const T* pSrc, size_t numElements)
+    {
+        typename ForthVectorAccum<T>::Type result = 0;
+        for (size_t i = 0; i < numElements; i++)
+        {
+            result = WrapAdd<typename ForthVectorAccum<T>::Type>(result, pSrc[i]);
+        }
+        return result;
+    }
+
+    template <class T>
+    typename ForthVectorAccum<T>::Type Dot(const T* pSrcA, const T* pSrcB, size_t numElements)
+    {
+        typedef typename ForthVectorAccum<T>::Type AccType;
+        AccType result = 0;
+        for (size_t i = 0; i < numElements; i++)
+        {
+            result = WrapAdd<AccType>(result, WrapMul<AccType>(pSrcA[i], pSrcB[i]));
+        }
+        return result;
+    }
+
+    template <class T>
+    T Min(const T* pSrc, size_t numElements)
+    {
+        T result = pSrc[0];
+        for (size_t i = 1; i < numElements; i++)
+        {
+            result = (pSrc[i] < result) ? pSrc[i] : result;
+        }
+        return result;
+    }
+
+    template <class T>
+    T Max(const T* pSrc, size_t numElements)
+    {
+        T result = pSrc[0];
+        for (size_t i = 1; i < numElements; i++)
+        {
+            result = (pSrc[i] > result) ? pSrc[i] : result;
+        }
+        return result;
+    }
+
+    template <class T>
+    void Add(T* pDst, const T* pSrc, size_t numElements)
+    {
+        for (size_t i = 0; i < numElements; i++)
+        {
+            pDst[i] = WrapAdd<T>(pDst[i], pSrc[i]);
+        }
+    }
+
+    template <class T>
+    void Sub(T* pDst, const T* pSrc, size_t numElements)
+    {
+        for (size_t i = 0; i < numElements; i++)
+        {
+            pDst[i] = WrapSub<T>(pDst[i], pSrc[i]);
+        }
+    }
+
+    template <class T>
+    void Mul(T* pDst, const T* pSrc, size_t numElements)
+    {
+        for (size_t i = 0; i < numElements; i++)
+        {
+            pDst[i] = WrapMul<T>(pDst[i], pSrc[i]);
+        }
+    }
+
+    template <class T>
+    void Scale(T* pDst, T factor, size_t numElements)
+    {
+        for (size_t i = 0; i < numElements; i++)
+        {
+            pDst[i] = WrapMul<T>(pDst[i], factor);
+        }
+    }
+
+    template <class T>
+    void Offset(T* pDst, T offset, size_t numElements)
+    {
+        for (size_t i = 0; i < numElements; i++)
+        {
+            pDst[i] = WrapAdd<T>(pDst[i], offset);
+        }
+    }
+
+    template <class T>
+    void FillVectorKernels(ForthVectorKernels<T>& kernels)
+    {
+        kernels.sum = Sum<T>;
+        kernels.dot = Dot<T>;
+        kernels.min = Min<T>;
+        kernels.max = Max<T>;
+        kernels.add = Add<T>;
+        kernels.sub = Sub<T>;
+        kernels.mul = Mul<T>;
+        kernels.scale = Scale<T>;
+        kernels.offset = Offset<T>;
+    }
+}
+
+#ifdef FORTH_VECTOR_X86
+
+//////////////////////////////////////////////////////////////////////
+///
+//                 SSE4.1 kernels
+//
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+
+namespace ForthSSE41Kernels
+{
+    struct DoubleVec
+    {
+        typedef double T;
+        typedef __m128d V;
+        typedef double Acc;
+        typedef __m128d AccV;
+        enum { kLanes = 2, kAccLanes = 2 };
+
+        static inline V Load(const T* pSrc) { return _mm_loadu_pd(pSrc); }
+        static inline void Store(T* pDst, V a) { _mm_storeu_pd(pDst, a); }
+        static inline V Set1(T val) { return _mm_set1_pd(val); }
+        static inline V Add(V a, V b) { return _mm_add_pd(a, b); }
+        static inline V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+        static inline V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+        static inline V Min(V a, V b) { return _mm_min_pd(a, b); }
+        static inline V Max(V a, V b) { return _mm_max_pd(a, b); }
+        static inline AccV AccZero() { return _mm_setzero_pd(); }
+        static inline AccV AccAdd(AccV acc, V a) { return _mm_add_pd(acc, a); }
+        static inline AccV AccDot(AccV acc, V a, V b) { return _mm_add_pd(acc, _mm_mul_pd(a, b)); }
+        static inline AccV AccCombine(AccV a, AccV b) { return _mm_add_pd(a, b); }
+        static inline void AccStore(Acc* pDst, AccV acc) { _mm_storeu_pd(pDst, acc); }
+    };
+
+    // float sums are done in doubles, each float vector is widened into two double vectors
+    struct FloatVec
+    {
+        typedef float T;
+        typedef __m128 V;
+        typedef double Acc;
+        typedef __m128d AccV;
+        enum { kLanes = 4, kAccLanes = 2 };
+
+        static inline V Load(const T* pSrc) { return _mm_loadu_ps(pSrc); }
+        static inline void Store(T* pDst, V a) { _mm_storeu_ps(pDst, a); }
+        static inline V Set1(T val) { return _mm_set1_ps(val); }
+        static inline V Add(V a, V b) { return _mm_add_ps(a, b); }
+        static inline V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static inline V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static inline V Min(V a, V b) { return _mm_min_ps(a, b); }
+        static inline V Max(V a, V b) { return _mm_max_ps(a, b); }
+        static inline AccV AccZero() { return _mm_setzero_pd(); }
+        static inline AccV AccAdd(AccV acc, V a)
+        {
+            acc = _mm_add_pd(acc, _mm_cvtps_pd(a));
+            return _mm_add_pd(acc, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+        }
+        static inline AccV AccDot(AccV acc, V a, V b)
+        {
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)));
+            return _mm_add_pd(acc, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), _mm_cvtps_pd(_mm_movehl_ps(b, b))));
+        }
+        static inline AccV AccCombine(AccV a, AccV b) { return _mm_add_pd(a, b); }
+        static inline void AccStore(Acc* pDst, AccV acc) { _mm_storeu_pd(pDst, acc); }
+    };
+
+    // int sums are done in 64 bits, each int vector is widened into two int64 vectors
+    struct IntVec
+    {
+        typedef int T;
+        typedef __m128i V;
+        typedef int64_t Acc;
+        typedef __m128i AccV;
+        enum { kLanes = 4, kAccLanes = 2 };
+
+        static inline V Load(const T* pSrc) { return _mm_loadu_si128((const __m128i *) pSrc); }
+        static inline void Store(T* pDst, V a) { _mm_storeu_si128((__m128i *) pDst, a); }
+        static inline V Set1(T val) { return _mm_set1_epi32(val); }
+        static inline V Add(V a, V b) { return _mm_add_epi32(a, b); }
+        static inline V Sub(V a, V b) { return _mm_sub_epi32(a, b); }
+        static inline V Mul(V a, V b) { return _mm_mullo_epi32(a, b); }
+        static inline V Min(V a, V b) { return _mm_min_epi32(a, b); }
+        static inline V Max(V a, V b) { return _mm_max_epi32(a, b); }
+        static inline AccV AccZero() { return _mm_setzero_si128(); }
+        static inline AccV AccAdd(AccV acc, V a)
+        {
+            acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(a));
+            return _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_srli_si128(a, 8)));
+        }
+        static inline AccV AccDot(AccV acc, V a, V b)
+        {
+            // _mm_mul_epi32 multiplies the even lanes into 64 bit products
+            acc = _mm_add_epi64(acc, _mm_mul_epi32(a, b));
+            return _mm_add_epi64(acc, _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)));
+        }
+        static inline AccV AccCombine(AccV a, AccV b) { return _mm_add_epi64(a, b); }
+        static inline void AccStore(Acc* pDst, AccV acc) { _mm_storeu_si128((__m128i *) pDst, acc); }
+    };
+
+#include "ForthVectorKernels.h"
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+//////////////////////////////////////////////////////////////////////
+///
+//                 AVX2 kernels
+//
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace ForthAVX2Kernels
+{
+    struct DoubleVec
+    {
+        typedef double T;
+        typedef __m256d V;
+        typedef double Acc;
+        typedef __m256d AccV;
+        enum { kLanes = 4, kAccLanes = 4 };
+
+        static inline V Load(const T* pSrc) { return _mm256_loadu_pd(pSrc); }
+        static inline void Store(T* pDst, V a) { _mm256_storeu_pd(pDst, a); }
+        static inline V Set1(T val) { return _mm256_set1_pd(val); }
+        static inline V Add(V a, V b) { return _mm256_add_pd(a, b); }
+        static inline V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+        static inline V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+        static inline V Min(V a, V b) { return _mm256_min_pd(a, b); }
+        static inline V Max(V a, V b) { return _mm256_max_pd(a, b); }
+        static inline AccV AccZero() { return _mm256_setzero_pd(); }
+        static inline AccV AccAdd(AccV acc, V a) { return _mm256_add_pd(acc, a); }
+        static inline AccV AccDot(AccV acc, V a, V b) { return _mm256_add_pd(acc, _mm256_mul_pd(a, b)); }
+        static inline AccV AccCombine(AccV a, AccV b) { return _mm256_add_pd(a, b); }
+        static inline void AccStore(Acc* pDst, AccV acc) { _mm256_storeu_pd(pDst, acc); }
+    };
+
+    struct FloatVec
+    {
+        typedef float T;
+        typedef __m256 V;
+        typedef double Acc;
+        typedef __m256d AccV;
+        enum { kLanes = 8, kAccLanes = 4 };
+
+        static inline V Load(const T* pSrc) { return _mm256_loadu_ps(pSrc); }
+        static inline void Store(T* pDst, V a) { _mm256_storeu_ps(pDst, a); }
+        static inline V Set1(T val) { return _mm256_set1_ps(val); }
+        static inline V Add(V a, V b) { return _mm256_add_ps(a, b); }
+        static inline V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static inline V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static inline V Min(V a, V b) { return _mm256_min_ps(a, b); }
+        static inline V Max(V a, V b) { return _mm256_max_ps(a, b); }
+        static inline AccV AccZero() { return _mm256_setzero_pd(); }
+        static inline AccV AccAdd(AccV acc, V a)
+        {
+            acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+            return _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+        }
+        static inline AccV AccDot(AccV acc, V a, V b)
+        {
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)),
+                _mm256_cvtps_pd(_mm256_castps256_ps128(b))));
+            return _mm256_add_pd(acc, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)),
+                _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1))));
+        }
+        static inline AccV AccCombine(AccV a, AccV b) { return _mm256_add_pd(a, b); }
+        static inline void AccStore(Acc* pDst, AccV acc) { _mm256_storeu_pd(pDst, acc); }
+    };
+
+    struct IntVec
+    {
+        typedef int T;
+        typedef __m256i V;
+        typedef int64_t Acc;
+        typedef __m256i AccV;
+        enum { kLanes = 8, kAccLanes = 4 };
+
+        static inline V Load(const T* pSrc) { return _mm256_loadu_si256((const __m256i *) pSrc); }
+        static inline void Store(T* pDst, V a) { _mm256_storeu_si256((__m256i *) pDst, a); }
+        static inline V Set1(T val) { return _mm256_set1_epi32(val); }
+        static inline V Add(V a, V b) { return _mm256_add_epi32(a, b); }
+        static inline V Sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+        static inline V Mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+        static inline V Min(V a, V b) { return _mm256_min_epi32(a, b); }
+        static inline V Max(V a, V b) { return _mm256_max_epi32(a, b); }
+        static inline AccV AccZero() { return _mm256_setzero_si256(); }
+        static inline AccV AccAdd(AccV acc, V a)
+        {
+            acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(a)));
+            return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(a, 1)));
+        }
+        static inline AccV AccDot(AccV acc, V a, V b)
+        {
+            acc = _mm256_add_epi64(acc, _mm256_mul_epi32(a, b));
+            return _mm256_add_epi64(acc, _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)));
+        }
+        static inline AccV AccCombine(AccV a, AccV b) { return _mm256_add_epi64(a, b); }
+        static inline void AccStore(Acc* pDst, AccV acc) { _mm256_storeu_si256((__m256i *) pDst, acc); }
+    };
+
+#include "ForthVectorKernels.h"
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+static int DetectVectorLevel()
+{
+    bool hasSSE41 = false;
+    bool hasAVX2 = false;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    hasSSE41 = (info[2] & (1 << 19)) != 0;
+    bool hasAVX = (info[2] & (1 << 28)) != 0;
+    bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+    // AVX registers are only usable if the OS saves them on context switches
+    if ((maxLeaf >= 7) && hasAVX && hasOSXSave && ((_xgetbv(0) & 6) == 6))
+    {
+        __cpuidex(info, 7, 0);
+        hasAVX2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    hasSSE41 = __builtin_cpu_supports("sse4.1") != 0;
+    hasAVX2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+    if (hasAVX2)
+    {
+        return kVectorLevelAVX2;
+    }
+    return hasSSE41 ? kVectorLevelSSE41 : kVectorLevelScalar;
+}
+
+#else
+
+static int DetectVectorLevel()
+{
+    return kVectorLevelScalar;
+}
+
+#endif
+
+static int GetVectorLevel()
+{
+    static int vectorLevel = DetectVectorLevel();
+    return vectorLevel;
+}
+
+// only int, float and double have SIMD kernels
+template <class T>
+void SelectVectorKernels(ForthVectorKernels<T>& kernels)
+{
+}
+
+#ifdef FORTH_VECTOR_X86
+template <class SSE41_VT, class AVX2_VT>
+void SelectSIMDKernels(ForthVectorKernels<typename SSE41_VT::T>& kernels)
+{
+    switch (GetVectorLevel())
+    {
+    case kVectorLevelAVX2:
+        ForthAVX2Kernels::FillVectorKernels<AVX2_VT>(kernels);
+        break;
+    case kVectorLevelSSE41:
+        ForthSSE41Kernels::FillVectorKernels<SSE41_VT>(kernels);
+        break;
+    default:
+        break;
+    }
+}
+
+template <>
+void SelectVectorKernels<int>(ForthVectorKernels<int>& kernels)
+{
+    SelectSIMDKernels<ForthSSE41Kernels::IntVec, ForthAVX2Kernels::IntVec>(kernels);
+}
+
+template <>
+void SelectVectorKernels<float>(ForthVectorKernels<float>& kernels)
+{
+    SelectSIMDKernels<ForthSSE41Kernels::FloatVec, ForthAVX2Kernels::FloatVec>(kernels);
+}
+
+template <>
+void SelectVectorKernels<double>(ForthVectorKernels<double>& kernels)
+{
+    SelectSIMDKernels<ForthSSE41Kernels::DoubleVec, ForthAVX2Kernels::DoubleVec>(kernels);
+}
+#endif
+
+template <class T>
+ForthVectorKernels<T> MakeVectorKernels()
+{
+    ForthVectorKernels<T> kernels;
+    ForthScalarKernels::FillVectorKernels<T>(kernels);
+    SelectVectorKernels<T>(kernels);
+    return kernels;
+}
+
+template <class T>
+const ForthVectorKernels<T>& GetVectorKernels()
+{
+    static const ForthVectorKernels<T> kernels = MakeVectorKernels<T>();
+    return kernels;
+}
+
+//////////////////////////////////////////////////////////////////////
+///
+//                 ForthVectorOps
+//
+
+template <class T>
+typename ForthVectorOps<T>::AccType ForthVectorOps<T>::Sum(const T* pSrc, size_t numElements)
+{
+    return GetVectorKernels<T>().sum(pSrc, numElements);
+}
+
+template <class T>
+T ForthVectorOps<T>::Min(const T* pSrc, size_t numElements)
+{
+    return GetVectorKernels<T>().min(pSrc, numElements);
+}
+
+template <class T>
+T ForthVectorOps<T>::Max(const T* pSrc, size_t numElements)
+{
+    return GetVectorKernels<T>().max(pSrc, numElements);
+}
+
+// find the min or max with the SIMD kernel, then search for its first occurrence, this is
+//   two passes over memory, but both run at memory speed unlike a scalar compare loop
+template <class T>
+size_t ForthVectorOps<T>::ArgMin(const T* pSrc, size_t numElements)
+{
+    if (numElements == 0)
+    {
+        return 0;
+    }
+    const T* pFound = std::find(pSrc, pSrc + numElements, Min(pSrc, numElements));
+    if (pFound == (pSrc + numElements))
+    {
+        // only happens if min is a NaN
+        return std::min_element(pSrc, pSrc + numElements) - pSrc;
+    }
+    return pFound - pSrc;
+}
+
+template <class T>
+size_t ForthVectorOps<T>::ArgMax(const T* pSrc, size_t numElements)
+{
+    if (numElements == 0)
+    {
+        return 0;
+    }
+    const T* pFound = std::find(pSrc, pSrc + numElements, Max(pSrc, numElements));
+    if (pFound == (pSrc + numElements))
+    {
+        return std::max_element(pSrc, pSrc + numElements) - pSrc;
+    }
+    return pFound - pSrc;
+}
+
+template <class T>
+typename ForthVectorOps<T>::AccType ForthVectorOps<T>::Dot(const T* pSrcA, const T* pSrcB, size_t numElements)
+{
+    return GetVectorKernels<T>().dot(pSrcA, pSrcB, numElements);
+}
+
+template <class T>
+void ForthVectorOps<T>::Add(T* pDst, const T* pSrc, size_t numElements)
+{
+    GetVectorKernels<T>().add(pDst, pSrc, numElements);
+}
+
+template <class T>
+void ForthVectorOps<T>::Sub(T* pDst, const T* pSrc, size_t numElements)
+{
+    GetVectorKernels<T>().sub(pDst, pSrc, numElements);
+}
+
+template <class T>
+void ForthVectorOps<T>::Mul(T* pDst, const T* pSrc, size_t numElements)
+{
+    GetVectorKernels<T>().mul(pDst, pSrc, numElements);
+}
+
+template <class T>
+void ForthVectorOps<T>::Scale(T* pDst, T factor, size_t numElements)
+{
+    GetVectorKernels<T>().scale(pDst, factor, numElements);
+}
+
+template <class T>
+void ForthVectorOps<T>::Offset(T* pDst, T offset, size_t numElements)
+{
+    GetVectorKernels<T>().offset(pDst, offset, numElements);
+}
+
+template <class T>
+void ForthVectorOps<T>::PrefixSum(T* pDst, size_t numElements)
+{
+    // each sum depends on the previous one, so this doesn't vectorize
+    T sum = 0;
+    for (size_t i = 0; i < numElements; i++)
+    {
+        sum = WrapAdd<T>(sum, pDst[i]);
+        pDst[i] = sum;
+    }
+}
+
+template <class T>
+void ForthVectorOps<T>::Histogram(const T* pSrc, size_t numElements, T lo, T hi, int* pCounts, size_t numBins)
+{
+    std::fill(pCounts, pCounts + numBins, 0);
+    if ((numBins == 0) || !(lo < hi))
+    {
+        return;
+    }
+    double binScale = ((double) numBins) / (((double) hi) - ((double) lo));
+    for (size_t i = 0; i < numElements; i++)
+    {
+        T val = pSrc[i];
+        if ((val >= lo) && (val < hi))
+        {
+            size_t bin = (size_t)((((double) val) - ((double) lo)) * binScale);
+            // rounding can put values just below hi into bin numBins
+            pCounts[(bin < numBins) ? bin : (numBins - 1)]++;
+        }
+    }
+}
+
+template class ForthVectorOps<char>;
+template class ForthVectorOps<short>;
+template class ForthVectorOps<int>;
+template class ForthVectorOps<int64_t>;
+template class ForthVectorOps<float>;
+template class ForthVectorOps<double>;
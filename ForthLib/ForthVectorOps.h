@@ -0,0 +1,45 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// ForthVectorOps.h: native bulk arithmetic used by the builtin numeric array classes
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stddef.h>
+
+// sums and dot products of integer elements are done in 64 bits, float elements in doubles
+template <class T> struct ForthVectorAccum { typedef int64_t Type; };
+template <> struct ForthVectorAccum<float> { typedef double Type; };
+template <> struct ForthVectorAccum<double> { typedef double Type; };
+
+// ForthVectorOps<T> is implemented for char, short, int, int64_t, float and double.
+// The int, float and double ops use SSE4.1 or AVX2 kernels when the CPU supports them,
+//   the instruction set is picked the first time the ops for a type are used.
+// Element-wise ops use the element type and wrap on integer overflow.
+template <class T>
+class ForthVectorOps
+{
+public:
+    typedef typename ForthVectorAccum<T>::Type AccType;
+
+    static AccType      Sum(const T* pSrc, size_t numElements);
+    // Min and Max require numElements > 0
+    static T            Min(const T* pSrc, size_t numElements);
+    static T            Max(const T* pSrc, size_t numElements);
+    // ArgMin and ArgMax return index of first min/max element, or numElements if numElements is 0
+    static size_t       ArgMin(const T* pSrc, size_t numElements);
+    static size_t       ArgMax(const T* pSrc, size_t numElements);
+    static AccType      Dot(const T* pSrcA, const T* pSrcB, size_t numElements);
+
+    // pDst[i] = pDst[i] op pSrc[i]
+    static void         Add(T* pDst, const T* pSrc, size_t numElements);
+    static void         Sub(T* pDst, const T* pSrc, size_t numElements);
+    static void         Mul(T* pDst, const T* pSrc, size_t numElements);
+    static void         Scale(T* pDst, T factor, size_t numElements);
+    static void         Offset(T* pDst, T offset, size_t numElements);
+    // pDst[i] = pDst[0] + ... + pDst[i]
+    static void         PrefixSum(T* pDst, size_t numElements);
+    // count elements in [lo, hi) into numBins equal width bins, pCounts is cleared first
+    static void         Histogram(const T* pSrc, size_t numElements, T lo, T hi, int* pCounts, size_t numBins);
+};
@@ -1287,7 +1287,7 @@ namespace OVocabulary
 	FORTHOP(oVocabularyHeadIterMethod)
 	{
 		GET_THIS(oVocabularyStruct, pVocabulary);
-		pVocabulary->refCount++;
+		INCREMENT_REFCOUNT(pVocabulary);
 		TRACK_KEEP;
 		ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIVocabularyIter);
 		MALLOCATE_ITER(oVocabularyIterStruct, pIter, pIterVocab);
@@ -0,0 +1,262 @@
+//////////////////////////////////////////////////////////////////////
+//
+// ForthWorkerPool.cpp: pool of native worker threads for parallel builtin ops
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "pch.h"
+
+#if defined(WINDOWS_BUILD)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "ForthWorkerPool.h"
+
+// limit on worker threads, no matter how many cores there are
+#define MAX_POOL_WORKERS 31
+
+ForthWorkerPool* ForthWorkerPool::mpInstance = nullptr;
+
+ForthWorkerPool::ForthWorkerPool()
+    : mTask(nullptr)
+    , mpUserData(nullptr)
+    , mNumTasks(0)
+    , mNextTask(0)
+    , mTasksRemaining(0)
+    , mShuttingDown(false)
+    , mStarted(false)
+{
+#if defined(WINDOWS_BUILD)
+    InitializeCriticalSection(&mLock);
+    InitializeCriticalSection(&mBatchLock);
+    InitializeConditionVariable(&mWorkReady);
+    InitializeConditionVariable(&mWorkDone);
+#else
+    pthread_mutex_init(&mLock, nullptr);
+    pthread_mutex_init(&mBatchLock, nullptr);
+    pthread_cond_init(&mWorkReady, nullptr);
+    pthread_cond_init(&mWorkDone, nullptr);
+#endif
+}
+
+ForthWorkerPool::~ForthWorkerPool()
+{
+#if defined(WINDOWS_BUILD)
+    EnterCriticalSection(&mLock);
+    mShuttingDown = true;
+    WakeAllConditionVariable(&mWorkReady);
+    LeaveCriticalSection(&mLock);
+    for (HANDLE worker : mWorkers)
+    {
+        WaitForSingleObject(worker, INFINITE);
+        CloseHandle(worker);
+    }
+    DeleteCriticalSection(&mLock);
+    DeleteCriticalSection(&mBatchLock);
+#else
+    pthread_mutex_lock(&mLock);
+    mShuttingDown = true;
+    pthread_cond_broadcast(&mWorkReady);
+    pthread_mutex_unlock(&mLock);
+    for (pthread_t worker : mWorkers)
+    {
+        pthread_join(worker, nullptr);
+    }
+    pthread_cond_destroy(&mWorkReady);
+    pthread_cond_destroy(&mWorkDone);
+    pthread_mutex_destroy(&mLock);
+    pthread_mutex_destroy(&mBatchLock);
+#endif
+}
+
+ForthWorkerPool* ForthWorkerPool::GetInstance()
+{
+    if (mpInstance == nullptr)
+    {
+        mpInstance = new ForthWorkerPool;
+    }
+    return mpInstance;
+}
+
+#if defined(WINDOWS_BUILD)
+unsigned __stdcall ForthWorkerPool::WorkerRoutine(void* pUserData)
+{
+    ((ForthWorkerPool*)pUserData)->WorkerLoop();
+    return 0;
+}
+#else
+void* ForthWorkerPool::WorkerRoutine(void* pUserData)
+{
+    ((ForthWorkerPool*)pUserData)->WorkerLoop();
+    return nullptr;
+}
+#endif
+
+void ForthWorkerPool::StartWorkers()
+{
+    // called with mBatchLock held
+    if (!mStarted)
+    {
+        mStarted = true;
+#if defined(WINDOWS_BUILD)
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        int numCores = (int)systemInfo.dwNumberOfProcessors;
+#else
+        int numCores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        int numWorkers = (numCores > 1) ? numCores - 1 : 0;
+        if (numWorkers > MAX_POOL_WORKERS)
+        {
+            numWorkers = MAX_POOL_WORKERS;
+        }
+        for (int i = 0; i < numWorkers; i++)
+        {
+#if defined(WINDOWS_BUILD)
+            HANDLE worker = (HANDLE)_beginthreadex(nullptr, 0, WorkerRoutine, this, 0, nullptr);
+            if (worker == 0)
+            {
+                break;
+            }
+#else
+            pthread_t worker;
+            if (pthread_create(&worker, nullptr, WorkerRoutine, this) != 0)
+            {
+                break;
+            }
+#endif
+            mWorkers.push_back(worker);
+        }
+    }
+}
+
+int ForthWorkerPool::GetNumThreads()
+{
+#if defined(WINDOWS_BUILD)
+    EnterCriticalSection(&mBatchLock);
+    StartWorkers();
+    LeaveCriticalSection(&mBatchLock);
+#else
+    pthread_mutex_lock(&mBatchLock);
+    StartWorkers();
+    pthread_mutex_unlock(&mBatchLock);
+#endif
+    return (int)mWorkers.size() + 1;
+}
+
+int ForthWorkerPool::RunAvailableTasks()
+{
+    int numRun = 0;
+    while (mNextTask < mNumTasks)
+    {
+        int taskIndex = mNextTask++;
+#if defined(WINDOWS_BUILD)
+        LeaveCriticalSection(&mLock);
+        mTask(taskIndex, mpUserData);
+        EnterCriticalSection(&mLock);
+#else
+        pthread_mutex_unlock(&mLock);
+        mTask(taskIndex, mpUserData);
+        pthread_mutex_lock(&mLock);
+#endif
+        numRun++;
+        if (--mTasksRemaining == 0)
+        {
+#if defined(WINDOWS_BUILD)
+            WakeAllConditionVariable(&mWorkDone);
+#else
+            pthread_cond_broadcast(&mWorkDone);
+#endif
+        }
+    }
+    return numRun;
+}
+
+void ForthWorkerPool::WorkerLoop()
+{
+#if defined(WINDOWS_BUILD)
+    EnterCriticalSection(&mLock);
+#else
+    pthread_mutex_lock(&mLock);
+#endif
+    while (true)
+    {
+        while (!mShuttingDown && (mNextTask >= mNumTasks))
+        {
+#if defined(WINDOWS_BUILD)
+            SleepConditionVariableCS(&mWorkReady, &mLock, INFINITE);
+#else
+            pthread_cond_wait(&mWorkReady, &mLock);
+#endif
+        }
+        if (mShuttingDown)
+        {
+            break;
+        }
+        RunAvailableTasks();
+    }
+#if defined(WINDOWS_BUILD)
+    LeaveCriticalSection(&mLock);
+#else
+    pthread_mutex_unlock(&mLock);
+#endif
+}
+
+void ForthWorkerPool::RunTasks(int numTasks, ForthWorkerTask task, void* pUserData)
+{
+#if defined(WINDOWS_BUILD)
+    EnterCriticalSection(&mBatchLock);
+#else
+    pthread_mutex_lock(&mBatchLock);
+#endif
+    StartWorkers();
+    if (mWorkers.empty() || numTasks == 1)
+    {
+        for (int i = 0; i < numTasks; i++)
+        {
+            task(i, pUserData);
+        }
+    }
+    else
+    {
+#if defined(WINDOWS_BUILD)
+        EnterCriticalSection(&mLock);
+#else
+        pthread_mutex_lock(&mLock);
+#endif
+        mTask = task;
+        mpUserData = pUserData;
+        mNumTasks = numTasks;
+        mNextTask = 0;
+        mTasksRemaining = numTasks;
+#if defined(WINDOWS_BUILD)
+        WakeAllConditionVariable(&mWorkReady);
+#else
+        pthread_cond_broadcast(&mWorkReady);
+#endif
+        RunAvailableTasks();
+        while (mTasksRemaining != 0)
+        {
+#if defined(WINDOWS_BUILD)
+            SleepConditionVariableCS(&mWorkDone, &mLock, INFINITE);
+#else
+            pthread_cond_wait(&mWorkDone, &mLock);
+#endif
+        }
+        mNumTasks = 0;
+        mNextTask = 0;
+        mTask = nullptr;
+#if defined(WINDOWS_BUILD)
+        LeaveCriticalSection(&mLock);
+#else
+        pthread_mutex_unlock(&mLock);
+#endif
+    }
+#if defined(WINDOWS_BUILD)
+    LeaveCriticalSection(&mBatchLock);
+#else
+    pthread_mutex_unlock(&mBatchLock);
+#endif
+}
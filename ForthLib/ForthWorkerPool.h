@@ -0,0 +1,68 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// ForthWorkerPool.h: pool of native worker threads for parallel builtin ops
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#if !defined(WINDOWS_BUILD)
+#include <pthread.h>
+#endif
+
+// a task function is called once for each task index in [0, numTasks)
+typedef void(*ForthWorkerTask)(int taskIndex, void* pUserData);
+
+// ForthWorkerPool runs native (non-forth) work on a set of OS threads which are shared by
+//   all forth threads, the workers are started the first time the pool is used.
+// RunTasks blocks until all tasks are done, the calling thread also runs tasks, so a pool
+//   with N workers runs up to N+1 tasks at once.
+class ForthWorkerPool
+{
+public:
+    // the pool is created by OArray::AddClasses during startup, before any forth threads run
+    static ForthWorkerPool* GetInstance();
+
+    // number of tasks which can run at once, including the calling thread
+    int                 GetNumThreads();
+    void                RunTasks(int numTasks, ForthWorkerTask task, void* pUserData);
+
+private:
+    ForthWorkerPool();
+    ~ForthWorkerPool();
+    void                StartWorkers();
+    void                WorkerLoop();
+    // run tasks from the current batch until none are left, returns number of tasks run
+    //  must be called with mLock held, which is released while each task runs
+    int                 RunAvailableTasks();
+#if defined(WINDOWS_BUILD)
+    static unsigned __stdcall WorkerRoutine(void* pUserData);
+#else
+    static void*        WorkerRoutine(void* pUserData);
+#endif
+
+#if defined(WINDOWS_BUILD)
+    std::vector<HANDLE> mWorkers;
+    CRITICAL_SECTION    mLock;
+    // only one batch of tasks runs at a time
+    CRITICAL_SECTION    mBatchLock;
+    CONDITION_VARIABLE  mWorkReady;
+    CONDITION_VARIABLE  mWorkDone;
+#else
+    std::vector<pthread_t> mWorkers;
+    pthread_mutex_t     mLock;
+    // only one batch of tasks runs at a time
+    pthread_mutex_t     mBatchLock;
+    pthread_cond_t      mWorkReady;
+    pthread_cond_t      mWorkDone;
+#endif
+    ForthWorkerTask     mTask;
+    void*               mpUserData;
+    int                 mNumTasks;
+    int                 mNextTask;
+    int                 mTasksRemaining;
+    bool                mShuttingDown;
+    bool                mStarted;
+
+    static ForthWorkerPool* mpInstance;
+};
@@ -6,6 +6,12 @@ BITS 32
 ;cextern	_chkesp
 
 EXTERN _CallDLLRoutine
+cextern gCycleCollectorEnabled
+%ifdef LINUX
+%define cycleCollectorEnabled gCycleCollectorEnabled
+%else
+%define cycleCollectorEnabled _gCycleCollectorEnabled
+%endif
 
 ;%define FCore ForthCoreState
 ;%define FileFunc ForthFileInterface
@@ -2300,51 +2306,77 @@ los0:
 	cmp eax, ebx
 	jz losx				; objects are same, don't change refcount
 	; handle newObj refcount
+	; objects shared between threads have SHARED_OBJECT_FLAG (the sign bit) set in their refcount,
+	;   and their refcounts must be updated atomically
 	or eax, eax
 	jz los1				; if newObj is null, don't try to increment refcount
+	cmp	dword[eax + Object.refCount], 0
+	jl	los4
 	inc dword[eax + Object.refCount]	; increment newObj refcount
 	; handle oldObj refcount
 los1:
 	or ebx, ebx
 	jz los2				; if oldObj is null, don't try to decrement refcount
-	dec dword[ebx + Object.refCount]
-	jz los3
+	mov	[ecx], eax		; var = newObj
+	add	rpsp, 4
+	mov	ecx, [ebx + Object.refCount]
+	or	ecx, ecx
+	js	los5
+	sub	ecx, 1
+	mov	[ebx + Object.refCount], ecx
+	jz	objectRefCountDropped
+los3:
+	; oldObj is still referenced, it is a possible garbage cycle root
+	cmp	byte[cycleCollectorEnabled], 0
+	jnz	objectRefCountDropped
+	jmp	rnext
+
 los2:
 	mov	[ecx], eax		; var = newObj
 losx:
 	add	rpsp, 4
 	jmp	rnext
 
-	; object var held last reference to oldObj, invoke olbObj.delete method
-	; eax = newObj
-	; ebx = oldObj
-	; [ecx] = var (still holds oldObj)
-los3:
-	push rnext
-	push eax
-	; TOS is object
-
-	; push this ptr on return stack
-	mov	rnext, [rcore + FCore.RPtr]
-	sub	rnext, 4
-	mov	[rcore + FCore.RPtr], rnext
-	mov	eax, [rcore + FCore.TPtr]
-	mov	[rnext], eax
-	
-	; set this to oldObj
-	mov	[rcore + FCore.TPtr], ebx
-	mov	ebx, [ebx]	; ebx = oldObj methods pointer
-	mov	ebx, [ebx]	; ebx = oldObj method 0 (delete)
+los4:
+	lock inc dword[eax + Object.refCount]
+	jmp	los1
 
-	pop eax
-	pop rnext
-	
-	mov	[ecx], eax		; var = newObj
-	add	rpsp, 4
+los5:
+	mov	ecx, -1
+	lock xadd [ebx + Object.refCount], ecx	; ecx = old refcount
+	sub	ecx, 1
+	shl	ecx, 1				; strip SHARED_OBJECT_FLAG from new refcount
+	shr	ecx, 1
+	jnz	los3
+	; object var held last reference to oldObj, fall through to let ObjectRefCountDropped
+	;   delete it, so deferred releases work the same as in C++ code
 
-	; execute the delete method opcode which is in ebx
-	mov	eax, [rcore + FCore.innerExecute]
-	jmp eax
+; call ObjectRefCountDropped( pCore, object, newRefCount ), which does what SAFE_RELEASE does
+;   after its decrement
+;	ebx = object, ecx = new refcount without SHARED_OBJECT_FLAG
+objectRefCountDropped:
+	mov	[rcore + FCore.IPtr], rip
+	mov	[rcore + FCore.SPtr], rpsp
+%ifdef MACOSX
+    sub esp, 12      ; 16-byte align for OSX
+%endif
+	push	rcore		; push core ptr (our save)
+	push	ecx			; new refcount
+	push	ebx			; object
+	push	rcore		; core ptr
+	xcall	ObjectRefCountDropped
+	add	esp, 12		; discard inputs to C routine
+	pop	rcore
+%ifdef MACOSX
+    add esp, 12
+%endif
+	; the delete method may have changed IP and SP
+	mov	rip, [rcore + FCore.IPtr]
+	mov	rpsp, [rcore + FCore.SPtr]
+	mov	eax, [rcore + FCore.state]
+	or	eax, eax
+	jnz	interpLoopExit		; if something went wrong
+	jmp	rnext
 
 localObjectClear:
 	; TOS is new object, eax points to destination/old object
@@ -2382,20 +2414,28 @@ localObjectUnref:
 	mov	[ecx], eax
 	; set var operation back to fetch
 	mov	[rcore + FCore.varMode], eax
-	; get object refcount, see if it is already 0
+	; get object refcount, see if it is already 0, ignoring SHARED_OBJECT_FLAG
 	mov	eax, [ebx + Object.refCount]
-	or	eax, eax
+	mov	ecx, eax
+	shl	ecx, 1
 	jnz	lou1
 	; report refcount negative error
 	mov	eax, kForthErrorBadReferenceCount
 	jmp	interpLoopErrorExit
 lou1:
 	; decrement object refcount
+	or	eax, eax
+	js	lou3
 	sub	eax, 1
 	mov	[ebx + Object.refCount], eax
 lou2:
 	jmp	rnext
 
+lou3:
+	; object is shared between threads
+	lock dec dword[ebx + Object.refCount]
+	jmp	rnext
+
 	
 localObjectActionTable:
 	DD	localObjectFetch
@@ -6080,29 +6120,16 @@ entry oclearVaractionBop
 entry odropBop
 	; TOS is object to check - if its refcount is already 0, invoke delete method
 	;  otherwise do nothing
-	mov	eax, [rpsp]
+	mov	ebx, [rpsp]
 	add	rpsp, 4
-	mov	ebx, [eax + Object.refCount]
 	or	ebx, ebx
+	jz .odrop1
+	mov	ecx, [ebx + Object.refCount]
+	shl	ecx, 1				; ignore SHARED_OBJECT_FLAG
 	jnz .odrop1
 
-	; refcount is 0, delete the object
-	; push this ptr on return stack
-	mov	ebx, [rcore + FCore.RPtr]
-	sub	ebx, 4
-	mov	[rcore + FCore.RPtr], ebx
-	mov	ecx, [rcore + FCore.TPtr]
-	mov	[ebx], ecx
-
-	; set this to object to delete
-	mov	[rcore + FCore.TPtr], eax
-
-	mov	ebx, [eax]	; ebx = methods pointer
-	mov	ebx, [ebx]	; ebx = method 0 (delete)
-
-	; execute the delete method opcode which is in ebx
-	mov	eax, [rcore + FCore.innerExecute]
-	jmp eax
+	; refcount is 0, delete the object or queue it for deletion
+	jmp	objectRefCountDropped
 
 .odrop1:
 	jmp rnext
@@ -52,6 +52,7 @@ BITS 64
 
 
 EXTERN CallDLLRoutine
+EXTERN gCycleCollectorEnabled
 
 SECTION .text
 
@@ -2431,35 +2432,71 @@ los0:
 	cmp rax, rbx
 	jz losx				; objects are same, don't change refcount
 	; handle newObj refcount
+	; objects shared between threads have SHARED_OBJECT_FLAG (the sign bit) set in their refcount,
+	;   and their refcounts must be updated atomically
 	or rax, rax
 	jz los1				; if newObj is null, don't try to increment refcount
+	mov	rdx, [rax + Object.refCount]
+	or	rdx, rdx
+	js	los4
 	inc QWORD[rax + Object.refCount]	; increment newObj refcount
 	; handle oldObj refcount
 los1:
 	or rbx, rbx
 	jz losx				; if oldObj is null, don't try to decrement refcount
-	dec QWORD[rbx + Object.refCount]
-	jz los3
+	mov	rdx, [rbx + Object.refCount]
+	or	rdx, rdx
+	js	los5
+	sub	rdx, 1
+	mov	[rbx + Object.refCount], rdx
+	jz	objectRefCountDropped
+los2:
+	; oldObj is still referenced, it is a possible garbage cycle root
+	cmp	BYTE[gCycleCollectorEnabled], 0
+	jnz	objectRefCountDropped
 losx:
 	jmp	rnext
 
-	; object var held last reference to oldObj, invoke olbObj.delete method
-	; rax = newObj
-	; rbx = oldObj
-los3:
-	; push this ptr on return stack
-    sub rrp, 8
-	mov	rax, [rcore + FCore.TPtr]
-	mov	[rrp], rax
-	
-	; set this to oldObj
-	mov	[rcore + FCore.TPtr], rbx
-	mov	rbx, [rbx]	; rbx = oldObj methods pointer
-	mov	ebx, [rbx]	; rbx = oldObj method 0 (delete)
-	
-	; execute the delete method opcode which is in rbx
-	mov	rax, [rcore + FCore.innerExecute]
-	jmp rax
+los4:
+	lock inc QWORD[rax + Object.refCount]
+	jmp	los1
+
+los5:
+	mov	rdx, -1
+	lock xadd [rbx + Object.refCount], rdx	; rdx = old refcount
+	sub	rdx, 1
+	shl	rdx, 1				; strip SHARED_OBJECT_FLAG from new refcount
+	shr	rdx, 1
+	jnz	los2
+	; object var held last reference to oldObj, fall through to let ObjectRefCountDropped
+	;   delete it, so deferred releases work the same as in C++ code
+	
+; call ObjectRefCountDropped( pCore, object, newRefCount ), which does what SAFE_RELEASE does
+;   after its decrement
+;	rbx = object, rdx = new refcount without SHARED_OBJECT_FLAG
+objectRefCountDropped:
+	mov	[rcore + FCore.IPtr], rip
+	mov	[rcore + FCore.SPtr], rpsp
+	mov	[rcore + FCore.RPtr], rrp
+	mov	[rcore + FCore.FPtr], rfp
+	mov	r8, rdx				; 3rd param - new refcount
+	mov	rdx, rbx			; 2nd param - object
+    mov rcx, rcore			; 1st param - core
+	sub rsp, 32			; shadow space
+	xcall	ObjectRefCountDropped
+	add rsp, 32
+	; the delete method may have changed IP and SP
+	mov	rpsp, [rcore + FCore.SPtr]
+	mov rrp, [rcore + FCore.RPtr]
+	mov	rfp, [rcore + FCore.FPtr]
+	mov	rip, [rcore + FCore.IPtr]
+	mov	rax, [rcore + FCore.state]
+	mov roptab, [rcore + FCore.ops]
+	mov rnumops, [rcore + FCore.numOps]
+	mov racttab, [rcore + FCore.optypeAction]
+	or	rax, rax
+	jnz	interpLoopExit		; if something went wrong
+	jmp	rnext
 
 localObjectClear:
 	; rax points to destination/old object
@@ -2496,20 +2533,28 @@ localObjectUnref:
 	mov	[rcx], rax
 	; set var operation back to fetch
 	mov	[rcore + FCore.varMode], rax
-	; get object refcount, see if it is already 0
+	; get object refcount, see if it is already 0, ignoring SHARED_OBJECT_FLAG
 	mov	rax, [rbx + Object.refCount]
-	or	rax, rax
+	mov	rcx, rax
+	shl	rcx, 1
 	jnz	lou1
 	; report refcount negative error
 	mov	rax, kForthErrorBadReferenceCount
 	jmp	interpLoopErrorExit
 lou1:
 	; decrement object refcount
+	or	rax, rax
+	js	lou3
 	sub	rax, 1
 	mov	[rbx + Object.refCount], rax
 lou2:
 	jmp	rnext
 
+lou3:
+	; object is shared between threads
+	lock dec QWORD[rbx + Object.refCount]
+	jmp	rnext
+
 	
 localObjectActionTable:
 	DQ	localObjectFetch
@@ -5486,27 +5531,16 @@ entry oclearVaractionBop
 entry odropBop
 	; TOS is object to check - if its refcount is already 0, invoke delete method
 	;  otherwise do nothing
-	mov	rax, [rpsp]
+	mov	rbx, [rpsp]
 	add	rpsp, 8
-	mov	rbx, [rax + Object.refCount]
 	or	rbx, rbx
+	jz .odrop1
+	mov	rdx, [rbx + Object.refCount]
+	shl	rdx, 1				; ignore SHARED_OBJECT_FLAG
 	jnz .odrop1
 
-	; refcount is 0, delete the object
-	; push this ptr on return stack
-	sub	rrp, 8
-	mov	rcx, [rcore + FCore.TPtr]
-	mov	[rrp], rcx
-
-	; set this to object to delete
-	mov	[rcore + FCore.TPtr], rax
-
-	mov	rbx, [rax]	; rbx = methods pointer
-	mov	ebx, [rbx]	; rbx = method 0 (delete)
-
-	; execute the delete method opcode which is in rbx
-	mov	rax, [rcore + FCore.innerExecute]
-	jmp rax
+	; refcount is 0, delete the object or queue it for deletion
+	jmp	objectRefCountDropped
 
 .odrop1:
 	jmp rnext
@@ -16,10 +16,13 @@
 #include "ForthBuiltinClasses.h"
 #include "ForthShowContext.h"
 #include "ForthObjectReader.h"
+#include "ForthBinarySerializer.h"
 
 #include "OArray.h"
 #include "OList.h"
 #include "OMap.h"
+#include "ForthSort.h"
+#include "ForthVectorOps.h"
 
 static void ReportBadArrayIndex(const char* pWhere, int ix, int arraySize)
 {
@@ -62,6 +65,40 @@ namespace OArray
         return pIter;
     }
 
+    void arrayChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oArray& a = *(reinterpret_cast<oArrayStruct*>(obj)->elements);
+        for (ucell i = 0; i < a.size(); i++)
+        {
+            if (a[i] != nullptr)
+            {
+                visitor(a[i], pUserData);
+            }
+        }
+    }
+
+    void arrayBinaryWriter(ForthObject& obj, ForthBinaryWriter* writer)
+    {
+        oArray& a = *(reinterpret_cast<oArrayStruct*>(obj)->elements);
+        writer->WriteU64(a.size());
+        for (ucell i = 0; i < a.size(); i++)
+        {
+            writer->WriteObjectRef(a[i]);
+        }
+    }
+
+    void arrayBinaryReader(ForthObject& obj, ForthBinaryReader* reader)
+    {
+        oArray& a = *(reinterpret_cast<oArrayStruct*>(obj)->elements);
+        uint64_t numElements = reader->ReadU64();
+        reader->CheckCount(numElements, sizeof(uint32_t));
+        a.resize(numElements);
+        for (ucell i = 0; i < a.size(); i++)
+        {
+            reader->ReadObjectRef(a[i]);
+        }
+    }
+
     bool customArrayReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "elements")
@@ -135,7 +172,7 @@ namespace OArray
     FORTHOP(oArrayHeadIterMethod)
     {
         GET_THIS(oArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oArrayIterStruct* pIter = createArrayIterator(pCore, pArray);
@@ -148,7 +185,7 @@ namespace OArray
     FORTHOP(oArrayTailIterMethod)
     {
         GET_THIS(oArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oArrayIterStruct* pIter = createArrayIterator(pCore, pArray);
@@ -171,7 +208,7 @@ namespace OArray
             ForthObject& o = a[i];
             if (OBJECTS_SAME(o, soughtObj))
             {
-                pArray->refCount++;
+                INCREMENT_REFCOUNT(pArray);
                 TRACK_KEEP;
 
                 oArrayIterStruct* pIter = createArrayIterator(pCore, pArray);
@@ -536,73 +573,192 @@ namespace OArray
 		METHOD_RETURN;
 	}
 
-    int objectArrayQuicksortPartition(ForthCoreState* pCore, ForthObject* pData, int left, int right)
-	{
-		ForthObject* pLeft = pData + left;
-		ForthObject* pRight = pData + right;
-		ForthObject pivot = *pLeft;
-		ForthObject tmp;
-		int compareResult;
-		ForthEngine* pEngine = ForthEngine::GetInstance();
-
-		left--;
-		pLeft--;
-		right++;
-		pRight++;
-		while (true)
-		{
-			do
-			{
-				left++;
-				pLeft++;
-				PUSH_OBJECT(pivot);
-				pEngine->FullyExecuteMethod(pCore, *pLeft, kMethodCompare);
-				compareResult = SPOP;
-			} while (compareResult < 0);
-
-			do
-			{
-				right--;
-				pRight--;
-				PUSH_OBJECT(pivot);
-				pEngine->FullyExecuteMethod(pCore, *pRight, kMethodCompare);
-				compareResult = SPOP;
-			} while (compareResult > 0);
-
-			if (left >= right)
-			{
-				return right;
-			}
-
-			// swap(a[left], a[right]);
-			tmp = *pLeft;
-			*pLeft = *pRight;
-			*pRight = tmp;
-		}
-	}
+    // orders objects with their forth compare method
+    struct objectArrayCompareLess
+    {
+        ForthCoreState* pCore;
+        ForthEngine* pEngine;
 
-	void objectArrayQuicksortStep(ForthCoreState* pCore, ForthObject* pData, int left, int right)
-	{
-		if (left < right)
-		{
-			int pivot = objectArrayQuicksortPartition(pCore, pData, left, right);
-			objectArrayQuicksortStep(pCore, pData, left, pivot);
-			objectArrayQuicksortStep(pCore, pData, pivot + 1, right);
-		}
-	}
+        bool operator()(ForthObject& a, ForthObject& b)
+        {
+            PUSH_OBJECT(b);
+            pEngine->FullyExecuteMethod(pCore, a, kMethodCompare);
+            return SPOP < 0;
+        }
+    };
 
 	FORTHOP(oArraySortMethod)
 	{
 		GET_THIS(oArrayStruct, pArray);
-		oArray::iterator iter;
 		oArray& a = *(pArray->elements);
 		if (a.size() > 1)
 		{
-			objectArrayQuicksortStep(pCore, &(a[0]), 0, a.size() - 1);
+            objectArrayCompareLess less;
+            less.pCore = pCore;
+            less.pEngine = ForthEngine::GetInstance();
+            ForthPdqSort(&(a[0]), &(a[0]) + a.size(), less);
 		}
 		METHOD_RETURN;
 	}
 
+    // sortByKey, sortByDoubleKey and sortByStringKey run the key op on each element once,
+    //   then sort the elements by key natively, instead of running a forth compare method
+    //   for every comparison like sort does, elements with equal keys keep their order
+    // each keyed element type has PopKey to take the key op result off the param stack,
+    //   and Sort to sort a vector of keyed elements
+    struct objectArrayIntKey
+    {
+        cell key;
+        ForthObject obj;
+
+        static inline void PopKey(ForthCoreState* pCore, objectArrayIntKey& keyed) { keyed.key = SPOP; }
+        static void Sort(std::vector<objectArrayIntKey>& keys);
+    };
+
+    struct objectArrayIntKeyTraits
+    {
+        typedef ucell KeyType;
+        static inline ucell ToKey(const objectArrayIntKey& val) { return ForthSignedRadixKey<cell, ucell>::ToKey(val.key); }
+    };
+
+    void objectArrayIntKey::Sort(std::vector<objectArrayIntKey>& keys)
+    {
+        ForthParallelSort<objectArrayIntKey, objectArrayIntKeyTraits>(keys.data(), keys.size());
+    }
+
+    struct objectArrayDoubleKey
+    {
+        double key;
+        ForthObject obj;
+
+        static inline void PopKey(ForthCoreState* pCore, objectArrayDoubleKey& keyed) { keyed.key = DPOP; }
+        static void Sort(std::vector<objectArrayDoubleKey>& keys);
+    };
+
+    struct objectArrayDoubleKeyTraits
+    {
+        typedef uint64_t KeyType;
+        static inline uint64_t ToKey(const objectArrayDoubleKey& val) { return ForthFloatRadixKey<double, uint64_t>::ToKey(val.key); }
+    };
+
+    void objectArrayDoubleKey::Sort(std::vector<objectArrayDoubleKey>& keys)
+    {
+        ForthParallelSort<objectArrayDoubleKey, objectArrayDoubleKeyTraits>(keys.data(), keys.size());
+    }
+
+    struct objectArrayStringKey
+    {
+        std::string key;
+        ForthObject obj;
+
+        static inline void PopKey(ForthCoreState* pCore, objectArrayStringKey& keyed)
+        {
+            // key op may return a temporary buffer, so copy it right away
+            const char* pKey = (const char*)(SPOP);
+            if (pKey != nullptr)
+            {
+                keyed.key = pKey;
+            }
+        }
+        static void Sort(std::vector<objectArrayStringKey>& keys);
+    };
+
+    struct objectArrayStringKeyLess
+    {
+        bool operator()(const objectArrayStringKey& a, const objectArrayStringKey& b) { return a.key < b.key; }
+    };
+
+    void objectArrayStringKey::Sort(std::vector<objectArrayStringKey>& keys)
+    {
+        objectArrayStringKeyLess less;
+        std::stable_sort(keys.begin(), keys.end(), less);
+    }
+
+    // push obj and run keyOp on it, leaving the key on the param stack
+    bool objectArrayGetKey(ForthCoreState* pCore, ForthObject& obj, forthop keyOp)
+    {
+        PUSH_OBJECT(obj);
+        return ForthEngine::GetInstance()->FullyExecuteOp(pCore, keyOp) == kResultOk;
+    }
+
+    // the key op can change the array, so each element is kept while the keys are built, and
+    //   the array is only reordered if it still holds the same elements after all key ops have run
+    template <class KEYED>
+    void objectArraySortByKey(ForthCoreState* pCore, oArray& a, forthop keyOp)
+    {
+        size_t numElements = a.size();
+        std::vector<KEYED> keys(numElements);
+        size_t numKept = 0;
+        bool unchanged = true;
+        while (numKept < numElements)
+        {
+            if (a.size() != numElements)
+            {
+                unchanged = false;
+                break;
+            }
+            KEYED& keyed = keys[numKept];
+            keyed.obj = a[numKept];
+            SAFE_KEEP(keyed.obj);
+            numKept++;
+            if (!objectArrayGetKey(pCore, keyed.obj, keyOp))
+            {
+                unchanged = false;
+                break;
+            }
+            KEYED::PopKey(pCore, keyed);
+        }
+
+        if (unchanged && (a.size() == numElements))
+        {
+            for (size_t i = 0; i < numElements; i++)
+            {
+                if (OBJECTS_DIFFERENT(a[i], keys[i].obj))
+                {
+                    unchanged = false;
+                    break;
+                }
+            }
+            if (unchanged)
+            {
+                KEYED::Sort(keys);
+                for (size_t i = 0; i < numElements; i++)
+                {
+                    a[i] = keys[i].obj;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < numKept; i++)
+        {
+            SAFE_RELEASE(pCore, keys[i].obj);
+        }
+    }
+
+    FORTHOP(oArraySortByKeyMethod)
+    {
+        GET_THIS(oArrayStruct, pArray);
+        forthop keyOp = (forthop)SPOP;
+        objectArraySortByKey<objectArrayIntKey>(pCore, *(pArray->elements), keyOp);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oArraySortByDoubleKeyMethod)
+    {
+        GET_THIS(oArrayStruct, pArray);
+        forthop keyOp = (forthop)SPOP;
+        objectArraySortByKey<objectArrayDoubleKey>(pCore, *(pArray->elements), keyOp);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oArraySortByStringKeyMethod)
+    {
+        GET_THIS(oArrayStruct, pArray);
+        forthop keyOp = (forthop)SPOP;
+        objectArraySortByKey<objectArrayStringKey>(pCore, *(pArray->elements), keyOp);
+        METHOD_RETURN;
+    }
+
     FORTHOP(oArrayToListMethod)
     {
         GET_THIS(oArrayStruct, pArray);
@@ -615,29 +771,12 @@ namespace OArray
         pList->refCount = 0;
         pList->head = NULL;
         pList->tail = NULL;
-        oListElement* oldTail = NULL;
+        pList->modCount = 0;
 
         // bump reference counts of all valid elements in this array
         for (iter = a.begin(); iter != a.end(); ++iter)
         {
-            ForthObject& o = *iter;
-            SAFE_KEEP(o);
-            MALLOCATE_LINK(oListElement, newElem);
-            newElem->obj = o;
-            if (oldTail == NULL)
-            {
-                ASSERT(pList->head == NULL);
-                pList->head = newElem;
-            }
-            else
-            {
-                ASSERT(oldTail->next == NULL);
-                oldTail->next = newElem;
-            }
-            newElem->prev = oldTail;
-            newElem->next = NULL;
-            pList->tail = newElem;
-            oldTail = newElem;
+            OList::listAddTail(pList, *iter, pCore);
         }
 
         // push list on TOS
@@ -692,6 +831,9 @@ namespace OArray
         METHOD_RET("findValue", oArrayFindValueMethod, RETURNS_NATIVE(kBaseTypeInt)),
         METHOD("reverse", oArrayReverseMethod),
         METHOD("sort", oArraySortMethod),
+        METHOD("sortByKey", oArraySortByKeyMethod),
+        METHOD("sortByDoubleKey", oArraySortByDoubleKeyMethod),
+        METHOD("sortByStringKey", oArraySortByStringKeyMethod),
         METHOD_RET("toList", oArrayToListMethod, RETURNS_OBJECT(kBCIList)),
         METHOD("unref", oArrayUnrefMethod),
        
@@ -869,7 +1011,7 @@ namespace OArray
 		pNewIter->refCount = 0;
         pNewIter->parent = pIter->parent;
 		oArrayStruct* pArray = reinterpret_cast<oArrayStruct *>(pIter->parent);
-		pArray->refCount++;
+		INCREMENT_REFCOUNT(pArray);
 		TRACK_KEEP;
 		pNewIter->cursor = pIter->cursor;
         PUSH_OBJECT(pNewIter);
@@ -1026,6 +1168,18 @@ namespace OArray
         return pIter;
     }
 
+    void bagChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oBag& a = *(reinterpret_cast<oBagStruct*>(obj)->elements);
+        for (ucell i = 0; i < a.size(); i++)
+        {
+            if (a[i].obj != nullptr)
+            {
+                visitor(a[i].obj, pUserData);
+            }
+        }
+    }
+
     bool customBagReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "elements")
@@ -1125,7 +1279,7 @@ namespace OArray
     FORTHOP(oBagHeadIterMethod)
     {
         GET_THIS(oBagStruct, pBag);
-        pBag->refCount++;
+        INCREMENT_REFCOUNT(pBag);
         TRACK_KEEP;
 
         oArrayIterStruct* pIter = createBagIterator(pCore, pBag);
@@ -1138,7 +1292,7 @@ namespace OArray
     FORTHOP(oBagTailIterMethod)
     {
         GET_THIS(oBagStruct, pBag);
-        pBag->refCount++;
+        INCREMENT_REFCOUNT(pBag);
         TRACK_KEEP;
 
         oArrayIterStruct* pIter = createBagIterator(pCore, pBag);
@@ -1161,7 +1315,7 @@ namespace OArray
             if (a[i].tag.s64 == soughtTag.s64)
             {
                 found = ~0;
-                pBag->refCount++;
+                INCREMENT_REFCOUNT(pBag);
                 TRACK_KEEP;
 
                 oArrayIterStruct* pIter = createBagIterator(pCore, pBag);
@@ -1854,7 +2008,7 @@ namespace OArray
         pNewIter->refCount = 0;
         pNewIter->parent = pIter->parent;
         oBagStruct* pBag = reinterpret_cast<oBagStruct *>(pIter->parent);
-        pBag->refCount++;
+        INCREMENT_REFCOUNT(pBag);
         TRACK_KEEP;
         pNewIter->cursor = pIter->cursor;
         PUSH_OBJECT(pNewIter);
@@ -1964,124 +2118,459 @@ namespace OArray
 
 
     //////////////////////////////////////////////////////////////////////
-	///
-	//                 ByteArray
-	//
+    ///
+    //                 numeric array math
+    //
+    // these are shared by ByteArray, ShortArray, IntArray, FloatArray, LongArray and
+    //   DoubleArray, they all have the same object layout, and use ForthVectorOps
+    //
 
-	typedef std::vector<char> oByteArray;
-	struct oByteArrayStruct
-	{
-        forthop*        pMethods;
-        ulong           refCount;
-		oByteArray*    elements;
-	};
+    // push and pop element values in the way the array type does
+    template <class T>
+    struct oNumericArrayValue
+    {
+        static inline T Pop(ForthCoreState* pCore) { return (T) SPOP; }
+        static inline void Push(ForthCoreState* pCore, T val) { SPUSH((cell) val); }
+    };
 
-	struct oByteArrayIterStruct
-	{
-        forthop*        pMethods;
-		ulong			refCount;
-		ForthObject		parent;
-		ulong			cursor;
-	};
+    template <>
+    struct oNumericArrayValue<int64_t>
+    {
+        static inline int64_t Pop(ForthCoreState* pCore) { stackInt64 val; LPOP(val); return val.s64; }
+        static inline void Push(ForthCoreState* pCore, int64_t val) { stackInt64 sval; sval.s64 = val; LPUSH(sval); }
+    };
 
-    oByteArrayIterStruct* createByteArrayIterator(ForthCoreState* pCore, oByteArrayStruct* pArray)
+    template <>
+    struct oNumericArrayValue<float>
     {
-        ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIByteArrayIter);
-        MALLOCATE_ITER(oByteArrayIterStruct, pIter, pIterVocab);
-        pIter->pMethods = pIterVocab->GetMethods();
-        pIter->refCount = 0;
-        pIter->parent = reinterpret_cast<ForthObject>(pArray);
-        return pIter;
+        static inline float Pop(ForthCoreState* pCore) { return FPOP; }
+        static inline void Push(ForthCoreState* pCore, float val) { FPUSH(val); }
+    };
+
+    template <>
+    struct oNumericArrayValue<double>
+    {
+        static inline double Pop(ForthCoreState* pCore) { double val = DPOP; return val; }
+        static inline void Push(ForthCoreState* pCore, double val) { DPUSH(val); }
+    };
+
+    // binary object format body is element count followed by the elements as one payload
+    template <class T>
+    void numericArrayBinaryWriter(ForthObject& obj, ForthBinaryWriter* writer)
+    {
+        std::vector<T, ForthHugePageAllocator<T>>& a = *(reinterpret_cast<oNumericArrayStruct<T>*>(obj)->elements);
+        writer->WriteU64(a.size());
+        writer->WritePayload(a.data(), a.size() * sizeof(T));
     }
 
-    bool customByteArrayReader(const std::string& elementName, ForthObjectReader* reader)
+    template <class T>
+    void numericArrayBinaryReader(ForthObject& obj, ForthBinaryReader* reader)
     {
-        if (elementName == "elements")
+        std::vector<T, ForthHugePageAllocator<T>>& a = *(reinterpret_cast<oNumericArrayStruct<T>*>(obj)->elements);
+        uint64_t numElements = reader->ReadU64();
+        reader->CheckCount(numElements, sizeof(T));
+        a.resize(numElements);
+        reader->ReadPayload(a.data(), numElements * sizeof(T));
+    }
+
+    // pop array argument of a binary op, it must be the same class and size as this array
+    template <class T>
+    oNumericArrayStruct<T>* popOtherNumericArray(ForthCoreState* pCore, oNumericArrayStruct<T>* pArray)
+    {
+        ForthObject otherObj;
+        POP_OBJECT(otherObj);
+        if ((otherObj == nullptr) || (otherObj->pMethods != pArray->pMethods))
         {
-            ForthCoreState* pCore = reader->GetCoreState();
-            oByteArrayStruct *dstArray = (oByteArrayStruct *)(reader->getCustomReaderContext().pData);
-            reader->getRequiredChar('[');
-            std::string number;
-            while (true)
-            {
-                char ch = reader->getChar();
-                if (ch == ']')
-                {
-                    break;
-                }
-                if (ch != ',')
-                {
-                    reader->ungetChar(ch);
-                }
-                reader->getNumber(number);
-                int value;
-                if (sscanf(number.c_str(), "%d", &value) == 1)
-                {
-                    dstArray->elements->push_back((char)value);
-                }
-                else
-                {
-                    reader->throwError("error parsing byte value");
-                }
-            }
-            return true;
+            GET_ENGINE->SetError(kForthErrorBadParameter, " array argument must be same type as array");
+            return nullptr;
         }
-        return false;
+        oNumericArrayStruct<T>* pOther = reinterpret_cast<oNumericArrayStruct<T> *>(otherObj);
+        if (pOther->elements->size() != pArray->elements->size())
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " array argument must be same size as array");
+            return nullptr;
+        }
+        return pOther;
     }
 
-    FORTHOP(oByteArrayNew)
-	{
-		ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
-		MALLOCATE_OBJECT(oByteArrayStruct, pArray, pClassVocab);
-        pArray->pMethods = pClassVocab->GetMethods();
-		pArray->refCount = 0;
-		pArray->elements = new oByteArray;
-		PUSH_OBJECT(pArray);
-	}
-
-	FORTHOP(oByteArrayDeleteMethod)
-	{
-		GET_THIS(oByteArrayStruct, pArray);
-		delete pArray->elements;
-		FREE_OBJECT(pArray);
-		METHOD_RETURN;
-	}
+    template <class T>
+    FORTHOP(oNumericArraySumMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        typename ForthVectorOps<T>::AccType sum = ForthVectorOps<T>::Sum(pArray->elements->data(), pArray->elements->size());
+        oNumericArrayValue<typename ForthVectorOps<T>::AccType>::Push(pCore, sum);
+        METHOD_RETURN;
+    }
 
-	FORTHOP(oByteArrayShowInnerMethod)
-	{
-		char buffer[8];
-		GET_THIS(oByteArrayStruct, pArray);
-        GET_SHOW_CONTEXT;
-        oByteArray& a = *(pArray->elements);
-        pShowContext->BeginElement("elements");
-        pShowContext->BeginArray();
-		for (unsigned int i = 0; i < a.size(); i++)
-		{
-            pShowContext->BeginArrayElement();
-			sprintf(buffer, "%u", a[i] & 0xFF);
-            pShowContext->ShowText(buffer);
+    template <class T>
+    FORTHOP(oNumericArrayMinMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        if (pArray->elements->size() > 0)
+        {
+            oNumericArrayValue<T>::Push(pCore, ForthVectorOps<T>::Min(pArray->elements->data(), pArray->elements->size()));
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " min of empty array");
         }
-        pShowContext->EndArray();
         METHOD_RETURN;
     }
 
-    FORTHOP(oByteArrayHeadIterMethod)
+    template <class T>
+    FORTHOP(oNumericArrayMaxMethod)
     {
-        GET_THIS(oByteArrayStruct, pArray);
-        pArray->refCount++;
-        TRACK_KEEP;
-
-        oByteArrayIterStruct* pIter = createByteArrayIterator(pCore, pArray);
-        pIter->cursor = 0;
-
-        PUSH_OBJECT(pIter);
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        if (pArray->elements->size() > 0)
+        {
+            oNumericArrayValue<T>::Push(pCore, ForthVectorOps<T>::Max(pArray->elements->data(), pArray->elements->size()));
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " max of empty array");
+        }
         METHOD_RETURN;
     }
 
-    FORTHOP(oByteArrayTailIterMethod)
+    // argMin and argMax return -1 for an empty array
+    template <class T>
+    FORTHOP(oNumericArrayArgMinMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        size_t numElements = pArray->elements->size();
+        cell index = (numElements > 0) ? (cell) ForthVectorOps<T>::ArgMin(pArray->elements->data(), numElements) : -1;
+        SPUSH(index);
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayArgMaxMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        size_t numElements = pArray->elements->size();
+        cell index = (numElements > 0) ? (cell) ForthVectorOps<T>::ArgMax(pArray->elements->data(), numElements) : -1;
+        SPUSH(index);
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayDotMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        oNumericArrayStruct<T>* pOther = popOtherNumericArray<T>(pCore, pArray);
+        if (pOther != nullptr)
+        {
+            typename ForthVectorOps<T>::AccType dot = ForthVectorOps<T>::Dot(pArray->elements->data(),
+                pOther->elements->data(), pArray->elements->size());
+            oNumericArrayValue<typename ForthVectorOps<T>::AccType>::Push(pCore, dot);
+        }
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayAddMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        oNumericArrayStruct<T>* pOther = popOtherNumericArray<T>(pCore, pArray);
+        if (pOther != nullptr)
+        {
+            ForthVectorOps<T>::Add(pArray->elements->data(), pOther->elements->data(), pArray->elements->size());
+        }
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArraySubMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        oNumericArrayStruct<T>* pOther = popOtherNumericArray<T>(pCore, pArray);
+        if (pOther != nullptr)
+        {
+            ForthVectorOps<T>::Sub(pArray->elements->data(), pOther->elements->data(), pArray->elements->size());
+        }
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayMulMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        oNumericArrayStruct<T>* pOther = popOtherNumericArray<T>(pCore, pArray);
+        if (pOther != nullptr)
+        {
+            ForthVectorOps<T>::Mul(pArray->elements->data(), pOther->elements->data(), pArray->elements->size());
+        }
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayScaleMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        T factor = oNumericArrayValue<T>::Pop(pCore);
+        ForthVectorOps<T>::Scale(pArray->elements->data(), factor, pArray->elements->size());
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayOffsetMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        T offset = oNumericArrayValue<T>::Pop(pCore);
+        ForthVectorOps<T>::Offset(pArray->elements->data(), offset, pArray->elements->size());
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayPrefixSumMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        ForthVectorOps<T>::PrefixSum(pArray->elements->data(), pArray->elements->size());
+        METHOD_RETURN;
+    }
+
+    // histogram ( IntArray counts, lo, hi -- )
+    // counts elements in [lo, hi) into bins, the number of bins is the size of counts
+    template <class T>
+    FORTHOP(oNumericArrayHistogramMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        T hi = oNumericArrayValue<T>::Pop(pCore);
+        T lo = oNumericArrayValue<T>::Pop(pCore);
+        ForthObject countsObj;
+        POP_OBJECT(countsObj);
+        ForthClassObject* pCountsClass = (countsObj != nullptr) ? GET_CLASS_OBJECT(countsObj) : nullptr;
+        if ((pCountsClass == nullptr) || (pCountsClass->pVocab != GET_CLASS_VOCABULARY(kBCIIntArray)))
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " histogram counts must be an IntArray");
+        }
+        else
+        {
+            oNumericArrayStruct<int>* pCounts = reinterpret_cast<oNumericArrayStruct<int> *>(countsObj);
+            ForthVectorOps<T>::Histogram(pArray->elements->data(), pArray->elements->size(), lo, hi,
+                pCounts->elements->data(), pCounts->elements->size());
+        }
+        METHOD_RETURN;
+    }
+
+    //
+    // mapped file storage
+    //
+
+    // deletes the elements of a numeric array, and closes the file they are mapped from if any
+    template <class T>
+    void deleteNumericArrayElements(std::vector<T, ForthHugePageAllocator<T>>* pElements)
+    {
+        ForthMappedArrayStorage* pStorage = pElements->get_allocator().GetMappedStorage();
+        size_t numUsedBytes = pElements->size() * sizeof(T);
+        delete pElements;
+        if (pStorage != nullptr)
+        {
+            pStorage->Close(numUsedBytes);
+            delete pStorage;
+        }
+    }
+
+    // open ( PATH_STRING WRITABLE -- )
+    // replaces the elements with the contents of a binary file, which the elements are then mapped
+    //   from instead of living on the heap.  A writable file is created if it doesn't exist, and
+    //   element changes and resizes change the file.  A read-only file is never changed.
+    template <class T>
+    FORTHOP(oNumericArrayOpenMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        bool writable = (SPOP != 0);
+        const char* pPath = (const char*)(SPOP);
+        if (pArray->elements->get_allocator().GetMappedStorage() != nullptr)
+        {
+            // the old file is closed and cut to its used size first, it may be the file being opened
+            deleteNumericArrayElements<T>(pArray->elements);
+            pArray->elements = new std::vector<T, ForthHugePageAllocator<T>>();
+        }
+        ForthMappedArrayStorage* pStorage = new ForthMappedArrayStorage;
+        if (pStorage->Open(pPath, writable))
+        {
+            deleteNumericArrayElements<T>(pArray->elements);
+            pArray->elements = new std::vector<T, ForthHugePageAllocator<T>>(ForthHugePageAllocator<T>(pStorage));
+            pArray->elements->resize(pStorage->FileSize() / sizeof(T));
+        }
+        else
+        {
+            delete pStorage;
+            GET_ENGINE->SetError(kForthErrorIO, " failed to open array file");
+        }
+        METHOD_RETURN;
+    }
+
+    // sync ( -- )
+    // writes changes to the elements of an array opened writable back to its file
+    template <class T>
+    FORTHOP(oNumericArraySyncMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        std::vector<T, ForthHugePageAllocator<T>>& a = *(pArray->elements);
+        ForthMappedArrayStorage* pStorage = a.get_allocator().GetMappedStorage();
+        if (pStorage != nullptr)
+        {
+            // the file is cut to the elements in use, so spare capacity must go first
+            a.shrink_to_fit();
+            if (!pStorage->Sync(a.size() * sizeof(T)))
+            {
+                GET_ENGINE->SetError(kForthErrorIO, " failed to sync array file");
+            }
+        }
+        METHOD_RETURN;
+    }
+
+    template <class T>
+    FORTHOP(oNumericArrayIsMappedMethod)
+    {
+        GET_THIS(oNumericArrayStruct<T>, pArray);
+        long retVal = (pArray->elements->get_allocator().GetMappedStorage() != nullptr) ? ~0 : 0;
+        SPUSH(retVal);
+        METHOD_RETURN;
+    }
+
+#define NUMERIC_ARRAY_FILE_METHODS(_T) \
+        METHOD("open", oNumericArrayOpenMethod<_T>), \
+        METHOD("sync", oNumericArraySyncMethod<_T>), \
+        METHOD_RET("isMapped", oNumericArrayIsMappedMethod<_T>, RETURNS_NATIVE(kBaseTypeInt))
+
+#define NUMERIC_ARRAY_MATH_METHODS(_T, _VALUE_TYPE, _SUM_TYPE) \
+        METHOD_RET("sum", oNumericArraySumMethod<_T>, RETURNS_NATIVE(_SUM_TYPE)), \
+        METHOD_RET("min", oNumericArrayMinMethod<_T>, RETURNS_NATIVE(_VALUE_TYPE)), \
+        METHOD_RET("max", oNumericArrayMaxMethod<_T>, RETURNS_NATIVE(_VALUE_TYPE)), \
+        METHOD_RET("argMin", oNumericArrayArgMinMethod<_T>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD_RET("argMax", oNumericArrayArgMaxMethod<_T>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD_RET("dot", oNumericArrayDotMethod<_T>, RETURNS_NATIVE(_SUM_TYPE)), \
+        METHOD("add", oNumericArrayAddMethod<_T>), \
+        METHOD("sub", oNumericArraySubMethod<_T>), \
+        METHOD("mul", oNumericArrayMulMethod<_T>), \
+        METHOD("scale", oNumericArrayScaleMethod<_T>), \
+        METHOD("offset", oNumericArrayOffsetMethod<_T>), \
+        METHOD("prefixSum", oNumericArrayPrefixSumMethod<_T>), \
+        METHOD("histogram", oNumericArrayHistogramMethod<_T>)
+
+
+    //////////////////////////////////////////////////////////////////////
+	///
+	//                 ByteArray
+	//
+
+	typedef std::vector<char, ForthHugePageAllocator<char>> oByteArray;
+	struct oByteArrayStruct
+	{
+        forthop*        pMethods;
+        ulong           refCount;
+		oByteArray*    elements;
+	};
+
+	struct oByteArrayIterStruct
+	{
+        forthop*        pMethods;
+		ulong			refCount;
+		ForthObject		parent;
+		ulong			cursor;
+	};
+
+    oByteArrayIterStruct* createByteArrayIterator(ForthCoreState* pCore, oByteArrayStruct* pArray)
+    {
+        ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIByteArrayIter);
+        MALLOCATE_ITER(oByteArrayIterStruct, pIter, pIterVocab);
+        pIter->pMethods = pIterVocab->GetMethods();
+        pIter->refCount = 0;
+        pIter->parent = reinterpret_cast<ForthObject>(pArray);
+        return pIter;
+    }
+
+    bool customByteArrayReader(const std::string& elementName, ForthObjectReader* reader)
+    {
+        if (elementName == "elements")
+        {
+            ForthCoreState* pCore = reader->GetCoreState();
+            oByteArrayStruct *dstArray = (oByteArrayStruct *)(reader->getCustomReaderContext().pData);
+            reader->getRequiredChar('[');
+            std::string number;
+            while (true)
+            {
+                char ch = reader->getChar();
+                if (ch == ']')
+                {
+                    break;
+                }
+                if (ch != ',')
+                {
+                    reader->ungetChar(ch);
+                }
+                reader->getNumber(number);
+                int value;
+                if (sscanf(number.c_str(), "%d", &value) == 1)
+                {
+                    dstArray->elements->push_back((char)value);
+                }
+                else
+                {
+                    reader->throwError("error parsing byte value");
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+
+    FORTHOP(oByteArrayNew)
+	{
+		ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+		MALLOCATE_OBJECT(oByteArrayStruct, pArray, pClassVocab);
+        pArray->pMethods = pClassVocab->GetMethods();
+		pArray->refCount = 0;
+		pArray->elements = new oByteArray;
+		PUSH_OBJECT(pArray);
+	}
+
+	FORTHOP(oByteArrayDeleteMethod)
+	{
+		GET_THIS(oByteArrayStruct, pArray);
+		delete pArray->elements;
+		FREE_OBJECT(pArray);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oByteArrayShowInnerMethod)
+	{
+		char buffer[8];
+		GET_THIS(oByteArrayStruct, pArray);
+        GET_SHOW_CONTEXT;
+        oByteArray& a = *(pArray->elements);
+        pShowContext->BeginElement("elements");
+        pShowContext->BeginArray();
+		for (unsigned int i = 0; i < a.size(); i++)
+		{
+            pShowContext->BeginArrayElement();
+			sprintf(buffer, "%u", a[i] & 0xFF);
+            pShowContext->ShowText(buffer);
+        }
+        pShowContext->EndArray();
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oByteArrayHeadIterMethod)
+    {
+        GET_THIS(oByteArrayStruct, pArray);
+        INCREMENT_REFCOUNT(pArray);
+        TRACK_KEEP;
+
+        oByteArrayIterStruct* pIter = createByteArrayIterator(pCore, pArray);
+        pIter->cursor = 0;
+
+        PUSH_OBJECT(pIter);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oByteArrayTailIterMethod)
     {
         GET_THIS(oByteArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         oByteArrayIterStruct* pIter = createByteArrayIterator(pCore, pArray);
         pIter->cursor = pArray->elements->size();
@@ -2101,7 +2590,7 @@ namespace OArray
         {
             if (soughtByte == a[i])
             {
-                pArray->refCount++;
+                INCREMENT_REFCOUNT(pArray);
                 TRACK_KEEP;
                 oByteArrayIterStruct* pIter = createByteArrayIterator(pCore, pArray);
                 pIter->cursor = i;
@@ -2398,6 +2887,23 @@ namespace OArray
         METHOD_RETURN;
     }
 
+    FORTHOP(oByteArrayParallelSortMethod)
+    {
+        // psort and upsort are radix sorts, which run in parallel on the worker pool for big arrays
+        GET_THIS(oByteArrayStruct, pArray);
+        oByteArray& a = *(pArray->elements);
+        ForthParallelSort<signed char, ForthSignedRadixKey<signed char, unsigned char>>((signed char *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oByteArrayUnsignedParallelSortMethod)
+    {
+        GET_THIS(oByteArrayStruct, pArray);
+        oByteArray& a = *(pArray->elements);
+        ForthParallelSort<unsigned char, ForthUnsignedRadixKey<unsigned char, unsigned char>>((unsigned char *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
 	FORTHOP(oByteArrayFromStringMethod)
 	{
 		GET_THIS(oByteArrayStruct, pArray);
@@ -2440,6 +2946,9 @@ namespace OArray
         METHOD("reverse", oByteArrayReverseMethod),
         METHOD("sort", oByteArraySortMethod),
         METHOD("usort", oByteArrayUnsignedSortMethod),
+        METHOD("psort", oByteArrayParallelSortMethod),
+        METHOD("upsort", oByteArrayUnsignedParallelSortMethod),
+        NUMERIC_ARRAY_MATH_METHODS(char, kBaseTypeByte, kBaseTypeLong),
 		METHOD("setFromString", oByteArrayFromStringMethod),
 
 		MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
@@ -2593,7 +3102,7 @@ namespace OArray
     {
         GET_THIS(oByteArrayIterStruct, pIter);
         oByteArrayStruct* pArray = reinterpret_cast<oByteArrayStruct *>(pIter->parent);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIByteArrayIter);
         MALLOCATE_ITER(oByteArrayIterStruct, pNewIter, pIterVocab);
@@ -2686,7 +3195,7 @@ namespace OArray
 	//                 ShortArray
 	//
 
-	typedef std::vector<short> oShortArray;
+	typedef std::vector<short, ForthHugePageAllocator<short>> oShortArray;
 	struct oShortArrayStruct
 	{
         forthop*        pMethods;
@@ -2786,7 +3295,7 @@ namespace OArray
     FORTHOP(oShortArrayHeadIterMethod)
     {
         GET_THIS(oShortArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         oShortArrayIterStruct* pIter = createShortArrayIterator(pCore, pArray);
         pIter->cursor = 0;
@@ -2798,7 +3307,7 @@ namespace OArray
     FORTHOP(oShortArrayTailIterMethod)
     {
         GET_THIS(oShortArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oShortArrayIterStruct* pIter = createShortArrayIterator(pCore, pArray);
@@ -3120,6 +3629,22 @@ namespace OArray
         METHOD_RETURN;
     }
 
+    FORTHOP(oShortArrayParallelSortMethod)
+    {
+        GET_THIS(oShortArrayStruct, pArray);
+        oShortArray& a = *(pArray->elements);
+        ForthParallelSort<short, ForthSignedRadixKey<short, unsigned short>>((short *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oShortArrayUnsignedParallelSortMethod)
+    {
+        GET_THIS(oShortArrayStruct, pArray);
+        oShortArray& a = *(pArray->elements);
+        ForthParallelSort<unsigned short, ForthUnsignedRadixKey<unsigned short, unsigned short>>((unsigned short *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
 
     baseMethodEntry oShortArrayMembers[] =
 	{
@@ -3151,6 +3676,9 @@ namespace OArray
         METHOD("reverse", oShortArrayReverseMethod),
         METHOD("sort", oShortArraySortMethod),
         METHOD("usort", oShortArrayUnsignedSortMethod),
+        METHOD("psort", oShortArrayParallelSortMethod),
+        METHOD("upsort", oShortArrayUnsignedParallelSortMethod),
+        NUMERIC_ARRAY_MATH_METHODS(short, kBaseTypeShort, kBaseTypeLong),
 
         MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
@@ -3304,7 +3832,7 @@ namespace OArray
     {
         GET_THIS(oShortArrayIterStruct, pIter);
         oShortArrayStruct* pArray = reinterpret_cast<oShortArrayStruct *>(pIter->parent);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIShortArrayIter);
         MALLOCATE_ITER(oShortArrayIterStruct, pNewIter, pIterVocab);
@@ -3394,7 +3922,7 @@ namespace OArray
 	//                 IntArray
 	//
 
-	typedef std::vector<int> oIntArray;
+	typedef std::vector<int, ForthHugePageAllocator<int>> oIntArray;
 	struct oIntArrayStruct
 	{
         forthop*        pMethods;
@@ -3468,7 +3996,7 @@ namespace OArray
 	FORTHOP(oIntArrayDeleteMethod)
 	{
 		GET_THIS(oIntArrayStruct, pArray);
-		delete pArray->elements;
+		deleteNumericArrayElements<int>(pArray->elements);
 		FREE_OBJECT(pArray);
 		METHOD_RETURN;
 	}
@@ -3494,7 +4022,7 @@ namespace OArray
     FORTHOP(oIntArrayHeadIterMethod)
     {
         GET_THIS(oIntArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oIntArrayIterStruct* pIter = createIntArrayIterator(pCore, pArray);
@@ -3507,7 +4035,7 @@ namespace OArray
     FORTHOP(oIntArrayTailIterMethod)
     {
         GET_THIS(oIntArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         oIntArrayIterStruct* pIter = createIntArrayIterator(pCore, pArray);
         pIter->cursor = pArray->elements->size();
@@ -3811,6 +4339,22 @@ namespace OArray
         METHOD_RETURN;
     }
 
+    FORTHOP(oIntArrayParallelSortMethod)
+    {
+        GET_THIS(oIntArrayStruct, pArray);
+        oIntArray& a = *(pArray->elements);
+        ForthParallelSort<int, ForthSignedRadixKey<int, unsigned int>>((int *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oIntArrayUnsignedParallelSortMethod)
+    {
+        GET_THIS(oIntArrayStruct, pArray);
+        oIntArray& a = *(pArray->elements);
+        ForthParallelSort<unsigned int, ForthUnsignedRadixKey<unsigned int, unsigned int>>((unsigned int *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
 	FORTHOP(oIntArrayFromMemoryMethod)
 	{
 		GET_THIS(oIntArrayStruct, pArray);
@@ -3859,6 +4403,10 @@ namespace OArray
         METHOD("reverse", oIntArrayReverseMethod),
         METHOD("sort", oIntArraySortMethod),
         METHOD("usort", oIntArrayUnsignedSortMethod),
+        METHOD("psort", oIntArrayParallelSortMethod),
+        METHOD("upsort", oIntArrayUnsignedParallelSortMethod),
+        NUMERIC_ARRAY_MATH_METHODS(int, kBaseTypeInt, kBaseTypeLong),
+        NUMERIC_ARRAY_FILE_METHODS(int),
 
         MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
@@ -4008,7 +4556,7 @@ namespace OArray
     {
         GET_THIS(oIntArrayIterStruct, pIter);
         oIntArrayStruct* pArray = reinterpret_cast<oIntArrayStruct *>(pIter->parent);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIIntArrayIter);
         MALLOCATE_ITER(oIntArrayIterStruct, pNewIter, pIterVocab);
@@ -4157,14 +4705,22 @@ namespace OArray
     FORTHOP(oFloatArraySortMethod)
     {
         GET_THIS(oIntArrayStruct, pArray);
-        std::vector<float> & a = *(((std::vector<float> *)(pArray->elements)));
+        std::vector<float, ForthHugePageAllocator<float>> & a = *(((std::vector<float, ForthHugePageAllocator<float>> *)(pArray->elements)));
         std::sort(a.begin(), a.end());
         METHOD_RETURN;
     }
 
+    FORTHOP(oFloatArrayParallelSortMethod)
+    {
+        GET_THIS(oIntArrayStruct, pArray);
+        oIntArray& a = *(pArray->elements);
+        ForthParallelSort<float, ForthFloatRadixKey<float, uint32_t>>((float *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
     baseMethodEntry oFloatArrayMembers[] =
 	{
-        // note that all these methods except showInner and sort are cloned from IntArray
+        // note that all these methods except showInner, sort, psort and the math methods are cloned from IntArray
         METHOD("__newOp", oIntArrayNew),
         METHOD("delete", oIntArrayDeleteMethod),
         METHOD("showInner", oFloatArrayShowInnerMethod),
@@ -4192,6 +4748,9 @@ namespace OArray
         METHOD_RET("findValue", oIntArrayFindValueMethod, RETURNS_NATIVE(kBaseTypeInt)),
         METHOD("reverse", oIntArrayReverseMethod),
         METHOD("sort", oFloatArraySortMethod),
+        METHOD("psort", oFloatArrayParallelSortMethod),
+        NUMERIC_ARRAY_MATH_METHODS(float, kBaseTypeFloat, kBaseTypeDouble),
+        NUMERIC_ARRAY_FILE_METHODS(int),
 
         MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
@@ -4205,7 +4764,7 @@ namespace OArray
 	//                 LongArray
 	//
 
-	typedef std::vector<int64_t> oLongArray;
+	typedef std::vector<int64_t, ForthHugePageAllocator<int64_t>> oLongArray;
 	struct oLongArrayStruct
 	{
         forthop*        pMethods;
@@ -4279,7 +4838,7 @@ namespace OArray
 	FORTHOP(oLongArrayDeleteMethod)
 	{
 		GET_THIS(oLongArrayStruct, pArray);
-		delete pArray->elements;
+		deleteNumericArrayElements<int64_t>(pArray->elements);
 		FREE_OBJECT(pArray);
 		METHOD_RETURN;
 	}
@@ -4305,7 +4864,7 @@ namespace OArray
     FORTHOP(oLongArrayHeadIterMethod)
     {
         GET_THIS(oLongArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oLongArrayIterStruct* pIter = createLongArrayIterator(pCore, pArray);
@@ -4318,7 +4877,7 @@ namespace OArray
     FORTHOP(oLongArrayTailIterMethod)
     {
         GET_THIS(oLongArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oLongArrayIterStruct* pIter = createLongArrayIterator(pCore, pArray);
@@ -4656,11 +5215,27 @@ namespace OArray
         METHOD_RETURN;
     }
 
-	baseMethodEntry oLongArrayMembers[] =
-	{
-		METHOD("__newOp", oLongArrayNew),
-		METHOD("delete", oLongArrayDeleteMethod),
-		METHOD("showInner", oLongArrayShowInnerMethod),
+    FORTHOP(oLongArrayParallelSortMethod)
+    {
+        GET_THIS(oLongArrayStruct, pArray);
+        oLongArray& a = *(pArray->elements);
+        ForthParallelSort<int64_t, ForthSignedRadixKey<int64_t, uint64_t>>((int64_t *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oLongArrayUnsignedParallelSortMethod)
+    {
+        GET_THIS(oLongArrayStruct, pArray);
+        oLongArray& a = *(pArray->elements);
+        ForthParallelSort<uint64_t, ForthUnsignedRadixKey<uint64_t, uint64_t>>((uint64_t *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
+	baseMethodEntry oLongArrayMembers[] =
+	{
+		METHOD("__newOp", oLongArrayNew),
+		METHOD("delete", oLongArrayDeleteMethod),
+		METHOD("showInner", oLongArrayShowInnerMethod),
 
         METHOD_RET("headIter", oLongArrayHeadIterMethod, RETURNS_OBJECT(kBCILongArrayIter)),
         METHOD_RET("tailIter", oLongArrayTailIterMethod, RETURNS_OBJECT(kBCILongArrayIter)),
@@ -4686,6 +5261,10 @@ namespace OArray
         METHOD("reverse", oLongArrayReverseMethod),
         METHOD("sort", oLongArraySortMethod),
         METHOD("usort", oLongArrayUnsignedSortMethod),
+        METHOD("psort", oLongArrayParallelSortMethod),
+        METHOD("upsort", oLongArrayUnsignedParallelSortMethod),
+        NUMERIC_ARRAY_MATH_METHODS(int64_t, kBaseTypeLong, kBaseTypeLong),
+        NUMERIC_ARRAY_FILE_METHODS(int64_t),
 
 		MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
@@ -4841,7 +5420,7 @@ namespace OArray
     {
         GET_THIS(oLongArrayIterStruct, pIter);
         oLongArrayStruct* pArray = reinterpret_cast<oLongArrayStruct *>(pIter->parent);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCILongArrayIter);
         MALLOCATE_ITER(oLongArrayIterStruct, pNewIter, pIterVocab);
@@ -4935,7 +5514,7 @@ namespace OArray
 	//                 DoubleArray
 	//
 
-	typedef std::vector<double> oDoubleArray;
+	typedef std::vector<double, ForthHugePageAllocator<double>> oDoubleArray;
 	struct oDoubleArrayStruct
 	{
         forthop*        pMethods;
@@ -5009,7 +5588,7 @@ namespace OArray
 	FORTHOP(oDoubleArrayDeleteMethod)
 	{
 		GET_THIS(oDoubleArrayStruct, pArray);
-		delete pArray->elements;
+		deleteNumericArrayElements<double>(pArray->elements);
 		FREE_OBJECT(pArray);
 		METHOD_RETURN;
 	}
@@ -5035,7 +5614,7 @@ namespace OArray
     FORTHOP(oDoubleArrayHeadIterMethod)
     {
         GET_THIS(oDoubleArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oDoubleArrayIterStruct* pIter = createDoubleArrayIterator(pCore, pArray);
@@ -5048,7 +5627,7 @@ namespace OArray
     FORTHOP(oDoubleArrayTailIterMethod)
     {
         GET_THIS(oDoubleArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         oDoubleArrayIterStruct* pIter = createDoubleArrayIterator(pCore, pArray);
         pIter->cursor = 0;
@@ -5228,6 +5807,14 @@ namespace OArray
         METHOD_RETURN;
     }
 
+    FORTHOP(oDoubleArrayParallelSortMethod)
+    {
+        GET_THIS(oDoubleArrayStruct, pArray);
+        oDoubleArray& a = *(pArray->elements);
+        ForthParallelSort<double, ForthFloatRadixKey<double, uint64_t>>((double *)(a.data()), a.size());
+        METHOD_RETURN;
+    }
+
     baseMethodEntry oDoubleArrayMembers[] =
 	{
         // note that many of these methods are cloned from LongArray
@@ -5258,6 +5845,9 @@ namespace OArray
         METHOD_RET("findValue", oDoubleArrayFindValueMethod, RETURNS_NATIVE(kBaseTypeInt)),
         METHOD("reverse", oLongArrayReverseMethod),
         METHOD("sort", oDoubleArraySortMethod),
+        METHOD("psort", oDoubleArrayParallelSortMethod),
+        NUMERIC_ARRAY_MATH_METHODS(double, kBaseTypeDouble, kBaseTypeDouble),
+        NUMERIC_ARRAY_FILE_METHODS(double),
 
         MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
@@ -5300,6 +5890,81 @@ namespace OArray
         return pIter;
     }
 
+    void structArrayChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oStructArrayStruct* pArray = reinterpret_cast<oStructArrayStruct*>(obj);
+        if (pArray->pVocab != nullptr)
+        {
+            for (ulong i = 0; i < pArray->numElements; i++)
+            {
+                char* pElement = &((*(pArray->elements))[i * pArray->elementSize]);
+                for (ForthStructVocabulary* pStruct = pArray->pVocab; pStruct != nullptr; pStruct = pStruct->BaseVocabulary())
+                {
+                    pStruct->VisitObjectFields(pElement, visitor, pUserData);
+                }
+            }
+        }
+    }
+
+    // binary object format body is struct type, element size and count, the elements as one
+    //   payload, then the object refs in the elements
+    void structArrayBinaryWriter(ForthObject& obj, ForthBinaryWriter* writer)
+    {
+        oStructArrayStruct* pArray = reinterpret_cast<oStructArrayStruct*>(obj);
+        const char* pStructName = (pArray->pVocab != nullptr) ? pArray->pVocab->GetName() : "";
+        writer->WriteString(pStructName, strlen(pStructName));
+        writer->WriteU64(pArray->elementSize);
+        writer->WriteU64(pArray->numElements);
+        oStructArray& a = *(pArray->elements);
+        writer->WriteU64(a.size());
+        writer->WritePayload(a.data(), a.size());
+        if (pArray->pVocab != nullptr)
+        {
+            for (ulong i = 0; i < pArray->numElements; i++)
+            {
+                writer->WriteStructObjectRefs(pArray->pVocab, &(a[i * pArray->elementSize]));
+            }
+        }
+    }
+
+    void structArrayBinaryReader(ForthObject& obj, ForthBinaryReader* reader)
+    {
+        oStructArrayStruct* pArray = reinterpret_cast<oStructArrayStruct*>(obj);
+        std::string structType;
+        reader->ReadString(structType);
+        pArray->pVocab = nullptr;
+        if (!structType.empty())
+        {
+            pArray->pVocab = ForthTypesManager::GetInstance()->GetStructVocabulary(structType.c_str());
+            if (pArray->pVocab == nullptr)
+            {
+                reader->throwError("unknown struct type for StructArray");
+            }
+        }
+        pArray->elementSize = (ulong) reader->ReadU64();
+        pArray->numElements = (ulong) reader->ReadU64();
+        uint64_t numBytes = reader->ReadU64();
+        if ((pArray->pVocab != nullptr) && (pArray->elementSize != (ulong) pArray->pVocab->GetSize()))
+        {
+            reader->throwError("StructArray element size doesn't match struct type");
+        }
+        if (((uint64_t) pArray->elementSize * pArray->numElements) > numBytes)
+        {
+            reader->throwError("StructArray elements are truncated");
+        }
+        reader->CheckCount(numBytes, 1);
+        oStructArray& a = *(pArray->elements);
+        a.resize(numBytes);
+        reader->ReadPayload(a.data(), numBytes);
+        if (pArray->pVocab != nullptr)
+        {
+            for (ulong i = 0; i < pArray->numElements; i++)
+            {
+                reader->ReadStructObjectRefs(pArray->pVocab, &(a[i * pArray->elementSize]));
+            }
+        }
+    }
+
     bool customStructArrayReader(const std::string& elementName, ForthObjectReader* reader)
     {
         oStructArrayStruct *dstArray = (oStructArrayStruct *)(reader->getCustomReaderContext().pData);
@@ -5413,7 +6078,7 @@ namespace OArray
     FORTHOP(oStructArrayHeadIterMethod)
     {
         GET_THIS(oStructArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
 
         oStructArrayIterStruct* pIter = createStructArrayIterator(pCore, pArray);
@@ -5426,7 +6091,7 @@ namespace OArray
     FORTHOP(oStructArrayTailIterMethod)
     {
         GET_THIS(oStructArrayStruct, pArray);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         oStructArrayIterStruct* pIter = createStructArrayIterator(pCore, pArray);
         pIter->cursor = pArray->elements->size();
@@ -5895,7 +6560,7 @@ namespace OArray
     {
         GET_THIS(oStructArrayIterStruct, pIter);
         oStructArrayStruct* pArray = reinterpret_cast<oStructArrayStruct *>(pIter->parent);
-        pArray->refCount++;
+        INCREMENT_REFCOUNT(pArray);
         TRACK_KEEP;
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIStructArrayIter);
         MALLOCATE_ITER(oStructArrayIterStruct, pNewIter, pIterVocab);
@@ -5961,6 +6626,593 @@ namespace OArray
 
 
 
+    //////////////////////////////////////////////////////////////////////
+    ///
+    //                 ColumnArray
+    //
+    // ColumnArray holds the same records as a StructArray, but stores each struct field in
+    //   its own column, so scanning one field only touches that field's memory.
+    // Columns for byte, short, int, float, long and double fields are the matching numeric
+    //   array objects, which can be fetched with column and used with the array math methods.
+    //   Other fields (nested structs, arrays, strings, pointers) are stored in ByteArrays
+    //   holding the raw field bytes of each row.
+    // Whole rows are copied in and out with get, set, push and pop like StructArray, there
+    //   is no ref method, since rows aren't stored contiguously there is nothing to point at.
+    //
+
+    struct oColumnArrayColumn
+    {
+        std::string     name;
+        ForthObject     column;
+        // offset and size of field in struct
+        ulong           offset;
+        ulong           size;
+        // size of elements of column array object
+        ulong           elementBytes;
+    };
+
+    typedef std::vector<oColumnArrayColumn> oColumnList;
+
+    struct oColumnArrayStruct
+    {
+        forthop*                pMethods;
+        ulong                   refCount;
+        oColumnList*            columns;
+        ulong                   elementSize;
+        ulong                   numElements;
+        ForthStructVocabulary*  pVocab;
+        // scratch row used by show and the object reader
+        char*                   pRowBuffer;
+    };
+
+    template <class S>
+    ForthObject createColumnObject(eBuiltinClassIndex classIndex)
+    {
+        ForthClassVocabulary *pClassVocab = GET_CLASS_VOCABULARY(classIndex);
+        MALLOCATE_OBJECT(oNumericArrayStruct<S>, pColumn, pClassVocab);
+        pColumn->pMethods = pClassVocab->GetMethods();
+        // column is owned by its ColumnArray
+        pColumn->refCount = 1;
+        pColumn->elements = new std::vector<S, ForthHugePageAllocator<S>>;
+        return reinterpret_cast<ForthObject>(pColumn);
+    }
+
+    template <class S>
+    std::vector<S, ForthHugePageAllocator<S>>& getColumnElements(ForthObject column)
+    {
+        return *(reinterpret_cast<oNumericArrayStruct<S> *>(column)->elements);
+    }
+
+    // resizes column object to hold numRows rows, new rows are zeroed
+    void resizeColumnData(oColumnArrayColumn& col, ulong numRows)
+    {
+        size_t numColumnElements = (numRows * col.size) / col.elementBytes;
+        switch (col.elementBytes)
+        {
+        case 2:
+            getColumnElements<short>(col.column).resize(numColumnElements);
+            break;
+        case 4:
+            getColumnElements<int>(col.column).resize(numColumnElements);
+            break;
+        case 8:
+            getColumnElements<int64_t>(col.column).resize(numColumnElements);
+            break;
+        default:
+            getColumnElements<char>(col.column).resize(numColumnElements);
+            break;
+        }
+    }
+
+    // returns pointer to row ix of column, the column object can be resized directly so that
+    //   it no longer holds all the rows, in that case a bad index error is set and null returned
+    char* getColumnRow(oColumnArrayColumn& col, ulong ix)
+    {
+        char* pData;
+        size_t numColumnBytes;
+        switch (col.elementBytes)
+        {
+        case 2:
+        {
+            std::vector<short, ForthHugePageAllocator<short>>& a = getColumnElements<short>(col.column);
+            pData = (char *)(a.data());
+            numColumnBytes = a.size() * sizeof(short);
+            break;
+        }
+        case 4:
+        {
+            std::vector<int, ForthHugePageAllocator<int>>& a = getColumnElements<int>(col.column);
+            pData = (char *)(a.data());
+            numColumnBytes = a.size() * sizeof(int);
+            break;
+        }
+        case 8:
+        {
+            std::vector<int64_t, ForthHugePageAllocator<int64_t>>& a = getColumnElements<int64_t>(col.column);
+            pData = (char *)(a.data());
+            numColumnBytes = a.size() * sizeof(int64_t);
+            break;
+        }
+        default:
+        {
+            std::vector<char, ForthHugePageAllocator<char>>& a = getColumnElements<char>(col.column);
+            pData = a.data();
+            numColumnBytes = a.size();
+            break;
+        }
+        }
+        ulong numColumnRows = (ulong)(numColumnBytes / col.size);
+        if (ix >= numColumnRows)
+        {
+            ReportBadArrayIndex("ColumnArray column", ix, numColumnRows);
+            return nullptr;
+        }
+        return pData + (ix * col.size);
+    }
+
+    void addStructColumns(oColumnArrayStruct* pArray, ForthStructVocabulary* pVocab)
+    {
+        // base struct fields are at lower offsets, add them first
+        if (pVocab->BaseVocabulary() != nullptr)
+        {
+            addStructColumns(pArray, pVocab->BaseVocabulary());
+        }
+        forthop* pEntry = pVocab->GetNewestEntry();
+        if (pEntry == nullptr)
+        {
+            return;
+        }
+        forthop* pEntriesEnd = pVocab->GetEntriesEnd();
+        long previousOffset = pVocab->GetSize();
+        size_t firstColumn = pArray->columns->size();
+        char buffer[256];
+        while (pEntry < pEntriesEnd)
+        {
+            long elementSize = VOCABENTRY_TO_ELEMENT_SIZE(pEntry);
+            if (elementSize != 0)
+            {
+                long typeCode = VOCABENTRY_TO_TYPECODE(pEntry);
+                long byteOffset = VOCABENTRY_TO_FIELD_OFFSET(pEntry);
+                // this relies on the fact that entries come up in reverse order of base offset
+                long numElements = CODE_IS_ARRAY(typeCode) ? ((previousOffset - byteOffset) / elementSize) : 1;
+                previousOffset = byteOffset;
+                long baseType = CODE_TO_BASE_TYPE(typeCode);
+                if ((baseType != kBaseTypeUserDefinition) && (baseType != kBaseTypeVoid))
+                {
+                    pVocab->GetEntryName(pEntry, buffer, sizeof(buffer));
+                    oColumnArrayColumn col;
+                    col.name = buffer;
+                    col.offset = byteOffset;
+                    col.size = elementSize * numElements;
+                    col.elementBytes = 1;
+                    if (!CODE_IS_PTR(typeCode) && !CODE_IS_ARRAY(typeCode))
+                    {
+                        switch (baseType)
+                        {
+                        case kBaseTypeShort:
+                        case kBaseTypeUShort:
+                            col.column = createColumnObject<short>(kBCIShortArray);
+                            col.elementBytes = 2;
+                            break;
+                        case kBaseTypeInt:
+                        case kBaseTypeUInt:
+                            col.column = createColumnObject<int>(kBCIIntArray);
+                            col.elementBytes = 4;
+                            break;
+                        case kBaseTypeFloat:
+                            // FloatArray uses an int vector for its elements
+                            col.column = createColumnObject<int>(kBCIFloatArray);
+                            col.elementBytes = 4;
+                            break;
+                        case kBaseTypeLong:
+                        case kBaseTypeULong:
+                            col.column = createColumnObject<int64_t>(kBCILongArray);
+                            col.elementBytes = 8;
+                            break;
+                        case kBaseTypeDouble:
+                            col.column = createColumnObject<double>(kBCIDoubleArray);
+                            col.elementBytes = 8;
+                            break;
+                        default:
+                            break;
+                        }
+                    }
+                    if (col.elementBytes == 1)
+                    {
+                        // byte fields and anything which isn't a single number, one raw field per row
+                        col.column = createColumnObject<char>(kBCIByteArray);
+                    }
+                    pArray->columns->push_back(col);
+                }
+            }
+            pEntry = pVocab->NextEntry(pEntry);
+        }
+        // vocab entries are newest first, put columns in field order
+        std::reverse(pArray->columns->begin() + firstColumn, pArray->columns->end());
+    }
+
+    void releaseColumns(ForthCoreState* pCore, oColumnArrayStruct* pArray)
+    {
+        for (oColumnArrayColumn& col : *(pArray->columns))
+        {
+            SAFE_RELEASE(pCore, col.column);
+        }
+        pArray->columns->clear();
+    }
+
+    void setColumnArrayType(ForthCoreState* pCore, oColumnArrayStruct* pArray, ForthStructVocabulary* pVocab)
+    {
+        releaseColumns(pCore, pArray);
+        __FREE(pArray->pRowBuffer);
+        pArray->pVocab = pVocab;
+        pArray->elementSize = pVocab->GetSize();
+        pArray->numElements = 0;
+        pArray->pRowBuffer = (char *)__MALLOC(pArray->elementSize);
+        memset(pArray->pRowBuffer, 0, pArray->elementSize);
+        addStructColumns(pArray, pVocab);
+    }
+
+    // gatherColumnArrayRow and scatterColumnArrayRow return false if a column object has been
+    //   resized so it doesn't hold row ix, the error has already been reported
+    bool gatherColumnArrayRow(oColumnArrayStruct* pArray, ulong ix, char* pDst)
+    {
+        for (oColumnArrayColumn& col : *(pArray->columns))
+        {
+            char* pSrc = getColumnRow(col, ix);
+            if (pSrc == nullptr)
+            {
+                return false;
+            }
+            memcpy(pDst + col.offset, pSrc, col.size);
+        }
+        return true;
+    }
+
+    bool scatterColumnArrayRow(oColumnArrayStruct* pArray, ulong ix, const char* pSrc)
+    {
+        for (oColumnArrayColumn& col : *(pArray->columns))
+        {
+            char* pDst = getColumnRow(col, ix);
+            if (pDst == nullptr)
+            {
+                return false;
+            }
+            memcpy(pDst, pSrc + col.offset, col.size);
+        }
+        return true;
+    }
+
+    void resizeColumnArray(oColumnArrayStruct* pArray, ulong numElements)
+    {
+        pArray->numElements = numElements;
+        for (oColumnArrayColumn& col : *(pArray->columns))
+        {
+            resizeColumnData(col, numElements);
+        }
+    }
+
+    void columnArrayChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oColumnArrayStruct* pArray = reinterpret_cast<oColumnArrayStruct *>(obj);
+        for (oColumnArrayColumn& col : *(pArray->columns))
+        {
+            visitor(col.column, pUserData);
+        }
+    }
+
+    bool customColumnArrayReader(const std::string& elementName, ForthObjectReader* reader)
+    {
+        oColumnArrayStruct *dstArray = (oColumnArrayStruct *)(reader->getCustomReaderContext().pData);
+        if (elementName == "structType")
+        {
+            std::string structType;
+            reader->getString(structType);
+            ForthStructVocabulary* pVocab = ForthTypesManager::GetInstance()->GetStructVocabulary(structType.c_str());
+            if (pVocab == nullptr)
+            {
+                reader->throwError("unknown struct type for ColumnArray");
+            }
+            setColumnArrayType(reader->GetCoreState(), dstArray, pVocab);
+            return true;
+        }
+        else if (elementName == "elements")
+        {
+            if (dstArray->pVocab == nullptr)
+            {
+                reader->throwError("ColumnArray is missing struct type");
+            }
+            reader->getRequiredChar('[');
+            while (true)
+            {
+                char ch = reader->getChar();
+                if (ch == ']')
+                {
+                    break;
+                }
+                if (ch != ',')
+                {
+                    reader->ungetChar(ch);
+                }
+                memset(dstArray->pRowBuffer, 0, dstArray->elementSize);
+                reader->getStruct(dstArray->pVocab, 0, dstArray->pRowBuffer);
+                resizeColumnArray(dstArray, dstArray->numElements + 1);
+                scatterColumnArrayRow(dstArray, dstArray->numElements - 1, dstArray->pRowBuffer);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    FORTHOP(oColumnArrayNew)
+    {
+        ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+        MALLOCATE_OBJECT(oColumnArrayStruct, pArray, pClassVocab);
+        pArray->pMethods = pClassVocab->GetMethods();
+        pArray->refCount = 0;
+        pArray->columns = new oColumnList;
+        pArray->elementSize = 0;
+        pArray->numElements = 0;
+        pArray->pVocab = nullptr;
+        pArray->pRowBuffer = nullptr;
+        PUSH_OBJECT(pArray);
+    }
+
+    FORTHOP(oColumnArrayDeleteMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        releaseColumns(pCore, pArray);
+        delete pArray->columns;
+        __FREE(pArray->pRowBuffer);
+        FREE_OBJECT(pArray);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayShowInnerMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        if (pArray->pVocab != nullptr)
+        {
+            GET_SHOW_CONTEXT;
+
+            pShowContext->BeginElement("structType");
+            pShowContext->ShowQuotedText(pArray->pVocab->GetName());
+
+            pShowContext->BeginElement("elements");
+            pShowContext->ShowTextReturn("[");
+            if (pArray->numElements > 0)
+            {
+                pShowContext->BeginIndent();
+                for (ulong i = 0; i < pArray->numElements; i++)
+                {
+                    if (i != 0)
+                    {
+                        pShowContext->ShowTextReturn(",");
+                    }
+                    pShowContext->ShowIndent();
+                    if (!gatherColumnArrayRow(pArray, i, pArray->pRowBuffer))
+                    {
+                        break;
+                    }
+                    pShowContext->BeginNestedShow();
+                    pArray->pVocab->ShowData(pArray->pRowBuffer, pCore, false);
+                    pShowContext->EndNestedShow();
+                }
+                pShowContext->EndIndent();
+                pShowContext->ShowIndent();
+            }
+            pShowContext->ShowTextReturn();
+            pShowContext->ShowIndent("]");
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, "ColumnArray:show unknown struct type");
+        }
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArraySetTypeMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        ForthStructVocabulary* pVocab = (ForthStructVocabulary *)SPOP;
+        if (pVocab != nullptr)
+        {
+            setColumnArrayType(pCore, pArray, pVocab);
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, "ColumnArray.setType unknown struct type");
+        }
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayCountMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        SPUSH(pArray->numElements);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayClearMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        resizeColumnArray(pArray, 0);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayResizeMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        ulong newSize = (ulong)SPOP;
+        resizeColumnArray(pArray, newSize);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayGetMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        ulong ix = (ulong)SPOP;
+        char* pDstStruct = (char *)SPOP;
+        if (pArray->numElements > ix)
+        {
+            if (pDstStruct != nullptr)
+            {
+                gatherColumnArrayRow(pArray, ix, pDstStruct);
+            }
+            else
+            {
+                GET_ENGINE->SetError(kForthErrorBadParameter, "ColumnArray:get null destination pointer");
+            }
+        }
+        else
+        {
+            ReportBadArrayIndex("ColumnArray:get", ix, pArray->numElements);
+        }
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArraySetMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        ulong ix = (ulong)SPOP;
+        char* pSrcStruct = (char *)SPOP;
+        if (pArray->numElements > ix)
+        {
+            if (pSrcStruct != nullptr)
+            {
+                scatterColumnArrayRow(pArray, ix, pSrcStruct);
+            }
+            else
+            {
+                GET_ENGINE->SetError(kForthErrorBadParameter, "ColumnArray:set null source pointer");
+            }
+        }
+        else
+        {
+            ReportBadArrayIndex("ColumnArray:set", ix, pArray->numElements);
+        }
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayPushMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        char* pSrc = (char *)SPOP;
+        if (pArray->pVocab == nullptr)
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, "ColumnArray:push unknown struct type");
+        }
+        else if (pSrc != nullptr)
+        {
+            resizeColumnArray(pArray, pArray->numElements + 1);
+            scatterColumnArrayRow(pArray, pArray->numElements - 1, pSrc);
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, "ColumnArray:push null source pointer");
+        }
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayPopMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        char* pDst = (char *)SPOP;
+        if (pArray->numElements > 0)
+        {
+            if (pDst != nullptr)
+            {
+                if (gatherColumnArrayRow(pArray, pArray->numElements - 1, pDst))
+                {
+                    resizeColumnArray(pArray, pArray->numElements - 1);
+                }
+            }
+            else
+            {
+                GET_ENGINE->SetError(kForthErrorBadParameter, "ColumnArray:pop null destination pointer");
+            }
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " pop of empty ColumnArray");
+        }
+        METHOD_RETURN;
+    }
+
+    // column ( ptrTo byte fieldName -- COLUMN_OBJECT )
+    // pushes null if there is no field with that name
+    FORTHOP(oColumnArrayColumnMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        const char* pName = (const char *)SPOP;
+        ForthObject result = nullptr;
+        if (pName != nullptr)
+        {
+            for (oColumnArrayColumn& col : *(pArray->columns))
+            {
+                if (col.name == pName)
+                {
+                    result = col.column;
+                    break;
+                }
+            }
+        }
+        PUSH_OBJECT(result);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayColumnAtMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        ulong ix = (ulong)SPOP;
+        ForthObject result = nullptr;
+        if (pArray->columns->size() > ix)
+        {
+            result = (*(pArray->columns))[ix].column;
+        }
+        else
+        {
+            ReportBadArrayIndex("ColumnArray:columnAt", ix, pArray->columns->size());
+        }
+        PUSH_OBJECT(result);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oColumnArrayNumColumnsMethod)
+    {
+        GET_THIS(oColumnArrayStruct, pArray);
+        SPUSH(pArray->columns->size());
+        METHOD_RETURN;
+    }
+
+    baseMethodEntry oColumnArrayMembers[] =
+    {
+        METHOD("__newOp", oColumnArrayNew),
+        METHOD("delete", oColumnArrayDeleteMethod),
+        METHOD("showInner", oColumnArrayShowInnerMethod),
+
+        METHOD_RET("count", oColumnArrayCountMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD("clear", oColumnArrayClearMethod),
+        METHOD("resize", oColumnArrayResizeMethod),
+        METHOD("get", oColumnArrayGetMethod),
+        METHOD("set", oColumnArraySetMethod),
+        METHOD("push", oColumnArrayPushMethod),
+        METHOD("pop", oColumnArrayPopMethod),
+        METHOD("setType", oColumnArraySetTypeMethod),
+        METHOD_RET("column", oColumnArrayColumnMethod, RETURNS_OBJECT(kBCIObject)),
+        METHOD_RET("columnAt", oColumnArrayColumnAtMethod, RETURNS_OBJECT(kBCIObject)),
+        METHOD_RET("numColumns", oColumnArrayNumColumnsMethod, RETURNS_NATIVE(kBaseTypeInt)),
+
+        MEMBER_VAR("__columns", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+        MEMBER_VAR("elementSize", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
+        MEMBER_VAR("numElements", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
+        MEMBER_VAR("__vocab", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+        MEMBER_VAR("__rowBuffer", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+
+        // following must be last in table
+        END_MEMBERS
+    };
+
+
     //////////////////////////////////////////////////////////////////////
 	///
 	//                 Pair
@@ -6020,7 +7272,7 @@ namespace OArray
     FORTHOP(oPairHeadIterMethod)
     {
         GET_THIS(oPairStruct, pPair);
-        pPair->refCount++;
+        INCREMENT_REFCOUNT(pPair);
         TRACK_KEEP;
 
         oPairIterStruct* pIter = createPairIterator(pCore, pPair);
@@ -6033,7 +7285,7 @@ namespace OArray
     FORTHOP(oPairTailIterMethod)
     {
         GET_THIS(oPairStruct, pPair);
-        pPair->refCount++;
+        INCREMENT_REFCOUNT(pPair);
         TRACK_KEEP;
         oPairIterStruct* pIter = createPairIterator(pCore, pPair);
         pIter->cursor = 2;
@@ -6124,8 +7376,7 @@ namespace OArray
 	{
 		GET_THIS(oPairIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -6359,7 +7610,7 @@ namespace OArray
     FORTHOP(oTripleHeadIterMethod)
     {
         GET_THIS(oTripleStruct, pTriple);
-        pTriple->refCount++;
+        INCREMENT_REFCOUNT(pTriple);
         TRACK_KEEP;
 
         oTripleIterStruct* pIter = createTripleIterator(pCore, pTriple);
@@ -6372,7 +7623,7 @@ namespace OArray
     FORTHOP(oTripleTailIterMethod)
     {
         GET_THIS(oTripleStruct, pTriple);
-        pTriple->refCount++;
+        INCREMENT_REFCOUNT(pTriple);
         TRACK_KEEP;
         oTripleIterStruct* pIter = createTripleIterator(pCore, pTriple);
         pIter->cursor = 3;
@@ -6486,8 +7737,7 @@ namespace OArray
 	{
 		GET_THIS(oTripleIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -6677,42 +7927,60 @@ namespace OArray
 
     void AddClasses(ForthEngine* pEngine)
 	{
+        // create the worker pool used by psort now, while there is only one thread
+        ForthWorkerPool::GetInstance();
+
 		gpArrayClassVocab = pEngine->AddBuiltinClass("Array", kBCIArray, kBCIIterable, oArrayMembers);
         gpArrayClassVocab->SetCustomObjectReader(customArrayReader);
+        gpArrayClassVocab->SetCustomChildVisitor(arrayChildVisitor);
+        gpArrayClassVocab->SetCustomBinarySerializer(arrayBinaryWriter, arrayBinaryReader);
         pEngine->AddBuiltinClass("ArrayIter", kBCIArrayIter, kBCIIter, oArrayIterMembers);
 
         ForthClassVocabulary* pVocab = pEngine->AddBuiltinClass("Bag", kBCIBag, kBCIIterable, oBagMembers);
         pVocab->SetCustomObjectReader(customBagReader);
+        pVocab->SetCustomChildVisitor(bagChildVisitor);
         pEngine->AddBuiltinClass("BagIter", kBCIBagIter, kBCIIter, oBagIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("ByteArray", kBCIByteArray, kBCIIterable, oByteArrayMembers);
         pVocab->SetCustomObjectReader(customByteArrayReader);
+        pVocab->SetCustomBinarySerializer(numericArrayBinaryWriter<char>, numericArrayBinaryReader<char>);
         pEngine->AddBuiltinClass("ByteArrayIter", kBCIByteArrayIter, kBCIIter, oByteArrayIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("ShortArray", kBCIShortArray, kBCIIterable, oShortArrayMembers);
         pVocab->SetCustomObjectReader(customShortArrayReader);
+        pVocab->SetCustomBinarySerializer(numericArrayBinaryWriter<short>, numericArrayBinaryReader<short>);
         pEngine->AddBuiltinClass("ShortArrayIter", kBCIShortArrayIter, kBCIIter, oShortArrayIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("IntArray", kBCIIntArray, kBCIIterable, oIntArrayMembers);
         pVocab->SetCustomObjectReader(customIntArrayReader);
+        pVocab->SetCustomBinarySerializer(numericArrayBinaryWriter<int>, numericArrayBinaryReader<int>);
         pEngine->AddBuiltinClass("IntArrayIter", kBCIIntArrayIter, kBCIIter, oIntArrayIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("FloatArray", kBCIFloatArray, kBCIIterable, oFloatArrayMembers);
         pVocab->SetCustomObjectReader(customFloatArrayReader);
+        pVocab->SetCustomBinarySerializer(numericArrayBinaryWriter<int>, numericArrayBinaryReader<int>);
         pEngine->AddBuiltinClass("FloatArrayIter", kBCIFloatArrayIter, kBCIIter, oIntArrayIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("LongArray", kBCILongArray, kBCIIterable, oLongArrayMembers);
         pVocab->SetCustomObjectReader(customLongArrayReader);
+        pVocab->SetCustomBinarySerializer(numericArrayBinaryWriter<int64_t>, numericArrayBinaryReader<int64_t>);
         pEngine->AddBuiltinClass("LongArrayIter", kBCILongArrayIter, kBCIIter, oLongArrayIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("DoubleArray", kBCIDoubleArray, kBCIIterable, oDoubleArrayMembers);
         pVocab->SetCustomObjectReader(customDoubleArrayReader);
+        pVocab->SetCustomBinarySerializer(numericArrayBinaryWriter<double>, numericArrayBinaryReader<double>);
         pEngine->AddBuiltinClass("DoubleArrayIter", kBCIDoubleArrayIter, kBCIIter, oLongArrayIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("StructArray", kBCIStructArray, kBCIIterable, oStructArrayMembers);
         pVocab->SetCustomObjectReader(customStructArrayReader);
+        pVocab->SetCustomChildVisitor(structArrayChildVisitor);
+        pVocab->SetCustomBinarySerializer(structArrayBinaryWriter, structArrayBinaryReader);
         pEngine->AddBuiltinClass("StructArrayIter", kBCIStructArrayIter, kBCIIter, oStructArrayIterMembers);
 
+        pVocab = pEngine->AddBuiltinClass("ColumnArray", kBCIColumnArray, kBCIObject, oColumnArrayMembers);
+        pVocab->SetCustomObjectReader(customColumnArrayReader);
+        pVocab->SetCustomChildVisitor(columnArrayChildVisitor);
+
         pEngine->AddBuiltinClass("Pair", kBCIPair, kBCIIterable, oPairMembers);
 		pEngine->AddBuiltinClass("PairIter", kBCIPairIter, kBCIIter, oPairIterMembers);
 
@@ -5,6 +5,9 @@
 //
 //////////////////////////////////////////////////////////////////////
 
+#include <vector>
+
+#include "ForthMemoryManager.h"
 
 class ForthClassVocabulary;
 
@@ -12,6 +15,33 @@ namespace OArray
 {
 	void AddClasses(ForthEngine* pEngine);
 
+    // ByteArray, ShortArray, IntArray, FloatArray, LongArray and DoubleArray all have this layout
+    template <class T>
+    struct oNumericArrayStruct
+    {
+        forthop*        pMethods;
+        ulong           refCount;
+        std::vector<T, ForthHugePageAllocator<T>>* elements;
+    };
+
+    // copies the elements of keysObj into keys, returns false if keysObj isn't an arrayClass object
+    template <class T, class KEY>
+    bool getNumericArrayKeys(ForthObject keysObj, eBuiltinClassIndex arrayClass, std::vector<KEY>& keys)
+    {
+        if (keysObj == nullptr)
+        {
+            return false;
+        }
+        ForthClassObject* pClassObject = GET_CLASS_OBJECT(keysObj);
+        if (pClassObject->pVocab != GET_CLASS_VOCABULARY(arrayClass))
+        {
+            return false;
+        }
+        oNumericArrayStruct<T>* pKeys = reinterpret_cast<oNumericArrayStruct<T> *>(keysObj);
+        keys.assign(pKeys->elements->begin(), pKeys->elements->end());
+        return true;
+    }
+
     oArrayStruct* createArrayObject(ForthClassVocabulary *pClassVocab);
 
     extern ForthClassVocabulary* gpArrayClassVocab;
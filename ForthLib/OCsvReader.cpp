@@ -0,0 +1,785 @@
+//////////////////////////////////////////////////////////////////////
+//
+// OCsvReader.cpp: builtin delimited text reader class
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "pch.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ForthEngine.h"
+#include "ForthVocabulary.h"
+#include "ForthObject.h"
+#include "ForthBuiltinClasses.h"
+#include "ForthShowContext.h"
+#include "ForthMemoryManager.h"
+
+#include "OCsvReader.h"
+#include "OString.h"
+#include "OArray.h"
+
+namespace
+{
+    using OArray::oNumericArrayStruct;
+
+    template <class T>
+    inline std::vector<T, ForthHugePageAllocator<T>>& numericElements(ForthObject& obj)
+    {
+        return *(reinterpret_cast<oNumericArrayStruct<T> *>(obj)->elements);
+    }
+
+    inline oArray& objectElements(ForthObject& obj)
+    {
+        return *(reinterpret_cast<oArrayStruct *>(obj)->elements);
+    }
+
+    inline bool isSpace(char ch)
+    {
+        return (ch == ' ') || (ch == '\t');
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+////
+///
+//                     ForthCsvReader
+//
+
+ForthCsvReader::ForthCsvReader()
+    : mDelimiter(',')
+    , mSkipLines(0)
+    , mRowCount(0)
+    , mLineNumber(0)
+    , mInStream(nullptr)
+    , mpInStream(nullptr)
+    , mpCore(nullptr)
+    , mbMapped(false)
+    , mbAtEOF(true)
+    , mpData(nullptr)
+    , mPos(0)
+    , mLimit(0)
+{
+}
+
+ForthCsvReader::~ForthCsvReader()
+{
+}
+
+bool ForthCsvReader::Open(ForthObject& inStream, ForthCoreState* pCore)
+{
+    mInStream = inStream;
+    mpInStream = reinterpret_cast<oInStreamStruct *>(inStream);
+    mpCore = pCore;
+    mRowCount = 0;
+    mLineNumber = 0;
+    mbMapped = false;
+    mbAtEOF = true;
+    mpData = nullptr;
+    mPos = 0;
+    mLimit = 0;
+    mError.clear();
+    if ((mpInStream == nullptr) || (mpInStream->pInFuncs == nullptr) || (mpInStream->pInFuncs->inBytes == nullptr))
+    {
+        mError.assign("CsvReader needs a builtin input stream");
+        return false;
+    }
+
+    mbAtEOF = false;
+    if (mpInStream->pInFuncs->inMapped != nullptr)
+    {
+        // a mapped stream fills the buffer with copies from its mapping instead of file reads,
+        //   rows aren't parsed in the mapping itself since closing the stream unmaps it
+        size_t numBytes = 0;
+        mbMapped = (mpInStream->pInFuncs->inMapped(pCore, mpInStream, numBytes) != nullptr);
+    }
+    mBuffer.resize(CSV_READER_BUFFER_SIZE);
+    mpData = &(mBuffer[0]);
+
+    try
+    {
+        const char* pRow;
+        size_t rowBytes;
+        while ((mLineNumber < mSkipLines) && findRow(pRow, rowBytes))
+        {
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        mError.assign(ex.what());
+        return false;
+    }
+    return true;
+}
+
+ucell ForthCsvReader::ReadRows(ucell maxRows, ForthCoreState* pCore)
+{
+    mpCore = pCore;
+    mError.clear();
+    if (mpData == nullptr)
+    {
+        mError.assign("CsvReader has no input");
+        return 0;
+    }
+
+    // column sizes before this read, so a bad row can be taken back out
+    std::vector<size_t> startSizes;
+    for (Column& column : mColumns)
+    {
+        size_t numElements = 0;
+        switch (column.type)
+        {
+        case kColumnInt:
+        case kColumnFloat:
+            numElements = numericElements<int>(column.array).size();
+            break;
+        case kColumnLong:
+            numElements = numericElements<int64_t>(column.array).size();
+            break;
+        case kColumnDouble:
+            numElements = numericElements<double>(column.array).size();
+            break;
+        case kColumnString:
+            numElements = objectElements(column.array).size();
+            break;
+        default:
+            break;
+        }
+        startSizes.push_back(numElements);
+    }
+
+    ucell numRows = 0;
+    try
+    {
+        const char* pRow;
+        size_t rowBytes;
+        while (((maxRows == 0) || (numRows < maxRows)) && findRow(pRow, rowBytes))
+        {
+            if (rowBytes == 0)
+            {
+                // blank lines aren't rows
+                continue;
+            }
+            parseRow(pRow, rowBytes);
+            numRows++;
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        mError.assign(ex.what());
+        std::vector<size_t> goodSizes(startSizes);
+        for (size_t& numElements : goodSizes)
+        {
+            numElements += numRows;
+        }
+        truncateColumns(goodSizes);
+    }
+    mRowCount += numRows;
+    return numRows;
+}
+
+bool ForthCsvReader::AtEOF()
+{
+    if (mPos < mLimit)
+    {
+        return false;
+    }
+    if (!mbAtEOF)
+    {
+        fillBuffer();
+    }
+    return mPos >= mLimit;
+}
+
+bool ForthCsvReader::fillBuffer()
+{
+    if (mbAtEOF)
+    {
+        return false;
+    }
+    // keep the unparsed part of the buffer, and make room for more after it
+    size_t numKept = mLimit - mPos;
+    if ((numKept != 0) && (mPos != 0))
+    {
+        memmove(&(mBuffer[0]), &(mBuffer[mPos]), numKept);
+    }
+    mPos = 0;
+    mLimit = numKept;
+    if (numKept == mBuffer.size())
+    {
+        // a row longer than the buffer
+        mBuffer.resize(mBuffer.size() * 2);
+    }
+    mpData = &(mBuffer[0]);
+
+    int numRead = mpInStream->pInFuncs->inBytes(mpCore, mpInStream, &(mBuffer[mLimit]), (int)(mBuffer.size() - mLimit));
+    if (numRead <= 0)
+    {
+        mbAtEOF = true;
+        return false;
+    }
+    mLimit += numRead;
+    return true;
+}
+
+bool ForthCsvReader::findRow(const char*& pRow, size_t& rowBytes)
+{
+    size_t scanStart = 0;
+    bool inQuotes = false;
+    while (true)
+    {
+        const char* pStart = mpData + mPos;
+        size_t available = mLimit - mPos;
+        const char* pEOL = nullptr;
+        if (scanStart < available)
+        {
+            const char* pScan = pStart + scanStart;
+            size_t numToScan = available - scanStart;
+            pEOL = (const char*) memchr(pScan, '\n', numToScan);
+            size_t lineBytes = (pEOL != nullptr) ? (pEOL - pScan) : numToScan;
+            if (inQuotes || (memchr(pScan, '"', lineBytes) != nullptr))
+            {
+                // newlines inside quoted fields don't end the row
+                pEOL = nullptr;
+                for (size_t i = 0; i < numToScan; i++)
+                {
+                    char ch = pScan[i];
+                    if (ch == '"')
+                    {
+                        inQuotes = !inQuotes;
+                    }
+                    else if ((ch == '\n') && !inQuotes)
+                    {
+                        pEOL = pScan + i;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (pEOL != nullptr)
+        {
+            pRow = pStart;
+            rowBytes = pEOL - pStart;
+            mPos += rowBytes + 1;
+            break;
+        }
+        if (mbAtEOF || !fillBuffer())
+        {
+            if (mPos >= mLimit)
+            {
+                return false;
+            }
+            // last row has no newline
+            pRow = mpData + mPos;
+            rowBytes = mLimit - mPos;
+            mPos = mLimit;
+            break;
+        }
+        // only the new input needs to be scanned, the quote state carries over
+        scanStart = available;
+    }
+
+    mLineNumber++;
+    if ((rowBytes > 0) && (pRow[rowBytes - 1] == '\r'))
+    {
+        rowBytes--;
+    }
+    return true;
+}
+
+void ForthCsvReader::parseRow(const char* pRow, size_t rowBytes)
+{
+    const char* pCur = pRow;
+    const char* pEnd = pRow + rowBytes;
+    // a row with fewer fields than there are columns gets empty fields for the missing ones
+    bool haveField = true;
+    for (Column& column : mColumns)
+    {
+        const char* pField = pCur;
+        size_t fieldBytes = 0;
+        if (haveField)
+        {
+            if ((pCur < pEnd) && (*pCur == '"'))
+            {
+                // quoted field, "" inside it is a quote
+                mField.clear();
+                pCur++;
+                while (true)
+                {
+                    const char* pQuote = (const char*) memchr(pCur, '"', pEnd - pCur);
+                    if (pQuote == nullptr)
+                    {
+                        throwError("unterminated quoted field");
+                    }
+                    mField.append(pCur, pQuote - pCur);
+                    pCur = pQuote + 1;
+                    if ((pCur < pEnd) && (*pCur == '"'))
+                    {
+                        mField.push_back('"');
+                        pCur++;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                pField = mField.data();
+                fieldBytes = mField.size();
+                // anything between the closing quote and the delimiter is ignored
+                const char* pDelim = (const char*) memchr(pCur, mDelimiter, pEnd - pCur);
+                pCur = (pDelim != nullptr) ? pDelim : pEnd;
+            }
+            else
+            {
+                const char* pDelim = (const char*) memchr(pCur, mDelimiter, pEnd - pCur);
+                const char* pFieldEnd = (pDelim != nullptr) ? pDelim : pEnd;
+                fieldBytes = pFieldEnd - pCur;
+                pCur = pFieldEnd;
+            }
+
+            if (pCur < pEnd)
+            {
+                // step over delimiter
+                pCur++;
+            }
+            else
+            {
+                haveField = false;
+            }
+        }
+        storeField(column, pField, fieldBytes);
+    }
+}
+
+void ForthCsvReader::storeField(Column& column, const char* pField, size_t fieldBytes)
+{
+    switch (column.type)
+    {
+    case kColumnInt:
+        numericElements<int>(column.array).push_back((int) parseInteger(pField, fieldBytes, INT32_MAX));
+        break;
+
+    case kColumnLong:
+        numericElements<int64_t>(column.array).push_back(parseInteger(pField, fieldBytes, INT64_MAX));
+        break;
+
+    case kColumnFloat:
+    {
+        // FloatArray elements are stored as ints
+        float fval = (float) parseDouble(pField, fieldBytes);
+        int ival;
+        memcpy(&ival, &fval, sizeof(ival));
+        numericElements<int>(column.array).push_back(ival);
+        break;
+    }
+
+    case kColumnDouble:
+        numericElements<double>(column.array).push_back(parseDouble(pField, fieldBytes));
+        break;
+
+    case kColumnString:
+        objectElements(column.array).push_back(createString(pField, fieldBytes));
+        break;
+
+    default:
+        break;
+    }
+}
+
+int64_t ForthCsvReader::parseInteger(const char* pField, size_t fieldBytes, int64_t maxValue)
+{
+    const char* pCur = pField;
+    const char* pEnd = pField + fieldBytes;
+    while ((pCur < pEnd) && isSpace(*pCur))
+    {
+        pCur++;
+    }
+    while ((pEnd > pCur) && isSpace(pEnd[-1]))
+    {
+        pEnd--;
+    }
+    if (pCur == pEnd)
+    {
+        return 0;
+    }
+
+    bool isNegative = false;
+    if ((*pCur == '-') || (*pCur == '+'))
+    {
+        isNegative = (*pCur == '-');
+        pCur++;
+    }
+    if (pCur == pEnd)
+    {
+        throwError("bad integer field");
+    }
+    // negative values can go one further than positive ones
+    uint64_t limit = ((uint64_t) maxValue) + (isNegative ? 1 : 0);
+    uint64_t val = 0;
+    while (pCur < pEnd)
+    {
+        unsigned int digit = (unsigned int)(*pCur - '0');
+        if (digit > 9)
+        {
+            throwError("bad integer field");
+        }
+        if (val > ((limit - digit) / 10))
+        {
+            throwError("integer out of range");
+        }
+        val = (val * 10) + digit;
+        pCur++;
+    }
+    return isNegative ? (int64_t)(0 - val) : (int64_t) val;
+}
+
+double ForthCsvReader::parseDouble(const char* pField, size_t fieldBytes)
+{
+    const char* pCur = pField;
+    const char* pEnd = pField + fieldBytes;
+    while ((pCur < pEnd) && isSpace(*pCur))
+    {
+        pCur++;
+    }
+    while ((pEnd > pCur) && isSpace(pEnd[-1]))
+    {
+        pEnd--;
+    }
+    if (pCur == pEnd)
+    {
+        return NAN;
+    }
+
+    // strtod needs a terminated string, and a field in the input isn't
+    char buffer[64];
+    size_t numChars = pEnd - pCur;
+    const char* pText = buffer;
+    if (numChars < sizeof(buffer))
+    {
+        memcpy(buffer, pCur, numChars);
+        buffer[numChars] = '\0';
+    }
+    else
+    {
+        mValueText.assign(pCur, numChars);
+        pText = mValueText.c_str();
+    }
+    char* pParseEnd;
+    double val = strtod(pText, &pParseEnd);
+    if (pParseEnd != (pText + numChars))
+    {
+        throwError("bad number field");
+    }
+    return val;
+}
+
+ForthObject ForthCsvReader::createString(const char* pChars, size_t numChars)
+{
+    ForthClassVocabulary* pClassVocab = OString::gpStringClassVocab;
+    oString* str = OString::createOString((int) numChars);
+    MALLOCATE_OBJECT(oStringStruct, pString, pClassVocab);
+    pString->pMethods = pClassVocab->GetMethods();
+    // the column array holds the only reference
+    pString->refCount = 1;
+    pString->hash = 0;
+    pString->str = str;
+    memcpy(str->data, pChars, numChars);
+    str->data[numChars] = '\0';
+    str->curLen = (long) numChars;
+    return (ForthObject) pString;
+}
+
+void ForthCsvReader::truncateColumns(const std::vector<size_t>& numRows)
+{
+    ForthCoreState* pCore = mpCore;
+    for (size_t i = 0; i < mColumns.size(); i++)
+    {
+        Column& column = mColumns[i];
+        switch (column.type)
+        {
+        case kColumnInt:
+        case kColumnFloat:
+        {
+            std::vector<int, ForthHugePageAllocator<int>>& a = numericElements<int>(column.array);
+            if (a.size() > numRows[i])
+            {
+                a.resize(numRows[i]);
+            }
+            break;
+        }
+
+        case kColumnLong:
+        {
+            std::vector<int64_t, ForthHugePageAllocator<int64_t>>& a = numericElements<int64_t>(column.array);
+            if (a.size() > numRows[i])
+            {
+                a.resize(numRows[i]);
+            }
+            break;
+        }
+
+        case kColumnDouble:
+        {
+            std::vector<double, ForthHugePageAllocator<double>>& a = numericElements<double>(column.array);
+            if (a.size() > numRows[i])
+            {
+                a.resize(numRows[i]);
+            }
+            break;
+        }
+
+        case kColumnString:
+        {
+            oArray& a = objectElements(column.array);
+            while (a.size() > numRows[i])
+            {
+                SAFE_RELEASE(pCore, a.back());
+                a.pop_back();
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+void ForthCsvReader::throwError(const char* message)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "CsvReader: %s on line %llu", message, (unsigned long long) mLineNumber);
+    throw std::runtime_error(buffer);
+}
+
+namespace OCsvReader
+{
+    //////////////////////////////////////////////////////////////////////
+    ///
+    //                 CsvReader
+    //
+
+    struct oCsvReaderStruct
+    {
+        forthop*        pMethods;
+        ulong           refCount;
+        ForthCsvReader* reader;
+    };
+
+    void csvReaderChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        ForthCsvReader* pReader = reinterpret_cast<oCsvReaderStruct*>(obj)->reader;
+        if (pReader->GetInStream() != nullptr)
+        {
+            visitor(pReader->GetInStream(), pUserData);
+        }
+        for (ForthCsvReader::Column& column : pReader->GetColumns())
+        {
+            if (column.array != nullptr)
+            {
+                visitor(column.array, pUserData);
+            }
+        }
+    }
+
+    void releaseColumns(ForthCoreState* pCore, ForthCsvReader* pReader)
+    {
+        for (ForthCsvReader::Column& column : pReader->GetColumns())
+        {
+            SAFE_RELEASE(pCore, column.array);
+        }
+        pReader->GetColumns().clear();
+    }
+
+    FORTHOP(oCsvReaderNew)
+    {
+        ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+        MALLOCATE_OBJECT(oCsvReaderStruct, pCsvReader, pClassVocab);
+        pCsvReader->pMethods = pClassVocab->GetMethods();
+        pCsvReader->refCount = 0;
+        pCsvReader->reader = new ForthCsvReader;
+        PUSH_OBJECT(pCsvReader);
+    }
+
+    FORTHOP(oCsvReaderDeleteMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        ForthCsvReader* pReader = pCsvReader->reader;
+        releaseColumns(pCore, pReader);
+        SAFE_RELEASE(pCore, pReader->GetInStream());
+        delete pReader;
+        FREE_OBJECT(pCsvReader);
+        METHOD_RETURN;
+    }
+
+    // setDelimiter ( CHAR -- )
+    FORTHOP(oCsvReaderSetDelimiterMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        pCsvReader->reader->SetDelimiter((char)(SPOP));
+        METHOD_RETURN;
+    }
+
+    // setSkipLines ( NUM_LINES -- )
+    // number of lines open skips before the first row, like a header line
+    FORTHOP(oCsvReaderSetSkipLinesMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        pCsvReader->reader->SetSkipLines((ucell)(SPOP));
+        METHOD_RETURN;
+    }
+
+    // addColumn ( ARRAY -- )
+    // adds a column which is read into ARRAY, which is an IntArray, LongArray, FloatArray,
+    //   DoubleArray or Array, or null to skip the column
+    FORTHOP(oCsvReaderAddColumnMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        ForthCsvReader::Column column;
+        POP_OBJECT(column.array);
+        column.type = ForthCsvReader::kColumnSkip;
+        if (column.array != nullptr)
+        {
+            // classes derived from the builtin arrays are parsed like their builtin ancestor
+            if (OString::objectIsA(column.array, GET_CLASS_VOCABULARY(kBCIIntArray)))
+            {
+                column.type = ForthCsvReader::kColumnInt;
+            }
+            else if (OString::objectIsA(column.array, GET_CLASS_VOCABULARY(kBCILongArray)))
+            {
+                column.type = ForthCsvReader::kColumnLong;
+            }
+            else if (OString::objectIsA(column.array, GET_CLASS_VOCABULARY(kBCIFloatArray)))
+            {
+                column.type = ForthCsvReader::kColumnFloat;
+            }
+            else if (OString::objectIsA(column.array, GET_CLASS_VOCABULARY(kBCIDoubleArray)))
+            {
+                column.type = ForthCsvReader::kColumnDouble;
+            }
+            else if (OString::objectIsA(column.array, GET_CLASS_VOCABULARY(kBCIArray)))
+            {
+                column.type = ForthCsvReader::kColumnString;
+            }
+            else
+            {
+                GET_ENGINE->SetError(kForthErrorBadParameter, " CsvReader column must be an IntArray, LongArray, FloatArray, DoubleArray or Array");
+                METHOD_RETURN;
+                return;
+            }
+        }
+        SAFE_KEEP(column.array);
+        pCsvReader->reader->GetColumns().push_back(column);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oCsvReaderClearColumnsMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        releaseColumns(pCore, pCsvReader->reader);
+        METHOD_RETURN;
+    }
+
+    // open ( IN_STREAM -- )
+    FORTHOP(oCsvReaderOpenMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        ForthCsvReader* pReader = pCsvReader->reader;
+        ForthObject inStream;
+        POP_OBJECT(inStream);
+        OBJECT_ASSIGN(pCore, pReader->GetInStream(), inStream);
+        if (!pReader->Open(inStream, pCore))
+        {
+            GET_ENGINE->SetError(kForthErrorIO, pReader->GetError().c_str());
+        }
+        METHOD_RETURN;
+    }
+
+    // read ( MAX_ROWS -- NUM_ROWS )
+    // appends up to MAX_ROWS rows to the column arrays, all the rest if MAX_ROWS is 0
+    // a bad row is an error, NUM_ROWS is the number of good rows before it, which are kept
+    FORTHOP(oCsvReaderReadMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        ForthCsvReader* pReader = pCsvReader->reader;
+        ucell maxRows = (ucell)(SPOP);
+        ucell numRows = pReader->ReadRows(maxRows, pCore);
+        if (!pReader->GetError().empty())
+        {
+            GET_ENGINE->SetError(kForthErrorBadSyntax, pReader->GetError().c_str());
+        }
+        SPUSH((cell) numRows);
+        METHOD_RETURN;
+    }
+
+    // tryRead ( MAX_ROWS -- NUM_ROWS ERROR_STRING )
+    // like read, but a bad row doesn't stop execution, ERROR_STRING is null if there was no
+    //   bad row, otherwise it is valid until the next read
+    FORTHOP(oCsvReaderTryReadMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        ForthCsvReader* pReader = pCsvReader->reader;
+        ucell maxRows = (ucell)(SPOP);
+        ucell numRows = pReader->ReadRows(maxRows, pCore);
+        SPUSH((cell) numRows);
+        SPUSH(pReader->GetError().empty() ? 0 : (cell)(pReader->GetError().c_str()));
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oCsvReaderRowCountMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        SPUSH((cell) pCsvReader->reader->GetRowCount());
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oCsvReaderAtEOFMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        long retVal = pCsvReader->reader->AtEOF() ? ~0 : 0;
+        SPUSH(retVal);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oCsvReaderIsMappedMethod)
+    {
+        GET_THIS(oCsvReaderStruct, pCsvReader);
+        long retVal = pCsvReader->reader->IsMapped() ? ~0 : 0;
+        SPUSH(retVal);
+        METHOD_RETURN;
+    }
+
+    baseMethodEntry oCsvReaderMembers[] =
+    {
+        METHOD("__newOp", oCsvReaderNew),
+        METHOD("delete", oCsvReaderDeleteMethod),
+
+        METHOD("setDelimiter", oCsvReaderSetDelimiterMethod),
+        METHOD("setSkipLines", oCsvReaderSetSkipLinesMethod),
+        METHOD("addColumn", oCsvReaderAddColumnMethod),
+        METHOD("clearColumns", oCsvReaderClearColumnsMethod),
+        METHOD("open", oCsvReaderOpenMethod),
+        METHOD_RET("read", oCsvReaderReadMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD("tryRead", oCsvReaderTryReadMethod),
+        METHOD_RET("rowCount", oCsvReaderRowCountMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("atEOF", oCsvReaderAtEOFMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("isMapped", oCsvReaderIsMappedMethod, RETURNS_NATIVE(kBaseTypeInt)),
+
+        MEMBER_VAR("__reader", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+        // following must be last in table
+        END_MEMBERS
+    };
+
+    void AddClasses(ForthEngine* pEngine)
+    {
+        ForthClassVocabulary* pVocab = pEngine->AddBuiltinClass("CsvReader", kBCICsvReader, kBCIObject, oCsvReaderMembers);
+        pVocab->SetCustomChildVisitor(csvReaderChildVisitor);
+    }
+
+} // namespace OCsvReader
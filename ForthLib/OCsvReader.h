@@ -0,0 +1,107 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// OCsvReader.h: builtin delimited text reader class
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+class ForthClassVocabulary;
+
+// input is read in blocks of at least this size
+#define CSV_READER_BUFFER_SIZE      65536
+
+// ForthCsvReader parses delimited text, like CSV or TSV files, straight into column arrays.
+// Each column has a destination array, whose class decides how its fields are parsed:
+//   IntArray, LongArray, FloatArray and DoubleArray get numbers, Array gets String objects,
+//   and a null array skips the field.
+// Fields can be double quoted, a quoted field can hold delimiters, newlines and "" for a quote.
+// Empty integer fields are 0, empty floating point fields are NaN, integers which don't fit
+//   their column's element type are an error.
+// Input is read through a buffer which only has to hold the longest row, so files of any
+//   size can be read a chunk of rows at a time. A mapped stream fills the buffer by copying
+//   from its mapping, so the reader doesn't depend on the mapping staying open.
+class ForthCsvReader
+{
+public:
+    enum ColumnType
+    {
+        kColumnSkip,
+        kColumnInt,
+        kColumnLong,
+        kColumnFloat,
+        kColumnDouble,
+        kColumnString
+    };
+
+    struct Column
+    {
+        ColumnType      type;
+        ForthObject     array;
+    };
+
+    ForthCsvReader();
+    ~ForthCsvReader();
+
+    inline void             SetDelimiter(char delimiter) { mDelimiter = delimiter; }
+    inline char             GetDelimiter() const { return mDelimiter; }
+    // lines skipped when input is opened, like a header line
+    inline void             SetSkipLines(ucell numLines) { mSkipLines = numLines; }
+    inline ucell            GetRowCount() const { return mRowCount; }
+    inline bool             IsMapped() const { return mbMapped; }
+    inline ForthObject&     GetInStream() { return mInStream; }
+    inline std::vector<Column>& GetColumns() { return mColumns; }
+    inline const std::string& GetError() const { return mError; }
+
+    // starts reading inStream, the caller owns the references to inStream and the column arrays
+    bool Open(ForthObject& inStream, ForthCoreState* pCore);
+    // appends up to maxRows rows to the column arrays, all rows if maxRows is 0, and returns
+    //   the number of rows read.  A bad row stops the read and sets the error, none of the bad
+    //   row is added to the columns, but the rows before it are kept and counted
+    ucell ReadRows(ucell maxRows, ForthCoreState* pCore);
+    bool AtEOF();
+
+private:
+    // finds the end of the next row, pRow points at it until the input is next read
+    bool findRow(const char*& pRow, size_t& rowBytes);
+    bool fillBuffer();
+    void parseRow(const char* pRow, size_t rowBytes);
+    void storeField(Column& column, const char* pField, size_t fieldBytes);
+    // maxValue is the largest value the column holds, the smallest is -maxValue - 1
+    int64_t parseInteger(const char* pField, size_t fieldBytes, int64_t maxValue);
+    double parseDouble(const char* pField, size_t fieldBytes);
+    ForthObject createString(const char* pChars, size_t numChars);
+    // drops elements past numRows from each column
+    void truncateColumns(const std::vector<size_t>& numRows);
+    void throwError(const char* message);
+
+    char                    mDelimiter;
+    ucell                   mSkipLines;
+    ucell                   mRowCount;
+    ucell                   mLineNumber;
+    ForthObject             mInStream;
+    oInStreamStruct*        mpInStream;
+    ForthCoreState*         mpCore;
+    std::vector<Column>     mColumns;
+
+    // unparsed input is mpData[mPos ... mLimit-1], mbMapped is set if the stream reads a mapped file
+    bool                    mbMapped;
+    bool                    mbAtEOF;
+    const char*             mpData;
+    size_t                  mPos;
+    size_t                  mLimit;
+    std::vector<char>       mBuffer;
+    // holds quoted fields with their quotes removed
+    std::string             mField;
+    // holds numbers too long for parseDouble's buffer
+    std::string             mValueText;
+
+    std::string             mError;
+};
+
+namespace OCsvReader
+{
+	void AddClasses(ForthEngine* pEngine);
+}
@@ -1,12 +1,13 @@
 //////////////////////////////////////////////////////////////////////
 //
-// ODeque.cpp: builtin deque class
+// ODeque.cpp: builtin deque, queue and priority queue classes
 //
 //////////////////////////////////////////////////////////////////////
 
 #include "pch.h"
 #include <stdio.h>
 #include <deque>
+#include <atomic>
 
 #include "ForthEngine.h"
 #include "ForthVocabulary.h"
@@ -14,12 +15,14 @@
 #include "ForthBuiltinClasses.h"
 #include "ForthShowContext.h"
 #include "ForthObjectReader.h"
+#include "ForthMemoryManager.h"
 
 #include "ODeque.h"
+#include "OArray.h"
 
 namespace ODeque
 {
-    typedef std::deque<ForthObject> oDeque;
+    typedef ForthObjectRing oDeque;
     struct oDequeStruct
     {
         forthop*        pMethods;
@@ -33,7 +36,7 @@ namespace ODeque
         long*               pMethods;
         ulong				refCount;
         ForthObject			parent;
-        oDeque::iterator	*cursor;
+        ucell               cursor;
     };
     */
 
@@ -55,6 +58,18 @@ namespace ODeque
     }
     */
 
+    void dequeChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oDeque& q = *(reinterpret_cast<oDequeStruct*>(obj)->que);
+        for (ucell i = 0; i < q.Count(); i++)
+        {
+            if (q.At(i) != nullptr)
+            {
+                visitor(q.At(i), pUserData);
+            }
+        }
+    }
+
     bool customDequeReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "queue")
@@ -76,7 +91,7 @@ namespace ODeque
                 }
                 reader->getObjectOrLink(&obj);
                 SAFE_KEEP(obj);
-                dstDeque->que->push_back(obj);
+                dstDeque->que->PushTail(obj);
                 // TODO: release obj here?
             }
             return true;
@@ -99,12 +114,12 @@ namespace ODeque
         // go through all elements and release any which are not null
         GET_THIS(oDequeStruct, pDeque);
         oDeque* deq = pDeque->que;
-        while (!deq->empty())
+        while (!deq->IsEmpty())
         {
-            ForthObject o = deq->back();
+            ForthObject o = deq->PopTail();
             SAFE_RELEASE(pCore, o);
-            deq->pop_back();
         }
+        delete deq;
         FREE_OBJECT(pDeque);
         METHOD_RETURN;
     }
@@ -112,19 +127,14 @@ namespace ODeque
     FORTHOP(oDequeShowInnerMethod)
     {
         GET_THIS(oDequeStruct, pDeque);
-        oDeque::iterator iter;
         oDeque& deq = *(pDeque->que);
         GET_SHOW_CONTEXT;
         pShowContext->BeginElement("queue");
         pShowContext->BeginArray();
-        if (!deq.empty())
+        for (ucell i = 0; i < deq.Count(); i++)
         {
-            for (iter = deq.begin(); iter != deq.end(); ++iter)
-            {
-                ForthObject& o = *iter;
-                pShowContext->BeginArrayElement(1);
-                ForthShowObject(o, pCore);
-            }
+            pShowContext->BeginArrayElement(1);
+            ForthShowObject(deq.At(i), pCore);
         }
         pShowContext->EndArray();
         METHOD_RETURN;
@@ -133,7 +143,7 @@ namespace ODeque
     FORTHOP(oDequeCountMethod)
     {
         GET_THIS(oDequeStruct, pDeque);
-        SPUSH((long)(pDeque->que->size()));
+        SPUSH((long)(pDeque->que->Count()));
         METHOD_RETURN;
     }
 
@@ -141,14 +151,12 @@ namespace ODeque
     {
         // go through all elements and release any which are not null
         GET_THIS(oDequeStruct, pDeque);
-        oDeque::iterator iter;
         oDeque& a = *(pDeque->que);
-        for (iter = a.begin(); iter != a.end(); ++iter)
+        for (ucell i = 0; i < a.Count(); i++)
         {
-            ForthObject& o = *iter;
-            SAFE_RELEASE(pCore, o);
+            SAFE_RELEASE(pCore, a.At(i));
         }
-        a.clear();
+        a.Clear();
         METHOD_RETURN;
     }
 
@@ -159,7 +167,7 @@ namespace ODeque
         ForthObject fobj;
         POP_OBJECT(fobj);
         SAFE_KEEP(fobj);
-        a.push_front(fobj);
+        a.PushHead(fobj);
         METHOD_RETURN;
     }
 
@@ -170,7 +178,7 @@ namespace ODeque
         ForthObject fobj;
         POP_OBJECT(fobj);
         SAFE_KEEP(fobj);
-        a.push_back(fobj);
+        a.PushTail(fobj);
         METHOD_RETURN;
     }
 
@@ -178,10 +186,9 @@ namespace ODeque
     {
         GET_THIS(oDequeStruct, pDeque);
         oDeque& a = *(pDeque->que);
-        if (!a.empty())
+        if (!a.IsEmpty())
         {
-            ForthObject fobj = a.front();
-            a.pop_front();
+            ForthObject fobj = a.PopHead();
             unrefObject(fobj);
             PUSH_OBJECT(fobj);
         }
@@ -196,10 +203,9 @@ namespace ODeque
     {
         GET_THIS(oDequeStruct, pDeque);
         oDeque& a = *(pDeque->que);
-        if (!a.empty())
+        if (!a.IsEmpty())
         {
-            ForthObject fobj = a.back();
-            a.pop_back();
+            ForthObject fobj = a.PopTail();
             unrefObject(fobj);
             PUSH_OBJECT(fobj);
         }
@@ -215,9 +221,9 @@ namespace ODeque
         GET_THIS(oDequeStruct, pDeque);
         oDeque& a = *(pDeque->que);
         ForthObject fobj = nullptr;
-        if (!a.empty())
+        if (!a.IsEmpty())
         {
-            fobj = a.front();
+            fobj = a.Head();
         }
         PUSH_OBJECT(fobj);
         METHOD_RETURN;
@@ -228,9 +234,9 @@ namespace ODeque
         GET_THIS(oDequeStruct, pDeque);
         oDeque& a = *(pDeque->que);
         ForthObject fobj = nullptr;
-        if (!a.empty())
+        if (!a.IsEmpty())
         {
-            fobj = a.back();
+            fobj = a.Tail();
         }
         PUSH_OBJECT(fobj);
         METHOD_RETURN;
@@ -257,10 +263,788 @@ namespace ODeque
         END_MEMBERS
     };
 
+    //////////////////////////////////////////////////////////////////////
+    ///
+    //                 Queue
+    //
+
+    // a fiber blocked in pop waits for an object to be put in pSlot, which is on its
+    //   parameter stack, a fiber blocked in push waits for obj to be pushed
+    struct oQueueWaiter
+    {
+        ForthFiber*     pFiber;
+        ForthObject     obj;
+        ForthObject*    pSlot;
+    };
+
+    // waiters are only touched with the lock held, the counts let push and pop skip
+    //   taking the lock when nobody is waiting
+    struct oQueueWaiters
+    {
+#if defined(WINDOWS_BUILD)
+        CRITICAL_SECTION            lock;
+#else
+        pthread_mutex_t             lock;
+#endif
+        std::atomic<int>            numPoppers;
+        std::atomic<int>            numPushers;
+        std::deque<oQueueWaiter>    poppers;
+        std::deque<oQueueWaiter>    pushers;
+    };
+
+    void lockQueueWaiters(oQueueWaiters* pWaiters)
+    {
+#if defined(WINDOWS_BUILD)
+        EnterCriticalSection(&pWaiters->lock);
+#else
+        pthread_mutex_lock(&pWaiters->lock);
+#endif
+    }
+
+    void unlockQueueWaiters(oQueueWaiters* pWaiters)
+    {
+#if defined(WINDOWS_BUILD)
+        LeaveCriticalSection(&pWaiters->lock);
+#else
+        pthread_mutex_unlock(&pWaiters->lock);
+#endif
+    }
+
+    template<bool SPSC>
+    struct oQueueStruct
+    {
+        forthop*                    pMethods;
+        ulong                       refCount;
+        ForthObjectQueue<SPSC>*     que;
+        oQueueWaiters*              waiters;
+    };
+
+    template<bool SPSC>
+    void queueChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        // the queued objects, and the objects which blocked pushers are waiting to push
+        oQueueStruct<SPSC>* pQueue = reinterpret_cast<oQueueStruct<SPSC>*>(obj);
+        pQueue->que->VisitContents([visitor, pUserData](ForthObject& child) { visitor(child, pUserData); });
+        oQueueWaiters* pWaiters = pQueue->waiters;
+        lockQueueWaiters(pWaiters);
+        for (oQueueWaiter& waiter : pWaiters->pushers)
+        {
+            if (waiter.obj != nullptr)
+            {
+                visitor(waiter.obj, pUserData);
+            }
+        }
+        unlockQueueWaiters(pWaiters);
+    }
+
+    // called after a successful push, hands objects to fibers blocked in pop
+    template<bool SPSC>
+    void serviceBlockedPoppers(oQueueStruct<SPSC>* pQueue)
+    {
+        oQueueWaiters* pWaiters = pQueue->waiters;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pWaiters->numPoppers.load() == 0)
+        {
+            return;
+        }
+        lockQueueWaiters(pWaiters);
+        ForthObject obj;
+        while (!pWaiters->poppers.empty() && pQueue->que->TryPop(obj))
+        {
+            oQueueWaiter& waiter = pWaiters->poppers.front();
+            // the queue's reference goes to the popper
+            *(waiter.pSlot) = obj;
+            ForthFiber* pFiber = waiter.pFiber;
+            pWaiters->poppers.pop_front();
+            pWaiters->numPoppers--;
+            pFiber->Wake();
+        }
+        unlockQueueWaiters(pWaiters);
+    }
+
+    // called after a successful pop, pushes objects for fibers blocked in push
+    template<bool SPSC>
+    void serviceBlockedPushers(oQueueStruct<SPSC>* pQueue)
+    {
+        oQueueWaiters* pWaiters = pQueue->waiters;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pWaiters->numPushers.load() == 0)
+        {
+            return;
+        }
+        lockQueueWaiters(pWaiters);
+        while (!pWaiters->pushers.empty() && pQueue->que->TryPush(pWaiters->pushers.front().obj))
+        {
+            ForthFiber* pFiber = pWaiters->pushers.front().pFiber;
+            pWaiters->pushers.pop_front();
+            pWaiters->numPushers--;
+            pFiber->Wake();
+        }
+        unlockQueueWaiters(pWaiters);
+        serviceBlockedPoppers(pQueue);
+    }
+
+    template<bool SPSC>
+    void releaseQueueContents(ForthCoreState* pCore, oQueueStruct<SPSC>* pQueue)
+    {
+        ForthObject obj;
+        while (pQueue->que->TryPop(obj))
+        {
+            SAFE_RELEASE(pCore, obj);
+        }
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueNew)
+    {
+        ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+        MALLOCATE_OBJECT(oQueueStruct<SPSC>, pQueue, pClassVocab);
+        pQueue->pMethods = pClassVocab->GetMethods();
+        pQueue->refCount = 0;
+        pQueue->que = new ForthObjectQueue<SPSC>(OBJECT_QUEUE_DEFAULT_CAPACITY);
+        pQueue->waiters = new oQueueWaiters;
+        pQueue->waiters->numPoppers = 0;
+        pQueue->waiters->numPushers = 0;
+#if defined(WINDOWS_BUILD)
+        InitializeCriticalSection(&pQueue->waiters->lock);
+#else
+        pthread_mutex_init(&pQueue->waiters->lock, nullptr);
+#endif
+        PUSH_OBJECT(pQueue);
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueDeleteMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        oQueueWaiters* pWaiters = pQueue->waiters;
+        // fibers still blocked on the queue must not touch it again, they are woken first,
+        //   blocked pops return null and blocked pushes are dropped
+        std::deque<oQueueWaiter> poppers;
+        std::deque<oQueueWaiter> pushers;
+        lockQueueWaiters(pWaiters);
+        poppers.swap(pWaiters->poppers);
+        pushers.swap(pWaiters->pushers);
+        pWaiters->numPoppers = 0;
+        pWaiters->numPushers = 0;
+        unlockQueueWaiters(pWaiters);
+        for (oQueueWaiter& waiter : poppers)
+        {
+            waiter.pFiber->Wake();
+        }
+        for (oQueueWaiter& waiter : pushers)
+        {
+            SAFE_RELEASE(pCore, waiter.obj);
+            waiter.pFiber->Wake();
+        }
+        releaseQueueContents(pCore, pQueue);
+#if defined(WINDOWS_BUILD)
+        DeleteCriticalSection(&pWaiters->lock);
+#else
+        pthread_mutex_destroy(&pWaiters->lock);
+#endif
+        delete pWaiters;
+        delete pQueue->que;
+        FREE_OBJECT(pQueue);
+        METHOD_RETURN;
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueCountMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        SPUSH((cell)(pQueue->que->Count()));
+        METHOD_RETURN;
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueCapacityMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        SPUSH((cell)(pQueue->que->Capacity()));
+        METHOD_RETURN;
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueSetCapacityMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        cell newCapacity = SPOP;
+        if (pQueue->que->Count() != 0)
+        {
+            GET_ENGINE->SetError(kForthErrorIllegalOperation, " Queue.setCapacity called on non-empty queue");
+        }
+        else if (newCapacity < 1)
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " Queue.setCapacity capacity must be positive");
+        }
+        else
+        {
+            delete pQueue->que;
+            pQueue->que = new ForthObjectQueue<SPSC>((ucell)newCapacity);
+        }
+        METHOD_RETURN;
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueClearMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        releaseQueueContents(pCore, pQueue);
+        serviceBlockedPushers(pQueue);
+        METHOD_RETURN;
+    }
+
+    // push blocks the fiber if the queue is full
+    template<bool SPSC>
+    FORTHOP(oQueuePushMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        ForthObject fobj;
+        POP_OBJECT(fobj);
+        // the popper may be on another thread
+        ForthShareObject(fobj);
+        SAFE_KEEP(fobj);
+        bool blocked = false;
+        if (!pQueue->que->TryPush(fobj))
+        {
+            oQueueWaiters* pWaiters = pQueue->waiters;
+            lockQueueWaiters(pWaiters);
+            pWaiters->numPushers++;
+            // a pop may have made room before numPushers went up
+            if (pQueue->que->TryPush(fobj))
+            {
+                pWaiters->numPushers--;
+            }
+            else
+            {
+                ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+                pWaiters->pushers.push_back(oQueueWaiter{ pFiber, fobj, nullptr });
+                pFiber->Block();
+                SET_STATE(kResultYield);
+                blocked = true;
+            }
+            unlockQueueWaiters(pWaiters);
+        }
+        if (!blocked)
+        {
+            serviceBlockedPoppers(pQueue);
+        }
+        METHOD_RETURN;
+    }
+
+    // pop blocks the fiber if the queue is empty
+    // popped objects keep the reference the queue held, so the pusher can't delete an object
+    //   on another thread while the popper has it on its stack, store them with ->o
+    template<bool SPSC>
+    FORTHOP(oQueuePopMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        ForthObject fobj;
+        bool blocked = false;
+        if (!pQueue->que->TryPop(fobj))
+        {
+            oQueueWaiters* pWaiters = pQueue->waiters;
+            lockQueueWaiters(pWaiters);
+            pWaiters->numPoppers++;
+            // a push may have happened before numPoppers went up
+            if (pQueue->que->TryPop(fobj))
+            {
+                pWaiters->numPoppers--;
+            }
+            else
+            {
+                // the pusher which wakes us will store the object in this stack slot
+                PUSH_OBJECT(nullptr);
+                ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+                pWaiters->poppers.push_back(oQueueWaiter{ pFiber, nullptr, (ForthObject*)(pCore->SP) });
+                pFiber->Block();
+                SET_STATE(kResultYield);
+                blocked = true;
+            }
+            unlockQueueWaiters(pWaiters);
+        }
+        if (!blocked)
+        {
+            PUSH_OBJECT(fobj);
+            serviceBlockedPushers(pQueue);
+        }
+        METHOD_RETURN;
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueTryPushMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        ForthObject fobj;
+        POP_OBJECT(fobj);
+        ForthShareObject(fobj);
+        SAFE_KEEP(fobj);
+        bool pushed = pQueue->que->TryPush(fobj);
+        if (pushed)
+        {
+            serviceBlockedPoppers(pQueue);
+        }
+        else
+        {
+            unrefObject(fobj);
+        }
+        SPUSH(pushed ? ~0 : 0);
+        METHOD_RETURN;
+    }
+
+    template<bool SPSC>
+    FORTHOP(oQueueTryPopMethod)
+    {
+        GET_THIS(oQueueStruct<SPSC>, pQueue);
+        ForthObject fobj;
+        if (pQueue->que->TryPop(fobj))
+        {
+            PUSH_OBJECT(fobj);
+            SPUSH(~0);
+            serviceBlockedPushers(pQueue);
+        }
+        else
+        {
+            SPUSH(0);
+        }
+        METHOD_RETURN;
+    }
+
+    baseMethodEntry oQueueMembers[] =
+    {
+        METHOD("__newOp", oQueueNew<false>),
+        METHOD("delete", oQueueDeleteMethod<false>),
+
+        METHOD_RET("count", oQueueCountMethod<false>, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("capacity", oQueueCapacityMethod<false>, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD("setCapacity", oQueueSetCapacityMethod<false>),
+        METHOD("clear", oQueueClearMethod<false>),
+
+        METHOD("push", oQueuePushMethod<false>),
+        METHOD_RET("pop", oQueuePopMethod<false>, RETURNS_OBJECT(kBCIContainedType)),
+        METHOD_RET("tryPush", oQueueTryPushMethod<false>, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("tryPop", oQueueTryPopMethod<false>, RETURNS_NATIVE(kBaseTypeInt)),
+
+        MEMBER_VAR("__queue", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+        MEMBER_VAR("__waiters", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+        // following must be last in table
+        END_MEMBERS
+    };
+
+    // SPSCQueue allows only one fiber at a time to push and one fiber at a time to pop
+    baseMethodEntry oSPSCQueueMembers[] =
+    {
+        METHOD("__newOp", oQueueNew<true>),
+        METHOD("delete", oQueueDeleteMethod<true>),
+
+        METHOD_RET("count", oQueueCountMethod<true>, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("capacity", oQueueCapacityMethod<true>, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD("setCapacity", oQueueSetCapacityMethod<true>),
+        METHOD("clear", oQueueClearMethod<true>),
+
+        METHOD("push", oQueuePushMethod<true>),
+        METHOD_RET("pop", oQueuePopMethod<true>, RETURNS_OBJECT(kBCIContainedType)),
+        METHOD_RET("tryPush", oQueueTryPushMethod<true>, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("tryPop", oQueueTryPopMethod<true>, RETURNS_NATIVE(kBaseTypeInt)),
+
+        MEMBER_VAR("__queue", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+        MEMBER_VAR("__waiters", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+        // following must be last in table
+        END_MEMBERS
+    };
+
+    //////////////////////////////////////////////////////////////////////
+    ///
+    //                 PriorityQueue family
+    //
+    // LongPriorityQueue and DoublePriorityQueue pop the object with the lowest priority first.
+    // push returns a handle for the pushed object which can be passed to decreaseKey
+    //   until the object is popped, after that the handle may be given to a new object.
+    // The methods are templated on a KEYOPS class which describes the priority type:
+    //   KeyType            type of priorities
+    //   PopKey/PushKey     move priorities between the param stack and native code
+    //   ShowKey/ParseKey   convert priorities to and from element names for show
+    //   GetKeys            get the priorities for bulkLoad out of a numeric array object
+
+    using OArray::getNumericArrayKeys;
+
+    struct LongPriorityOps
+    {
+        typedef int64_t KeyType;
+
+        static inline void PopKey(ForthCoreState* pCore, int64_t& key)
+        {
+            stackInt64 val;
+            LPOP(val);
+            key = val.s64;
+        }
+        static inline void PushKey(ForthCoreState* pCore, int64_t key)
+        {
+            stackInt64 val;
+            val.s64 = key;
+            LPUSH(val);
+        }
+        static inline void ShowKey(ForthShowContext* pShowContext, int64_t key)
+        {
+            char buffer[32];
+            sprintf(buffer, "%lld", (long long)key);
+            pShowContext->BeginElement(buffer);
+        }
+        static inline void ParseKey(const std::string& keyText, int64_t& key)
+        {
+            long long val = 0;
+            sscanf(keyText.c_str(), "%lld", &val);
+            key = val;
+        }
+        static inline bool GetKeys(ForthObject keysObj, std::vector<int64_t>& keys)
+        {
+            return getNumericArrayKeys<int64_t>(keysObj, kBCILongArray, keys);
+        }
+    };
+
+    struct DoublePriorityOps
+    {
+        typedef double KeyType;
+
+        static inline void PopKey(ForthCoreState* pCore, double& key)
+        {
+            key = DPOP;
+        }
+        static inline void PushKey(ForthCoreState* pCore, double key)
+        {
+            DPUSH(key);
+        }
+        static inline void ShowKey(ForthShowContext* pShowContext, double key)
+        {
+            char buffer[64];
+            sprintf(buffer, "%.17g", key);
+            pShowContext->BeginElement(buffer);
+        }
+        static inline void ParseKey(const std::string& keyText, double& key)
+        {
+            sscanf(keyText.c_str(), "%lf", &key);
+        }
+        static inline bool GetKeys(ForthObject keysObj, std::vector<double>& keys)
+        {
+            return getNumericArrayKeys<double>(keysObj, kBCIDoubleArray, keys);
+        }
+    };
+
+    template <class KEYOPS>
+    struct oPriorityQueueStruct
+    {
+        forthop*        pMethods;
+        ulong           refCount;
+        ForthObjectHeap<typename KEYOPS::KeyType>* heap;
+    };
+
+    template <class KEYOPS>
+    void releasePriorityQueueEntries(oPriorityQueueStruct<KEYOPS>* pQueue, ForthCoreState* pCore)
+    {
+        ForthObjectHeap<typename KEYOPS::KeyType>& heap = *(pQueue->heap);
+        for (ucell i = 0; i < heap.Count(); i++)
+        {
+            SAFE_RELEASE(pCore, heap.At(i).obj);
+        }
+        heap.Clear();
+    }
+
+    template <class KEYOPS>
+    void priorityQueueChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        ForthObjectHeap<typename KEYOPS::KeyType>& heap = *(reinterpret_cast<oPriorityQueueStruct<KEYOPS>*>(obj)->heap);
+        for (ucell i = 0; i < heap.Count(); i++)
+        {
+            if (heap.At(i).obj != nullptr)
+            {
+                visitor(heap.At(i).obj, pUserData);
+            }
+        }
+    }
+
+    template <class KEYOPS>
+    bool customPriorityQueueReader(const std::string& elementName, ForthObjectReader* reader)
+    {
+        if (elementName == "heap")
+        {
+            oPriorityQueueStruct<KEYOPS> *dstQueue = (oPriorityQueueStruct<KEYOPS> *)(reader->getCustomReaderContext().pData);
+            reader->getRequiredChar('{');
+            std::string keyText;
+            ForthObject obj;
+            while (true)
+            {
+                char ch = reader->getChar();
+                if (ch == '}')
+                {
+                    break;
+                }
+                if (ch != ',')
+                {
+                    reader->ungetChar(ch);
+                }
+                reader->getString(keyText);
+                typename KEYOPS::KeyType key;
+                KEYOPS::ParseKey(keyText, key);
+                reader->getRequiredChar(':');
+                reader->getObjectOrLink(&obj);
+                SAFE_KEEP(obj);
+                dstQueue->heap->Push(key, obj);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueNew)
+    {
+        ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+        MALLOCATE_OBJECT(oPriorityQueueStruct<KEYOPS>, pQueue, pClassVocab);
+        pQueue->pMethods = pClassVocab->GetMethods();
+        pQueue->refCount = 0;
+        pQueue->heap = new ForthObjectHeap<typename KEYOPS::KeyType>;
+        PUSH_OBJECT(pQueue);
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueDeleteMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        releasePriorityQueueEntries(pQueue, pCore);
+        delete pQueue->heap;
+        FREE_OBJECT(pQueue);
+        METHOD_RETURN;
+    }
+
+    // entries are shown in heap order
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueShowInnerMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        ForthObjectHeap<typename KEYOPS::KeyType>& heap = *(pQueue->heap);
+        GET_SHOW_CONTEXT;
+        pShowContext->BeginElement("heap");
+        pShowContext->ShowTextReturn("{");
+        pShowContext->BeginNestedShow();
+        if (!heap.IsEmpty())
+        {
+            pShowContext->BeginIndent();
+            for (ucell i = 0; i < heap.Count(); i++)
+            {
+                KEYOPS::ShowKey(pShowContext, heap.At(i).key);
+                ForthShowObject(heap.At(i).obj, pCore);
+                pShowContext->EndElement();
+            }
+            pShowContext->EndIndent();
+            pShowContext->ShowIndent();
+        }
+        pShowContext->ShowTextReturn();
+        pShowContext->ShowIndent();
+        pShowContext->EndElement("}");
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueCountMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        SPUSH((cell)(pQueue->heap->Count()));
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueClearMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        releasePriorityQueueEntries(pQueue, pCore);
+        METHOD_RETURN;
+    }
+
+    // push ( obj priority -- handle )
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueuePushMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        typename KEYOPS::KeyType key;
+        KEYOPS::PopKey(pCore, key);
+        ForthObject fobj;
+        POP_OBJECT(fobj);
+        SAFE_KEEP(fobj);
+        SPUSH((cell)(pQueue->heap->Push(key, fobj)));
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueuePopMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        if (!pQueue->heap->IsEmpty())
+        {
+            ForthObject fobj = pQueue->heap->Pop();
+            unrefObject(fobj);
+            PUSH_OBJECT(fobj);
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " pop of empty PriorityQueue");
+        }
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueuePeekMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        ForthObject fobj = nullptr;
+        if (!pQueue->heap->IsEmpty())
+        {
+            fobj = pQueue->heap->Top().obj;
+        }
+        PUSH_OBJECT(fobj);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueuePeekPriorityMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        if (!pQueue->heap->IsEmpty())
+        {
+            KEYOPS::PushKey(pCore, pQueue->heap->Top().key);
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " peekPriority of empty PriorityQueue");
+        }
+        METHOD_RETURN;
+    }
+
+    // contains ( handle -- flag )
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueContainsMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        ucell handle = (ucell)(SPOP);
+        SPUSH(pQueue->heap->IsValidHandle(handle) ? ~0 : 0);
+        METHOD_RETURN;
+    }
+
+    // decreaseKey ( handle newPriority -- )
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueDecreaseKeyMethod)
+    {
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        typename KEYOPS::KeyType key;
+        KEYOPS::PopKey(pCore, key);
+        ucell handle = (ucell)(SPOP);
+        if (!pQueue->heap->IsValidHandle(handle))
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " PriorityQueue.decreaseKey handle is not in queue");
+        }
+        else if (!pQueue->heap->DecreaseKey(handle, key))
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " PriorityQueue.decreaseKey new priority is greater than old priority");
+        }
+        METHOD_RETURN;
+    }
+
+    // bulkLoad ( prioritiesArray valuesArray -- )
+    // replace contents of queue with the elements of valuesArray, with priorities from the
+    //   matching elements of prioritiesArray.  Element i gets handle i.
+    template <class KEYOPS>
+    FORTHOP(oPriorityQueueBulkLoadMethod)
+    {
+        typedef typename KEYOPS::KeyType KeyType;
+        GET_THIS(oPriorityQueueStruct<KEYOPS>, pQueue);
+        ForthObject valuesObj;
+        POP_OBJECT(valuesObj);
+        ForthObject keysObj;
+        POP_OBJECT(keysObj);
+        std::vector<KeyType> keys;
+        ForthClassObject* pValuesClassObject = (valuesObj != nullptr) ? GET_CLASS_OBJECT(valuesObj) : nullptr;
+        if (!KEYOPS::GetKeys(keysObj, keys))
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " bulkLoad priorities array is wrong type");
+        }
+        else if ((pValuesClassObject == nullptr) || (pValuesClassObject->pVocab != GET_CLASS_VOCABULARY(kBCIArray)))
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " bulkLoad values must be an Array");
+        }
+        else
+        {
+            oArray& values = *(reinterpret_cast<oArrayStruct *>(valuesObj)->elements);
+            if (values.size() != keys.size())
+            {
+                GET_ENGINE->SetError(kForthErrorBadParameter, " bulkLoad priorities and values arrays must be same size");
+            }
+            else
+            {
+                std::vector<std::pair<KeyType, ForthObject>> items;
+                items.reserve(keys.size());
+                for (size_t i = 0; i < keys.size(); i++)
+                {
+                    // keep new values before releasing old ones, in case they are the same objects
+                    SAFE_KEEP(values[i]);
+                    items.push_back(std::pair<KeyType, ForthObject>(keys[i], values[i]));
+                }
+                releasePriorityQueueEntries(pQueue, pCore);
+                pQueue->heap->BulkLoad(items);
+            }
+        }
+        METHOD_RETURN;
+    }
+
+#define PRIORITY_QUEUE_MEMBERS(KEYOPS, PRIORITY_TYPE) \
+        METHOD("__newOp", oPriorityQueueNew<KEYOPS>), \
+        METHOD("delete", oPriorityQueueDeleteMethod<KEYOPS>), \
+        METHOD("showInner", oPriorityQueueShowInnerMethod<KEYOPS>), \
+        METHOD_RET("count", oPriorityQueueCountMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD("clear", oPriorityQueueClearMethod<KEYOPS>), \
+        METHOD_RET("push", oPriorityQueuePushMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD_RET("pop", oPriorityQueuePopMethod<KEYOPS>, RETURNS_OBJECT(kBCIContainedType)), \
+        METHOD_RET("peek", oPriorityQueuePeekMethod<KEYOPS>, RETURNS_OBJECT(kBCIContainedType)), \
+        METHOD_RET("peekPriority", oPriorityQueuePeekPriorityMethod<KEYOPS>, RETURNS_NATIVE(PRIORITY_TYPE)), \
+        METHOD_RET("contains", oPriorityQueueContainsMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD("decreaseKey", oPriorityQueueDecreaseKeyMethod<KEYOPS>), \
+        METHOD("bulkLoad", oPriorityQueueBulkLoadMethod<KEYOPS>), \
+        MEMBER_VAR("__heap", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell))
+
+    baseMethodEntry oLongPriorityQueueMembers[] =
+    {
+        PRIORITY_QUEUE_MEMBERS(LongPriorityOps, kBaseTypeLong),
+
+        // following must be last in table
+        END_MEMBERS
+    };
+
+    baseMethodEntry oDoublePriorityQueueMembers[] =
+    {
+        PRIORITY_QUEUE_MEMBERS(DoublePriorityOps, kBaseTypeDouble),
+
+        // following must be last in table
+        END_MEMBERS
+    };
+
     void AddClasses(ForthEngine* pEngine)
     {
         ForthClassVocabulary* pVocab = pEngine->AddBuiltinClass("Deque", kBCIDeque, kBCIObject, oDequeMembers);
         pVocab->SetCustomObjectReader(customDequeReader);
+        pVocab->SetCustomChildVisitor(dequeChildVisitor);
+
+        pVocab = pEngine->AddBuiltinClass("Queue", kBCIQueue, kBCIObject, oQueueMembers);
+        pVocab->SetCustomChildVisitor(queueChildVisitor<false>);
+
+        pVocab = pEngine->AddBuiltinClass("SPSCQueue", kBCISPSCQueue, kBCIObject, oSPSCQueueMembers);
+        pVocab->SetCustomChildVisitor(queueChildVisitor<true>);
+
+        pVocab = pEngine->AddBuiltinClass("LongPriorityQueue", kBCILongPriorityQueue, kBCIObject, oLongPriorityQueueMembers);
+        pVocab->SetCustomObjectReader(customPriorityQueueReader<LongPriorityOps>);
+        pVocab->SetCustomChildVisitor(priorityQueueChildVisitor<LongPriorityOps>);
+
+        pVocab = pEngine->AddBuiltinClass("DoublePriorityQueue", kBCIDoublePriorityQueue, kBCIObject, oDoublePriorityQueueMembers);
+        pVocab->SetCustomObjectReader(customPriorityQueueReader<DoublePriorityOps>);
+        pVocab->SetCustomChildVisitor(priorityQueueChildVisitor<DoublePriorityOps>);
     }
 
 } // namespace ODeque
@@ -1,13 +1,463 @@
 #pragma once
 //////////////////////////////////////////////////////////////////////
 //
-// ODeque.h: builtin double-ended queue class
+// ODeque.h: builtin double-ended queue, queue and priority queue classes
 //
 //////////////////////////////////////////////////////////////////////
 
+#include <atomic>
+#include <vector>
+#include <utility>
 
 class ForthClassVocabulary;
 
+#define OBJECT_RING_MIN_CAPACITY    8
+#define OBJECT_QUEUE_DEFAULT_CAPACITY   64
+// keeps the producer and consumer positions of ForthObjectQueue on separate cache lines
+#define OBJECT_QUEUE_PAD_BYTES      64
+
+inline ucell RoundUpToPowerOf2(ucell num, ucell minNum)
+{
+    ucell result = minNum;
+    while (result < num)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+// ForthObjectRing is a growable ring buffer of objects, the capacity is always a power of 2
+//   so element positions wrap with a mask instead of a divide
+class ForthObjectRing
+{
+public:
+    ForthObjectRing()
+        : mpElements(nullptr)
+        , mCapacity(0)
+        , mHead(0)
+        , mCount(0)
+    {
+    }
+
+    ~ForthObjectRing()
+    {
+        delete [] mpElements;
+    }
+
+    inline ucell        Count() const { return mCount; }
+    inline bool         IsEmpty() const { return mCount == 0; }
+    // element 0 is the head, element Count()-1 is the tail
+    inline ForthObject& At(ucell ix) { return mpElements[(mHead + ix) & (mCapacity - 1)]; }
+    inline ForthObject& Head() { return At(0); }
+    inline ForthObject& Tail() { return At(mCount - 1); }
+
+    void PushHead(ForthObject obj)
+    {
+        if (mCount == mCapacity)
+        {
+            Grow();
+        }
+        mHead = (mHead - 1) & (mCapacity - 1);
+        mpElements[mHead] = obj;
+        mCount++;
+    }
+
+    void PushTail(ForthObject obj)
+    {
+        if (mCount == mCapacity)
+        {
+            Grow();
+        }
+        mpElements[(mHead + mCount) & (mCapacity - 1)] = obj;
+        mCount++;
+    }
+
+    ForthObject PopHead()
+    {
+        ForthObject obj = mpElements[mHead];
+        mHead = (mHead + 1) & (mCapacity - 1);
+        mCount--;
+        return obj;
+    }
+
+    ForthObject PopTail()
+    {
+        mCount--;
+        return mpElements[(mHead + mCount) & (mCapacity - 1)];
+    }
+
+    void Clear()
+    {
+        mHead = 0;
+        mCount = 0;
+    }
+
+private:
+    void Grow()
+    {
+        ucell newCapacity = (mCapacity == 0) ? OBJECT_RING_MIN_CAPACITY : (mCapacity << 1);
+        ForthObject* pNewElements = new ForthObject[newCapacity];
+        for (ucell i = 0; i < mCount; i++)
+        {
+            pNewElements[i] = At(i);
+        }
+        delete [] mpElements;
+        mpElements = pNewElements;
+        mCapacity = newCapacity;
+        mHead = 0;
+    }
+
+    ForthObject*    mpElements;
+    ucell           mCapacity;
+    ucell           mHead;
+    ucell           mCount;
+};
+
+// ForthObjectQueue is a bounded lock-free FIFO of objects, the capacity is a power of 2.
+// With SINGLE_PRODUCER_CONSUMER true, only one thread at a time may push and only one thread
+//   at a time may pop, and pushing and popping are each just a load and a store of the
+//   queue positions.  Otherwise any number of threads can push and pop, each cell has a
+//   sequence number which tells whether it is ready to be pushed or popped at a given position.
+// Positions are free running counters, cell for position pos is pos & mask.
+template <bool SINGLE_PRODUCER_CONSUMER>
+class ForthObjectQueue
+{
+public:
+    ForthObjectQueue(ucell capacity)
+    {
+        mCapacity = RoundUpToPowerOf2(capacity, 2);
+        mMask = mCapacity - 1;
+        mpCells = new Cell[mCapacity];
+        for (ucell i = 0; i < mCapacity; i++)
+        {
+            mpCells[i].sequence.store(i, std::memory_order_relaxed);
+            mpCells[i].value = nullptr;
+        }
+        mPushPos.store(0, std::memory_order_relaxed);
+        mPopPos.store(0, std::memory_order_relaxed);
+        mCachedPopPos = 0;
+        mCachedPushPos = 0;
+    }
+
+    ~ForthObjectQueue()
+    {
+        delete [] mpCells;
+    }
+
+    inline ucell Capacity() const { return mCapacity; }
+
+    // only exact when no other thread is pushing or popping
+    ucell Count() const
+    {
+        ucell popPos = mPopPos.load(std::memory_order_acquire);
+        ucell pushPos = mPushPos.load(std::memory_order_acquire);
+        ucell count = pushPos - popPos;
+        return (count > mCapacity) ? 0 : count;
+    }
+
+    // returns false if queue is full
+    bool TryPush(ForthObject obj)
+    {
+        if (SINGLE_PRODUCER_CONSUMER)
+        {
+            ucell pos = mPushPos.load(std::memory_order_relaxed);
+            if ((pos - mCachedPopPos) == mCapacity)
+            {
+                mCachedPopPos = mPopPos.load(std::memory_order_acquire);
+                if ((pos - mCachedPopPos) == mCapacity)
+                {
+                    return false;
+                }
+            }
+            mpCells[pos & mMask].value = obj;
+            mPushPos.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        Cell* pCell;
+        ucell pos = mPushPos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            pCell = &(mpCells[pos & mMask]);
+            ucell seq = pCell->sequence.load(std::memory_order_acquire);
+            cell diff = (cell)seq - (cell)pos;
+            if (diff == 0)
+            {
+                if (mPushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // cell still holds the value pushed mCapacity positions ago
+                return false;
+            }
+            else
+            {
+                pos = mPushPos.load(std::memory_order_relaxed);
+            }
+        }
+        pCell->value = obj;
+        pCell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // returns false if queue is empty
+    bool TryPop(ForthObject& obj)
+    {
+        if (SINGLE_PRODUCER_CONSUMER)
+        {
+            ucell pos = mPopPos.load(std::memory_order_relaxed);
+            if (pos == mCachedPushPos)
+            {
+                mCachedPushPos = mPushPos.load(std::memory_order_acquire);
+                if (pos == mCachedPushPos)
+                {
+                    return false;
+                }
+            }
+            obj = mpCells[pos & mMask].value;
+            mPopPos.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        Cell* pCell;
+        ucell pos = mPopPos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            pCell = &(mpCells[pos & mMask]);
+            ucell seq = pCell->sequence.load(std::memory_order_acquire);
+            cell diff = (cell)seq - (cell)(pos + 1);
+            if (diff == 0)
+            {
+                if (mPopPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // cell hasn't been pushed for this position yet
+                return false;
+            }
+            else
+            {
+                pos = mPopPos.load(std::memory_order_relaxed);
+            }
+        }
+        obj = pCell->value;
+        pCell->sequence.store(pos + mCapacity, std::memory_order_release);
+        return true;
+    }
+
+    // calls visit on each queued object without popping it, only exact when no other thread
+    //   is pushing or popping, cells which are being pushed are skipped
+    template <class VISITOR>
+    void VisitContents(VISITOR visit)
+    {
+        ucell popPos = mPopPos.load(std::memory_order_acquire);
+        ucell pushPos = mPushPos.load(std::memory_order_acquire);
+        if ((pushPos - popPos) > mCapacity)
+        {
+            return;
+        }
+        for (ucell pos = popPos; pos != pushPos; pos++)
+        {
+            Cell& c = mpCells[pos & mMask];
+            if (!SINGLE_PRODUCER_CONSUMER && (c.sequence.load(std::memory_order_acquire) != (pos + 1)))
+            {
+                continue;
+            }
+            if (c.value != nullptr)
+            {
+                visit(c.value);
+            }
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<ucell>  sequence;
+        ForthObject         value;
+    };
+
+    Cell*               mpCells;
+    ucell               mCapacity;
+    ucell               mMask;
+    char                mPad0[OBJECT_QUEUE_PAD_BYTES];
+    std::atomic<ucell>  mPushPos;
+    // producer's last look at mPopPos, only used by single producer queues
+    ucell               mCachedPopPos;
+    char                mPad1[OBJECT_QUEUE_PAD_BYTES];
+    std::atomic<ucell>  mPopPos;
+    // consumer's last look at mPushPos, only used by single consumer queues
+    ucell               mCachedPushPos;
+    char                mPad2[OBJECT_QUEUE_PAD_BYTES];
+};
+
+// ForthObjectHeap is a binary min-heap of objects ordered by a KEY priority, the lowest
+//   priority is at the top.  Each pushed item gets a handle which stays the same while
+//   the item moves around the heap, handles are reused after their items are popped.
+template <class KEY>
+class ForthObjectHeap
+{
+public:
+    struct Entry
+    {
+        KEY             key;
+        ForthObject     obj;
+        ucell           handle;
+    };
+
+    inline ucell        Count() const { return (ucell) mEntries.size(); }
+    inline bool         IsEmpty() const { return mEntries.empty(); }
+    inline Entry&       Top() { return mEntries[0]; }
+    // entries are in heap order, not priority order
+    inline Entry&       At(ucell ix) { return mEntries[ix]; }
+
+    inline bool IsValidHandle(ucell handle) const
+    {
+        return (handle < mPositions.size()) && (mPositions[handle] != kNoPosition);
+    }
+
+    inline const KEY& HandleKey(ucell handle) const { return mEntries[mPositions[handle]].key; }
+
+    ucell Push(const KEY& key, ForthObject obj)
+    {
+        Entry entry;
+        entry.key = key;
+        entry.obj = obj;
+        if (mFreeHandles.empty())
+        {
+            entry.handle = (ucell) mPositions.size();
+            // position is set by SiftUp
+            mPositions.push_back(0);
+        }
+        else
+        {
+            entry.handle = mFreeHandles.back();
+            mFreeHandles.pop_back();
+        }
+        mEntries.push_back(entry);
+        SiftUp(mEntries.size() - 1);
+        return entry.handle;
+    }
+
+    ForthObject Pop()
+    {
+        ForthObject obj = mEntries[0].obj;
+        ucell handle = mEntries[0].handle;
+        mPositions[handle] = kNoPosition;
+        mFreeHandles.push_back(handle);
+        Entry last = mEntries.back();
+        mEntries.pop_back();
+        if (!mEntries.empty())
+        {
+            mEntries[0] = last;
+            SiftDown(0);
+        }
+        return obj;
+    }
+
+    // returns false if newKey is greater than the item's current priority
+    bool DecreaseKey(ucell handle, const KEY& newKey)
+    {
+        size_t pos = mPositions[handle];
+        if (mEntries[pos].key < newKey)
+        {
+            return false;
+        }
+        mEntries[pos].key = newKey;
+        SiftUp(pos);
+        return true;
+    }
+
+    // replaces the contents of the heap, item i of items gets handle i.
+    //   heapifying bottom up is O(n), pushing the items one at a time is O(n log n)
+    void BulkLoad(const std::vector<std::pair<KEY, ForthObject>>& items)
+    {
+        Clear();
+        mEntries.resize(items.size());
+        mPositions.resize(items.size());
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            mEntries[i].key = items[i].first;
+            mEntries[i].obj = items[i].second;
+            mEntries[i].handle = (ucell) i;
+            mPositions[i] = (ucell) i;
+        }
+        for (size_t i = mEntries.size() / 2; i-- > 0; )
+        {
+            SiftDown(i);
+        }
+    }
+
+    void Clear()
+    {
+        mEntries.clear();
+        mPositions.clear();
+        mFreeHandles.clear();
+    }
+
+private:
+    static const ucell kNoPosition = ~((ucell) 0);
+
+    // the entry at pos is held aside while the entries it passes are moved into the hole
+    void SiftUp(size_t pos)
+    {
+        Entry entry = mEntries[pos];
+        while (pos > 0)
+        {
+            size_t parent = (pos - 1) >> 1;
+            if (!(entry.key < mEntries[parent].key))
+            {
+                break;
+            }
+            Place(pos, mEntries[parent]);
+            pos = parent;
+        }
+        Place(pos, entry);
+    }
+
+    void SiftDown(size_t pos)
+    {
+        Entry entry = mEntries[pos];
+        size_t count = mEntries.size();
+        while (true)
+        {
+            size_t child = (pos << 1) + 1;
+            if (child >= count)
+            {
+                break;
+            }
+            if (((child + 1) < count) && (mEntries[child + 1].key < mEntries[child].key))
+            {
+                child++;
+            }
+            if (!(mEntries[child].key < entry.key))
+            {
+                break;
+            }
+            Place(pos, mEntries[child]);
+            pos = child;
+        }
+        Place(pos, entry);
+    }
+
+    inline void Place(size_t pos, const Entry& entry)
+    {
+        mEntries[pos] = entry;
+        mPositions[entry.handle] = (ucell) pos;
+    }
+
+    std::vector<Entry>  mEntries;
+    // heap position of each handle's entry, kNoPosition for unused handles
+    std::vector<ucell>  mPositions;
+    std::vector<ucell>  mFreeHandles;
+};
+
 namespace ODeque
 {
     void AddClasses(ForthEngine* pEngine);
@@ -0,0 +1,963 @@
+//////////////////////////////////////////////////////////////////////
+//
+// OHashMap.cpp: builtin hash map related classes
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "pch.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "ForthEngine.h"
+#include "ForthVocabulary.h"
+#include "ForthObject.h"
+#include "ForthBuiltinClasses.h"
+#include "ForthShowContext.h"
+#include "ForthObjectReader.h"
+
+#include "OString.h"
+#include "OHashMap.h"
+
+// The hash map classes have the same methods as the std::map based classes in OMap.cpp
+//   and OString.cpp, but since they are flat open addressing tables, iteration order
+//   is not sorted and adding keys to a map can move its entries around, which leaves any
+//   iterators on that map at arbitrary (but safe) positions.
+// All the hash map classes share the same method implementations, which are templated
+//   on a KEYOPS class that describes the key type:
+//   KeyType        type of keys stored in the table
+//   LookupType     type of keys popped off the param stack
+//   kIterClass     builtin class index of the iterator class
+//   Hash           hash a key, returned value must be at least 2
+//   PopKey/PushKey move keys between the param stack and native code
+//   KeepKey/ReleaseKey do refcounting on keys which are objects
+//   VisitKey       pass key to child visitor if key is a non-null object
+//   ShowKey        show a key as an element name for showInner
+
+namespace OHashMap
+{
+    template <class KEYOPS>
+    struct oHashMapStruct
+    {
+        forthop*        pMethods;
+        ulong           refCount;
+        ForthHashTable<typename KEYOPS::KeyType>* elements;
+    };
+
+    struct oHashMapIterStruct
+    {
+        forthop*        pMethods;
+        ulong           refCount;
+        ForthObject     parent;
+        ucell           cursor;
+    };
+
+    struct ObjectKeyOps
+    {
+        typedef ForthObject KeyType;
+        typedef ForthObject LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCIHashMapIter;
+
+        static inline ucell Hash(const ForthObject& key) { return HashTableMixBits((uint64_t)(ucell)key); }
+        static inline void PopKey(ForthCoreState* pCore, ForthObject& key) { POP_OBJECT(key); }
+        static inline void PushKey(ForthCoreState* pCore, ForthObject key) { PUSH_OBJECT(key); }
+        static inline void KeepKey(ForthObject& key) { SAFE_KEEP(key); }
+        static inline void ReleaseKey(ForthCoreState* pCore, ForthObject& key) { SAFE_RELEASE(pCore, key); }
+        static inline void VisitKey(ForthObject& key, ObjectVisitor visitor, void* pUserData) { if (key != nullptr) { visitor(key, pUserData); } }
+    };
+
+    struct IntKeyOps
+    {
+        typedef long KeyType;
+        typedef long LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCIIntHashMapIter;
+
+        static inline ucell Hash(long key) { return HashTableMixBits((uint64_t)key); }
+        static inline void PopKey(ForthCoreState* pCore, long& key) { key = (long)SPOP; }
+        static inline void PushKey(ForthCoreState* pCore, long key) { SPUSH(key); }
+        static inline void KeepKey(long& key) {}
+        static inline void ReleaseKey(ForthCoreState* pCore, long& key) {}
+        static inline void VisitKey(long& key, ObjectVisitor visitor, void* pUserData) {}
+        static inline void ShowKey(ForthShowContext* pShowContext, long key)
+        {
+            char buffer[32];
+            sprintf(buffer, "%ld", key);
+            pShowContext->BeginElement(buffer);
+        }
+    };
+
+    struct LongKeyOps
+    {
+        typedef int64_t KeyType;
+        typedef int64_t LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCILongHashMapIter;
+
+        static inline ucell Hash(int64_t key) { return HashTableMixBits((uint64_t)key); }
+        static inline void PopKey(ForthCoreState* pCore, int64_t& key)
+        {
+            stackInt64 val;
+            LPOP(val);
+            key = val.s64;
+        }
+        static inline void PushKey(ForthCoreState* pCore, int64_t key)
+        {
+            stackInt64 val;
+            val.s64 = key;
+            LPUSH(val);
+        }
+        static inline void KeepKey(int64_t& key) {}
+        static inline void ReleaseKey(ForthCoreState* pCore, int64_t& key) {}
+        static inline void VisitKey(int64_t& key, ObjectVisitor visitor, void* pUserData) {}
+        static inline void ShowKey(ForthShowContext* pShowContext, int64_t key)
+        {
+            char buffer[32];
+            sprintf(buffer, "%lld", (long long)key);
+            pShowContext->BeginElement(buffer);
+        }
+    };
+
+    struct StringKeyOps
+    {
+        typedef std::string KeyType;
+        // lookups use the C string on the param stack so they don't have to build a std::string
+        typedef const char* LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCIStringHashMapIter;
+
+        // same hash as OString::getOStringHash, so String objects can use their cached hash
+        static inline ucell Hash(const char* key) { return OString::hashStringBytes(key, (int)strlen(key)); }
+        static inline ucell Hash(const std::string& key) { return Hash(key.c_str()); }
+        static inline void PopKey(ForthCoreState* pCore, const char*& key) { key = (const char*)(SPOP); }
+        static inline void PushKey(ForthCoreState* pCore, const std::string& key) { SPUSH((cell)(key.c_str())); }
+        static inline void KeepKey(std::string& key) {}
+        static inline void ReleaseKey(ForthCoreState* pCore, std::string& key) {}
+        static inline void VisitKey(std::string& key, ObjectVisitor visitor, void* pUserData) {}
+        static inline void ShowKey(ForthShowContext* pShowContext, const std::string& key)
+        {
+            pShowContext->BeginElement(key.c_str());
+        }
+    };
+
+    typedef oHashMapStruct<ObjectKeyOps> oObjectHashMapStruct;
+    typedef oHashMapStruct<IntKeyOps> oIntHashMapStruct;
+    typedef oHashMapStruct<LongKeyOps> oLongHashMapStruct;
+    typedef oHashMapStruct<StringKeyOps> oStringHashMapStruct;
+
+    // set value for key, a null value removes key from map
+    template <class KEYOPS, class LOOKUP>
+    void setHashMap(oHashMapStruct<KEYOPS>* pMap, const LOOKUP& key, ucell hash, ForthObject& valueObj, ForthCoreState* pCore)
+    {
+        typedef ForthHashTable<typename KEYOPS::KeyType> TableType;
+        TableType& a = *(pMap->elements);
+        if (valueObj != nullptr)
+        {
+            bool isNew;
+            ucell ix = a.Insert(key, hash, isNew);
+            typename TableType::Slot& slot = a.GetSlot(ix);
+            if (isNew)
+            {
+                KEYOPS::KeepKey(slot.key);
+                SAFE_KEEP(valueObj);
+            }
+            else if (OBJECTS_DIFFERENT(slot.value, valueObj))
+            {
+                // releasing the old value can run a delete method which changes this map and
+                //  moves or frees the slot, so finish with the slot before releasing
+                ForthObject oldObj = slot.value;
+                SAFE_KEEP(valueObj);
+                slot.value = valueObj;
+                SAFE_RELEASE(pCore, oldObj);
+                return;
+            }
+            slot.value = valueObj;
+        }
+        else
+        {
+            // remove element associated with key from map
+            ucell ix = a.Find(key, hash);
+            if (ix != HASH_TABLE_END)
+            {
+                typename TableType::Slot& slot = a.GetSlot(ix);
+                typename KEYOPS::KeyType oldKey = slot.key;
+                ForthObject oldObj = slot.value;
+                a.Remove(ix);
+                KEYOPS::ReleaseKey(pCore, oldKey);
+                SAFE_RELEASE(pCore, oldObj);
+            }
+        }
+    }
+
+    template <class KEYOPS>
+    void releaseHashMapEntries(oHashMapStruct<KEYOPS>* pMap, ForthCoreState* pCore)
+    {
+        typedef ForthHashTable<typename KEYOPS::KeyType> TableType;
+        TableType& a = *(pMap->elements);
+        for (ucell ix = a.NextLive(0); ix != HASH_TABLE_END; ix = a.NextLive(ix + 1))
+        {
+            typename TableType::Slot& slot = a.GetSlot(ix);
+            KEYOPS::ReleaseKey(pCore, slot.key);
+            SAFE_RELEASE(pCore, slot.value);
+        }
+        a.Clear();
+    }
+
+    template <class KEYOPS>
+    void hashMapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        typedef ForthHashTable<typename KEYOPS::KeyType> TableType;
+        oHashMapStruct<KEYOPS>* pMap = reinterpret_cast<oHashMapStruct<KEYOPS>*>(obj);
+        TableType& a = *(pMap->elements);
+        for (ucell ix = a.NextLive(0); ix != HASH_TABLE_END; ix = a.NextLive(ix + 1))
+        {
+            typename TableType::Slot& slot = a.GetSlot(ix);
+            KEYOPS::VisitKey(slot.key, visitor, pUserData);
+            if (slot.value != nullptr)
+            {
+                visitor(slot.value, pUserData);
+            }
+        }
+    }
+
+    template <class KEYOPS>
+    oHashMapIterStruct* createHashMapIterator(ForthCoreState* pCore, oHashMapStruct<KEYOPS>* pMap, ucell cursor)
+    {
+        INCREMENT_REFCOUNT(pMap);
+        TRACK_KEEP;
+        ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(KEYOPS::kIterClass);
+        MALLOCATE_ITER(oHashMapIterStruct, pIter, pIterVocab);
+        pIter->pMethods = pIterVocab->GetMethods();
+        pIter->refCount = 0;
+        pIter->parent = reinterpret_cast<ForthObject>(pMap);
+        pIter->cursor = cursor;
+        return pIter;
+    }
+
+
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 HashMap family methods
+	//
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapNew)
+	{
+		ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+		MALLOCATE_OBJECT(oHashMapStruct<KEYOPS>, pMap, pClassVocab);
+        pMap->pMethods = pClassVocab->GetMethods();
+		pMap->refCount = 0;
+		pMap->elements = new ForthHashTable<typename KEYOPS::KeyType>;
+		PUSH_OBJECT(pMap);
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapDeleteMethod)
+	{
+		// go through all elements and release any which are not null
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        releaseHashMapEntries(pMap, pCore);
+		delete pMap->elements;
+		FREE_OBJECT(pMap);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapShowInnerMethod)
+	{
+        typedef ForthHashTable<typename KEYOPS::KeyType> TableType;
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+		TableType& a = *(pMap->elements);
+        GET_SHOW_CONTEXT;
+        pShowContext->BeginElement("map");
+        pShowContext->ShowTextReturn("{");
+        pShowContext->BeginNestedShow();
+        if (a.Count() > 0)
+		{
+			pShowContext->BeginIndent();
+            for (ucell ix = a.NextLive(0); ix != HASH_TABLE_END; ix = a.NextLive(ix + 1))
+			{
+                typename TableType::Slot& slot = a.GetSlot(ix);
+                KEYOPS::ShowKey(pShowContext, slot.key);
+				ForthShowObject(slot.value, pCore);
+                pShowContext->EndElement();
+            }
+			pShowContext->EndIndent();
+			pShowContext->ShowIndent();
+		}
+        pShowContext->ShowTextReturn();
+        pShowContext->ShowIndent();
+        pShowContext->EndElement("}");
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapHeadIterMethod)
+    {
+        GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        oHashMapIterStruct* pIter = createHashMapIterator(pCore, pMap, pMap->elements->NextLive(0));
+        PUSH_OBJECT(pIter);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapTailIterMethod)
+    {
+        GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        oHashMapIterStruct* pIter = createHashMapIterator(pCore, pMap, HASH_TABLE_END);
+        PUSH_OBJECT(pIter);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapFindMethod)
+    {
+        GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        long found = 0;
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ucell ix = pMap->elements->Find(key, KEYOPS::Hash(key));
+        if (ix != HASH_TABLE_END)
+        {
+            oHashMapIterStruct* pIter = createHashMapIterator(pCore, pMap, ix);
+            PUSH_OBJECT(pIter);
+            found = ~0;
+        }
+        SPUSH(found);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapCountMethod)
+    {
+        GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        SPUSH((cell)(pMap->elements->Count()));
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapClearMethod)
+	{
+		// go through all elements and release any which are not null
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        releaseHashMapEntries(pMap, pCore);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapGrabMethod)
+	{
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        long found = 0;
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ucell ix = pMap->elements->Find(key, KEYOPS::Hash(key));
+        if (ix != HASH_TABLE_END)
+		{
+			ForthObject fobj = pMap->elements->GetSlot(ix).value;
+			PUSH_OBJECT(fobj);
+            found = ~0;
+		}
+        SPUSH(found);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapSetMethod)
+	{
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ForthObject newObj;
+        POP_OBJECT(newObj);
+        setHashMap(pMap, key, KEYOPS::Hash(key), newObj, pCore);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapLoadMethod)
+    {
+        GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        releaseHashMapEntries(pMap, pCore);
+        cell n = SPOP;
+        pMap->elements->Reserve(n);
+        for (cell i = 0; i < n; i++)
+        {
+            typename KEYOPS::LookupType key;
+            KEYOPS::PopKey(pCore, key);
+            ForthObject newObj;
+            POP_OBJECT(newObj);
+            setHashMap(pMap, key, KEYOPS::Hash(key), newObj, pCore);
+        }
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapFindValueMethod)
+	{
+        typedef ForthHashTable<typename KEYOPS::KeyType> TableType;
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+		long found = 0;
+		ForthObject soughtObj;
+		POP_OBJECT(soughtObj);
+		TableType& a = *(pMap->elements);
+        for (ucell ix = a.NextLive(0); ix != HASH_TABLE_END; ix = a.NextLive(ix + 1))
+		{
+            typename TableType::Slot& slot = a.GetSlot(ix);
+			if (OBJECTS_SAME(slot.value, soughtObj))
+			{
+				found = ~0;
+                KEYOPS::PushKey(pCore, slot.key);
+                break;
+			}
+		}
+		SPUSH(found);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapRemoveMethod)
+	{
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ForthObject nullObj = nullptr;
+        setHashMap(pMap, key, KEYOPS::Hash(key), nullObj, pCore);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapUnrefMethod)
+	{
+        typedef ForthHashTable<typename KEYOPS::KeyType> TableType;
+		GET_THIS(oHashMapStruct<KEYOPS>, pMap);
+		TableType& a = *(pMap->elements);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ucell ix = a.Find(key, KEYOPS::Hash(key));
+        if (ix != HASH_TABLE_END)
+		{
+            typename TableType::Slot& slot = a.GetSlot(ix);
+            KEYOPS::ReleaseKey(pCore, slot.key);
+			ForthObject fobj = slot.value;
+			unrefObject(fobj);
+			PUSH_OBJECT(fobj);
+			a.Remove(ix);
+		}
+		METHOD_RETURN;
+	}
+
+    // HashMap showInner is like Map showInner, keys are objects so they are shown first
+    //   and then referred to by link
+	FORTHOP(oObjectHashMapShowInnerMethod)
+	{
+        typedef ForthHashTable<ForthObject> TableType;
+		GET_THIS(oObjectHashMapStruct, pMap);
+		TableType& a = *(pMap->elements);
+        GET_SHOW_CONTEXT;
+
+        // first, show any key objects that weren't already shown
+        std::vector<ForthObject> keysToShow;
+        for (ucell ix = a.NextLive(0); ix != HASH_TABLE_END; ix = a.NextLive(ix + 1))
+        {
+            ForthObject key = a.GetSlot(ix).key;
+            if (!pShowContext->ObjectAlreadyShown(key))
+            {
+                keysToShow.push_back(key);
+            }
+        }
+
+        pShowContext->BeginElement("__keys");
+        pShowContext->BeginArray();
+        for (ForthObject& keyObj : keysToShow)
+        {
+            pShowContext->BeginArrayElement(1);
+            ForthShowObject(keyObj, pCore);
+        }
+        pShowContext->EndArray();
+
+        pShowContext->BeginElement("map");
+        pShowContext->ShowTextReturn("{");
+        pShowContext->BeginIndent();
+        pShowContext->BeginNestedShow();
+        for (ucell ix = a.NextLive(0); ix != HASH_TABLE_END; ix = a.NextLive(ix + 1))
+		{
+            TableType::Slot& slot = a.GetSlot(ix);
+            ForthObject key = slot.key;
+            pShowContext->AddObject(key);
+            pShowContext->BeginLinkElement(key);
+			ForthShowObject(slot.value, pCore);
+        }
+        pShowContext->EndNestedShow();
+        pShowContext->EndIndent();
+        pShowContext->ShowTextReturn();
+        pShowContext->ShowIndent();
+        pShowContext->EndElement("}");
+		METHOD_RETURN;
+	}
+
+    // the "map" element of IntHashMap, LongHashMap and StringHashMap is an object
+    //   with one element per key, the key is the element name
+    template <class KEYOPS>
+    void parseHashMapKey(const std::string& keyText, typename KEYOPS::KeyType& key);
+
+    template <>
+    void parseHashMapKey<IntKeyOps>(const std::string& keyText, long& key)
+    {
+        sscanf(keyText.c_str(), "%ld", &key);
+    }
+
+    template <>
+    void parseHashMapKey<LongKeyOps>(const std::string& keyText, int64_t& key)
+    {
+        long long val = 0;
+        sscanf(keyText.c_str(), "%lld", &val);
+        key = val;
+    }
+
+    template <>
+    void parseHashMapKey<StringKeyOps>(const std::string& keyText, std::string& key)
+    {
+        key = keyText;
+    }
+
+    template <class KEYOPS>
+    bool customHashMapReader(const std::string& elementName, ForthObjectReader* reader)
+    {
+        if (elementName == "map")
+        {
+            ForthCoreState* pCore = reader->GetCoreState();
+            oHashMapStruct<KEYOPS> *dstMap = (oHashMapStruct<KEYOPS> *)(reader->getCustomReaderContext().pData);
+            reader->getRequiredChar('{');
+            std::string keyText;
+            ForthObject obj;
+            while (true)
+            {
+                char ch = reader->getChar();
+                if (ch == '}')
+                {
+                    break;
+                }
+                if (ch != ',')
+                {
+                    reader->ungetChar(ch);
+                }
+                reader->getString(keyText);
+                typename KEYOPS::KeyType key;
+                parseHashMapKey<KEYOPS>(keyText, key);
+                reader->getRequiredChar(':');
+                reader->getObjectOrLink(&obj);
+                setHashMap(dstMap, key, KEYOPS::Hash(key), obj, pCore);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool customObjectHashMapReader(const std::string& elementName, ForthObjectReader* reader)
+    {
+        if (elementName == "__keys")
+        {
+            reader->getRequiredChar('[');
+            ForthObject obj;
+            while (true)
+            {
+                char ch = reader->getChar();
+                if (ch == ']')
+                {
+                    break;
+                }
+                if (ch != ',')
+                {
+                    reader->ungetChar(ch);
+                }
+                reader->getObjectOrLink(&obj);
+                SAFE_KEEP(obj);
+            }
+            return true;
+        }
+        else if (elementName == "map")
+        {
+            ForthCoreState* pCore = reader->GetCoreState();
+            oObjectHashMapStruct *dstMap = (oObjectHashMapStruct *)(reader->getCustomReaderContext().pData);
+            reader->getRequiredChar('{');
+            ForthObject keyObj;
+            ForthObject valueObj;
+            while (true)
+            {
+                char ch = reader->getChar();
+                if (ch == '}')
+                {
+                    break;
+                }
+                if (ch != ',')
+                {
+                    reader->ungetChar(ch);
+                }
+                reader->getObjectOrLink(&keyObj);
+                reader->getRequiredChar(':');
+                reader->getObjectOrLink(&valueObj);
+                setHashMap(dstMap, keyObj, ObjectKeyOps::Hash(keyObj), valueObj, pCore);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // StringHashMap grabString, setString and removeString take a String object as the key
+    //   and use its cached hash, so repeated lookups with the same key don't rehash it
+
+	FORTHOP(oStringHashMapGrabStringMethod)
+	{
+		GET_THIS(oStringHashMapStruct, pMap);
+        long found = 0;
+        ForthObject keyObj;
+        POP_OBJECT(keyObj);
+        oStringStruct* pKey = reinterpret_cast<oStringStruct *>(keyObj);
+        ucell ix = pMap->elements->Find(&(pKey->str->data[0]), OString::getOStringHash(pKey));
+        if (ix != HASH_TABLE_END)
+		{
+			ForthObject fobj = pMap->elements->GetSlot(ix).value;
+			PUSH_OBJECT(fobj);
+            found = ~0;
+		}
+        SPUSH(found);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringHashMapSetStringMethod)
+	{
+		GET_THIS(oStringHashMapStruct, pMap);
+        ForthObject keyObj;
+        POP_OBJECT(keyObj);
+        ForthObject newObj;
+        POP_OBJECT(newObj);
+        oStringStruct* pKey = reinterpret_cast<oStringStruct *>(keyObj);
+        const char* pKeyChars = &(pKey->str->data[0]);
+        setHashMap(pMap, pKeyChars, OString::getOStringHash(pKey), newObj, pCore);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringHashMapRemoveStringMethod)
+	{
+		GET_THIS(oStringHashMapStruct, pMap);
+        ForthObject keyObj;
+        POP_OBJECT(keyObj);
+        ForthObject nullObj = nullptr;
+        oStringStruct* pKey = reinterpret_cast<oStringStruct *>(keyObj);
+        const char* pKeyChars = &(pKey->str->data[0]);
+        setHashMap(pMap, pKeyChars, OString::getOStringHash(pKey), nullObj, pCore);
+		METHOD_RETURN;
+	}
+
+#define HASH_MAP_MEMBERS(KEYOPS, SHOW_INNER_OP, ITER_CLASS) \
+		METHOD("__newOp", oHashMapNew<KEYOPS>), \
+		METHOD("delete", oHashMapDeleteMethod<KEYOPS>), \
+		METHOD("showInner", SHOW_INNER_OP), \
+		METHOD_RET("headIter", oHashMapHeadIterMethod<KEYOPS>, RETURNS_OBJECT(ITER_CLASS)), \
+		METHOD_RET("tailIter", oHashMapTailIterMethod<KEYOPS>, RETURNS_OBJECT(ITER_CLASS)), \
+		METHOD_RET("find", oHashMapFindMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD_RET("count", oHashMapCountMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD("clear", oHashMapClearMethod<KEYOPS>), \
+        METHOD_RET("grab", oHashMapGrabMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD("set", oHashMapSetMethod<KEYOPS>), \
+        METHOD("load", oHashMapLoadMethod<KEYOPS>), \
+        METHOD_RET("findValue", oHashMapFindValueMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD("remove", oHashMapRemoveMethod<KEYOPS>), \
+		METHOD("unref", oHashMapUnrefMethod<KEYOPS>), \
+		MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell))
+
+	baseMethodEntry oHashMapMembers[] =
+	{
+        HASH_MAP_MEMBERS(ObjectKeyOps, oObjectHashMapShowInnerMethod, kBCIHashMapIter),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+	baseMethodEntry oIntHashMapMembers[] =
+	{
+        HASH_MAP_MEMBERS(IntKeyOps, oHashMapShowInnerMethod<IntKeyOps>, kBCIIntHashMapIter),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+	baseMethodEntry oLongHashMapMembers[] =
+	{
+        HASH_MAP_MEMBERS(LongKeyOps, oHashMapShowInnerMethod<LongKeyOps>, kBCILongHashMapIter),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+	baseMethodEntry oStringHashMapMembers[] =
+	{
+        HASH_MAP_MEMBERS(StringKeyOps, oHashMapShowInnerMethod<StringKeyOps>, kBCIStringHashMapIter),
+        METHOD_RET("grabString", oStringHashMapGrabStringMethod, RETURNS_NATIVE(kBaseTypeInt)),
+		METHOD("setString", oStringHashMapSetStringMethod),
+		METHOD("removeString", oStringHashMapRemoveStringMethod),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 HashMapIter family methods
+	//
+    // cursor is the index of a live slot, or HASH_TABLE_END when iterator is at tail,
+    //   the slot may have been removed or moved by a rehash since cursor was set, so
+    //   all methods go to the next live slot before using cursor
+
+	FORTHOP(oHashMapIterNew)
+	{
+		ForthEngine *pEngine = ForthEngine::GetInstance();
+		pEngine->SetError(kForthErrorIllegalOperation, " cannot explicitly create a hash map iterator object");
+	}
+
+	FORTHOP(oHashMapIterDeleteMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+		SAFE_RELEASE(pCore, pIter->parent);
+		FREE_ITER(pIter);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    inline ForthHashTable<typename KEYOPS::KeyType>& getIterTable(oHashMapIterStruct* pIter)
+    {
+        return *(reinterpret_cast<oHashMapStruct<KEYOPS> *>(pIter->parent)->elements);
+    }
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapIterSeekNextMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        ucell ix = a.NextLive(pIter->cursor);
+        pIter->cursor = (ix == HASH_TABLE_END) ? ix : a.NextLive(ix + 1);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapIterSeekPrevMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        ucell ix = a.PrevLive(pIter->cursor);
+        if (ix != HASH_TABLE_END)
+        {
+            pIter->cursor = ix;
+        }
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapIterSeekHeadMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        pIter->cursor = getIterTable<KEYOPS>(pIter).NextLive(0);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oHashMapIterSeekTailMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        pIter->cursor = HASH_TABLE_END;
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapIterAtHeadMethod)
+    {
+        GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        long retVal = (a.NextLive(pIter->cursor) == a.NextLive(0)) ? ~0 : 0;
+        SPUSH(retVal);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapIterAtTailMethod)
+    {
+        GET_THIS(oHashMapIterStruct, pIter);
+        long retVal = (getIterTable<KEYOPS>(pIter).NextLive(pIter->cursor) == HASH_TABLE_END) ? ~0 : 0;
+        SPUSH(retVal);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapIterNextMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        ucell ix = a.NextLive(pIter->cursor);
+		if (ix == HASH_TABLE_END)
+		{
+            pIter->cursor = ix;
+			SPUSH(0);
+		}
+		else
+		{
+			ForthObject o = a.GetSlot(ix).value;
+			PUSH_OBJECT(o);
+            pIter->cursor = a.NextLive(ix + 1);
+			SPUSH(~0);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapIterPrevMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        ucell ix = a.PrevLive(pIter->cursor);
+		if (ix == HASH_TABLE_END)
+		{
+			SPUSH(0);
+		}
+		else
+		{
+            pIter->cursor = ix;
+			ForthObject o = a.GetSlot(ix).value;
+			PUSH_OBJECT(o);
+			SPUSH(~0);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oHashMapIterCurrentMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        ucell ix = a.NextLive(pIter->cursor);
+        pIter->cursor = ix;
+		if (ix == HASH_TABLE_END)
+		{
+			SPUSH(0);
+		}
+		else
+		{
+			ForthObject o = a.GetSlot(ix).value;
+			PUSH_OBJECT(o);
+			SPUSH(~0);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapIterRemoveMethod)
+	{
+		GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        ucell ix = a.NextLive(pIter->cursor);
+		if (ix != HASH_TABLE_END)
+		{
+            typename ForthHashTable<typename KEYOPS::KeyType>::Slot& slot = a.GetSlot(ix);
+            KEYOPS::ReleaseKey(pCore, slot.key);
+			SAFE_RELEASE(pCore, slot.value);
+			a.Remove(ix);
+            ix = a.NextLive(ix + 1);
+		}
+        pIter->cursor = ix;
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oHashMapIterCurrentPairMethod)
+    {
+        GET_THIS(oHashMapIterStruct, pIter);
+        ForthHashTable<typename KEYOPS::KeyType>& a = getIterTable<KEYOPS>(pIter);
+        ucell ix = a.NextLive(pIter->cursor);
+        pIter->cursor = ix;
+        if (ix == HASH_TABLE_END)
+        {
+            SPUSH(0);
+        }
+        else
+        {
+            typename ForthHashTable<typename KEYOPS::KeyType>::Slot& slot = a.GetSlot(ix);
+            ForthObject o = slot.value;
+            PUSH_OBJECT(o);
+            KEYOPS::PushKey(pCore, slot.key);
+            SPUSH(~0);
+        }
+        METHOD_RETURN;
+    }
+
+#define HASH_MAP_ITER_MEMBERS(KEYOPS, PARENT_CLASS) \
+		METHOD("__newOp", oHashMapIterNew), \
+		METHOD("delete", oHashMapIterDeleteMethod), \
+		METHOD("seekNext", oHashMapIterSeekNextMethod<KEYOPS>), \
+		METHOD("seekPrev", oHashMapIterSeekPrevMethod<KEYOPS>), \
+		METHOD("seekHead", oHashMapIterSeekHeadMethod<KEYOPS>), \
+		METHOD("seekTail", oHashMapIterSeekTailMethod), \
+        METHOD_RET("atHead", oHashMapIterAtHeadMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD_RET("atTail", oHashMapIterAtTailMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD_RET("next", oHashMapIterNextMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD_RET("prev", oHashMapIterPrevMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD_RET("current", oHashMapIterCurrentMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD("remove", oHashMapIterRemoveMethod<KEYOPS>), \
+        METHOD_RET("currentPair", oHashMapIterCurrentPairMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		MEMBER_VAR("parent", OBJECT_TYPE_TO_CODE(0, PARENT_CLASS)), \
+		MEMBER_VAR("__cursor", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell))
+
+    baseMethodEntry oHashMapIterMembers[] =
+	{
+        HASH_MAP_ITER_MEMBERS(ObjectKeyOps, kBCIHashMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+    baseMethodEntry oIntHashMapIterMembers[] =
+	{
+        HASH_MAP_ITER_MEMBERS(IntKeyOps, kBCIIntHashMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+    baseMethodEntry oLongHashMapIterMembers[] =
+	{
+        HASH_MAP_ITER_MEMBERS(LongKeyOps, kBCILongHashMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+    baseMethodEntry oStringHashMapIterMembers[] =
+	{
+        HASH_MAP_ITER_MEMBERS(StringKeyOps, kBCIStringHashMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+
+	void AddClasses(ForthEngine* pEngine)
+	{
+		ForthClassVocabulary* pVocab = pEngine->AddBuiltinClass("HashMap", kBCIHashMap, kBCIIterable, oHashMapMembers);
+        pVocab->SetCustomObjectReader(customObjectHashMapReader);
+        pVocab->SetCustomChildVisitor(hashMapChildVisitor<ObjectKeyOps>);
+        pEngine->AddBuiltinClass("HashMapIter", kBCIHashMapIter, kBCIIter, oHashMapIterMembers);
+
+		pVocab = pEngine->AddBuiltinClass("IntHashMap", kBCIIntHashMap, kBCIIterable, oIntHashMapMembers);
+        pVocab->SetCustomObjectReader(customHashMapReader<IntKeyOps>);
+        pVocab->SetCustomChildVisitor(hashMapChildVisitor<IntKeyOps>);
+        pEngine->AddBuiltinClass("IntHashMapIter", kBCIIntHashMapIter, kBCIIter, oIntHashMapIterMembers);
+
+		pVocab = pEngine->AddBuiltinClass("LongHashMap", kBCILongHashMap, kBCIIterable, oLongHashMapMembers);
+        pVocab->SetCustomObjectReader(customHashMapReader<LongKeyOps>);
+        pVocab->SetCustomChildVisitor(hashMapChildVisitor<LongKeyOps>);
+        pEngine->AddBuiltinClass("LongHashMapIter", kBCILongHashMapIter, kBCIIter, oLongHashMapIterMembers);
+
+		pVocab = pEngine->AddBuiltinClass("StringHashMap", kBCIStringHashMap, kBCIIterable, oStringHashMapMembers);
+        pVocab->SetCustomObjectReader(customHashMapReader<StringKeyOps>);
+        pVocab->SetCustomChildVisitor(hashMapChildVisitor<StringKeyOps>);
+        pEngine->AddBuiltinClass("StringHashMapIter", kBCIStringHashMapIter, kBCIIter, oStringHashMapIterMembers);
+	}
+
+} // namespace OHashMap
@@ -0,0 +1,249 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// OHashMap.h: builtin hash map related classes
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <utility>
+
+class ForthClassVocabulary;
+
+// slot hash values 0 and 1 mark empty and deleted slots, real hashes are always 2 or higher
+#define HASH_TABLE_EMPTY_SLOT       0
+#define HASH_TABLE_DELETED_SLOT     1
+#define HASH_TABLE_MIN_CAPACITY     8
+// Find and NextLive return HASH_TABLE_END when there is no such slot
+#define HASH_TABLE_END              (~((ucell)0))
+
+inline ucell HashTableMixBits(uint64_t bits)
+{
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    bits *= 0xc4ceb9fe1a85ec53ULL;
+    bits ^= bits >> 33;
+    ucell hash = (ucell)bits;
+    return (hash > HASH_TABLE_DELETED_SLOT) ? hash : hash + 2;
+}
+
+// ForthHashTable is a flat open addressing table with linear probing, the capacity is
+//   always a power of 2 and is kept at most 3/4 full (counting deleted slots).
+// Removed entries leave a deleted marker behind, so entries never move except when the
+//   table is rehashed, which only happens when adding an entry.
+template <class KEY>
+class ForthHashTable
+{
+public:
+    struct Slot
+    {
+        ucell           hash;
+        KEY             key;
+        ForthObject     value;
+    };
+
+    ForthHashTable()
+        : mpSlots(nullptr)
+        , mCapacity(0)
+        , mCount(0)
+        , mUsed(0)
+    {
+    }
+
+    ~ForthHashTable()
+    {
+        delete [] mpSlots;
+    }
+
+    inline ucell    Count() const { return mCount; }
+    inline ucell    Capacity() const { return mCapacity; }
+    inline Slot&    GetSlot(ucell ix) { return mpSlots[ix]; }
+    inline bool     IsLive(ucell ix) const { return (ix < mCapacity) && (mpSlots[ix].hash > HASH_TABLE_DELETED_SLOT); }
+
+    // returns index of slot holding key, or HASH_TABLE_END if key is not in table
+    template <class LOOKUP>
+    ucell Find(const LOOKUP& key, ucell hash) const
+    {
+        if (mCount == 0)
+        {
+            return HASH_TABLE_END;
+        }
+        ucell mask = mCapacity - 1;
+        ucell ix = hash & mask;
+        while (true)
+        {
+            const Slot& slot = mpSlots[ix];
+            if (slot.hash == HASH_TABLE_EMPTY_SLOT)
+            {
+                return HASH_TABLE_END;
+            }
+            if (slot.hash == hash && slot.key == key)
+            {
+                return ix;
+            }
+            ix = (ix + 1) & mask;
+        }
+    }
+
+    // returns index of slot for key, adding an entry with a null value if key isn't already in table
+    template <class LOOKUP>
+    ucell Insert(const LOOKUP& key, ucell hash, bool& isNew)
+    {
+        if (((mUsed + 1) << 2) > (mCapacity * 3))
+        {
+            Rehash(mCount + 1);
+        }
+        ucell mask = mCapacity - 1;
+        ucell ix = hash & mask;
+        ucell deletedIx = HASH_TABLE_END;
+        while (true)
+        {
+            Slot& slot = mpSlots[ix];
+            if (slot.hash == HASH_TABLE_EMPTY_SLOT)
+            {
+                break;
+            }
+            if (slot.hash == HASH_TABLE_DELETED_SLOT)
+            {
+                if (deletedIx == HASH_TABLE_END)
+                {
+                    deletedIx = ix;
+                }
+            }
+            else if (slot.hash == hash && slot.key == key)
+            {
+                isNew = false;
+                return ix;
+            }
+            ix = (ix + 1) & mask;
+        }
+        if (deletedIx != HASH_TABLE_END)
+        {
+            ix = deletedIx;
+        }
+        else
+        {
+            mUsed++;
+        }
+        Slot& slot = mpSlots[ix];
+        slot.hash = hash;
+        slot.key = key;
+        slot.value = nullptr;
+        mCount++;
+        isNew = true;
+        return ix;
+    }
+
+    void Remove(ucell ix)
+    {
+        Slot& slot = mpSlots[ix];
+        slot.hash = HASH_TABLE_DELETED_SLOT;
+        slot.key = KEY();
+        slot.value = nullptr;
+        mCount--;
+    }
+
+    void Clear()
+    {
+        for (ucell ix = 0; ix < mCapacity; ix++)
+        {
+            Slot& slot = mpSlots[ix];
+            slot.hash = HASH_TABLE_EMPTY_SLOT;
+            slot.key = KEY();
+            slot.value = nullptr;
+        }
+        mCount = 0;
+        mUsed = 0;
+    }
+
+    // make room for numEntries without any further rehashing
+    void Reserve(ucell numEntries)
+    {
+        if (((numEntries + 1) << 2) > (mCapacity * 3))
+        {
+            Rehash(numEntries);
+        }
+    }
+
+    // returns ix if it is a live slot, else the next live slot after ix, else HASH_TABLE_END
+    ucell NextLive(ucell ix) const
+    {
+        while (ix < mCapacity)
+        {
+            if (mpSlots[ix].hash > HASH_TABLE_DELETED_SLOT)
+            {
+                return ix;
+            }
+            ix++;
+        }
+        return HASH_TABLE_END;
+    }
+
+    // returns the last live slot before ix, or HASH_TABLE_END if there isn't one
+    ucell PrevLive(ucell ix) const
+    {
+        if (ix > mCapacity)
+        {
+            ix = mCapacity;
+        }
+        while (ix > 0)
+        {
+            ix--;
+            if (mpSlots[ix].hash > HASH_TABLE_DELETED_SLOT)
+            {
+                return ix;
+            }
+        }
+        return HASH_TABLE_END;
+    }
+
+private:
+    // rebuild table with room for numEntries at no more than 1/2 full, dropping deleted slots
+    void Rehash(ucell numEntries)
+    {
+        ucell newCapacity = HASH_TABLE_MIN_CAPACITY;
+        while (newCapacity < (numEntries << 1))
+        {
+            newCapacity <<= 1;
+        }
+        Slot* pOldSlots = mpSlots;
+        ucell oldCapacity = mCapacity;
+        mpSlots = new Slot[newCapacity];
+        mCapacity = newCapacity;
+        ucell mask = newCapacity - 1;
+        for (ucell ix = 0; ix < newCapacity; ix++)
+        {
+            mpSlots[ix].hash = HASH_TABLE_EMPTY_SLOT;
+            mpSlots[ix].value = nullptr;
+        }
+        for (ucell oldIx = 0; oldIx < oldCapacity; oldIx++)
+        {
+            Slot& oldSlot = pOldSlots[oldIx];
+            if (oldSlot.hash > HASH_TABLE_DELETED_SLOT)
+            {
+                ucell ix = oldSlot.hash & mask;
+                while (mpSlots[ix].hash != HASH_TABLE_EMPTY_SLOT)
+                {
+                    ix = (ix + 1) & mask;
+                }
+                Slot& slot = mpSlots[ix];
+                slot.hash = oldSlot.hash;
+                std::swap(slot.key, oldSlot.key);
+                slot.value = oldSlot.value;
+            }
+        }
+        mUsed = mCount;
+        delete [] pOldSlots;
+    }
+
+    Slot*       mpSlots;
+    ucell       mCapacity;
+    ucell       mCount;
+    // number of live plus deleted slots
+    ucell       mUsed;
+};
+
+namespace OHashMap
+{
+	void AddClasses(ForthEngine* pEngine);
+}
@@ -15,6 +15,7 @@
 #include "ForthBuiltinClasses.h"
 #include "ForthShowContext.h"
 #include "ForthObjectReader.h"
+#include "ForthBinarySerializer.h"
 
 #include "OList.h"
 #include "OArray.h"
@@ -22,6 +23,248 @@
 namespace OList
 {
 
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 list nodes
+	//
+	// Nodes are carved out of blocks of LIST_NODES_PER_BLOCK nodes, freed nodes go on a free
+	//   chain and are reused by any list.  Node blocks are never freed, since the nodes of one
+	//   block end up scattered over many lists, and finding a block whose nodes are all free
+	//   would need a per-block count on every alloc and free, so list node memory stays at its
+	//   high water mark and is reused by later lists.
+	// A list position is a node and an index into its objs, removing an object shifts the
+	//   objects after it in the same node down, and a node is freed when it becomes empty.
+	// Anything which removes objects or moves them to other positions changes the list modCount,
+	//   an iterator whose modCount no longer matches may have a cursor on the free chain, so it
+	//   is moved past the tail of the list before it is used.
+
+#define LIST_NODES_PER_BLOCK 64
+
+#if defined(WINDOWS_BUILD)
+	CRITICAL_SECTION gListNodeLock;
+#else
+	pthread_mutex_t gListNodeLock;
+#endif
+	oListElement* gpFreeListNodes = nullptr;
+
+	void lockListNodes()
+	{
+#if defined(WINDOWS_BUILD)
+		EnterCriticalSection(&gListNodeLock);
+#else
+		pthread_mutex_lock(&gListNodeLock);
+#endif
+	}
+
+	void unlockListNodes()
+	{
+#if defined(WINDOWS_BUILD)
+		LeaveCriticalSection(&gListNodeLock);
+#else
+		pthread_mutex_unlock(&gListNodeLock);
+#endif
+	}
+
+	oListElement* allocateListNode()
+	{
+		lockListNodes();
+		if (gpFreeListNodes == nullptr)
+		{
+			oListElement* pBlock = (oListElement *) __MALLOC(sizeof(oListElement) * LIST_NODES_PER_BLOCK);
+			for (int i = 0; i < LIST_NODES_PER_BLOCK; i++)
+			{
+				pBlock[i].next = gpFreeListNodes;
+				gpFreeListNodes = &(pBlock[i]);
+			}
+		}
+		oListElement* pNode = gpFreeListNodes;
+		gpFreeListNodes = pNode->next;
+		pNode->prev = nullptr;
+		pNode->next = nullptr;
+		pNode->count = 0;
+		unlockListNodes();
+		TRACK_LINK_NEW;
+		return pNode;
+	}
+
+	void freeListNode(oListElement* pNode)
+	{
+		lockListNodes();
+		pNode->next = gpFreeListNodes;
+		gpFreeListNodes = pNode;
+		unlockListNodes();
+		TRACK_LINK_DELETE;
+	}
+
+	// links pNode into pList after pPrev, or at head of list if pPrev is null
+	void linkListNode(oListStruct* pList, oListElement* pNode, oListElement* pPrev)
+	{
+		oListElement* pNext = (pPrev == nullptr) ? pList->head : pPrev->next;
+		pNode->prev = pPrev;
+		pNode->next = pNext;
+		if (pPrev == nullptr)
+		{
+			pList->head = pNode;
+		}
+		else
+		{
+			pPrev->next = pNode;
+		}
+		if (pNext == nullptr)
+		{
+			pList->tail = pNode;
+		}
+		else
+		{
+			pNext->prev = pNode;
+		}
+	}
+
+	void unlinkListNode(oListStruct* pList, oListElement* pNode)
+	{
+		if (pNode->prev == nullptr)
+		{
+			pList->head = pNode->next;
+		}
+		else
+		{
+			pNode->prev->next = pNode->next;
+		}
+		if (pNode->next == nullptr)
+		{
+			pList->tail = pNode->prev;
+		}
+		else
+		{
+			pNode->next->prev = pNode->prev;
+		}
+		freeListNode(pNode);
+	}
+
+	// releases all objects in list and frees its nodes
+	void releaseListElements(oListStruct* pList, ForthCoreState* pCore)
+	{
+		pList->modCount++;
+		oListElement* pCur = pList->head;
+		while (pCur != NULL)
+		{
+			oListElement* pNext = pCur->next;
+			for (ucell i = 0; i < pCur->count; i++)
+			{
+				SAFE_RELEASE(pCore, pCur->objs[i]);
+			}
+			freeListNode(pCur);
+			pCur = pNext;
+		}
+		pList->head = NULL;
+		pList->tail = NULL;
+	}
+
+	// takes obj out of list without changing its refcount, returns the position after it in pNode/index
+	ForthObject listRemoveAt(oListStruct* pList, oListElement*& pNode, ucell& index)
+	{
+		ASSERT(index < pNode->count);
+		pList->modCount++;
+		ForthObject obj = pNode->objs[index];
+		ucell numAfter = pNode->count - (index + 1);
+		pNode->count--;
+		if (pNode->count == 0)
+		{
+			oListElement* pNext = pNode->next;
+			unlinkListNode(pList, pNode);
+			pNode = pNext;
+			index = 0;
+		}
+		else
+		{
+			ForthObject* pObjs = &(pNode->objs[0]);
+			memmove(pObjs + index, pObjs + index + 1, numAfter * sizeof(ForthObject));
+			if (index == pNode->count)
+			{
+				pNode = pNode->next;
+				index = 0;
+			}
+		}
+		return obj;
+	}
+
+	// finds first element at or after pNode/index which is soughtObj, returns false if not found
+	bool listFindFrom(ForthObject soughtObj, oListElement*& pNode, ucell& index)
+	{
+		ucell i = index;
+		for (oListElement* pCur = pNode; pCur != NULL; pCur = pCur->next)
+		{
+			for (; i < pCur->count; i++)
+			{
+				if (OBJECTS_SAME(pCur->objs[i], soughtObj))
+				{
+					pNode = pCur;
+					index = i;
+					return true;
+				}
+			}
+			i = 0;
+		}
+		return false;
+	}
+
+	void listAddTail(oListStruct* pList, ForthObject& obj, ForthCoreState* pCore)
+	{
+		SAFE_KEEP(obj);
+		oListElement* pTail = pList->tail;
+		if ((pTail == NULL) || (pTail->count == LIST_NODE_CAPACITY))
+		{
+			pTail = allocateListNode();
+			linkListNode(pList, pTail, pList->tail);
+		}
+		pTail->objs[pTail->count++] = obj;
+	}
+
+	void listAddHead(oListStruct* pList, ForthObject& obj, ForthCoreState* pCore)
+	{
+		SAFE_KEEP(obj);
+		oListElement* pHead = pList->head;
+		if ((pHead == NULL) || (pHead->count == LIST_NODE_CAPACITY))
+		{
+			pHead = allocateListNode();
+			linkListNode(pList, pHead, NULL);
+		}
+		else
+		{
+			memmove(&(pHead->objs[1]), &(pHead->objs[0]), pHead->count * sizeof(ForthObject));
+			pList->modCount++;
+		}
+		pHead->objs[0] = obj;
+		pHead->count++;
+	}
+
+	oListIterStruct* createListIterator(ForthCoreState* pCore, oListStruct* pList, oListElement* pNode, ucell index)
+	{
+		INCREMENT_REFCOUNT(pList);
+		TRACK_KEEP;
+		ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIListIter);
+		MALLOCATE_ITER(oListIterStruct, pIter, pIterVocab);
+		pIter->pMethods = pIterVocab->GetMethods();
+		pIter->refCount = 0;
+		pIter->parent = reinterpret_cast<ForthObject>(pList);
+		pIter->cursor = pNode;
+		pIter->index = index;
+		pIter->modCount = pList->modCount;
+		return pIter;
+	}
+
+	oListStruct* createListObject()
+	{
+		ForthClassVocabulary *pClassVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIList);
+		MALLOCATE_OBJECT(oListStruct, pList, pClassVocab);
+		pList->pMethods = pClassVocab->GetMethods();
+		pList->refCount = 0;
+		pList->head = NULL;
+		pList->tail = NULL;
+		pList->modCount = 0;
+		return pList;
+	}
+
 	//////////////////////////////////////////////////////////////////////
 	///
 	//                 List
@@ -35,6 +278,7 @@ namespace OList
 		pList->refCount = 0;
 		pList->head = NULL;
 		pList->tail = NULL;
+		pList->modCount = 0;
 		PUSH_OBJECT(pList);
 	}
 
@@ -42,14 +286,7 @@ namespace OList
 	{
 		// go through all elements and release any which are not null
 		GET_THIS(oListStruct, pList);
-		oListElement* pCur = pList->head;
-		while (pCur != NULL)
-		{
-			oListElement* pNext = pCur->next;
-			SAFE_RELEASE(pCore, pCur->obj);
-			FREE_LINK(pCur);
-			pCur = pNext;
-		}
+		releaseListElements(pList, pCore);
 		FREE_OBJECT(pList);
 		METHOD_RETURN;
 	}
@@ -57,16 +294,16 @@ namespace OList
 	FORTHOP(oListShowInnerMethod)
 	{
 		GET_THIS(oListStruct, pList);
-		oListElement* pCur = pList->head;
         GET_SHOW_CONTEXT;
         pShowContext->BeginElement("elements");
         pShowContext->BeginArray();
-		while (pCur != NULL)
+		for (oListElement* pCur = pList->head; pCur != NULL; pCur = pCur->next)
 		{
-            pShowContext->BeginArrayElement(1);
-            oListElement* pNext = pCur->next;
-			ForthShowObject(pCur->obj, pCore);
-            pCur = pNext;
+			for (ucell i = 0; i < pCur->count; i++)
+			{
+				pShowContext->BeginArrayElement(1);
+				ForthShowObject(pCur->objs[i], pCore);
+			}
 		}
         pShowContext->EndArray();
 		METHOD_RETURN;
@@ -75,14 +312,7 @@ namespace OList
     FORTHOP(oListHeadIterMethod)
     {
         GET_THIS(oListStruct, pList);
-        pList->refCount++;
-        TRACK_KEEP;
-        ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIListIter);
-        MALLOCATE_ITER(oListIterStruct, pIter, pIterVocab);
-        pIter->pMethods = pIterVocab->GetMethods();
-        pIter->refCount = 0;
-        pIter->parent = reinterpret_cast<ForthObject>(pList);
-        pIter->cursor = pList->head;
+        oListIterStruct* pIter = createListIterator(pCore, pList, pList->head, 0);
         PUSH_OBJECT(pIter);
         METHOD_RETURN;
     }
@@ -90,14 +320,7 @@ namespace OList
     FORTHOP(oListTailIterMethod)
     {
         GET_THIS(oListStruct, pList);
-        pList->refCount++;
-        TRACK_KEEP;
-        ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIListIter);
-        MALLOCATE_ITER(oListIterStruct, pIter, pIterVocab);
-        pIter->pMethods = pIterVocab->GetMethods();
-        pIter->refCount = 0;
-        pIter->parent = reinterpret_cast<ForthObject>(pList);
-        pIter->cursor = NULL;
+        oListIterStruct* pIter = createListIterator(pCore, pList, NULL, 0);
         PUSH_OBJECT(pIter);
         METHOD_RETURN;
     }
@@ -105,32 +328,17 @@ namespace OList
     FORTHOP(oListFindMethod)
     {
         GET_THIS(oListStruct, pList);
-        oListElement* pCur = pList->head;
         ForthObject soughtObj;
         POP_OBJECT(soughtObj);
-        while (pCur != NULL)
-        {
-            ForthObject& o = pCur->obj;
-            if (OBJECTS_SAME(o, soughtObj))
-            {
-                break;
-            }
-            pCur = pCur->next;
-        }
-        if (pCur == NULL)
+        oListElement* pCur = pList->head;
+        ucell index = 0;
+        if (!listFindFrom(soughtObj, pCur, index))
         {
             SPUSH(0);
         }
         else
         {
-            pList->refCount++;
-            TRACK_KEEP;
-            ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIListIter);
-            MALLOCATE_ITER(oListIterStruct, pIter, pIterVocab);
-            pIter->pMethods = pIterVocab->GetMethods();
-            pIter->refCount = 0;
-            pIter->parent = reinterpret_cast<ForthObject>(pList);
-            pIter->cursor = pCur;
+            oListIterStruct* pIter = createListIterator(pCore, pList, pCur, index);
             PUSH_OBJECT(pIter);
             SPUSH(~0);
         }
@@ -139,38 +347,19 @@ namespace OList
 
     FORTHOP(oListCloneMethod)
     {
-        // create an empty list
-        ForthClassVocabulary *pClassVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIList);
-        MALLOCATE_OBJECT(oListStruct, pCloneList, pClassVocab);
-        pCloneList->pMethods = pClassVocab->GetMethods();
-        pCloneList->refCount = 0;
-        pCloneList->head = NULL;
-        pCloneList->tail = NULL;
-        // go through all elements and add a reference to any which are not null and add to clone list
         GET_THIS(oListStruct, pList);
-        oListElement* pCur = pList->head;
-        oListElement* oldTail = NULL;
-        while (pCur != NULL)
+        oListStruct* pCloneList = createListObject();
+        // copy nodes whole, and add a reference to any elements which are not null
+        for (oListElement* pCur = pList->head; pCur != NULL; pCur = pCur->next)
         {
-            oListElement* pNext = pCur->next;
-            MALLOCATE_LINK(oListElement, newElem);
-            newElem->obj = pCur->obj;
-            SAFE_KEEP(newElem->obj);
-            if (oldTail == NULL)
-            {
-                pCloneList->head = newElem;
-            }
-            else
+            oListElement* pNewNode = allocateListNode();
+            pNewNode->count = pCur->count;
+            for (ucell i = 0; i < pCur->count; i++)
             {
-                oldTail->next = newElem;
+                pNewNode->objs[i] = pCur->objs[i];
+                SAFE_KEEP(pNewNode->objs[i]);
             }
-            newElem->prev = oldTail;
-            oldTail = newElem;
-            pCur = pNext;
-        }
-        if (oldTail != NULL)
-        {
-            oldTail->next = NULL;
+            linkListNode(pCloneList, pNewNode, pCloneList->tail);
         }
         PUSH_OBJECT(pCloneList);
         METHOD_RETURN;
@@ -180,11 +369,9 @@ namespace OList
     {
         GET_THIS(oListStruct, pList);
         long count = 0;
-        oListElement* pCur = pList->head;
-        while (pCur != NULL)
+        for (oListElement* pCur = pList->head; pCur != NULL; pCur = pCur->next)
         {
-            count++;
-            pCur = pCur->next;
+            count += (long) pCur->count;
         }
         SPUSH(count);
         METHOD_RETURN;
@@ -194,16 +381,7 @@ namespace OList
     {
         // go through all elements and release any which are not null
         GET_THIS(oListStruct, pList);
-        oListElement* pCur = pList->head;
-        while (pCur != NULL)
-        {
-            oListElement* pNext = pCur->next;
-            SAFE_RELEASE(pCore, pCur->obj);
-            FREE_LINK(pCur);
-            pCur = pNext;
-        }
-        pList->head = NULL;
-        pList->tail = NULL;
+        releaseListElements(pList, pCore);
         METHOD_RETURN;
     }
 
@@ -211,37 +389,14 @@ namespace OList
     {
         // go through all elements and release any which are not null
         GET_THIS(oListStruct, pList);
-        oListElement* pCur = pList->head;
-        while (pCur != NULL)
-        {
-            oListElement* pNext = pCur->next;
-            SAFE_RELEASE(pCore, pCur->obj);
-            FREE_LINK(pCur);
-            pCur = pNext;
-        }
-        pList->head = NULL;
-        pList->tail = NULL;
+        releaseListElements(pList, pCore);
 
         int n = SPOP;
         for (int i = 0; i < n; i++)
         {
-            MALLOCATE_LINK(oListElement, newElem);
-            POP_OBJECT(newElem->obj);
-            SAFE_KEEP(newElem->obj);
-            newElem->next = NULL;
-            oListElement* oldTail = pList->tail;
-            if (oldTail == NULL)
-            {
-                ASSERT(pList->head == NULL);
-                pList->head = newElem;
-            }
-            else
-            {
-                ASSERT(oldTail->next == NULL);
-                oldTail->next = newElem;
-            }
-            newElem->prev = oldTail;
-            pList->tail = newElem;
+            ForthObject obj;
+            POP_OBJECT(obj);
+            listAddTail(pList, obj, pCore);
         }
         METHOD_RETURN;
     }
@@ -249,19 +404,20 @@ namespace OList
     FORTHOP(oListToArrayMethod)
     {
         GET_THIS(oListStruct, pList);
-        oListElement* pCur = pList->head;
         ForthClassVocabulary *pArrayVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIArray);
         MALLOCATE_OBJECT(oArrayStruct, pArray, pArrayVocab);
         pArray->pMethods = pArrayVocab->GetMethods();
         pArray->refCount = 0;
         pArray->elements = new oArray;
 
-        while (pCur != NULL)
+        for (oListElement* pCur = pList->head; pCur != NULL; pCur = pCur->next)
         {
-            ForthObject& o = pCur->obj;
-            SAFE_KEEP(o);
-            pArray->elements->push_back(o);
-            pCur = pCur->next;
+            for (ucell i = 0; i < pCur->count; i++)
+            {
+                ForthObject& o = pCur->objs[i];
+                SAFE_KEEP(o);
+                pArray->elements->push_back(o);
+            }
         }
 
         // push array on TOS
@@ -292,7 +448,7 @@ namespace OList
 		}
 		else
 		{
-			PUSH_OBJECT(pList->head->obj);
+			PUSH_OBJECT(pList->head->objs[0]);
 		}
 		METHOD_RETURN;
 	}
@@ -307,7 +463,7 @@ namespace OList
 		}
 		else
 		{
-			PUSH_OBJECT(pList->tail->obj);
+			PUSH_OBJECT(pList->tail->objs[pList->tail->count - 1]);
 		}
 		METHOD_RETURN;
 	}
@@ -315,47 +471,12 @@ namespace OList
 	FORTHOP(oListAddHeadMethod)
 	{
 		GET_THIS(oListStruct, pList);
-		MALLOCATE_LINK(oListElement, newElem);
-		POP_OBJECT(newElem->obj);
-		SAFE_KEEP(newElem->obj);
-		newElem->prev = NULL;
-		oListElement* oldHead = pList->head;
-		if (oldHead == NULL)
-		{
-			ASSERT(pList->tail == NULL);
-			pList->tail = newElem;
-		}
-		else
-		{
-			ASSERT(oldHead->prev == NULL);
-			oldHead->prev = newElem;
-		}
-		newElem->next = oldHead;
-		pList->head = newElem;
+        ForthObject obj;
+        POP_OBJECT(obj);
+        listAddHead(pList, obj, pCore);
 		METHOD_RETURN;
 	}
 
-    void listAddTail(oListStruct* pList, ForthObject& obj, ForthCoreState* pCore)
-    {
-        MALLOCATE_LINK(oListElement, newElem);
-        newElem->obj = obj;
-        SAFE_KEEP(obj);
-        newElem->next = NULL;
-        oListElement* oldTail = pList->tail;
-        if (oldTail == NULL)
-        {
-            ASSERT(pList->head == NULL);
-            pList->head = newElem;
-        }
-        else
-        {
-            ASSERT(oldTail->next == NULL);
-            oldTail->next = newElem;
-        }
-        newElem->prev = oldTail;
-        pList->tail = newElem;
-    }
-
 	FORTHOP(oListAddTailMethod)
 	{
 		GET_THIS(oListStruct, pList);
@@ -368,26 +489,12 @@ namespace OList
 	FORTHOP(oListRemoveHeadMethod)
 	{
 		GET_THIS(oListStruct, pList);
-		oListElement* oldHead = pList->head;
-		if (oldHead != NULL)
+		oListElement* pNode = pList->head;
+		if (pNode != NULL)
 		{
-			ForthObject& obj = oldHead->obj;
-			if (oldHead == pList->tail)
-			{
-				// removed only element in list
-				pList->head = NULL;
-				pList->tail = NULL;
-			}
-			else
-			{
-				ASSERT(oldHead->prev == NULL);
-				oListElement* newHead = oldHead->next;
-				ASSERT(newHead != NULL);
-				newHead->prev = NULL;
-				pList->head = newHead;
-			}
+			ucell index = 0;
+			ForthObject obj = listRemoveAt(pList, pNode, index);
 			SAFE_RELEASE(pCore, obj);
-			FREE_LINK(oldHead);
 		}
 		METHOD_RETURN;
 	}
@@ -395,26 +502,12 @@ namespace OList
 	FORTHOP(oListRemoveTailMethod)
 	{
 		GET_THIS(oListStruct, pList);
-		oListElement* oldTail = pList->tail;
-		if (oldTail != NULL)
+		oListElement* pNode = pList->tail;
+		if (pNode != NULL)
 		{
-			ForthObject& obj = oldTail->obj;
-			if (pList->head == oldTail)
-			{
-				// removed only element in list
-				pList->head = NULL;
-				pList->tail = NULL;
-			}
-			else
-			{
-				ASSERT(oldTail->next == NULL);
-				oListElement* newTail = oldTail->prev;
-				ASSERT(newTail != NULL);
-				newTail->next = NULL;
-				pList->tail = newTail;
-			}
+			ucell index = pNode->count - 1;
+			ForthObject obj = listRemoveAt(pList, pNode, index);
 			SAFE_RELEASE(pCore, obj);
-			FREE_LINK(oldTail);
 		}
 		METHOD_RETURN;
 	}
@@ -422,32 +515,18 @@ namespace OList
 	FORTHOP(oListUnrefHeadMethod)
 	{
 		GET_THIS(oListStruct, pList);
-		oListElement* oldHead = pList->head;
-		if (oldHead == NULL)
+		oListElement* pNode = pList->head;
+		if (pNode == NULL)
 		{
 			ASSERT(pList->tail == NULL);
 			PUSH_OBJECT(nullptr);
 		}
 		else
 		{
-			ForthObject& obj = oldHead->obj;
-			if (oldHead == pList->tail)
-			{
-				// removed only element in list
-				pList->head = NULL;
-				pList->tail = NULL;
-			}
-			else
-			{
-				ASSERT(oldHead->prev == NULL);
-				oListElement* newHead = oldHead->next;
-				ASSERT(newHead != NULL);
-				newHead->prev = NULL;
-				pList->head = newHead;
-			}
+			ucell index = 0;
+			ForthObject obj = listRemoveAt(pList, pNode, index);
 			unrefObject(obj);
 			PUSH_OBJECT(obj);
-			FREE_LINK(oldHead);
 		}
 		METHOD_RETURN;
 	}
@@ -455,32 +534,18 @@ namespace OList
 	FORTHOP(oListUnrefTailMethod)
 	{
 		GET_THIS(oListStruct, pList);
-		oListElement* oldTail = pList->tail;
-		if (oldTail == NULL)
+		oListElement* pNode = pList->tail;
+		if (pNode == NULL)
 		{
 			ASSERT(pList->head == NULL);
 			PUSH_OBJECT(nullptr);
 		}
 		else
 		{
-			ForthObject& obj = oldTail->obj;
-			if (pList->head == oldTail)
-			{
-				// removed only element in list
-				pList->head = NULL;
-				pList->tail = NULL;
-			}
-			else
-			{
-				ASSERT(oldTail->next == NULL);
-				oListElement* newTail = oldTail->prev;
-				ASSERT(newTail != NULL);
-				newTail->next = NULL;
-				pList->tail = newTail;
-			}
+			ucell index = pNode->count - 1;
+			ForthObject obj = listRemoveAt(pList, pNode, index);
 			unrefObject(obj);
 			PUSH_OBJECT(obj);
-			FREE_LINK(oldTail);
 		}
 		METHOD_RETURN;
 	}
@@ -503,40 +568,14 @@ namespace OList
 	FORTHOP(oListRemoveMethod)
 	{
 		GET_THIS(oListStruct, pList);
-		oListElement* pCur = pList->head;
 		ForthObject soughtObj;
 		POP_OBJECT(soughtObj);
-		while (pCur != NULL)
+		oListElement* pNode = pList->head;
+		ucell index = 0;
+		if (listFindFrom(soughtObj, pNode, index))
 		{
-			ForthObject& o = pCur->obj;
-			if (OBJECTS_SAME(o, soughtObj))
-			{
-				break;
-			}
-			pCur = pCur->next;
-		}
-		if (pCur != NULL)
-		{
-			oListElement* pPrev = pCur->prev;
-			oListElement* pNext = pCur->next;
-			if (pCur == pList->head)
-			{
-				pList->head = pNext;
-			}
-			if (pCur == pList->tail)
-			{
-				pList->tail = pPrev;
-			}
-			if (pNext != NULL)
-			{
-				pNext->prev = pPrev;
-			}
-			if (pPrev != NULL)
-			{
-				pPrev->next = pNext;
-			}
-			SAFE_RELEASE(pCore, pCur->obj);
-			FREE_LINK(pCur);
+			ForthObject obj = listRemoveAt(pList, pNode, index);
+			SAFE_RELEASE(pCore, obj);
 		}
 		METHOD_RETURN;
 	}
@@ -569,6 +608,7 @@ namespace OList
 
 		MEMBER_VAR("__head", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
 		MEMBER_VAR("__tail", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+		MEMBER_VAR("__modCount", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
 		// following must be last in table
 		END_MEMBERS
@@ -580,6 +620,23 @@ namespace OList
 	//                 ListIter
 	//
 
+	// call before using the cursor, a stale iterator is moved past the tail of its list
+	inline void iterValidate(oListIterStruct* pIter)
+	{
+		oListStruct* pList = reinterpret_cast<oListStruct *>(pIter->parent);
+		if (pIter->modCount != pList->modCount)
+		{
+			pIter->cursor = NULL;
+			pIter->index = 0;
+			pIter->modCount = pList->modCount;
+		}
+		else if ((pIter->cursor != NULL) && (pIter->index >= pIter->cursor->count))
+		{
+			pIter->cursor = pIter->cursor->next;
+			pIter->index = 0;
+		}
+	}
+
 	FORTHOP(oListIterNew)
 	{
 		ForthEngine *pEngine = ForthEngine::GetInstance();
@@ -597,23 +654,25 @@ namespace OList
 	FORTHOP(oListIterShowInnerMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
+		iterValidate(pIter);
         char buffer[32];
 		ForthEngine *pEngine = ForthEngine::GetInstance();
         GET_SHOW_CONTEXT;
         oListElement* pCur = reinterpret_cast<oListStruct *>(pIter->parent)->head;
-        int cursor = 0;
+        long cursor = 0;
         while (pCur != NULL)
         {
             if (pCur == pIter->cursor)
             {
+                cursor += (long) pIter->index;
                 break;
             }
-            cursor++;
+            cursor += (long) pCur->count;
             pCur = pCur->next;
         }
 
         pShowContext->BeginElement("cursor");
-        sprintf(buffer, "%d", cursor);
+        sprintf(buffer, "%ld", cursor);
         pShowContext->ShowText(buffer);
         pShowContext->EndElement();
         pShowContext->BeginElement("parent");
@@ -622,34 +681,61 @@ namespace OList
 		METHOD_RETURN;
 	}
 
-	FORTHOP(oListIterSeekNextMethod)
+	inline void iterStepForward(oListIterStruct* pIter)
 	{
-		GET_THIS(oListIterStruct, pIter);
-		if (pIter->cursor != NULL)
+		pIter->index++;
+		if (pIter->index >= pIter->cursor->count)
 		{
 			pIter->cursor = pIter->cursor->next;
+			pIter->index = 0;
 		}
-		METHOD_RETURN;
 	}
 
-	FORTHOP(oListIterSeekPrevMethod)
+	// moving back from the head of the list leaves the cursor past the tail
+	inline void iterStepBack(oListIterStruct* pIter)
 	{
-		GET_THIS(oListIterStruct, pIter);
-		if (pIter->cursor != NULL)
+		if (pIter->cursor == NULL)
 		{
-			pIter->cursor = pIter->cursor->prev;
+			pIter->cursor = reinterpret_cast<oListStruct *>(pIter->parent)->tail;
+			pIter->index = (pIter->cursor == NULL) ? 0 : pIter->cursor->count - 1;
+		}
+		else if (pIter->index > 0)
+		{
+			pIter->index--;
 		}
 		else
 		{
-			pIter->cursor = reinterpret_cast<oListStruct *>(pIter->parent)->tail;
+			pIter->cursor = pIter->cursor->prev;
+			pIter->index = (pIter->cursor == NULL) ? 0 : pIter->cursor->count - 1;
+		}
+	}
+
+	FORTHOP(oListIterSeekNextMethod)
+	{
+		GET_THIS(oListIterStruct, pIter);
+		iterValidate(pIter);
+		if (pIter->cursor != NULL)
+		{
+			iterStepForward(pIter);
 		}
 		METHOD_RETURN;
 	}
 
+	FORTHOP(oListIterSeekPrevMethod)
+	{
+		GET_THIS(oListIterStruct, pIter);
+		iterValidate(pIter);
+		iterStepBack(pIter);
+		METHOD_RETURN;
+	}
+
 	FORTHOP(oListIterSeekHeadMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
-		pIter->cursor = reinterpret_cast<oListStruct *>(pIter->parent)->head;
+		oListStruct* pList = reinterpret_cast<oListStruct *>(pIter->parent);
+		pIter->cursor = pList->head;
+		pIter->index = 0;
+		pIter->modCount = pList->modCount;
 		METHOD_RETURN;
 	}
 
@@ -657,13 +743,16 @@ namespace OList
 	{
 		GET_THIS(oListIterStruct, pIter);
 		pIter->cursor = NULL;
+		pIter->index = 0;
+		pIter->modCount = reinterpret_cast<oListStruct *>(pIter->parent)->modCount;
 		METHOD_RETURN;
 	}
 
     FORTHOP(oListIterAtHeadMethod)
     {
         GET_THIS(oListIterStruct, pIter);
-        long retVal = (pIter->cursor = reinterpret_cast<oListStruct *>(pIter->parent)->head) ? ~0 : 0;
+        iterValidate(pIter);
+        long retVal = ((pIter->cursor == reinterpret_cast<oListStruct *>(pIter->parent)->head) && (pIter->index == 0)) ? ~0 : 0;
         SPUSH(retVal);
         METHOD_RETURN;
     }
@@ -671,6 +760,7 @@ namespace OList
     FORTHOP(oListIterAtTailMethod)
     {
         GET_THIS(oListIterStruct, pIter);
+        iterValidate(pIter);
         long retVal = (pIter->cursor == nullptr) ? ~0 : 0;
         SPUSH(retVal);
         METHOD_RETURN;
@@ -679,14 +769,15 @@ namespace OList
 	FORTHOP(oListIterNextMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
+		iterValidate(pIter);
 		if (pIter->cursor == NULL)
 		{
 			SPUSH(0);
 		}
 		else
 		{
-			PUSH_OBJECT(pIter->cursor->obj);
-			pIter->cursor = pIter->cursor->next;
+			PUSH_OBJECT(pIter->cursor->objs[pIter->index]);
+			iterStepForward(pIter);
 			SPUSH(~0);
 		}
 		METHOD_RETURN;
@@ -695,22 +786,16 @@ namespace OList
 	FORTHOP(oListIterPrevMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
+		iterValidate(pIter);
 		// special case: NULL cursor means tail of list
-		if (pIter->cursor == NULL)
-		{
-			pIter->cursor = reinterpret_cast<oListStruct *>(pIter->parent)->tail;
-		}
-		else
-		{
-			pIter->cursor = pIter->cursor->prev;
-		}
+		iterStepBack(pIter);
 		if (pIter->cursor == NULL)
 		{
 			SPUSH(0);
 		}
 		else
 		{
-			PUSH_OBJECT(pIter->cursor->obj);
+			PUSH_OBJECT(pIter->cursor->objs[pIter->index]);
 			SPUSH(~0);
 		}
 		METHOD_RETURN;
@@ -719,13 +804,14 @@ namespace OList
 	FORTHOP(oListIterCurrentMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
+		iterValidate(pIter);
 		if (pIter->cursor == NULL)
 		{
 			SPUSH(0);
 		}
 		else
 		{
-			PUSH_OBJECT(pIter->cursor->obj);
+			PUSH_OBJECT(pIter->cursor->objs[pIter->index]);
 			SPUSH(~0);
 		}
 		METHOD_RETURN;
@@ -734,31 +820,13 @@ namespace OList
 	FORTHOP(oListIterRemoveMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
-		oListElement* pCur = pIter->cursor;
-		if (pCur != NULL)
+		iterValidate(pIter);
+		if (pIter->cursor != NULL)
 		{
 			oListStruct* pList = reinterpret_cast<oListStruct *>(pIter->parent);
-			oListElement* pPrev = pCur->prev;
-			oListElement* pNext = pCur->next;
-			if (pCur == pList->head)
-			{
-				pList->head = pNext;
-			}
-			if (pCur == pList->tail)
-			{
-				pList->tail = pPrev;
-			}
-			if (pNext != NULL)
-			{
-				pNext->prev = pPrev;
-			}
-			if (pPrev != NULL)
-			{
-				pPrev->next = pNext;
-			}
-			pIter->cursor = pNext;
-			SAFE_RELEASE(pCore, pCur->obj);
-			FREE_LINK(pCur);
+			ForthObject obj = listRemoveAt(pList, pIter->cursor, pIter->index);
+			pIter->modCount = pList->modCount;
+			SAFE_RELEASE(pCore, obj);
 		}
 		METHOD_RETURN;
 	}
@@ -766,32 +834,14 @@ namespace OList
 	FORTHOP(oListIterUnrefMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
-		oListElement* pCur = pIter->cursor;
-		if (pCur != NULL)
+		iterValidate(pIter);
+		if (pIter->cursor != NULL)
 		{
 			oListStruct* pList = reinterpret_cast<oListStruct *>(pIter->parent);
-			oListElement* pPrev = pCur->prev;
-			oListElement* pNext = pCur->next;
-			if (pCur == pList->head)
-			{
-				pList->head = pNext;
-			}
-			if (pCur == pList->tail)
-			{
-				pList->tail = pPrev;
-			}
-			if (pNext != NULL)
-			{
-				pNext->prev = pPrev;
-			}
-			if (pPrev != NULL)
-			{
-				pPrev->next = pNext;
-			}
-			pIter->cursor = pNext;
-			PUSH_OBJECT(pCur->obj);
-			unrefObject(pCur->obj);
-			FREE_LINK(pCur);
+			ForthObject obj = listRemoveAt(pList, pIter->cursor, pIter->index);
+			pIter->modCount = pList->modCount;
+			PUSH_OBJECT(obj);
+			unrefObject(obj);
 		}
 		METHOD_RETURN;
 	}
@@ -799,24 +849,21 @@ namespace OList
 	FORTHOP(oListIterFindNextMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
-		oListElement* pCur = pIter->cursor;
+		iterValidate(pIter);
         long found = 0;
 		ForthObject soughtObj;
 		POP_OBJECT(soughtObj);
-		if (pCur != NULL)
-		{
-			pCur = pCur->next;
-		}
-		while (pCur != NULL)
+		if (pIter->cursor != NULL)
 		{
-			ForthObject& o = pCur->obj;
-			if (OBJECTS_SAME(o, soughtObj))
+			// search starts after current element
+			oListElement* pNode = pIter->cursor;
+			ucell index = pIter->index + 1;
+			if (listFindFrom(soughtObj, pNode, index))
 			{
-                pIter->cursor = pCur;
-                found = ~0;
-                break;
+				pIter->cursor = pNode;
+				pIter->index = index;
+				found = ~0;
 			}
-			pCur = pCur->next;
 		}
 		SPUSH(found);
 		METHOD_RETURN;
@@ -825,16 +872,24 @@ namespace OList
     FORTHOP(oListIterSwapNextMethod)
     {
         GET_THIS(oListIterStruct, pIter);
+        iterValidate(pIter);
         oListElement* pCursor = pIter->cursor;
         if (pCursor != NULL)
         {
-            oListElement* pNext = pCursor->next;
-            if (pNext != NULL)
+            ForthObject* pNextObj = nullptr;
+            if ((pIter->index + 1) < pCursor->count)
+            {
+                pNextObj = &(pCursor->objs[pIter->index + 1]);
+            }
+            else if (pCursor->next != NULL)
+            {
+                pNextObj = &(pCursor->next->objs[0]);
+            }
+            if (pNextObj != nullptr)
             {
-                ForthObject nextObj = pNext->obj;
-                ForthObject obj = pCursor->obj;
-                pCursor->obj = nextObj;
-                pNext->obj = obj;
+                ForthObject obj = pCursor->objs[pIter->index];
+                pCursor->objs[pIter->index] = *pNextObj;
+                *pNextObj = obj;
             }
         }
         METHOD_RETURN;
@@ -843,16 +898,24 @@ namespace OList
     FORTHOP(oListIterSwapPrevMethod)
     {
         GET_THIS(oListIterStruct, pIter);
+        iterValidate(pIter);
         oListElement* pCursor = pIter->cursor;
         if (pCursor != NULL)
         {
-            oListElement* pPrev = pCursor->prev;
-            if (pPrev != NULL)
+            ForthObject* pPrevObj = nullptr;
+            if (pIter->index > 0)
             {
-                ForthObject prevObj = pPrev->obj;
-                ForthObject obj = pCursor->obj;
-                pCursor->obj = prevObj;
-                pPrev->obj = obj;
+                pPrevObj = &(pCursor->objs[pIter->index - 1]);
+            }
+            else if (pCursor->prev != NULL)
+            {
+                pPrevObj = &(pCursor->prev->objs[pCursor->prev->count - 1]);
+            }
+            if (pPrevObj != nullptr)
+            {
+                ForthObject obj = pCursor->objs[pIter->index];
+                pCursor->objs[pIter->index] = *pPrevObj;
+                *pPrevObj = obj;
             }
         }
         METHOD_RETURN;
@@ -861,20 +924,27 @@ namespace OList
     FORTHOP(oListIterSplitMethod)
 	{
 		GET_THIS(oListIterStruct, pIter);
+		iterValidate(pIter);
 
 		// create an empty list
-		ForthClassVocabulary *pClassVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIList);
-		MALLOCATE_OBJECT(oListStruct, pNewList, pClassVocab);
-        pNewList->pMethods = pClassVocab->GetMethods();
-        pNewList->refCount = 0;
-        pNewList->head = NULL;
-		pNewList->tail = NULL;
+		oListStruct* pNewList = createListObject();
 
 		oListElement* pCursor = pIter->cursor;
 		oListStruct* pOldList = reinterpret_cast<oListStruct *>(pIter->parent);
 		// if pCursor is NULL, iter cursor is past tail, new list is just empty list, leave old list alone
 		if (pCursor != NULL)
 		{
+			pOldList->modCount++;
+			if (pIter->index != 0)
+			{
+				// move the part of the cursor node from the cursor on into a new node
+				oListElement* pSplitNode = allocateListNode();
+				pSplitNode->count = pCursor->count - pIter->index;
+				memcpy(&(pSplitNode->objs[0]), &(pCursor->objs[pIter->index]), pSplitNode->count * sizeof(ForthObject));
+				pCursor->count = pIter->index;
+				linkListNode(pOldList, pSplitNode, pCursor);
+				pCursor = pSplitNode;
+			}
 			if (pCursor == pOldList->head)
 			{
 				// iter cursor is start of list, make old list empty, new list is entire old list
@@ -889,13 +959,16 @@ namespace OList
 				pNewList->head = pCursor;
 				pNewList->tail = pOldList->tail;
 				// fix old list tail
-				pOldList->tail = pNewList->head->prev;
+				pOldList->tail = pCursor->prev;
 				pOldList->tail->next = NULL;
+				pCursor->prev = NULL;
 			}
 		}
 
 		// split leaves iter cursor past tail
 		pIter->cursor = NULL;
+		pIter->index = 0;
+		pIter->modCount = pOldList->modCount;
 
 		PUSH_OBJECT(pNewList);
 		METHOD_RETURN;
@@ -927,11 +1000,63 @@ namespace OList
 
 		MEMBER_VAR("parent", OBJECT_TYPE_TO_CODE(0, kBCIList)),
 		MEMBER_VAR("__cursor", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+		MEMBER_VAR("__index", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
+		MEMBER_VAR("__modCount", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
 		// following must be last in table
 		END_MEMBERS
 	};
 
+    void listChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        for (oListElement* pCur = reinterpret_cast<oListStruct*>(obj)->head; pCur != nullptr; pCur = pCur->next)
+        {
+            for (ucell i = 0; i < pCur->count; i++)
+            {
+                if (pCur->objs[i] != nullptr)
+                {
+                    visitor(pCur->objs[i], pUserData);
+                }
+            }
+        }
+    }
+
+    void listBinaryWriter(ForthObject& obj, ForthBinaryWriter* writer)
+    {
+        oListStruct* pList = reinterpret_cast<oListStruct*>(obj);
+        uint64_t numElements = 0;
+        for (oListElement* pCur = pList->head; pCur != nullptr; pCur = pCur->next)
+        {
+            numElements += pCur->count;
+        }
+        writer->WriteU64(numElements);
+        for (oListElement* pCur = pList->head; pCur != nullptr; pCur = pCur->next)
+        {
+            for (ucell i = 0; i < pCur->count; i++)
+            {
+                writer->WriteObjectRef(pCur->objs[i]);
+            }
+        }
+    }
+
+    void listBinaryReader(ForthObject& obj, ForthBinaryReader* reader)
+    {
+        oListStruct* pList = reinterpret_cast<oListStruct*>(obj);
+        uint64_t numElements = reader->ReadU64();
+        reader->CheckCount(numElements, sizeof(uint32_t));
+        for (uint64_t i = 0; i < numElements; i++)
+        {
+            ForthObject elementObj;
+            reader->ReadObjectRef(elementObj);
+            listAddTail(pList, elementObj, reader->GetCoreState());
+            // listAddTail added its own reference
+            if (elementObj != nullptr)
+            {
+                DECREMENT_REFCOUNT(elementObj);
+            }
+        }
+    }
+
     bool customListReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "elements")
@@ -963,8 +1088,16 @@ namespace OList
 
 	void AddClasses(ForthEngine* pEngine)
 	{
+#if defined(WINDOWS_BUILD)
+		InitializeCriticalSection(&gListNodeLock);
+#else
+		pthread_mutex_init(&gListNodeLock, nullptr);
+#endif
+
 		ForthClassVocabulary* pListVoc = pEngine->AddBuiltinClass("List", kBCIList, kBCIIterable, oListMembers);
         pListVoc->SetCustomObjectReader(customListReader);
+        pListVoc->SetCustomChildVisitor(listChildVisitor);
+        pListVoc->SetCustomBinarySerializer(listBinaryWriter, listBinaryReader);
 
 		pEngine->AddBuiltinClass("ListIter", kBCIListIter, kBCIIter, oListIterMembers);
 	}
@@ -10,13 +10,20 @@ class ForthClassVocabulary;
 
 namespace OList
 {
+	// cursor is at cursor->objs[index], a null cursor is past the tail of the list
+	// the iterator is stale if modCount doesn't match its list's modCount
 	struct oListIterStruct
 	{
         forthop*        pMethods;
         ucell           refCount;
 		ForthObject		parent;
 		oListElement*	cursor;
+		ucell			index;
+		ucell			modCount;
 	};
 
 	void AddClasses(ForthEngine* pEngine);
-}
\ No newline at end of file
+
+	// adds a reference to obj and appends it to pList
+	void listAddTail(oListStruct* pList, ForthObject& obj, ForthCoreState* pCore);
+}
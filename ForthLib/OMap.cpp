@@ -79,6 +79,23 @@ namespace OMap
         }
     }
 
+    void mapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oMapStruct* pMap = reinterpret_cast<oMapStruct*>(obj);
+        for (oMap::iterator iter = pMap->elements->begin(); iter != pMap->elements->end(); ++iter)
+        {
+            ForthObject key = iter->first;
+            if (key != nullptr)
+            {
+                visitor(key, pUserData);
+            }
+            if (iter->second != nullptr)
+            {
+                visitor(iter->second, pUserData);
+            }
+        }
+    }
+
     bool customMapReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "__keys")
@@ -136,10 +153,7 @@ namespace OMap
     oMapIterStruct* createMapIterator(ForthCoreState* pCore, oMapStruct* pMap)
     {
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIMapIter);
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oMapIterStruct* pIter = new oMapIterStruct;
-        TRACK_ITER_NEW;
+        MALLOCATE_ITER(oMapIterStruct, pIter, pIterVocab);
         pIter->pMethods = pIterVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -226,7 +240,7 @@ namespace OMap
     FORTHOP(oMapHeadIterMethod)
     {
         GET_THIS(oMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
         oMapIterStruct* pIter = createMapIterator(pCore, pMap);
         *(pIter->cursor) = pMap->elements->begin();
@@ -238,7 +252,7 @@ namespace OMap
     FORTHOP(oMapTailIterMethod)
     {
         GET_THIS(oMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oMapIterStruct* pIter = createMapIterator(pCore, pMap);
@@ -259,7 +273,7 @@ namespace OMap
         oMap::iterator iter = a.find(key);
         if (iter != a.end())
         {
-            pMap->refCount++;
+            INCREMENT_REFCOUNT(pMap);
             TRACK_KEEP;
             oMapIterStruct* pIter = createMapIterator(pCore, pMap);
             *(pIter->cursor) = iter;
@@ -462,8 +476,7 @@ namespace OMap
 		GET_THIS(oMapIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
 		delete pIter->cursor;
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -684,6 +697,18 @@ namespace OMap
         }
     }
 
+    void intMapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oIntMapStruct* pMap = reinterpret_cast<oIntMapStruct*>(obj);
+        for (oIntMap::iterator iter = pMap->elements->begin(); iter != pMap->elements->end(); ++iter)
+        {
+            if (iter->second != nullptr)
+            {
+                visitor(iter->second, pUserData);
+            }
+        }
+    }
+
     bool customIntMapReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "map")
@@ -720,10 +745,7 @@ namespace OMap
     oIntMapIterStruct* createIntMapIterator(ForthCoreState* pCore, oIntMapStruct* pMap)
     {
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIIntMapIter);
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oIntMapIterStruct* pIter = new oIntMapIterStruct;
-        TRACK_ITER_NEW;
+        MALLOCATE_ITER(oIntMapIterStruct, pIter, pIterVocab);
         pIter->pMethods = pIterVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -791,7 +813,7 @@ namespace OMap
     FORTHOP(oIntMapHeadIterMethod)
     {
         GET_THIS(oIntMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oIntMapIterStruct* pIter = createIntMapIterator(pCore, pMap);
@@ -804,7 +826,7 @@ namespace OMap
     FORTHOP(oIntMapTailIterMethod)
     {
         GET_THIS(oIntMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
         oIntMapIterStruct* pIter = createIntMapIterator(pCore, pMap);
         *(pIter->cursor) = pMap->elements->end();
@@ -823,7 +845,7 @@ namespace OMap
         oIntMap::iterator iter = a.find(key);
         if (iter != a.end())
         {
-            pMap->refCount++;
+            INCREMENT_REFCOUNT(pMap);
             TRACK_KEEP;
             oIntMapIterStruct* pIter = createIntMapIterator(pCore, pMap);
             *(pIter->cursor) = iter;
@@ -1012,8 +1034,7 @@ namespace OMap
 		GET_THIS(oIntMapIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
 		delete pIter->cursor;
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -1232,6 +1253,18 @@ namespace OMap
         }
     }
 
+    void floatMapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oFloatMapStruct* pMap = reinterpret_cast<oFloatMapStruct*>(obj);
+        for (oFloatMap::iterator iter = pMap->elements->begin(); iter != pMap->elements->end(); ++iter)
+        {
+            if (iter->second != nullptr)
+            {
+                visitor(iter->second, pUserData);
+            }
+        }
+    }
+
     bool customFloatMapReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "map")
@@ -1268,10 +1301,7 @@ namespace OMap
     oFloatMapIterStruct* createFloatMapIterator(ForthCoreState* pCore, oFloatMapStruct* pMap)
     {
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIFloatMapIter);
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oFloatMapIterStruct* pIter = new oFloatMapIterStruct;
-        TRACK_ITER_NEW;
+        MALLOCATE_ITER(oFloatMapIterStruct, pIter, pIterVocab);
         pIter->pMethods = pIterVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -1323,7 +1353,7 @@ namespace OMap
     FORTHOP(oFloatMapHeadIterMethod)
     {
         GET_THIS(oFloatMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oFloatMapIterStruct* pIter = createFloatMapIterator(pCore, pMap);
@@ -1336,7 +1366,7 @@ namespace OMap
     FORTHOP(oFloatMapTailIterMethod)
     {
         GET_THIS(oFloatMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
         oFloatMapIterStruct* pIter = createFloatMapIterator(pCore, pMap);
         *(pIter->cursor) = pMap->elements->end();
@@ -1355,7 +1385,7 @@ namespace OMap
         oFloatMap::iterator iter = a.find(key);
         if (iter != a.end())
         {
-            pMap->refCount++;
+            INCREMENT_REFCOUNT(pMap);
             TRACK_KEEP;
             oFloatMapIterStruct* pIter = createFloatMapIterator(pCore, pMap);
             *(pIter->cursor) = iter;
@@ -1551,6 +1581,18 @@ namespace OMap
         }
     }
 
+    void longMapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oLongMapStruct* pMap = reinterpret_cast<oLongMapStruct*>(obj);
+        for (oLongMap::iterator iter = pMap->elements->begin(); iter != pMap->elements->end(); ++iter)
+        {
+            if (iter->second != nullptr)
+            {
+                visitor(iter->second, pUserData);
+            }
+        }
+    }
+
     bool customLongMapReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "map")
@@ -1587,10 +1629,7 @@ namespace OMap
     oLongMapIterStruct* createLongMapIterator(ForthCoreState* pCore, oLongMapStruct* pMap)
     {
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCILongMapIter);
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oLongMapIterStruct* pIter = new oLongMapIterStruct;
-        TRACK_ITER_NEW;
+        MALLOCATE_ITER(oLongMapIterStruct, pIter, pIterVocab);
         pIter->pMethods = pIterVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -1655,7 +1694,7 @@ namespace OMap
     FORTHOP(oLongMapHeadIterMethod)
     {
         GET_THIS(oLongMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oLongMapIterStruct* pIter = createLongMapIterator(pCore, pMap);
@@ -1668,7 +1707,7 @@ namespace OMap
     FORTHOP(oLongMapTailIterMethod)
     {
         GET_THIS(oLongMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
         oLongMapIterStruct* pIter = createLongMapIterator(pCore, pMap);
         *(pIter->cursor) = pMap->elements->end();
@@ -1688,7 +1727,7 @@ namespace OMap
         oLongMap::iterator iter = a.find(key.s64);
         if (iter != a.end())
         {
-            pMap->refCount++;
+            INCREMENT_REFCOUNT(pMap);
             TRACK_KEEP;
             oLongMapIterStruct* pIter = createLongMapIterator(pCore, pMap);
             *(pIter->cursor) = iter;
@@ -1884,8 +1923,7 @@ namespace OMap
 		GET_THIS(oLongMapIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
 		delete pIter->cursor;
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -2106,6 +2144,18 @@ namespace OMap
         }
     }
 
+    void doubleMapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oDoubleMapStruct* pMap = reinterpret_cast<oDoubleMapStruct*>(obj);
+        for (oDoubleMap::iterator iter = pMap->elements->begin(); iter != pMap->elements->end(); ++iter)
+        {
+            if (iter->second != nullptr)
+            {
+                visitor(iter->second, pUserData);
+            }
+        }
+    }
+
     bool customDoubleMapReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "map")
@@ -2142,10 +2192,7 @@ namespace OMap
     oDoubleMapIterStruct* createDoubleMapIterator(ForthCoreState* pCore, oDoubleMapStruct* pMap, ForthObject& obj)
     {
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIDoubleMapIter);
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oDoubleMapIterStruct* pIter = new oDoubleMapIterStruct;
-        TRACK_ITER_NEW;
+        MALLOCATE_ITER(oDoubleMapIterStruct, pIter, pIterVocab);
         pIter->pMethods = pIterVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -2213,7 +2260,7 @@ namespace OMap
     FORTHOP(oDoubleMapHeadIterMethod)
     {
         GET_THIS(oDoubleMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
         ForthObject obj;
 
@@ -2227,7 +2274,7 @@ namespace OMap
     FORTHOP(oDoubleMapTailIterMethod)
     {
         GET_THIS(oDoubleMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
         ForthObject obj;
 
@@ -2248,7 +2295,7 @@ namespace OMap
         oDoubleMap::iterator iter = a.find(key);
         if (iter != a.end())
         {
-            pMap->refCount++;
+            INCREMENT_REFCOUNT(pMap);
             TRACK_KEEP;
             ForthObject obj;
 
@@ -2439,8 +2486,7 @@ namespace OMap
 		GET_THIS(oDoubleMapIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
 		delete pIter->cursor;
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -2664,10 +2710,7 @@ namespace OMap
     oStringIntMapIterStruct* createStringIntMapIterator(ForthCoreState* pCore, oStringIntMapStruct* pMap)
     {
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIStringIntMapIter);
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oStringIntMapIterStruct* pIter = new oStringIntMapIterStruct;
-        TRACK_ITER_NEW;
+        MALLOCATE_ITER(oStringIntMapIterStruct, pIter, pIterVocab);
         pIter->pMethods = pIterVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -2726,7 +2769,7 @@ namespace OMap
     FORTHOP(oStringIntMapHeadIterMethod)
     {
         GET_THIS(oStringIntMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oStringIntMapIterStruct* pIter = createStringIntMapIterator(pCore, pMap);
@@ -2739,7 +2782,7 @@ namespace OMap
     FORTHOP(oStringIntMapTailIterMethod)
     {
         GET_THIS(oStringIntMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oStringIntMapIterStruct* pIter = createStringIntMapIterator(pCore, pMap);
@@ -2760,7 +2803,7 @@ namespace OMap
         oStringIntMap::iterator iter = a.find(key);
         if (iter != a.end())
         {
-            pMap->refCount++;
+            INCREMENT_REFCOUNT(pMap);
             TRACK_KEEP;
 
             oStringIntMapIterStruct* pIter = createStringIntMapIterator(pCore, pMap);
@@ -2915,8 +2958,7 @@ namespace OMap
 		GET_THIS(oStringIntMapIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
 		delete pIter->cursor;
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -3217,10 +3259,7 @@ namespace OMap
     oStringLongMapIterStruct* createStringLongMapIterator(ForthCoreState* pCore, oStringLongMapStruct* pMap)
     {
         ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(kBCIStringLongMapIter);
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oStringLongMapIterStruct* pIter = new oStringLongMapIterStruct;
-        TRACK_ITER_NEW;
+        MALLOCATE_ITER(oStringLongMapIterStruct, pIter, pIterVocab);
         pIter->pMethods = pIterVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -3279,7 +3318,7 @@ namespace OMap
     FORTHOP(oStringLongMapHeadIterMethod)
     {
         GET_THIS(oStringLongMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oStringLongMapIterStruct* pIter = createStringLongMapIterator(pCore, pMap);
@@ -3292,7 +3331,7 @@ namespace OMap
     FORTHOP(oStringLongMapTailIterMethod)
     {
         GET_THIS(oStringLongMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
 
         oStringLongMapIterStruct* pIter = createStringLongMapIterator(pCore, pMap);
@@ -3313,7 +3352,7 @@ namespace OMap
         oStringLongMap::iterator iter = a.find(key);
         if (iter != a.end())
         {
-            pMap->refCount++;
+            INCREMENT_REFCOUNT(pMap);
             TRACK_KEEP;
 
             oStringLongMapIterStruct* pIter = createStringLongMapIterator(pCore, pMap);
@@ -3473,8 +3512,7 @@ namespace OMap
 		GET_THIS(oStringLongMapIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
 		delete pIter->cursor;
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -3709,22 +3747,27 @@ namespace OMap
 	{
 		ForthClassVocabulary* pVocab = pEngine->AddBuiltinClass("Map", kBCIMap, kBCIIterable, oMapMembers);
         pVocab->SetCustomObjectReader(customMapReader);
+        pVocab->SetCustomChildVisitor(mapChildVisitor);
         pEngine->AddBuiltinClass("MapIter", kBCIMapIter, kBCIIter, oMapIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("IntMap", kBCIIntMap, kBCIIterable, oIntMapMembers);
         pVocab->SetCustomObjectReader(customIntMapReader);
+        pVocab->SetCustomChildVisitor(intMapChildVisitor);
         pEngine->AddBuiltinClass("IntMapIter", kBCIIntMapIter, kBCIIter, oIntMapIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("FloatMap", kBCIFloatMap, kBCIIntMap, oFloatMapMembers);
         pVocab->SetCustomObjectReader(customFloatMapReader);
+        pVocab->SetCustomChildVisitor(floatMapChildVisitor);
         pEngine->AddBuiltinClass("FloatMapIter", kBCIFloatMapIter, kBCIIter, oIntMapIterMembers);
 
         gpLongMapClassVocab = pEngine->AddBuiltinClass("LongMap", kBCILongMap, kBCIIterable, oLongMapMembers);
         gpLongMapClassVocab->SetCustomObjectReader(customLongMapReader);
+        gpLongMapClassVocab->SetCustomChildVisitor(longMapChildVisitor);
         pEngine->AddBuiltinClass("LongMapIter", kBCILongMapIter, kBCIIter, oLongMapIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("DoubleMap", kBCIDoubleMap, kBCILongMap, oDoubleMapMembers);
         pVocab->SetCustomObjectReader(customDoubleMapReader);
+        pVocab->SetCustomChildVisitor(doubleMapChildVisitor);
         pEngine->AddBuiltinClass("DoubleMapIter", kBCIDoubleMapIter, kBCIIter, oLongMapIterMembers);
 
         pVocab = pEngine->AddBuiltinClass("StringIntMap", kBCIStringIntMap, kBCIIterable, oStringIntMapMembers);
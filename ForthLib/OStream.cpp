@@ -18,6 +18,15 @@
 #include "OStream.h"
 #include "OString.h"
 
+#if defined(LINUX) || defined(MACOSX)
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+// most blocks passed to a single writev call by ForthStreamGatherOut
+#define GATHER_OUT_MAX_BLOCKS   64
+
 extern "C"
 {
 	extern cell oStringFormatSub( ForthCoreState* pCore, char* pBuffer, int bufferSize );
@@ -174,6 +183,7 @@ namespace OStream
                 }
                 pBuffer[numWritten] = '\0';
                 dst->curLen = numWritten;
+                pString->hash = 0;
             }
             else
             {
@@ -454,6 +464,7 @@ namespace OStream
             }
             pBuffer[numWritten] = '\0';
             dst->curLen = numWritten;
+            pString->hash = 0;
         }
         SPUSH(numWritten);
         METHOD_RETURN;
@@ -623,18 +634,72 @@ namespace OStream
     //                 oFileInStream
     //
 
+    // a FileInStream opened with openMapped reads regular files through a mapping,
+    //   pMappedFile is null if the stream is reading with stdio
     struct oFileInStreamStruct
     {
         oInStreamStruct     istream;
         FILE*               pInFile;
+        ForthMappedFile*    pMappedFile;
+        size_t              mappedPos;
     };
 
+    void unmapFileInStream(oFileInStreamStruct* pFileInStreamStruct)
+    {
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            delete pFileInStreamStruct->pMappedFile;
+            pFileInStreamStruct->pMappedFile = nullptr;
+            pFileInStreamStruct->mappedPos = 0;
+        }
+    }
+
+    // finds the next line in a mapped file, at most maxBytes long, and steps past it
+    //   pLine points into the mapping, returns false at end of file
+    bool mappedNextLine(oFileInStreamStruct* pFileInStreamStruct, size_t maxBytes, const char*& pLine, size_t& numBytes)
+    {
+        ForthMappedFile* pMappedFile = pFileInStreamStruct->pMappedFile;
+        size_t pos = pFileInStreamStruct->mappedPos;
+        if (pos >= pMappedFile->Size())
+        {
+            return false;
+        }
+        const char* pSrc = pMappedFile->Data() + pos;
+        size_t available = pMappedFile->Size() - pos;
+        if (available > maxBytes)
+        {
+            available = maxBytes;
+        }
+        const char* pEOL = (const char*)memchr(pSrc, '\n', available);
+        size_t lineBytes = (pEOL != nullptr) ? ((pEOL - pSrc) + 1) : available;
+        pFileInStreamStruct->mappedPos = pos + lineBytes;
+        if (pFileInStreamStruct->istream.bTrimEOL && (pEOL != nullptr))
+        {
+            lineBytes--;
+            if ((lineBytes > 0) && (pSrc[lineBytes - 1] == '\r'))
+            {
+                lineBytes--;
+            }
+        }
+        pLine = pSrc;
+        numBytes = lineBytes;
+        return true;
+    }
+
     int fileCharIn(ForthCoreState* pCore, void *pData, int& ch)
     {
         oFileInStreamStruct* pFileInStreamStruct = static_cast<oFileInStreamStruct*>(pData);
         int numWritten = 0;
         ch = -1;
-        if (pFileInStreamStruct->pInFile != nullptr)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            if (pFileInStreamStruct->mappedPos < pFileInStreamStruct->pMappedFile->Size())
+            {
+                ch = ((int)(pFileInStreamStruct->pMappedFile->Data()[pFileInStreamStruct->mappedPos++])) & 0xFF;
+                numWritten = 1;
+            }
+        }
+        else if (pFileInStreamStruct->pInFile != nullptr)
         {
             ch = GET_ENGINE->GetShell()->GetFileInterface()->fileGetChar(pFileInStreamStruct->pInFile);
             numWritten = 1;
@@ -646,7 +711,17 @@ namespace OStream
     {
         oFileInStreamStruct* pFileInStreamStruct = static_cast<oFileInStreamStruct*>(pData);
         int numWritten = 0;
-        if (pFileInStreamStruct->pInFile != nullptr)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            size_t available = pFileInStreamStruct->pMappedFile->Size() - pFileInStreamStruct->mappedPos;
+            numWritten = (available < (size_t)numChars) ? (int)available : numChars;
+            if (numWritten > 0)
+            {
+                memcpy(pBuff, pFileInStreamStruct->pMappedFile->Data() + pFileInStreamStruct->mappedPos, numWritten);
+                pFileInStreamStruct->mappedPos += numWritten;
+            }
+        }
+        else if (pFileInStreamStruct->pInFile != nullptr)
         {
             numWritten = (int)GET_ENGINE->GetShell()->GetFileInterface()->fileRead(pBuff, 1, numChars, pFileInStreamStruct->pInFile);
         }
@@ -666,7 +741,25 @@ namespace OStream
         int numWritten = 0;
 
         char* pResult = nullptr;
-        if (pFileInStreamStruct->pInFile != nullptr)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            const char* pLine;
+            size_t lineBytes;
+            if (mappedNextLine(pFileInStreamStruct, ~((size_t)0), pLine, lineBytes))
+            {
+                if (lineBytes > (size_t)dst->maxLen)
+                {
+                    dst = OString::resizeOString(pString, (int)lineBytes);
+                    pBuffer = &(dst->data[0]);
+                }
+                memcpy(pBuffer, pLine, lineBytes);
+                numWritten = (int)lineBytes;
+            }
+            pBuffer[numWritten] = '\0';
+            dst->curLen = numWritten;
+            pString->hash = 0;
+        }
+        else if (pFileInStreamStruct->pInFile != nullptr)
         {
             bool atEOF = false;
             bool done = false;
@@ -704,6 +797,7 @@ namespace OStream
                 }
             }
             dst->curLen = numWritten;
+            pString->hash = 0;
 
             if (pFileInStreamStruct->istream.bTrimEOL)
             {
@@ -727,7 +821,19 @@ namespace OStream
     {
         oFileInStreamStruct* pFileInStreamStruct = static_cast<oFileInStreamStruct*>(pData);
         char* pResult = nullptr;
-        if (pFileInStreamStruct->pInFile != nullptr)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            const char* pLine;
+            size_t lineBytes;
+            if ((maxBytes > 0) && mappedNextLine(pFileInStreamStruct, maxBytes - 1, pLine, lineBytes))
+            {
+                memcpy(pBuffer, pLine, lineBytes);
+                pBuffer[lineBytes] = '\0';
+                return (int)lineBytes;
+            }
+            return 0;
+        }
+        else if (pFileInStreamStruct->pInFile != nullptr)
         {
             pResult = GET_ENGINE->GetShell()->GetFileInterface()->fileGetString(pBuffer, maxBytes, pFileInStreamStruct->pInFile);
         }
@@ -753,12 +859,31 @@ namespace OStream
         return numWritten;
     }
 
+    const char* fileMappedIn(ForthCoreState* pCore, void *pData, size_t& numBytes)
+    {
+        oFileInStreamStruct* pFileInStreamStruct = static_cast<oFileInStreamStruct*>(pData);
+        ForthMappedFile* pMappedFile = pFileInStreamStruct->pMappedFile;
+        if ((pMappedFile == nullptr) || (pMappedFile->Data() == nullptr))
+        {
+            return nullptr;
+        }
+        size_t available = pMappedFile->Size() - pFileInStreamStruct->mappedPos;
+        if (numBytes > available)
+        {
+            numBytes = available;
+        }
+        const char* pBytes = pMappedFile->Data() + pFileInStreamStruct->mappedPos;
+        pFileInStreamStruct->mappedPos += numBytes;
+        return pBytes;
+    }
+
     InStreamFuncs fileInFuncs =
     {
         fileCharIn,
         fileBytesIn,
         fileLineIn,
-        fileStringIn
+        fileStringIn,
+        fileMappedIn
     };
 
     FORTHOP(oFileInStreamNew)
@@ -771,6 +896,8 @@ namespace OStream
         pFileInStreamStruct->istream.pInFuncs = &fileInFuncs;
         pFileInStreamStruct->istream.bTrimEOL = true;
 		pFileInStreamStruct->pInFile = NULL;
+        pFileInStreamStruct->pMappedFile = nullptr;
+        pFileInStreamStruct->mappedPos = 0;
         printf("new fileInStream %p\n", pFileInStreamStruct);
 		PUSH_OBJECT(pFileInStreamStruct);
 	}
@@ -778,6 +905,7 @@ namespace OStream
 	FORTHOP(oFileInStreamDeleteMethod)
 	{
 		GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
+        unmapFileInStream(pFileInStreamStruct);
 		if (pFileInStreamStruct->pInFile != NULL)
 		{
 			GET_ENGINE->GetShell()->GetFileInterface()->fileClose((FILE *)(pFileInStreamStruct->pInFile));
@@ -790,7 +918,14 @@ namespace OStream
     {
         GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
         int atEOF = 0;
-        if (pFileInStreamStruct->pInFile == NULL)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            if (pFileInStreamStruct->mappedPos >= pFileInStreamStruct->pMappedFile->Size())
+            {
+                atEOF--;
+            }
+        }
+        else if (pFileInStreamStruct->pInFile == NULL)
         {
             atEOF--;
         }
@@ -809,7 +944,16 @@ namespace OStream
     {
         GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
         int gotData = 0;
-        if (pFileInStreamStruct->pInFile != NULL)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            int ch;
+            if (fileCharIn(pCore, pFileInStreamStruct, ch) != 0)
+            {
+                SPUSH(ch);
+                gotData--;
+            }
+        }
+        else if (pFileInStreamStruct->pInFile != NULL)
         {
             int ch = GET_ENGINE->GetShell()->GetFileInterface()->fileGetChar((FILE *)(pFileInStreamStruct->pInFile));
             if (ch != -1)
@@ -828,7 +972,16 @@ namespace OStream
         int numBytes = (int)SPOP;
         char* pBuffer = reinterpret_cast<char *>(SPOP);
         int gotData = 0;
-        if (pFileInStreamStruct->pInFile != NULL)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            int numRead = fileBytesIn(pCore, pFileInStreamStruct, pBuffer, numBytes);
+            if (numRead > 0)
+            {
+                SPUSH(numRead);
+                gotData--;
+            }
+        }
+        else if (pFileInStreamStruct->pInFile != NULL)
         {
             int numRead = (int)GET_ENGINE->GetShell()->GetFileInterface()->fileRead(pBuffer, 1, numBytes, (FILE *)(pFileInStreamStruct->pInFile));
             if (numRead > 0)
@@ -850,7 +1003,19 @@ namespace OStream
         int gotData = 0;
         FILE* pInFile = (FILE *)(pFileInStreamStruct->pInFile);
 
-        if (pInFile != NULL)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            const char* pLine;
+            size_t lineBytes;
+            if ((maxBytes > 0) && mappedNextLine(pFileInStreamStruct, maxBytes - 1, pLine, lineBytes))
+            {
+                memcpy(pBuffer, pLine, lineBytes);
+                pBuffer[lineBytes] = '\0';
+                SPUSH((cell)lineBytes);
+                gotData--;
+            }
+        }
+        else if (pInFile != NULL)
         {
             pResult = GET_ENGINE->GetShell()->GetFileInterface()->fileGetString(pBuffer, maxBytes, pInFile);
         }
@@ -884,6 +1049,7 @@ namespace OStream
     FORTHOP(oFileInStreamOpenMethod)
 	{
 		GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
+        unmapFileInStream(pFileInStreamStruct);
 		if (pFileInStreamStruct->pInFile != NULL)
 		{
             printf("oFileInStreamOpenMethod closing infile\n");
@@ -903,6 +1069,7 @@ namespace OStream
 	FORTHOP(oFileInStreamCloseMethod)
 	{
 		GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
+        unmapFileInStream(pFileInStreamStruct);
 		if (pFileInStreamStruct->pInFile != NULL)
 		{
 			GET_ENGINE->GetShell()->GetFileInterface()->fileClose((FILE *)(pFileInStreamStruct->pInFile));
@@ -914,10 +1081,76 @@ namespace OStream
     FORTHOP(oFileInStreamSetFileMethod)
     {
         GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
+        unmapFileInStream(pFileInStreamStruct);
         pFileInStreamStruct->pInFile = reinterpret_cast<FILE *>(SPOP);
         METHOD_RETURN;
     }
 
+    // openMapped ( PATH -- RESULT )
+    // opens a file for reading through a memory mapping, if the file can't be mapped
+    //   it is read with stdio like a file opened with open, RESULT is 0 if open fails
+    FORTHOP(oFileInStreamOpenMappedMethod)
+    {
+        GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
+        unmapFileInStream(pFileInStreamStruct);
+        ForthFileInterface* pFileInterface = GET_ENGINE->GetShell()->GetFileInterface();
+        if (pFileInStreamStruct->pInFile != NULL)
+        {
+            pFileInterface->fileClose((FILE *)(pFileInStreamStruct->pInFile));
+            pFileInStreamStruct->pInFile = NULL;
+        }
+        const char* path = (const char*)(SPOP);
+        pFileInStreamStruct->pInFile = pFileInterface->fileOpen(path, "rb");
+        if (pFileInStreamStruct->pInFile != nullptr)
+        {
+            ForthMappedFile* pMappedFile = new ForthMappedFile;
+            if (pMappedFile->Map(pFileInStreamStruct->pInFile))
+            {
+                pFileInStreamStruct->pMappedFile = pMappedFile;
+                pFileInStreamStruct->mappedPos = 0;
+            }
+            else
+            {
+                delete pMappedFile;
+            }
+        }
+        SPUSH(pFileInStreamStruct->pInFile == nullptr ? 0 : -1);
+        METHOD_RETURN;
+    }
+
+    FORTHOP(oFileInStreamIsMappedMethod)
+    {
+        GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
+        SPUSH(pFileInStreamStruct->pMappedFile == nullptr ? 0 : -1);
+        METHOD_RETURN;
+    }
+
+    // iterLineView ( -- ADDR NUM_BYTES TRUE | FALSE )
+    // returns the next line without copying it, ADDR points into the file mapping and
+    //   is only valid until the stream is closed or reopened
+    FORTHOP(oFileInStreamIterLineViewMethod)
+    {
+        GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
+        int gotData = 0;
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            const char* pLine;
+            size_t lineBytes;
+            if (mappedNextLine(pFileInStreamStruct, ~((size_t)0), pLine, lineBytes))
+            {
+                SPUSH((cell)pLine);
+                SPUSH((cell)lineBytes);
+                gotData--;
+            }
+        }
+        else
+        {
+            GET_ENGINE->SetError(kForthErrorIO, " FileInStream.iterLineView needs a file opened with openMapped");
+        }
+        SPUSH(gotData);
+        METHOD_RETURN;
+    }
+
     FORTHOP(oFileInStreamGetFileMethod)
     {
         GET_THIS(oFileInStreamStruct, pFileInStreamStruct);
@@ -931,7 +1164,11 @@ namespace OStream
 		stackInt64 size;
 		size.s64 = 0l;
 
-		if (pFileInStreamStruct->pInFile != nullptr)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            size.s64 = (int64_t)(pFileInStreamStruct->pMappedFile->Size());
+        }
+		else if (pFileInStreamStruct->pInFile != nullptr)
 		{
 #if defined(WINDOWS_BUILD)
 			int64_t oldPos = _ftelli64(pFileInStreamStruct->pInFile);
@@ -960,7 +1197,11 @@ namespace OStream
         stackInt64 pos;
         pos.s64 = 0l;
 
-        if (pFileInStreamStruct->pInFile != nullptr)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            pos.s64 = (int64_t)(pFileInStreamStruct->mappedPos);
+        }
+        else if (pFileInStreamStruct->pInFile != nullptr)
         {
 #if defined(WINDOWS_BUILD)
             pos.s64 = _ftelli64(pFileInStreamStruct->pInFile);
@@ -981,7 +1222,29 @@ namespace OStream
 		stackInt64 pos;
 		LPOP(pos);
 
-		if (pFileInStreamStruct->pInFile != nullptr)
+        if (pFileInStreamStruct->pMappedFile != nullptr)
+        {
+            int64_t fileSize = (int64_t)(pFileInStreamStruct->pMappedFile->Size());
+            int64_t newPos = pos.s64;
+            if (seekType == SEEK_CUR)
+            {
+                newPos += (int64_t)(pFileInStreamStruct->mappedPos);
+            }
+            else if (seekType == SEEK_END)
+            {
+                newPos += fileSize;
+            }
+            if (newPos < 0)
+            {
+                newPos = 0;
+            }
+            else if (newPos > fileSize)
+            {
+                newPos = fileSize;
+            }
+            pFileInStreamStruct->mappedPos = (size_t)newPos;
+        }
+		else if (pFileInStreamStruct->pInFile != nullptr)
 		{
 #if defined(WINDOWS_BUILD)
             _fseeki64(pFileInStreamStruct->pInFile, pos.s64, seekType);
@@ -1011,8 +1274,13 @@ namespace OStream
 		METHOD_RET("getSize", oFileInStreamGetSizeMethod, RETURNS_NATIVE(kBaseTypeLong)),
 		METHOD_RET("tell", oFileInStreamTellMethod, RETURNS_NATIVE(kBaseTypeLong)),
 		METHOD("seek", oFileInStreamSeekMethod),
+        METHOD_RET("openMapped", oFileInStreamOpenMappedMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("isMapped", oFileInStreamIsMappedMethod, RETURNS_NATIVE(kBaseTypeInt)),
+        METHOD_RET("iterLineView", oFileInStreamIterLineViewMethod, RETURNS_NATIVE(kBaseTypeInt)),
 
 		MEMBER_VAR("inFile", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+		MEMBER_VAR("__mappedFile", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+		MEMBER_VAR("__mappedPos", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
 
 		// following must be last in table
 		END_MEMBERS
@@ -1034,6 +1302,8 @@ namespace OStream
         pConsoleInStreamStruct->istream.pInFuncs = &fileInFuncs;
         pConsoleInStreamStruct->istream.bTrimEOL = true;
 		pConsoleInStreamStruct->pInFile = GET_ENGINE->GetShell()->GetFileInterface()->getStdIn();
+        pConsoleInStreamStruct->pMappedFile = nullptr;
+        pConsoleInStreamStruct->mappedPos = 0;
 		PUSH_OBJECT(pConsoleInStreamStruct);
 	}
 
@@ -1068,7 +1338,13 @@ namespace OStream
 	//                 oOutStream
 	//
 
-	void streamCharOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, char ch)
+	void streamCharOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, char ch);
+	void streamBytesOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer, int numBytes);
+	void streamStringOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer);
+
+	// the direct*Out routines bypass the stream buffer
+
+	void directCharOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, char ch)
 	{
 		if (pOutStream->pOutFuncs->outChar != NULL)
 		{
@@ -1107,7 +1383,7 @@ namespace OStream
 		METHOD_RETURN;
 	}
 
-	void streamBytesOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer, int numBytes)
+	void directBytesOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer, int numBytes)
 	{
 		if (pOutStream->pOutFuncs->outBytes != NULL)
 		{
@@ -1160,7 +1436,7 @@ namespace OStream
 		METHOD_RETURN;
 	}
 
-	void streamStringOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer)
+	void directStringOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer)
 	{
  		if (pOutStream->pOutFuncs->outString != NULL)
 		{
@@ -1187,6 +1463,143 @@ namespace OStream
 		}
 	}
 
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 output stream buffers
+	//
+	// A stream buffer collects output until it is full or flushed, then writes it with one
+	//   outBytes call.  A buffer with OUT_BUFFER_FLUSH_ON_YIELD is put on the pending list of
+	//   the fiber which writes to it, and the scheduler flushes the pending list whenever the
+	//   fiber gives up control, so output from different fibers doesn't get reordered.
+
+	void unlinkPendingBuffer(ForthOutBuffer* pBuffer)
+	{
+		ForthFiber* pFiber = pBuffer->pPendingFiber;
+		if (pFiber != nullptr)
+		{
+			ForthOutBuffer** ppLink = &(pFiber->PendingOutBuffers());
+			while (*ppLink != nullptr)
+			{
+				if (*ppLink == pBuffer)
+				{
+					*ppLink = pBuffer->pNextPending;
+					break;
+				}
+				ppLink = &((*ppLink)->pNextPending);
+			}
+			pBuffer->pPendingFiber = nullptr;
+			pBuffer->pNextPending = nullptr;
+		}
+	}
+
+	void streamFlush(ForthCoreState* pCore, oOutStreamStruct* pOutStream)
+	{
+		ForthOutBuffer* pBuffer = pOutStream->pOutBuffer;
+		if (pBuffer != nullptr)
+		{
+			unlinkPendingBuffer(pBuffer);
+			int numBytes = pBuffer->used;
+			if (numBytes > 0)
+			{
+				pBuffer->used = 0;
+				directBytesOut(pCore, pOutStream, pBuffer->pData, numBytes);
+			}
+		}
+	}
+
+	// called after bytes are added to the buffer
+	inline void bufferWritten(ForthCoreState* pCore, ForthOutBuffer* pBuffer)
+	{
+		if (((pBuffer->flags & OUT_BUFFER_FLUSH_ON_YIELD) != 0) && (pBuffer->pPendingFiber == nullptr))
+		{
+			ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+			if (pFiber != nullptr)
+			{
+				pBuffer->pPendingFiber = pFiber;
+				pBuffer->pNextPending = pFiber->PendingOutBuffers();
+				pFiber->PendingOutBuffers() = pBuffer;
+			}
+		}
+	}
+
+	// flushes and frees stream buffer, call this in delete of any stream which can be buffered
+	void streamReleaseBuffer(ForthCoreState* pCore, oOutStreamStruct* pOutStream)
+	{
+		ForthOutBuffer* pBuffer = pOutStream->pOutBuffer;
+		if (pBuffer != nullptr)
+		{
+			streamFlush(pCore, pOutStream);
+			pOutStream->pOutBuffer = nullptr;
+			__FREE(pBuffer->pData);
+			__FREE(pBuffer);
+		}
+	}
+
+	void streamCharOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, char ch)
+	{
+		ForthOutBuffer* pBuffer = pOutStream->pOutBuffer;
+		if (pBuffer == nullptr)
+		{
+			directCharOut(pCore, pOutStream, ch);
+			return;
+		}
+		if (pBuffer->used == pBuffer->size)
+		{
+			streamFlush(pCore, pOutStream);
+		}
+		pBuffer->pData[pBuffer->used++] = ch;
+		if ((ch == '\n') && ((pBuffer->flags & OUT_BUFFER_FLUSH_ON_NEWLINE) != 0))
+		{
+			streamFlush(pCore, pOutStream);
+		}
+		else
+		{
+			bufferWritten(pCore, pBuffer);
+		}
+	}
+
+	void streamBytesOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer, int numBytes)
+	{
+		ForthOutBuffer* pOutBuffer = pOutStream->pOutBuffer;
+		if (pOutBuffer == nullptr)
+		{
+			directBytesOut(pCore, pOutStream, pBuffer, numBytes);
+			return;
+		}
+		if ((pOutBuffer->used + numBytes) > pOutBuffer->size)
+		{
+			streamFlush(pCore, pOutStream);
+		}
+		if (numBytes >= pOutBuffer->size)
+		{
+			// too big to be worth copying, buffer is empty so just write it
+			directBytesOut(pCore, pOutStream, pBuffer, numBytes);
+			return;
+		}
+		memcpy(pOutBuffer->pData + pOutBuffer->used, pBuffer, numBytes);
+		pOutBuffer->used += numBytes;
+		if (((pOutBuffer->flags & OUT_BUFFER_FLUSH_ON_NEWLINE) != 0) && (memchr(pBuffer, '\n', numBytes) != nullptr))
+		{
+			streamFlush(pCore, pOutStream);
+		}
+		else
+		{
+			bufferWritten(pCore, pOutBuffer);
+		}
+	}
+
+	void streamStringOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const char* pBuffer)
+	{
+		if (pOutStream->pOutBuffer == nullptr)
+		{
+			directStringOut(pCore, pOutStream, pBuffer);
+		}
+		else
+		{
+			streamBytesOut(pCore, pOutStream, pBuffer, (int)strlen(pBuffer));
+		}
+	}
+
 	FORTHOP(oOutStreamPutStringMethod)
 	{
 		GET_THIS(oOutStreamStruct, pOutStream);
@@ -1267,6 +1680,52 @@ namespace OStream
         METHOD_RETURN;
     }
 
+	// setBuffer ( NUM_BYTES FLAGS -- )
+	// give the stream an output buffer of NUM_BYTES, 0 makes the stream unbuffered
+	// FLAGS is the sum of 1 to flush on newline and 2 to flush whenever the fiber yields
+	FORTHOP(oOutStreamSetBufferMethod)
+	{
+		GET_THIS(oOutStreamStruct, pOutStream);
+		int flags = (int)SPOP;
+		int numBytes = (int)SPOP;
+
+		if (pOutStream->pOutFuncs == NULL)
+		{
+			ForthEngine::GetInstance()->SetError(kForthErrorIO, " output stream with no output routines can't be buffered");
+		}
+		else if (numBytes < 0)
+		{
+			ForthEngine::GetInstance()->SetError(kForthErrorBadParameter, " OutStream.setBuffer size is negative");
+		}
+		else
+		{
+			streamReleaseBuffer(pCore, pOutStream);
+			if (numBytes > 0)
+			{
+				ForthOutBuffer* pBuffer = (ForthOutBuffer *)__MALLOC(sizeof(ForthOutBuffer));
+				pBuffer->pData = (char *)__MALLOC(numBytes);
+				pBuffer->size = numBytes;
+				pBuffer->used = 0;
+				pBuffer->flags = flags;
+				pBuffer->pPendingFiber = nullptr;
+				pBuffer->pNextPending = nullptr;
+				pBuffer->pStream = pOutStream;
+				pOutStream->pOutBuffer = pBuffer;
+			}
+		}
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oOutStreamFlushMethod)
+	{
+		GET_THIS(oOutStreamStruct, pOutStream);
+		if (pOutStream->pOutFuncs != NULL)
+		{
+			streamFlush(pCore, pOutStream);
+		}
+		METHOD_RETURN;
+	}
+
 	baseMethodEntry oOutStreamMembers[] =
 	{
 		// putChar, putBytes and putString must be first 3 methods and in this order
@@ -1275,10 +1734,13 @@ namespace OStream
 		METHOD("putString", oOutStreamPutStringMethod),
 		METHOD("putLine", oOutStreamPutLineMethod),
         METHOD("printf", oOutStreamPrintfMethod),
+		METHOD("setBuffer", oOutStreamSetBufferMethod),
+		METHOD("flush", oOutStreamFlushMethod),
 
 		MEMBER_VAR("userData", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
 		MEMBER_VAR("__outFuncs", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
 		MEMBER_VAR("__eolChars", NATIVE_TYPE_TO_CODE(0, kBaseTypeInt)),
+		MEMBER_VAR("__outBuffer", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
 
 		// following must be last in table
 		END_MEMBERS
@@ -1318,6 +1780,63 @@ namespace OStream
 		fileStringOut
 	};
 
+#if defined(LINUX) || defined(MACOSX)
+	// writes blocks straight to the file descriptor of a local file output stream with writev,
+	//   returns false if the stream isn't one, in which case nothing has been written
+	bool gatherFileOut(ForthCoreState* pCore, oOutStreamStruct* pOutStream, const ForthOutBlock* pBlocks, int numBlocks)
+	{
+		ForthFileInterface* pFiles = GET_ENGINE->GetShell()->GetFileInterface();
+		FILE* pOutFile = reinterpret_cast<oFileOutStreamStruct*>(pOutStream)->pOutFile;
+		if ((pOutStream->pOutFuncs != &fileOutFuncs) || (pFiles->fileWrite != fwrite) || (pOutFile == nullptr))
+		{
+			return false;
+		}
+
+		// anything already written to the stream must go out first
+		streamFlush(pCore, pOutStream);
+		pFiles->fileFlush(pOutFile);
+		int fd = pFiles->fileNo(pOutFile);
+
+		struct iovec vecs[GATHER_OUT_MAX_BLOCKS];
+		int blockIx = 0;
+		int blockOffset = 0;
+		while (blockIx < numBlocks)
+		{
+			int numVecs = 0;
+			for (int i = blockIx; (i < numBlocks) && (numVecs < GATHER_OUT_MAX_BLOCKS); i++)
+			{
+				int offset = (i == blockIx) ? blockOffset : 0;
+				vecs[numVecs].iov_base = (void *)(pBlocks[i].pData + offset);
+				vecs[numVecs].iov_len = pBlocks[i].numBytes - offset;
+				numVecs++;
+			}
+			ssize_t numWritten = writev(fd, vecs, numVecs);
+			if (numWritten < 0)
+			{
+				if (errno != EINTR)
+				{
+					GET_ENGINE->SetError(kForthErrorIO, " writev failed");
+					break;
+				}
+			}
+			else
+			{
+				// skip the blocks which were completely written, a short write leaves
+				//   blockOffset inside the first unfinished block
+				size_t bytesLeft = (size_t)numWritten;
+				while ((blockIx < numBlocks) && (bytesLeft >= (size_t)(pBlocks[blockIx].numBytes - blockOffset)))
+				{
+					bytesLeft -= pBlocks[blockIx].numBytes - blockOffset;
+					blockOffset = 0;
+					blockIx++;
+				}
+				blockOffset += (int)bytesLeft;
+			}
+		}
+		return true;
+	}
+#endif
+
 	FORTHOP(oFileOutStreamNew)
 	{
 		ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
@@ -1326,6 +1845,7 @@ namespace OStream
         pFileOutStream->ostream.refCount = 0;
 		pFileOutStream->ostream.pOutFuncs = &fileOutFuncs;
 		pFileOutStream->ostream.pUserData = NULL;
+		pFileOutStream->ostream.pOutBuffer = nullptr;
 		pFileOutStream->pOutFile = nullptr;
 		PUSH_OBJECT(pFileOutStream);
 	}
@@ -1333,6 +1853,7 @@ namespace OStream
 	FORTHOP(oFileOutStreamDeleteMethod)
 	{
 		GET_THIS(oFileOutStreamStruct, pFileOutStream);
+		streamReleaseBuffer(pCore, &(pFileOutStream->ostream));
 		if (pFileOutStream->pOutFile != NULL)
 		{
 			GET_ENGINE->GetShell()->GetFileInterface()->fileClose(static_cast<FILE *>(pFileOutStream->pOutFile));
@@ -1345,6 +1866,7 @@ namespace OStream
 	FORTHOP(oFileOutStreamOpenMethod)
 	{
 		GET_THIS(oFileOutStreamStruct, pFileOutStream);
+		streamFlush(pCore, &(pFileOutStream->ostream));
 		if (pFileOutStream->pOutFile != NULL)
 		{
 			GET_ENGINE->GetShell()->GetFileInterface()->fileClose((FILE *)(pFileOutStream->pOutFile));
@@ -1360,6 +1882,7 @@ namespace OStream
 	FORTHOP(oFileOutStreamCloseMethod)
 	{
 		GET_THIS(oFileOutStreamStruct, pFileOutStream);
+		streamFlush(pCore, &(pFileOutStream->ostream));
 		if (pFileOutStream->pOutFile != NULL)
 		{
 			GET_ENGINE->GetShell()->GetFileInterface()->fileClose((FILE *)(pFileOutStream->pOutFile));
@@ -1371,6 +1894,7 @@ namespace OStream
     FORTHOP(oFileOutStreamSetFileMethod)
     {
         GET_THIS(oFileOutStreamStruct, pFileOutStream);
+        streamFlush(pCore, &(pFileOutStream->ostream));
         pFileOutStream->pOutFile = reinterpret_cast<FILE *>(SPOP);
         METHOD_RETURN;
     }
@@ -1385,6 +1909,7 @@ namespace OStream
     FORTHOP(oFileOutStreamGetSizeMethod)
     {
         GET_THIS(oFileOutStreamStruct, pFileOutStream);
+        streamFlush(pCore, &(pFileOutStream->ostream));
         stackInt64 size;
         size.s64 = 0l;
 
@@ -1414,6 +1939,7 @@ namespace OStream
     FORTHOP(oFileOutStreamTellMethod)
 	{
 		GET_THIS(oFileOutStreamStruct, pFileOutStream);
+		streamFlush(pCore, &(pFileOutStream->ostream));
 		stackInt64 pos;
 		pos.s64 = 0l;
 
@@ -1434,6 +1960,7 @@ namespace OStream
 	FORTHOP(oFileOutStreamSeekMethod)
 	{
 		GET_THIS(oFileOutStreamStruct, pFileOutStream);
+		streamFlush(pCore, &(pFileOutStream->ostream));
 		int seekType = (int)SPOP;
 		stackInt64 pos;
 		LPOP(pos);
@@ -1490,6 +2017,7 @@ namespace OStream
         pStringOutStream->ostream.refCount = 0;
 		pStringOutStream->ostream.pOutFuncs = &stringOutFuncs;
 		pStringOutStream->ostream.pUserData = &(pStringOutStream->outString);
+		pStringOutStream->ostream.pOutBuffer = nullptr;
 		CLEAR_OBJECT(pStringOutStream->outString);
 		PUSH_OBJECT(pStringOutStream);
 	}
@@ -1497,6 +2025,7 @@ namespace OStream
 	FORTHOP(oStringOutStreamDeleteMethod)
 	{
 		GET_THIS(oStringOutStreamStruct, pStringOutStream);
+		streamReleaseBuffer(pCore, &(pStringOutStream->ostream));
 		SAFE_RELEASE(pCore, pStringOutStream->outString);
 		FREE_OBJECT(pStringOutStream);
 		METHOD_RETURN;
@@ -1505,6 +2034,7 @@ namespace OStream
 	FORTHOP(oStringOutStreamSetStringMethod)
 	{
 		GET_THIS(oStringOutStreamStruct, pStringOutStream);
+		streamFlush(pCore, &(pStringOutStream->ostream));
 		ForthObject dstString;
 		POP_OBJECT(dstString);
 		OBJECT_ASSIGN(pCore, pStringOutStream->outString, dstString);
@@ -1514,6 +2044,7 @@ namespace OStream
 	FORTHOP(oStringOutStreamGetStringMethod)
 	{
 		GET_THIS(oStringOutStreamStruct, pStringOutStream);
+		streamFlush(pCore, &(pStringOutStream->ostream));
 		PUSH_OBJECT(pStringOutStream->outString);
 		METHOD_RETURN;
 	}
@@ -1588,6 +2119,7 @@ namespace OStream
         pFunctionOutStream->ostream.refCount = 0;
 		pFunctionOutStream->ostream.pOutFuncs = &(pFunctionOutStream->outFuncs);
 		pFunctionOutStream->ostream.pUserData = NULL;
+		pFunctionOutStream->ostream.pOutBuffer = nullptr;
 		pFunctionOutStream->outFuncs.outChar = NULL;
 		pFunctionOutStream->outFuncs.outBytes = NULL;
 		pFunctionOutStream->outFuncs.outString = NULL;
@@ -1597,6 +2129,7 @@ namespace OStream
 	FORTHOP(oFunctionOutStreamInitMethod)
 	{
 		GET_THIS(oFunctionOutStreamStruct, pFunctionOutStream);
+		streamFlush(pCore, &(pFunctionOutStream->ostream));
 		pFunctionOutStream->ostream.pUserData = reinterpret_cast<void *>(SPOP);
 		pFunctionOutStream->outFuncs.outString = reinterpret_cast<streamStringOutRoutine>(SPOP);
 		pFunctionOutStream->outFuncs.outBytes = reinterpret_cast<streamBytesOutRoutine>(SPOP);
@@ -1604,9 +2137,18 @@ namespace OStream
 		METHOD_RETURN;
 	}
 
+	FORTHOP(oFunctionOutStreamDeleteMethod)
+	{
+		GET_THIS(oFunctionOutStreamStruct, pFunctionOutStream);
+		streamReleaseBuffer(pCore, &(pFunctionOutStream->ostream));
+		FREE_OBJECT(pFunctionOutStream);
+		METHOD_RETURN;
+	}
+
 	baseMethodEntry oFunctionOutStreamMembers[] =
 	{
 		METHOD("__newOp", oFunctionOutStreamNew),
+		METHOD("delete", oFunctionOutStreamDeleteMethod),
 
 		METHOD("init", oFunctionOutStreamInitMethod),
 
@@ -1665,12 +2207,14 @@ namespace OStream
         pTraceOutStream->refCount = 0;
 		pTraceOutStream->pOutFuncs = &traceOutFuncs;
 		pTraceOutStream->pUserData = NULL;
+		pTraceOutStream->pOutBuffer = nullptr;
 		PUSH_OBJECT(pTraceOutStream);
 	}
 
 	FORTHOP(oTraceOutStreamDeleteMethod)
 	{
 		GET_THIS(oOutStreamStruct, pTraceOutStream);
+		streamReleaseBuffer(pCore, pTraceOutStream);
 		FREE_OBJECT(pTraceOutStream);
 		METHOD_RETURN;
 	}
@@ -1886,11 +2430,13 @@ void GetForthConsoleOutStream(ForthCoreState* pCore, ForthObject& outObject)
 void CreateForthFileOutStream(ForthCoreState* pCore, ForthObject& outObject, FILE* pOutFile)
 {
     ForthClassVocabulary *pClassVocab = GET_CLASS_VOCABULARY(kBCIFileOutStream);
-	MALLOCATE_OBJECT(oOutStreamStruct, pFileOutStream, pClassVocab);
-    pFileOutStream->pMethods = pClassVocab->GetMethods();
-    pFileOutStream->refCount = 1;
-	pFileOutStream->pOutFuncs = &OStream::fileOutFuncs;
-	pFileOutStream->pUserData = pOutFile;
+	MALLOCATE_OBJECT(OStream::oFileOutStreamStruct, pFileOutStream, pClassVocab);
+    pFileOutStream->ostream.pMethods = pClassVocab->GetMethods();
+    pFileOutStream->ostream.refCount = 1;
+	pFileOutStream->ostream.pOutFuncs = &OStream::fileOutFuncs;
+	pFileOutStream->ostream.pUserData = nullptr;
+	pFileOutStream->ostream.pOutBuffer = nullptr;
+	pFileOutStream->pOutFile = pOutFile;
     outObject = reinterpret_cast<ForthObject>(pFileOutStream);
 }
 
@@ -1910,6 +2456,7 @@ void CreateForthStringOutStream(ForthCoreState* pCore, ForthObject& outObject)
     pStringOutStream->ostream.refCount = 1;
 	pStringOutStream->ostream.pOutFuncs = &OStream::stringOutFuncs;
 	pStringOutStream->ostream.pUserData = &(pStringOutStream->outString);
+	pStringOutStream->ostream.pOutBuffer = nullptr;
     pStringOutStream->outString = (ForthObject)pString;
     outObject = reinterpret_cast<ForthObject>(pStringOutStream);
 }
@@ -1917,6 +2464,7 @@ void CreateForthStringOutStream(ForthCoreState* pCore, ForthObject& outObject)
 const char* GetForthStringOutStreamData(ForthCoreState* pCore, ForthObject& streamObject)
 {
 	oStringOutStreamStruct* pStream = reinterpret_cast<oStringOutStreamStruct *>(streamObject);
+	OStream::streamFlush(pCore, &(pStream->ostream));
 	oStringStruct* pString = reinterpret_cast<oStringStruct *>(pStream->outString);
 	return pString->str->data;
 }
@@ -1930,6 +2478,7 @@ void CreateForthFunctionOutStream(ForthCoreState* pCore, ForthObject& outObject,
     pFunctionOutStream->ostream.refCount = 1;
 	pFunctionOutStream->ostream.pOutFuncs = &(pFunctionOutStream->outFuncs);
 	pFunctionOutStream->ostream.pUserData = pUserData;
+	pFunctionOutStream->ostream.pOutBuffer = nullptr;
 	pFunctionOutStream->outFuncs.outChar = outChar;
 	pFunctionOutStream->outFuncs.outBytes = outBytes;
 	pFunctionOutStream->outFuncs.outString = outString;
@@ -1945,11 +2494,68 @@ void ReleaseForthObject(ForthCoreState* pCore, ForthObject& inObject)
 	}
 	else
 	{
+		OStream::streamReleaseBuffer(pCore, pObjData);
 		FREE_OBJECT(pObjData);
         inObject = nullptr;
 	}
 }
 
+// flush the buffered streams which the fiber has written to since it last gave up control
+void ForthFlushPendingOutStreams(ForthCoreState* pCore)
+{
+	ForthFiber* pFiber = (ForthFiber*)(pCore->pFiber);
+	if (pFiber != nullptr)
+	{
+		while (pFiber->PendingOutBuffers() != nullptr)
+		{
+			// streamFlush takes the buffer off the pending list
+			OStream::streamFlush(pCore, pFiber->PendingOutBuffers()->pStream);
+		}
+	}
+}
+
+void ForthFlushOutStream(ForthCoreState* pCore, ForthObject& streamObject)
+{
+	oOutStreamStruct* pOutStream = reinterpret_cast<oOutStreamStruct*>(streamObject);
+	if ((pOutStream != nullptr) && (pOutStream->pOutFuncs != nullptr))
+	{
+		OStream::streamFlush(pCore, pOutStream);
+	}
+}
+
+void ForthStreamGatherOut(ForthCoreState* pCore, ForthObject& streamObject, const ForthOutBlock* pBlocks, int numBlocks)
+{
+	oOutStreamStruct* pOutStream = reinterpret_cast<oOutStreamStruct*>(streamObject);
+	if (pOutStream == nullptr)
+	{
+		GET_ENGINE->SetError(kForthErrorBadParameter, " null output stream");
+	}
+	else if (pOutStream->pOutFuncs == nullptr)
+	{
+		// stream is defined in forth, use its putBytes method
+		ForthEngine *pEngine = ForthEngine::GetInstance();
+		for (int i = 0; i < numBlocks; i++)
+		{
+			SPUSH((cell)(pBlocks[i].pData));
+			SPUSH(pBlocks[i].numBytes);
+			pEngine->FullyExecuteMethod(pCore, streamObject, kOutStreamPutBytesMethod);
+		}
+	}
+	else
+	{
+#if defined(LINUX) || defined(MACOSX)
+		if (OStream::gatherFileOut(pCore, pOutStream, pBlocks, numBlocks))
+		{
+			return;
+		}
+#endif
+		for (int i = 0; i < numBlocks; i++)
+		{
+			OStream::streamBytesOut(pCore, pOutStream, pBlocks[i].pData, pBlocks[i].numBytes);
+		}
+	}
+}
+
 // ForthConsoleCharOut etc. exist so that stuff outside this module can do output
 //   without having to know about object innards
 // TODO: remove hard coded method numbers
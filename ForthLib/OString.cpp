@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <map>
+#include <vector>
 
 #include "ForthEngine.h"
 #include "ForthVocabulary.h"
@@ -15,9 +16,11 @@
 #include "ForthBuiltinClasses.h"
 #include "ForthShowContext.h"
 #include "ForthObjectReader.h"
+#include "ForthBinarySerializer.h"
 
 #include "OString.h"
 #include "OArray.h"
+#include "OHashMap.h"
 
 extern "C"
 {
@@ -36,6 +39,9 @@ namespace OString
 	int gDefaultOStringSize = DEFAULT_STRING_DATA_BYTES - 1;
     ForthClassVocabulary* gpStringClassVocab = nullptr;
     ForthClassVocabulary* gpStringMapClassVocab = nullptr;
+    ForthClassVocabulary* gpStringViewClassVocab = nullptr;
+    ForthClassVocabulary* gpInternedStringClassVocab = nullptr;
+    ForthClassVocabulary* gpStringBuilderClassVocab = nullptr;
 
 // temp hackaround for a heap corruption when expanding a string
 //#define RCSTRING_SLOP 16
@@ -51,6 +57,64 @@ namespace OString
 		return str;
 	}
 
+    ucell hashStringBytes(const char* pChars, int numChars)
+    {
+        // 0 in oStringStruct::hash means hash hasn't been computed yet, and 1 marks deleted
+        //   slots in hash tables, so real hash values are always 2 or higher
+        ucell hash = (ucell)SuperFastHash(pChars, numChars, 0);
+        return (hash > 1) ? hash : hash + 2;
+    }
+
+    ucell getOStringHash(oStringStruct* pString)
+    {
+        if (pString->hash == 0)
+        {
+            pString->hash = hashStringBytes(&(pString->str->data[0]), pString->str->curLen);
+        }
+        return pString->hash;
+    }
+
+    // the intern table holds one InternedString object for each distinct text which has been interned,
+    //   interned strings are never deleted or changed, and are shared so they can be used by any thread
+    ForthHashTable<std::string> gInternTable;
+#if defined(WINDOWS_BUILD)
+    CRITICAL_SECTION* gpInternLock = nullptr;
+#else
+    pthread_mutex_t gInternLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+    ForthObject internString(const char* pChars, ucell hash)
+    {
+#if defined(WINDOWS_BUILD)
+        EnterCriticalSection(gpInternLock);
+#else
+        pthread_mutex_lock(&gInternLock);
+#endif
+        bool isNew;
+        ucell ix = gInternTable.Insert(pChars, hash, isNew);
+        ForthHashTable<std::string>::Slot& slot = gInternTable.GetSlot(ix);
+        if (isNew)
+        {
+            int numChars = (int)slot.key.length();
+            MALLOCATE_OBJECT(oStringStruct, pString, gpInternedStringClassVocab);
+            pString->pMethods = gpInternedStringClassVocab->GetMethods();
+            // the intern table holds the only permanent reference
+            pString->refCount = SHARED_OBJECT_FLAG | 1;
+            pString->hash = hash;
+            pString->str = createOString(numChars);
+            memcpy(&(pString->str->data[0]), slot.key.c_str(), numChars + 1);
+            pString->str->curLen = numChars;
+            slot.value = (ForthObject)pString;
+        }
+        ForthObject result = slot.value;
+#if defined(WINDOWS_BUILD)
+        LeaveCriticalSection(gpInternLock);
+#else
+        pthread_mutex_unlock(&gInternLock);
+#endif
+        return result;
+    }
+
 	oString* resizeOString(oStringStruct* pString, int newLen)
     {
         int dataBytes = ((newLen + 4) & ~3);
@@ -95,6 +159,105 @@ namespace OString
         pString->hash = 0;
     }
 
+    // the part of the parent which a view can see, clipped to the parent's current length,
+    //   a view with no parent is empty
+    inline void getViewBytes(oStringViewStruct* pView, const char*& pChars, int& numChars)
+    {
+        if (pView->parent == nullptr)
+        {
+            pChars = "";
+            numChars = 0;
+            return;
+        }
+        oString* str = ((oStringStruct*)(pView->parent))->str;
+        ucell parentLen = (ucell)(str->curLen);
+        ucell offset = (pView->offset < parentLen) ? pView->offset : parentLen;
+        ucell length = parentLen - offset;
+        pChars = &(str->data[offset]);
+        numChars = (int)((pView->length < length) ? pView->length : length);
+    }
+
+    // true if obj is an instance of pClassVocab or of a class derived from it
+    bool objectIsA(ForthObject obj, ForthClassVocabulary* pClassVocab)
+    {
+        ForthClassObject* pClassObject = GET_CLASS_OBJECT(obj);
+        ForthClassVocabulary* pVocab = pClassObject->pVocab;
+        while (pVocab != nullptr)
+        {
+            if (pVocab == pClassVocab)
+            {
+                return true;
+            }
+            pVocab = pVocab->ParentClass();
+        }
+        return false;
+    }
+
+    bool getStringBytes(ForthObject obj, const char*& pChars, int& numChars)
+    {
+        if (obj == nullptr)
+        {
+            return false;
+        }
+        if (objectIsA(obj, gpStringClassVocab))
+        {
+            oString* str = ((oStringStruct*)obj)->str;
+            pChars = &(str->data[0]);
+            numChars = (int)(str->curLen);
+            return true;
+        }
+        if (objectIsA(obj, gpStringViewClassVocab))
+        {
+            getViewBytes((oStringViewStruct*)obj, pChars, numChars);
+            return true;
+        }
+        return false;
+    }
+
+    // compares like strcmp, but strings can contain nuls
+    int compareStringBytes(const char* pA, int numA, const char* pB, int numB)
+    {
+        int result = memcmp(pA, pB, (numA < numB) ? numA : numB);
+        if (result == 0)
+        {
+            result = (numA < numB) ? -1 : ((numA > numB) ? 1 : 0);
+        }
+        return result;
+    }
+
+    oStringViewStruct* createStringView(oStringStruct* pParent, ucell offset, ucell length)
+    {
+        MALLOCATE_OBJECT(oStringViewStruct, pView, gpStringViewClassVocab);
+        pView->pMethods = gpStringViewClassVocab->GetMethods();
+        pView->refCount = 0;
+        pView->parent = (ForthObject)pParent;
+        SAFE_KEEP(pView->parent);
+        pView->offset = offset;
+        pView->length = length;
+        return pView;
+    }
+
+    // adds views of each delimited piece of pChars to pArray, which holds the only reference to them
+    void splitIntoViews(oStringStruct* pParent, const char* pChars, int numChars, int delimiter, oArrayStruct* pArray)
+    {
+        const char* pBase = &(pParent->str->data[0]);
+        const char* pSrc = pChars;
+        const char* pEnd = pChars + numChars;
+        while (true)
+        {
+            const char* pDelim = (const char*)memchr(pSrc, delimiter, pEnd - pSrc);
+            const char* pPieceEnd = (pDelim != nullptr) ? pDelim : pEnd;
+            oStringViewStruct* pView = createStringView(pParent, (ucell)(pSrc - pBase), (ucell)(pPieceEnd - pSrc));
+            pView->refCount = 1;
+            pArray->elements->push_back((ForthObject)pView);
+            if (pDelim == nullptr)
+            {
+                break;
+            }
+            pSrc = pDelim + 1;
+        }
+    }
+
 
     FORTHOP( oStringNew )
     {
@@ -147,7 +310,13 @@ namespace OString
         ForthObject compObj;
         POP_OBJECT( compObj );
 		oStringStruct* pComp = (oStringStruct *) compObj;
-		int retVal = strcmp( &(pString->str->data[0]), &(pComp->str->data[0]) );
+		int retVal = 0;
+		const char* pCompChars;
+		int compLen;
+		if ( (pComp != pString) && getStringBytes( compObj, pCompChars, compLen ) )
+		{
+			retVal = compareStringBytes( &(pString->str->data[0]), pString->str->curLen, pCompChars, compLen );
+		}
 		SPUSH( retVal );
         METHOD_RETURN;
     }
@@ -265,14 +434,14 @@ namespace OString
 		GET_THIS(oStringStruct, pString);
 		ForthObject srcObj;
 		POP_OBJECT(srcObj);
-		long srcLen = 0;
-		oStringStruct* srcStr = nullptr;
-		if (srcObj != nullptr)
+		// srcObj can be a String or a StringView
+		int srcLen = 0;
+		const char* pSrcChars = nullptr;
+		if (!getStringBytes(srcObj, pSrcChars, srcLen))
 		{
-			srcStr = (oStringStruct *)srcObj;
-			srcLen = srcStr->str->curLen;
+			srcLen = 0;
 		}
-		
+
 		oString* dst = pString->str;
 		if (srcLen == 0)
 		{
@@ -282,12 +451,18 @@ namespace OString
 		{
 			if (srcLen > dst->maxLen)
 			{
-				// enlarge string
+				// enlarge string, copy before freeing since the source may be a view of this string
+				oString* newStr = createOString(srcLen);
+				memcpy(&(newStr->data[0]), pSrcChars, srcLen);
 				free(dst);
-				dst = createOString(srcLen);
+				dst = newStr;
 				pString->str = dst;
 			}
-			memmove(&(dst->data[0]), &(srcStr->str->data[0]), srcLen + 1);
+			else
+			{
+				memmove(&(dst->data[0]), pSrcChars, srcLen);
+			}
+			dst->data[srcLen] = '\0';
 		}
 		dst->curLen = srcLen;
 		pString->hash = 0;
@@ -386,6 +561,7 @@ namespace OString
         }
         str->curLen = newLen;
         str->data[newLen] = '\0';
+        pString->hash = 0;
         METHOD_RETURN;
     }
 
@@ -412,6 +588,7 @@ namespace OString
         }
         str->curLen = newLen;
         str->data[newLen] = '\0';
+        pString->hash = 0;
         METHOD_RETURN;
     }
 
@@ -458,6 +635,7 @@ namespace OString
                 str->curLen = newLen;
                 str->data[newLen] = '\0';
             }
+            pString->hash = 0;
         }
         METHOD_RETURN;
     }
@@ -555,7 +733,11 @@ namespace OString
         GET_THIS( oStringStruct, pString );
 		const char* srcStr = (const char *) SPOP;
 		long result = 0;
-		if ( srcStr != NULL )
+		if ( srcStr == &(pString->str->data[0]) )
+		{
+			result = ~0;
+		}
+		else if ( srcStr != NULL )
 		{
 			long len = (long) strlen( srcStr );
 			if ( (len == pString->str->curLen)
@@ -568,6 +750,41 @@ namespace OString
         METHOD_RETURN;
     }
 
+	// equalsString compares against another String object, strings with different cached
+	//   hashes are rejected without looking at their characters
+	FORTHOP(oStringEqualsStringMethod)
+    {
+        GET_THIS( oStringStruct, pString );
+        ForthObject compObj;
+        POP_OBJECT( compObj );
+		oStringStruct* pComp = (oStringStruct *) compObj;
+		long result = 0;
+		const char* pCompChars;
+		int compLen;
+		if ( pComp == pString )
+		{
+			result = ~0;
+		}
+		else if ( (pComp != nullptr) && (pComp->pMethods == pString->pMethods) )
+		{
+			if ( (pComp->str->curLen == pString->str->curLen)
+				&& (getOStringHash( pComp ) == getOStringHash( pString ))
+				&& (memcmp( pString->str->data, pComp->str->data, pString->str->curLen ) == 0) )
+			{
+				result = ~0;
+			}
+		}
+		else if ( getStringBytes( compObj, pCompChars, compLen )
+			&& (compLen == pString->str->curLen)
+			&& (memcmp( pString->str->data, pCompChars, compLen ) == 0) )
+		{
+			// StringViews don't cache their hash
+			result = ~0;
+		}
+		SPUSH( result );
+        METHOD_RETURN;
+    }
+
 	FORTHOP(oStringStartsWithMethod)
 	{
 		GET_THIS(oStringStruct, pString);
@@ -635,13 +852,15 @@ namespace OString
     FORTHOP( oStringHashMethod )
     {
         GET_THIS( oStringStruct, pString );
-		pString->hash = 0;
-		oString* dst = pString->str;
-		if ( dst->curLen != 0 )
-		{
-			pString->hash = SuperFastHash( &(dst->data[0]), dst->curLen, 0 );
-		}
-		SPUSH( (cell)(pString->hash) );
+		SPUSH( (cell)(getOStringHash( pString )) );
+        METHOD_RETURN;
+    }
+
+    FORTHOP( oStringInternMethod )
+    {
+        GET_THIS( oStringStruct, pString );
+        ForthObject internedObj = internString( &(pString->str->data[0]), getOStringHash( pString ) );
+        PUSH_OBJECT( internedObj );
         METHOD_RETURN;
     }
 
@@ -742,6 +961,38 @@ namespace OString
 		METHOD_RETURN;
 	}
 
+	// splitView is like split, but adds StringViews of this string to the array instead of copies
+	FORTHOP(oStringSplitViewMethod)
+	{
+		GET_THIS(oStringStruct, pString);
+		int delimiter = SPOP;
+		ForthObject dstArrayObj;
+		POP_OBJECT(dstArrayObj);
+		oArrayStruct* pArray = (oArrayStruct *)(dstArrayObj);
+
+		if ((pArray != nullptr) && (pString->str->curLen != 0))
+		{
+			splitIntoViews(pString, &(pString->str->data[0]), pString->str->curLen, delimiter, pArray);
+		}
+		METHOD_RETURN;
+	}
+
+	// slice ( FIRST_CHAR NUM_CHARS -- STRING_VIEW )
+	FORTHOP(oStringSliceMethod)
+	{
+		GET_THIS(oStringStruct, pString);
+		long numChars = SPOP;
+		long firstChar = SPOP;
+		if ((firstChar < 0) || (numChars < 0))
+		{
+			GET_ENGINE->SetError(kForthErrorBadParameter, " String.slice negative first character or length");
+			firstChar = 0;
+			numChars = 0;
+		}
+		PUSH_OBJECT(createStringView(pString, (ucell)firstChar, (ucell)numChars));
+		METHOD_RETURN;
+	}
+
 	FORTHOP(oStringJoinMethod)
 	{
 		GET_THIS(oStringStruct, pString);
@@ -758,17 +1009,23 @@ namespace OString
 		bool firstTime = true;
         pString->str->curLen = 0;
         pString->str->data[0] = '\0';
+        pString->hash = 0;
         for (iter = a.begin(); iter != a.end(); ++iter)
 		{
-			ForthObject& o = *iter;
-			oStringStruct* pStr = (oStringStruct *)o;
+			// elements can be Strings or StringViews
+			const char* pChars;
+			int numChars;
+			if (!getStringBytes(*iter, pChars, numChars))
+			{
+				numChars = 0;
+			}
 
 			if (!firstTime && (delimLen != 0))
 			{
 				appendOString(pString, delimStr, delimLen);
 			}
 
-			appendOString(pString, pStr->str->data, pStr->str->curLen);
+			appendOString(pString, pChars, numChars);
 			firstTime = false;
 		}
 
@@ -822,6 +1079,7 @@ namespace OString
 		GET_THIS(oStringStruct, pString);
 		pString->str->curLen = 0;
 		pString->str->data[0] = '\0';
+		pString->hash = 0;
 		oStringAppendFormattedMethod(pCore);
 	}
 
@@ -912,17 +1170,21 @@ namespace OString
         METHOD(     "rightBytes",           oStringRightBytesMethod ),
         METHOD(     "middleBytes",          oStringMiddleBytesMethod ),
         METHOD(     "equals",				oStringEqualsMethod ),
+        METHOD_RET( "equalsString",         oStringEqualsStringMethod, RETURNS_NATIVE(kBaseTypeInt) ),
         METHOD(     "startsWith",           oStringStartsWithMethod ),
         METHOD(     "endsWith",             oStringEndsWithMethod ),
         METHOD(     "contains",             oStringContainsMethod ),
         METHOD(     "clear",                oStringClearMethod ),
         METHOD(     "hash",                 oStringHashMethod ),
+        METHOD_RET( "intern",               oStringInternMethod, RETURNS_OBJECT(kBCIString) ),
         METHOD(     "appendChar",           oStringAppendCharMethod ),
         METHOD(     "append4c",             oStringAppend4CMethod ),
         METHOD(     "append8c",             oStringAppend8CMethod ),
         METHOD(     "load",                 oStringLoadMethod ),
         METHOD(		"split",                oStringSplitMethod ),
         METHOD(		"join",					oStringJoinMethod ),
+        METHOD(		"splitView",			oStringSplitViewMethod ),
+        METHOD_RET(	"slice",				oStringSliceMethod, RETURNS_OBJECT(kBCIStringView) ),
         METHOD(		"format",				oStringFormatMethod ),
         METHOD(     "appendFormatted",      oStringAppendFormattedMethod ),
         METHOD(		"fixup",				oStringFixupMethod ),
@@ -937,6 +1199,675 @@ namespace OString
         END_MEMBERS
     };
 
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 InternedString
+	//
+	// String.intern returns InternedString objects, they are shared by everything which
+	//   interned the same text, so all the String methods which change the text are errors
+
+	FORTHOP(oInternedStringModifyMethod)
+	{
+		GET_ENGINE->SetError(kForthErrorIllegalOperation, " cannot modify an interned String");
+		METHOD_RETURN;
+	}
+
+	baseMethodEntry oInternedStringMembers[] =
+	{
+		METHOD(     "set",                  oInternedStringModifyMethod ),
+		METHOD(     "set4c",                oInternedStringModifyMethod ),
+		METHOD(     "set8c",                oInternedStringModifyMethod ),
+		METHOD(     "copy",                 oInternedStringModifyMethod ),
+		METHOD(     "append",               oInternedStringModifyMethod ),
+		METHOD(     "prepend",              oInternedStringModifyMethod ),
+		METHOD(     "setBytes",             oInternedStringModifyMethod ),
+		METHOD(     "appendBytes",          oInternedStringModifyMethod ),
+		METHOD(     "prependBytes",         oInternedStringModifyMethod ),
+		METHOD(     "resize",               oInternedStringModifyMethod ),
+		METHOD(     "keepLeft",             oInternedStringModifyMethod ),
+		METHOD(     "keepRight",            oInternedStringModifyMethod ),
+		METHOD(     "keepMiddle",           oInternedStringModifyMethod ),
+		METHOD(     "clear",                oInternedStringModifyMethod ),
+		METHOD(     "appendChar",           oInternedStringModifyMethod ),
+		METHOD(     "append4c",             oInternedStringModifyMethod ),
+		METHOD(     "append8c",             oInternedStringModifyMethod ),
+		METHOD(     "load",                 oInternedStringModifyMethod ),
+		METHOD(     "join",                 oInternedStringModifyMethod ),
+		METHOD(     "format",               oInternedStringModifyMethod ),
+		METHOD(     "appendFormatted",      oInternedStringModifyMethod ),
+		METHOD(     "fixup",                oInternedStringModifyMethod ),
+		METHOD(     "toLower",              oInternedStringModifyMethod ),
+		METHOD(     "toUpper",              oInternedStringModifyMethod ),
+		METHOD(     "replaceChar",          oInternedStringModifyMethod ),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 StringView
+	//
+
+	FORTHOP(oStringViewNew)
+	{
+		ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+		MALLOCATE_OBJECT(oStringViewStruct, pView, pClassVocab);
+		pView->pMethods = pClassVocab->GetMethods();
+		pView->refCount = 0;
+		pView->parent = nullptr;
+		pView->offset = 0;
+		pView->length = 0;
+		PUSH_OBJECT(pView);
+	}
+
+	FORTHOP(oStringViewDeleteMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		SAFE_RELEASE(pCore, pView->parent);
+		FREE_OBJECT(pView);
+		METHOD_RETURN;
+	}
+
+	// a view without a parent is empty
+	// init ( STRING FIRST_CHAR NUM_CHARS -- )
+	FORTHOP(oStringViewInitMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		long numChars = SPOP;
+		long firstChar = SPOP;
+		ForthObject parentObj;
+		POP_OBJECT(parentObj);
+		if ((firstChar < 0) || (numChars < 0))
+		{
+			GET_ENGINE->SetError(kForthErrorBadParameter, " StringView.init negative first character or length");
+		}
+		else if ((parentObj != nullptr) && !objectIsA(parentObj, gpStringClassVocab))
+		{
+			GET_ENGINE->SetError(kForthErrorBadParameter, " StringView.init parent must be a String");
+		}
+		else
+		{
+			OBJECT_ASSIGN(pCore, pView->parent, parentObj);
+			pView->offset = (ucell)firstChar;
+			pView->length = (ucell)numChars;
+		}
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringViewCompareMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		ForthObject compObj;
+		POP_OBJECT(compObj);
+		const char* pChars;
+		int numChars;
+		const char* pCompChars;
+		int compLen;
+		int retVal = 0;
+		getViewBytes(pView, pChars, numChars);
+		if (getStringBytes(compObj, pCompChars, compLen))
+		{
+			retVal = compareStringBytes(pChars, numChars, pCompChars, compLen);
+		}
+		SPUSH(retVal);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringViewLengthMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* pChars;
+		int numChars;
+		getViewBytes(pView, pChars, numChars);
+		SPUSH(numChars);
+		METHOD_RETURN;
+	}
+
+	// getBytes ( -- ADDR NUM_CHARS )  the bytes are not nul terminated
+	FORTHOP(oStringViewGetBytesMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* pChars;
+		int numChars;
+		getViewBytes(pView, pChars, numChars);
+		SPUSH((cell)pChars);
+		SPUSH(numChars);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringViewEqualsMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* srcStr = (const char *)SPOP;
+		const char* pChars;
+		int numChars;
+		long result = 0;
+		getViewBytes(pView, pChars, numChars);
+		if ((srcStr != NULL) && ((int)strlen(srcStr) == numChars) && (memcmp(pChars, srcStr, numChars) == 0))
+		{
+			result = ~0;
+		}
+		SPUSH(result);
+		METHOD_RETURN;
+	}
+
+	// equalsString ( STRING_OR_VIEW -- BOOL )
+	FORTHOP(oStringViewEqualsStringMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		ForthObject compObj;
+		POP_OBJECT(compObj);
+		const char* pChars;
+		int numChars;
+		const char* pCompChars;
+		int compLen;
+		long result = 0;
+		getViewBytes(pView, pChars, numChars);
+		if (getStringBytes(compObj, pCompChars, compLen)
+			&& (compLen == numChars) && (memcmp(pChars, pCompChars, numChars) == 0))
+		{
+			result = ~0;
+		}
+		SPUSH(result);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringViewStartsWithMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* srcStr = (const char *)SPOP;
+		const char* pChars;
+		int numChars;
+		long result = 0;
+		getViewBytes(pView, pChars, numChars);
+		if (srcStr != NULL)
+		{
+			int len = (int)strlen(srcStr);
+			if ((len <= numChars) && (memcmp(pChars, srcStr, len) == 0))
+			{
+				result = ~0;
+			}
+		}
+		SPUSH(result);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringViewEndsWithMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* srcStr = (const char *)SPOP;
+		const char* pChars;
+		int numChars;
+		long result = 0;
+		getViewBytes(pView, pChars, numChars);
+		if (srcStr != NULL)
+		{
+			int len = (int)strlen(srcStr);
+			if ((len <= numChars) && (memcmp(pChars + (numChars - len), srcStr, len) == 0))
+			{
+				result = ~0;
+			}
+		}
+		SPUSH(result);
+		METHOD_RETURN;
+	}
+
+	// indexOf ( SUBSTRING -- INDEX )  INDEX is -1 if substring isn't found
+	FORTHOP(oStringViewIndexOfMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* srcStr = (const char *)SPOP;
+		const char* pChars;
+		int numChars;
+		cell result = -1;
+		getViewBytes(pView, pChars, numChars);
+		if (srcStr != NULL)
+		{
+			int len = (int)strlen(srcStr);
+			if (len == 0)
+			{
+				result = 0;
+			}
+			else
+			{
+				const char* pLast = pChars + (numChars - len);
+				for (const char* pSrc = pChars; pSrc <= pLast; pSrc++)
+				{
+					pSrc = (const char*)memchr(pSrc, *srcStr, (pLast - pSrc) + 1);
+					if (pSrc == nullptr)
+					{
+						break;
+					}
+					if (memcmp(pSrc, srcStr, len) == 0)
+					{
+						result = pSrc - pChars;
+						break;
+					}
+				}
+			}
+		}
+		SPUSH(result);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringViewContainsMethod)
+	{
+		oStringViewIndexOfMethod(pCore);
+		// indexOf has done the method return
+		cell index = SPOP;
+		SPUSH((index >= 0) ? ~0 : 0);
+	}
+
+	FORTHOP(oStringViewHashMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* pChars;
+		int numChars;
+		getViewBytes(pView, pChars, numChars);
+		SPUSH((cell)hashStringBytes(pChars, numChars));
+		METHOD_RETURN;
+	}
+
+	// slice ( FIRST_CHAR NUM_CHARS -- STRING_VIEW )  returns a view of part of this view
+	FORTHOP(oStringViewSliceMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		long numChars = SPOP;
+		long firstChar = SPOP;
+		const char* pChars;
+		int viewLen;
+		getViewBytes(pView, pChars, viewLen);
+		if ((firstChar < 0) || (numChars < 0))
+		{
+			GET_ENGINE->SetError(kForthErrorBadParameter, " StringView.slice negative first character or length");
+			firstChar = 0;
+			numChars = 0;
+		}
+		if (firstChar > viewLen)
+		{
+			firstChar = viewLen;
+		}
+		if (numChars > (viewLen - firstChar))
+		{
+			numChars = viewLen - firstChar;
+		}
+		oStringViewStruct* pSlice = createStringView((oStringStruct*)(pView->parent), pView->offset + firstChar, numChars);
+		PUSH_OBJECT(pSlice);
+		METHOD_RETURN;
+	}
+
+	// split ( ARRAY DELIMITER -- )  adds views of the delimited pieces of this view to ARRAY
+	FORTHOP(oStringViewSplitMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		int delimiter = SPOP;
+		ForthObject dstArrayObj;
+		POP_OBJECT(dstArrayObj);
+		oArrayStruct* pArray = (oArrayStruct *)(dstArrayObj);
+		const char* pChars;
+		int numChars;
+		getViewBytes(pView, pChars, numChars);
+		if ((pArray != nullptr) && (numChars != 0))
+		{
+			splitIntoViews((oStringStruct*)(pView->parent), pChars, numChars, delimiter, pArray);
+		}
+		METHOD_RETURN;
+	}
+
+	// toString ( -- STRING )  returns a new String holding a copy of the view
+	FORTHOP(oStringViewToStringMethod)
+	{
+		GET_THIS(oStringViewStruct, pView);
+		const char* pChars;
+		int numChars;
+		getViewBytes(pView, pChars, numChars);
+		MALLOCATE_OBJECT(oStringStruct, pString, gpStringClassVocab);
+		pString->pMethods = gpStringClassVocab->GetMethods();
+		pString->refCount = 0;
+		pString->hash = 0;
+		pString->str = createOString(numChars);
+		memcpy(&(pString->str->data[0]), pChars, numChars);
+		pString->str->data[numChars] = '\0';
+		pString->str->curLen = numChars;
+		PUSH_OBJECT(pString);
+		METHOD_RETURN;
+	}
+
+	baseMethodEntry oStringViewMembers[] =
+	{
+		METHOD("__newOp", oStringViewNew),
+		METHOD("delete", oStringViewDeleteMethod),
+		METHOD_RET("compare", oStringViewCompareMethod, RETURNS_NATIVE(kBaseTypeInt)),
+
+		METHOD("init", oStringViewInitMethod),
+		METHOD_RET("length", oStringViewLengthMethod, RETURNS_NATIVE(kBaseTypeInt)),
+		METHOD("getBytes", oStringViewGetBytesMethod),
+		METHOD_RET("equals", oStringViewEqualsMethod, RETURNS_NATIVE(kBaseTypeInt)),
+		METHOD_RET("equalsString", oStringViewEqualsStringMethod, RETURNS_NATIVE(kBaseTypeInt)),
+		METHOD_RET("startsWith", oStringViewStartsWithMethod, RETURNS_NATIVE(kBaseTypeInt)),
+		METHOD_RET("endsWith", oStringViewEndsWithMethod, RETURNS_NATIVE(kBaseTypeInt)),
+		METHOD_RET("contains", oStringViewContainsMethod, RETURNS_NATIVE(kBaseTypeInt)),
+		METHOD_RET("indexOf", oStringViewIndexOfMethod, RETURNS_NATIVE(kBaseTypeCell)),
+		METHOD_RET("hash", oStringViewHashMethod, RETURNS_NATIVE(kBaseTypeUCell)),
+		METHOD_RET("slice", oStringViewSliceMethod, RETURNS_OBJECT(kBCIStringView)),
+		METHOD("split", oStringViewSplitMethod),
+		METHOD_RET("toString", oStringViewToStringMethod, RETURNS_OBJECT(kBCIString)),
+
+		MEMBER_VAR("__parent", OBJECT_TYPE_TO_CODE(0, kBCIString)),
+		MEMBER_VAR("__offset", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
+		MEMBER_VAR("__length", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 StringBuilder
+	//
+
+	// adds an empty chunk with room for at least minChars to the end of the builder
+	oStringChunk* builderAddChunk(oStringBuilderStruct* pBuilder, int minChars)
+	{
+		int chunkSize = (minChars > pBuilder->chunkSize) ? minChars : pBuilder->chunkSize;
+		size_t nBytes = sizeof(oStringChunk) + (chunkSize + 1) - sizeof(((oStringChunk*)nullptr)->data);
+		oStringChunk* pChunk = (oStringChunk *)__MALLOC(nBytes);
+		pChunk->pNext = nullptr;
+		pChunk->used = 0;
+		pChunk->size = chunkSize;
+		if (pBuilder->pTail == nullptr)
+		{
+			pBuilder->pHead = pChunk;
+		}
+		else
+		{
+			pBuilder->pTail->pNext = pChunk;
+		}
+		pBuilder->pTail = pChunk;
+		return pChunk;
+	}
+
+	// frees the tail chunk, which must be empty, pPrevTail is the chunk before it or null
+	void builderRemoveTailChunk(oStringBuilderStruct* pBuilder, oStringChunk* pPrevTail)
+	{
+		__FREE(pBuilder->pTail);
+		if (pPrevTail == nullptr)
+		{
+			pBuilder->pHead = nullptr;
+		}
+		else
+		{
+			pPrevTail->pNext = nullptr;
+		}
+		pBuilder->pTail = pPrevTail;
+	}
+
+	void builderAppend(oStringBuilderStruct* pBuilder, const char* pSrc, int numChars)
+	{
+		oStringChunk* pChunk = pBuilder->pTail;
+		if (pChunk != nullptr)
+		{
+			// fill up the current tail chunk
+			int numToCopy = pChunk->size - pChunk->used;
+			if (numToCopy > numChars)
+			{
+				numToCopy = numChars;
+			}
+			memcpy(&(pChunk->data[pChunk->used]), pSrc, numToCopy);
+			pChunk->used += numToCopy;
+			pSrc += numToCopy;
+			numChars -= numToCopy;
+			pBuilder->length += numToCopy;
+		}
+		if (numChars > 0)
+		{
+			// whatever is left goes in one new chunk
+			pChunk = builderAddChunk(pBuilder, numChars);
+			memcpy(&(pChunk->data[0]), pSrc, numChars);
+			pChunk->used = numChars;
+			pBuilder->length += numChars;
+		}
+	}
+
+	void builderClear(oStringBuilderStruct* pBuilder)
+	{
+		oStringChunk* pChunk = pBuilder->pHead;
+		while (pChunk != nullptr)
+		{
+			oStringChunk* pNext = pChunk->pNext;
+			__FREE(pChunk);
+			pChunk = pNext;
+		}
+		pBuilder->pHead = nullptr;
+		pBuilder->pTail = nullptr;
+		pBuilder->length = 0;
+	}
+
+	FORTHOP(oStringBuilderNew)
+	{
+		ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+		MALLOCATE_OBJECT(oStringBuilderStruct, pBuilder, pClassVocab);
+		pBuilder->pMethods = pClassVocab->GetMethods();
+		pBuilder->refCount = 0;
+		pBuilder->pHead = nullptr;
+		pBuilder->pTail = nullptr;
+		pBuilder->length = 0;
+		pBuilder->chunkSize = STRING_BUILDER_DEFAULT_CHUNK_SIZE;
+		PUSH_OBJECT(pBuilder);
+	}
+
+	FORTHOP(oStringBuilderDeleteMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		builderClear(pBuilder);
+		FREE_OBJECT(pBuilder);
+		METHOD_RETURN;
+	}
+
+	// setChunkSize ( NUM_BYTES -- )  only affects chunks which are added after this
+	FORTHOP(oStringBuilderSetChunkSizeMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		int chunkSize = (int)SPOP;
+		if (chunkSize <= 0)
+		{
+			GET_ENGINE->SetError(kForthErrorBadParameter, " StringBuilder.setChunkSize size must be positive");
+		}
+		else
+		{
+			pBuilder->chunkSize = chunkSize;
+		}
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringBuilderLengthMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		SPUSH(pBuilder->length);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringBuilderClearMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		builderClear(pBuilder);
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringBuilderAppendMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		const char* srcStr = (const char *)SPOP;
+		if (srcStr != nullptr)
+		{
+			builderAppend(pBuilder, srcStr, (int)strlen(srcStr));
+		}
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringBuilderAppendBytesMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		int numChars = (int)SPOP;
+		const char* pSrc = (const char *)SPOP;
+		if ((pSrc != nullptr) && (numChars > 0))
+		{
+			builderAppend(pBuilder, pSrc, numChars);
+		}
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringBuilderAppendCharMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		char ch = (char)SPOP;
+		builderAppend(pBuilder, &ch, 1);
+		METHOD_RETURN;
+	}
+
+	// appendString ( STRING_OR_VIEW -- )
+	FORTHOP(oStringBuilderAppendStringMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		ForthObject srcObj;
+		POP_OBJECT(srcObj);
+		const char* pChars;
+		int numChars;
+		if (getStringBytes(srcObj, pChars, numChars))
+		{
+			builderAppend(pBuilder, pChars, numChars);
+		}
+		METHOD_RETURN;
+	}
+
+	FORTHOP(oStringBuilderAppendFormattedMethod)
+	{
+		// TOS: N argN ... arg1 formatStr     (arg1 to argN are optional)
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		oStringChunk* pChunk = pBuilder->pTail;
+		// the tail before any chunk is added here, a chunk added for a failed try is unlinked
+		oStringChunk* pOldTail = pBuilder->pTail;
+		int newChunkSize = pBuilder->chunkSize;
+		cell* oldSP = pCore->SP;
+		bool tryAgain = true;
+		while (tryAgain)
+		{
+			if (pChunk == nullptr)
+			{
+				pChunk = builderAddChunk(pBuilder, newChunkSize);
+			}
+			int roomLeft = pChunk->size - pChunk->used;
+			cell numChars = oStringFormatSub(pCore, &(pChunk->data[pChunk->used]), roomLeft + 1);
+			if ((numChars >= 0) && (numChars <= roomLeft))
+			{
+				tryAgain = false;
+				pChunk->used += (int)numChars;
+				pBuilder->length += numChars;
+				continue;
+			}
+
+			if (pChunk != pOldTail)
+			{
+				builderRemoveTailChunk(pBuilder, pOldTail);
+			}
+			if (newChunkSize >= OSTRING_PRINTF_LAST_OVERFLOW_SIZE)
+			{
+				// format args have been consumed
+				tryAgain = false;
+				GET_ENGINE->SetError(kForthErrorBadParameter, " StringBuilder.appendFormatted result too long");
+			}
+			else
+			{
+				// snprintf returns the needed length if it is standard, -1 if it isn't
+				if (numChars > newChunkSize)
+				{
+					newChunkSize = (int)numChars;
+				}
+				else if ((numChars < 0) && (roomLeft >= newChunkSize))
+				{
+					newChunkSize <<= 1;
+				}
+				pChunk = nullptr;
+				pCore->SP = oldSP;
+			}
+		}
+		METHOD_RETURN;
+	}
+
+	// toString ( -- STRING )  returns a new String holding all the text in the builder
+	FORTHOP(oStringBuilderToStringMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		int numChars = (int)(pBuilder->length);
+		MALLOCATE_OBJECT(oStringStruct, pString, gpStringClassVocab);
+		pString->pMethods = gpStringClassVocab->GetMethods();
+		pString->refCount = 0;
+		pString->hash = 0;
+		pString->str = createOString(numChars);
+		char* pDst = &(pString->str->data[0]);
+		for (oStringChunk* pChunk = pBuilder->pHead; pChunk != nullptr; pChunk = pChunk->pNext)
+		{
+			memcpy(pDst, &(pChunk->data[0]), pChunk->used);
+			pDst += pChunk->used;
+		}
+		*pDst = '\0';
+		pString->str->curLen = numChars;
+		PUSH_OBJECT(pString);
+		METHOD_RETURN;
+	}
+
+	// writeTo ( OUT_STREAM -- )  writes the chunks to the stream without joining them
+	FORTHOP(oStringBuilderWriteToMethod)
+	{
+		GET_THIS(oStringBuilderStruct, pBuilder);
+		ForthObject streamObj;
+		POP_OBJECT(streamObj);
+		std::vector<ForthOutBlock> blocks;
+		for (oStringChunk* pChunk = pBuilder->pHead; pChunk != nullptr; pChunk = pChunk->pNext)
+		{
+			if (pChunk->used != 0)
+			{
+				ForthOutBlock block;
+				block.pData = &(pChunk->data[0]);
+				block.numBytes = pChunk->used;
+				blocks.push_back(block);
+			}
+		}
+		if (!blocks.empty())
+		{
+			ForthStreamGatherOut(pCore, streamObj, &(blocks[0]), (int)blocks.size());
+		}
+		METHOD_RETURN;
+	}
+
+	baseMethodEntry oStringBuilderMembers[] =
+	{
+		METHOD("__newOp", oStringBuilderNew),
+		METHOD("delete", oStringBuilderDeleteMethod),
+
+		METHOD("setChunkSize", oStringBuilderSetChunkSizeMethod),
+		METHOD_RET("length", oStringBuilderLengthMethod, RETURNS_NATIVE(kBaseTypeCell)),
+		METHOD("clear", oStringBuilderClearMethod),
+		METHOD("append", oStringBuilderAppendMethod),
+		METHOD("appendBytes", oStringBuilderAppendBytesMethod),
+		METHOD("appendChar", oStringBuilderAppendCharMethod),
+		METHOD("appendString", oStringBuilderAppendStringMethod),
+		METHOD("appendFormatted", oStringBuilderAppendFormattedMethod),
+		METHOD_RET("toString", oStringBuilderToStringMethod, RETURNS_OBJECT(kBCIString)),
+		METHOD("writeTo", oStringBuilderWriteToMethod),
+
+		MEMBER_VAR("__head", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+		MEMBER_VAR("__tail", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell)),
+		MEMBER_VAR("__length", NATIVE_TYPE_TO_CODE(0, kBaseTypeUCell)),
+		MEMBER_VAR("__chunkSize", NATIVE_TYPE_TO_CODE(0, kBaseTypeInt)),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+
 	//////////////////////////////////////////////////////////////////////
 	///
 	//                 StringMap
@@ -1042,13 +1973,10 @@ namespace OString
     FORTHOP(oStringMapHeadIterMethod)
     {
         GET_THIS(oStringMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oStringMapIterStruct* pIter = new oStringMapIterStruct;
-        TRACK_ITER_NEW;
         ForthClassVocabulary *pClassVocab = GET_CLASS_VOCABULARY(kBCIStringMapIter);
+        MALLOCATE_ITER(oStringMapIterStruct, pIter, pClassVocab);
         pIter->pMethods = pClassVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -1061,13 +1989,10 @@ namespace OString
     FORTHOP(oStringMapTailIterMethod)
     {
         GET_THIS(oStringMapStruct, pMap);
-        pMap->refCount++;
+        INCREMENT_REFCOUNT(pMap);
         TRACK_KEEP;
-        // needed to use new instead of malloc otherwise the iterator isn't setup right and
-        //   a crash happens when you assign to it
-        oStringMapIterStruct* pIter = new oStringMapIterStruct;
-        TRACK_ITER_NEW;
         ForthClassVocabulary *pClassVocab = GET_CLASS_VOCABULARY(kBCIStringMapIter);
+        MALLOCATE_ITER(oStringMapIterStruct, pIter, pClassVocab);
         pIter->pMethods = pClassVocab->GetMethods();
         pIter->refCount = 0;
         pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -1091,13 +2016,10 @@ namespace OString
             if (OBJECTS_SAME(o, soughtObj))
             {
                 found = ~0;
-                pMap->refCount++;
+                INCREMENT_REFCOUNT(pMap);
                 TRACK_KEEP;
-                // needed to use new instead of malloc otherwise the iterator isn't setup right and
-                //   a crash happens when you assign to it
-                oStringMapIterStruct* pIter = new oStringMapIterStruct;
-                TRACK_ITER_NEW;
                 ForthClassVocabulary *pClassVocab = GET_CLASS_VOCABULARY(kBCIStringMapIter);
+                MALLOCATE_ITER(oStringMapIterStruct, pIter, pClassVocab);
                 pIter->pMethods = pClassVocab->GetMethods();
                 pIter->refCount = 0;
                 pIter->parent = reinterpret_cast<ForthObject>(pMap);
@@ -1288,8 +2210,7 @@ namespace OString
 		GET_THIS(oStringMapIterStruct, pIter);
 		SAFE_RELEASE(pCore, pIter->parent);
 		delete pIter->cursor;
-		delete pIter;
-		TRACK_ITER_DELETE;
+		FREE_ITER(pIter);
 		METHOD_RETURN;
 	}
 
@@ -1501,6 +2422,40 @@ namespace OString
         return false;
     }
 
+    void stringBinaryWriter(ForthObject& obj, ForthBinaryWriter* writer)
+    {
+        oString* pStr = reinterpret_cast<oStringStruct*>(obj)->str;
+        writer->WriteString(&(pStr->data[0]), pStr->curLen);
+    }
+
+    void stringBinaryReader(ForthObject& obj, ForthBinaryReader* reader)
+    {
+        oStringStruct* pString = reinterpret_cast<oStringStruct*>(obj);
+        uint32_t len = reader->ReadU32();
+        reader->CheckCount(len, 1);
+        oString* dst = pString->str;
+        if ((long) len > dst->maxLen)
+        {
+            dst = resizeOString(pString, len);
+        }
+        reader->ReadBytes(&(dst->data[0]), len);
+        dst->data[len] = '\0';
+        dst->curLen = len;
+        pString->hash = 0;
+    }
+
+    void stringMapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        oStringMapStruct* pMap = reinterpret_cast<oStringMapStruct*>(obj);
+        for (oStringMap::iterator iter = pMap->elements->begin(); iter != pMap->elements->end(); ++iter)
+        {
+            if (iter->second != nullptr)
+            {
+                visitor(iter->second, pUserData);
+            }
+        }
+    }
+
     bool customStringMapReader(const std::string& elementName, ForthObjectReader* reader)
     {
         if (elementName == "map")
@@ -1534,13 +2489,31 @@ namespace OString
 
     void AddClasses(ForthEngine* pEngine)
 	{
+#if defined(WINDOWS_BUILD)
+        if (gpInternLock == nullptr)
+        {
+            gpInternLock = new CRITICAL_SECTION();
+            InitializeCriticalSection(gpInternLock);
+        }
+#endif
         gpStringClassVocab = pEngine->AddBuiltinClass("String", kBCIString, kBCIObject, oStringMembers);
         gpStringClassVocab->SetCustomObjectReader(customStringReader);
+        gpStringClassVocab->SetCustomBinarySerializer(stringBinaryWriter, stringBinaryReader);
+
+        // an InternedString which is read back from a file is a read-only copy, it isn't in the intern table
+        gpInternedStringClassVocab = pEngine->AddBuiltinClass("InternedString", kBCIInternedString, kBCIString, oInternedStringMembers);
+        gpInternedStringClassVocab->SetCustomObjectReader(customStringReader);
+        gpInternedStringClassVocab->SetCustomBinarySerializer(stringBinaryWriter, stringBinaryReader);
 
         gpStringMapClassVocab = pEngine->AddBuiltinClass("StringMap", kBCIStringMap, kBCIIterable, oStringMapMembers);
         gpStringMapClassVocab->SetCustomObjectReader(customStringMapReader);
+        gpStringMapClassVocab->SetCustomChildVisitor(stringMapChildVisitor);
 
         pEngine->AddBuiltinClass("StringMapIter", kBCIStringMapIter, kBCIIter, oStringMapIterMembers);
+
+        gpStringViewClassVocab = pEngine->AddBuiltinClass("StringView", kBCIStringView, kBCIObject, oStringViewMembers);
+
+        gpStringBuilderClassVocab = pEngine->AddBuiltinClass("StringBuilder", kBCIStringBuilder, kBCIObject, oStringBuilderMembers);
 	}
 
 } // namespace oString
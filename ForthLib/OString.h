@@ -10,6 +10,8 @@
 #define OSTRING_PRINTF_FIRST_OVERFLOW_SIZE 256
 // this is size limit of buffer expansion upon OString:printf overflow
 #define OSTRING_PRINTF_LAST_OVERFLOW_SIZE 0x2000000
+// default size of the chunks StringBuilder text is stored in
+#define STRING_BUILDER_DEFAULT_CHUNK_SIZE 4096
 
 
 namespace OString
@@ -30,11 +32,59 @@ namespace OString
         oStringMap::iterator	*cursor;
     };
 
+    // a StringView is a slice of a String which doesn't copy its characters.  It keeps its
+    //   parent String alive and sees the parent's current contents, if the parent gets
+    //   shorter than offset + length the view is cut short too.
+    struct oStringViewStruct
+    {
+        forthop*    pMethods;
+        ucell       refCount;
+        ForthObject parent;
+        ucell       offset;
+        ucell       length;
+    };
+
+    // StringBuilder text is kept in a list of chunks, so appending never moves text which
+    //   is already in the builder.  Chunks are usually chunkSize bytes, a single append
+    //   larger than that gets a chunk of its own.
+    struct oStringChunk
+    {
+        oStringChunk*   pNext;
+        int             used;
+        int             size;
+        // actually size + 1 bytes, room for the nul snprintf adds
+        char            data[4];
+    };
+
+    struct oStringBuilderStruct
+    {
+        forthop*        pMethods;
+        ucell           refCount;
+        oStringChunk*   pHead;
+        oStringChunk*   pTail;
+        ucell           length;
+        int             chunkSize;
+    };
+
     extern oString* createOString(int maxChars);
 	extern oString* resizeOString(oStringStruct* pString, int newLen);
 	extern void appendOString(oStringStruct* pString, const char* pSrc, int numNewBytes);
 	extern void prependOString(oStringStruct* pString, const char* pSrc, int numNewBytes);
 
+    // string hash values are never 0 or 1, oStringStruct::hash is 0 until getOStringHash computes it
+    extern ucell hashStringBytes(const char* pChars, int numChars);
+    extern ucell getOStringHash(oStringStruct* pString);
+    // returns the single permanent InternedString object for the text pChars, whose hash must be passed in,
+    //   interned strings can be compared by pointer, so their methods which modify the text are errors
+    extern ForthObject internString(const char* pChars, ucell hash);
+
+    // creates a StringView with refCount 0 which holds a reference to pParent
+    extern oStringViewStruct* createStringView(oStringStruct* pParent, ucell offset, ucell length);
+    // gets the characters of a String or StringView, returns false if obj is neither
+    extern bool getStringBytes(ForthObject obj, const char*& pChars, int& numChars);
+    // true if obj is an instance of pClassVocab or of a class derived from it
+    extern bool objectIsA(ForthObject obj, ForthClassVocabulary* pClassVocab);
+
     // functions for string output streams
 	extern void stringCharOut( ForthCoreState* pCore, void *pData, char ch );
 	extern void stringBlockOut( ForthCoreState* pCore, void *pData, const char *pBuffer, int numChars );
@@ -47,8 +97,13 @@ namespace OString
     extern int gDefaultOStringSize;
     extern ForthClassVocabulary* gpStringClassVocab;
     extern ForthClassVocabulary* gpStringMapClassVocab;
+    extern ForthClassVocabulary* gpStringViewClassVocab;
+    extern ForthClassVocabulary* gpInternedStringClassVocab;
+    extern ForthClassVocabulary* gpStringBuilderClassVocab;
 
     extern baseMethodEntry oStringMembers[];
     extern baseMethodEntry oStringMapMembers[];
     extern baseMethodEntry oStringMapIterMembers[];
+    extern baseMethodEntry oStringViewMembers[];
+    extern baseMethodEntry oStringBuilderMembers[];
 } // namespace oString
@@ -0,0 +1,994 @@
+//////////////////////////////////////////////////////////////////////
+//
+// OTreeMap.cpp: builtin B+tree ordered map related classes
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "pch.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "ForthEngine.h"
+#include "ForthVocabulary.h"
+#include "ForthObject.h"
+#include "ForthBuiltinClasses.h"
+#include "ForthShowContext.h"
+#include "ForthObjectReader.h"
+#include "ForthMemoryManager.h"
+
+#include "OTreeMap.h"
+#include "OString.h"
+#include "OArray.h"
+
+// The tree map classes have the same methods as the std::map based classes in OMap.cpp,
+//   plus lowerBound/upperBound which return iterators, countRange, removeRange and bulkLoad.
+// Ranges are half open, "lo hi countRange" counts the keys k with lo <= k < hi.
+// Iterators on a tree map stay usable while the map is changed, if the entry an iterator
+//   is on is removed, the iterator moves to the next entry.
+// All the tree map classes share the same method implementations, which are templated
+//   on a KEYOPS class that describes the key type:
+//   KeyType        type of keys stored in the tree
+//   LookupType     type of keys popped off the param stack
+//   kIterClass     builtin class index of the iterator class
+//   PopKey/PushKey move keys between the param stack and native code
+//   ShowKey        show a key as an element name for showInner
+//   ParseKey       convert an element name back to a key for the object reader
+//   GetKeys        get the keys for bulkLoad out of a keys array object
+
+namespace OTreeMap
+{
+    template <class KEYOPS>
+    struct oTreeMapStruct
+    {
+        forthop*        pMethods;
+        ulong           refCount;
+        ForthBTree<typename KEYOPS::KeyType>* elements;
+    };
+
+    template <class KEYOPS>
+    struct oTreeMapIterStruct
+    {
+        forthop*        pMethods;
+        ulong           refCount;
+        ForthObject     parent;
+        typename ForthBTree<typename KEYOPS::KeyType>::Cursor* cursor;
+    };
+
+    bool isObjectOfClass(ForthObject obj, eBuiltinClassIndex classIndex)
+    {
+        if (obj == nullptr)
+        {
+            return false;
+        }
+        ForthClassObject* pClassObject = GET_CLASS_OBJECT(obj);
+        return pClassObject->pVocab == GET_CLASS_VOCABULARY(classIndex);
+    }
+
+    using OArray::getNumericArrayKeys;
+
+    struct IntKeyOps
+    {
+        typedef long KeyType;
+        typedef long LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCIIntTreeMapIter;
+
+        static inline void PopKey(ForthCoreState* pCore, long& key) { key = (long)SPOP; }
+        static inline void PushKey(ForthCoreState* pCore, long key) { SPUSH(key); }
+        static inline void ShowKey(ForthShowContext* pShowContext, long key)
+        {
+            char buffer[32];
+            sprintf(buffer, "%ld", key);
+            pShowContext->BeginElement(buffer);
+        }
+        static inline void ParseKey(const std::string& keyText, long& key)
+        {
+            sscanf(keyText.c_str(), "%ld", &key);
+        }
+        static inline bool GetKeys(ForthObject keysObj, std::vector<long>& keys)
+        {
+            return getNumericArrayKeys<int>(keysObj, kBCIIntArray, keys);
+        }
+    };
+
+    struct LongKeyOps
+    {
+        typedef int64_t KeyType;
+        typedef int64_t LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCILongTreeMapIter;
+
+        static inline void PopKey(ForthCoreState* pCore, int64_t& key)
+        {
+            stackInt64 val;
+            LPOP(val);
+            key = val.s64;
+        }
+        static inline void PushKey(ForthCoreState* pCore, int64_t key)
+        {
+            stackInt64 val;
+            val.s64 = key;
+            LPUSH(val);
+        }
+        static inline void ShowKey(ForthShowContext* pShowContext, int64_t key)
+        {
+            char buffer[32];
+            sprintf(buffer, "%lld", (long long)key);
+            pShowContext->BeginElement(buffer);
+        }
+        static inline void ParseKey(const std::string& keyText, int64_t& key)
+        {
+            long long val = 0;
+            sscanf(keyText.c_str(), "%lld", &val);
+            key = val;
+        }
+        static inline bool GetKeys(ForthObject keysObj, std::vector<int64_t>& keys)
+        {
+            return getNumericArrayKeys<int64_t>(keysObj, kBCILongArray, keys);
+        }
+    };
+
+    struct DoubleKeyOps
+    {
+        typedef double KeyType;
+        typedef double LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCIDoubleTreeMapIter;
+
+        static inline void PopKey(ForthCoreState* pCore, double& key)
+        {
+            key = DPOP;
+        }
+        static inline void PushKey(ForthCoreState* pCore, double key)
+        {
+            DPUSH(key);
+        }
+        static inline void ShowKey(ForthShowContext* pShowContext, double key)
+        {
+            char buffer[64];
+            sprintf(buffer, "%g", key);
+            pShowContext->BeginElement(buffer);
+        }
+        static inline void ParseKey(const std::string& keyText, double& key)
+        {
+            sscanf(keyText.c_str(), "%lf", &key);
+        }
+        static inline bool GetKeys(ForthObject keysObj, std::vector<double>& keys)
+        {
+            return getNumericArrayKeys<double>(keysObj, kBCIDoubleArray, keys);
+        }
+    };
+
+    struct StringKeyOps
+    {
+        typedef std::string KeyType;
+        // lookups use the C string on the param stack so they don't have to build a std::string
+        typedef const char* LookupType;
+        static const eBuiltinClassIndex kIterClass = kBCIStringTreeMapIter;
+
+        // a null key is treated as an empty string
+        static inline void PopKey(ForthCoreState* pCore, const char*& key)
+        {
+            key = (const char*)(SPOP);
+            if (key == nullptr)
+            {
+                key = "";
+            }
+        }
+        // keys move around inside the tree as it changes, so push a temp string copy of the key
+        static inline void PushKey(ForthCoreState* pCore, const std::string& key)
+        {
+            SPUSH((cell)(GET_ENGINE->AddTempString(key.c_str(), (int)key.size())));
+        }
+        static inline void ShowKey(ForthShowContext* pShowContext, const std::string& key)
+        {
+            pShowContext->BeginElement(key.c_str());
+        }
+        static inline void ParseKey(const std::string& keyText, std::string& key)
+        {
+            key = keyText;
+        }
+        // string map keys come from an Array of String or StringView objects
+        static bool GetKeys(ForthObject keysObj, std::vector<std::string>& keys)
+        {
+            if (!isObjectOfClass(keysObj, kBCIArray))
+            {
+                return false;
+            }
+            oArray& a = *(reinterpret_cast<oArrayStruct *>(keysObj)->elements);
+            keys.resize(a.size());
+            for (size_t i = 0; i < a.size(); i++)
+            {
+                const char* pChars;
+                int numChars;
+                if (!OString::getStringBytes(a[i], pChars, numChars))
+                {
+                    return false;
+                }
+                keys[i].assign(pChars, numChars);
+            }
+            return true;
+        }
+    };
+
+    template <class KEYOPS>
+    struct TreeMapTypes
+    {
+        typedef ForthBTree<typename KEYOPS::KeyType> TreeType;
+        typedef typename TreeType::Cursor CursorType;
+        typedef typename TreeType::Leaf LeafType;
+    };
+
+    // set value for key, a null value removes key from map
+    template <class KEYOPS, class LOOKUP>
+    void setTreeMap(oTreeMapStruct<KEYOPS>* pMap, const LOOKUP& key, ForthObject& valueObj, ForthCoreState* pCore)
+    {
+        typename TreeMapTypes<KEYOPS>::TreeType& a = *(pMap->elements);
+        if (valueObj != nullptr)
+        {
+            bool isNew;
+            ForthObject* pValue = a.Insert(key, isNew);
+            if (isNew)
+            {
+                SAFE_KEEP(valueObj);
+            }
+            else if (OBJECTS_DIFFERENT(*pValue, valueObj))
+            {
+                SAFE_KEEP(valueObj);
+                SAFE_RELEASE(pCore, *pValue);
+            }
+            *pValue = valueObj;
+        }
+        else
+        {
+            // remove element associated with key from map
+            ForthObject oldValue;
+            if (a.Remove(key, oldValue))
+            {
+                SAFE_RELEASE(pCore, oldValue);
+            }
+        }
+    }
+
+    template <class KEYOPS>
+    void releaseTreeMapEntries(oTreeMapStruct<KEYOPS>* pMap, ForthCoreState* pCore)
+    {
+        typedef typename TreeMapTypes<KEYOPS>::LeafType LeafType;
+        for (LeafType* pLeaf = pMap->elements->FirstLeaf(); pLeaf != nullptr; pLeaf = pLeaf->pNext)
+        {
+            for (int i = 0; i < pLeaf->count; i++)
+            {
+                SAFE_RELEASE(pCore, pLeaf->values[i]);
+            }
+        }
+        pMap->elements->Clear();
+    }
+
+    template <class KEYOPS>
+    void treeMapChildVisitor(ForthObject& obj, ObjectVisitor visitor, void* pUserData)
+    {
+        typedef typename TreeMapTypes<KEYOPS>::LeafType LeafType;
+        oTreeMapStruct<KEYOPS>* pMap = reinterpret_cast<oTreeMapStruct<KEYOPS>*>(obj);
+        for (LeafType* pLeaf = pMap->elements->FirstLeaf(); pLeaf != nullptr; pLeaf = pLeaf->pNext)
+        {
+            for (int i = 0; i < pLeaf->count; i++)
+            {
+                if (pLeaf->values[i] != nullptr)
+                {
+                    visitor(pLeaf->values[i], pUserData);
+                }
+            }
+        }
+    }
+
+    // creates an iterator positioned at the start of the map, caller seeks it to where it should be
+    template <class KEYOPS>
+    oTreeMapIterStruct<KEYOPS>* createTreeMapIterator(ForthCoreState* pCore, oTreeMapStruct<KEYOPS>* pMap)
+    {
+        INCREMENT_REFCOUNT(pMap);
+        TRACK_KEEP;
+        ForthClassVocabulary *pIterVocab = ForthTypesManager::GetInstance()->GetClassVocabulary(KEYOPS::kIterClass);
+        MALLOCATE_ITER(oTreeMapIterStruct<KEYOPS>, pIter, pIterVocab);
+        pIter->pMethods = pIterVocab->GetMethods();
+        pIter->refCount = 0;
+        pIter->parent = reinterpret_cast<ForthObject>(pMap);
+        pIter->cursor = new typename TreeMapTypes<KEYOPS>::CursorType;
+        pMap->elements->SeekFirst(*(pIter->cursor));
+        return pIter;
+    }
+
+
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 TreeMap family methods
+	//
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapNew)
+	{
+		ForthClassVocabulary *pClassVocab = (ForthClassVocabulary *)(SPOP);
+		MALLOCATE_OBJECT(oTreeMapStruct<KEYOPS>, pMap, pClassVocab);
+        pMap->pMethods = pClassVocab->GetMethods();
+		pMap->refCount = 0;
+		pMap->elements = new typename TreeMapTypes<KEYOPS>::TreeType;
+		PUSH_OBJECT(pMap);
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapDeleteMethod)
+	{
+		// go through all elements and release any which are not null
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        releaseTreeMapEntries(pMap, pCore);
+		delete pMap->elements;
+		FREE_OBJECT(pMap);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapShowInnerMethod)
+	{
+        typedef typename TreeMapTypes<KEYOPS>::LeafType LeafType;
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        GET_SHOW_CONTEXT;
+        pShowContext->BeginElement("map");
+        pShowContext->ShowTextReturn("{");
+        pShowContext->BeginNestedShow();
+        if (pMap->elements->Count() > 0)
+		{
+			pShowContext->BeginIndent();
+            for (LeafType* pLeaf = pMap->elements->FirstLeaf(); pLeaf != nullptr; pLeaf = pLeaf->pNext)
+            {
+                for (int i = 0; i < pLeaf->count; i++)
+                {
+                    KEYOPS::ShowKey(pShowContext, pLeaf->keys[i]);
+                    ForthShowObject(pLeaf->values[i], pCore);
+                    pShowContext->EndElement();
+                }
+            }
+			pShowContext->EndIndent();
+			pShowContext->ShowIndent();
+		}
+        pShowContext->ShowTextReturn();
+        pShowContext->ShowIndent();
+        pShowContext->EndElement("}");
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapHeadIterMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        oTreeMapIterStruct<KEYOPS>* pIter = createTreeMapIterator(pCore, pMap);
+        PUSH_OBJECT(pIter);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapTailIterMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        oTreeMapIterStruct<KEYOPS>* pIter = createTreeMapIterator(pCore, pMap);
+        pMap->elements->SeekEnd(*(pIter->cursor));
+        PUSH_OBJECT(pIter);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapFindMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        long found = 0;
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        if (pMap->elements->Find(key) != nullptr)
+        {
+            oTreeMapIterStruct<KEYOPS>* pIter = createTreeMapIterator(pCore, pMap);
+            pMap->elements->SeekLowerBound(*(pIter->cursor), key);
+            PUSH_OBJECT(pIter);
+            found = ~0;
+        }
+        SPUSH(found);
+        METHOD_RETURN;
+    }
+
+    // lowerBound returns an iterator on the first entry with key >= given key,
+    //   upperBound returns an iterator on the first entry with key > given key
+    template <class KEYOPS>
+    FORTHOP(oTreeMapLowerBoundMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        oTreeMapIterStruct<KEYOPS>* pIter = createTreeMapIterator(pCore, pMap);
+        pMap->elements->SeekLowerBound(*(pIter->cursor), key);
+        PUSH_OBJECT(pIter);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapUpperBoundMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        oTreeMapIterStruct<KEYOPS>* pIter = createTreeMapIterator(pCore, pMap);
+        pMap->elements->SeekUpperBound(*(pIter->cursor), key);
+        PUSH_OBJECT(pIter);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapCountMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        SPUSH((cell)(pMap->elements->Count()));
+        METHOD_RETURN;
+    }
+
+    // countRange ( lo hi -- n )
+    template <class KEYOPS>
+    FORTHOP(oTreeMapCountRangeMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType hi;
+        KEYOPS::PopKey(pCore, hi);
+        typename KEYOPS::LookupType lo;
+        KEYOPS::PopKey(pCore, lo);
+        SPUSH((cell)(pMap->elements->CountRange(lo, hi)));
+        METHOD_RETURN;
+    }
+
+    // removeRange ( lo hi -- )
+    template <class KEYOPS>
+    FORTHOP(oTreeMapRemoveRangeMethod)
+    {
+        typedef typename TreeMapTypes<KEYOPS>::TreeType TreeType;
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType hi;
+        KEYOPS::PopKey(pCore, hi);
+        typename KEYOPS::LookupType lo;
+        KEYOPS::PopKey(pCore, lo);
+        TreeType& a = *(pMap->elements);
+        // gather the keys first, since each removal can move entries between leaves
+        std::vector<typename KEYOPS::KeyType> keys;
+        typename TreeType::Cursor cursor;
+        for (a.SeekLowerBound(cursor, lo); a.IsValid(cursor) && (a.CursorKey(cursor) < hi); a.SeekNext(cursor))
+        {
+            keys.push_back(a.CursorKey(cursor));
+        }
+        for (const typename KEYOPS::KeyType& key : keys)
+        {
+            ForthObject oldValue;
+            if (a.Remove(key, oldValue))
+            {
+                SAFE_RELEASE(pCore, oldValue);
+            }
+        }
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapClearMethod)
+	{
+		// go through all elements and release any which are not null
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        releaseTreeMapEntries(pMap, pCore);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapGrabMethod)
+	{
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        long found = 0;
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ForthObject* pValue = pMap->elements->Find(key);
+        if (pValue != nullptr)
+		{
+			ForthObject fobj = *pValue;
+			PUSH_OBJECT(fobj);
+            found = ~0;
+		}
+        SPUSH(found);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapSetMethod)
+	{
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ForthObject newObj;
+        POP_OBJECT(newObj);
+        setTreeMap(pMap, key, newObj, pCore);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapLoadMethod)
+    {
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        releaseTreeMapEntries(pMap, pCore);
+        cell n = SPOP;
+        for (cell i = 0; i < n; i++)
+        {
+            typename KEYOPS::LookupType key;
+            KEYOPS::PopKey(pCore, key);
+            ForthObject newObj;
+            POP_OBJECT(newObj);
+            setTreeMap(pMap, key, newObj, pCore);
+        }
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    bool bulkLoadEntryLess(const std::pair<typename KEYOPS::KeyType, ForthObject>& a,
+        const std::pair<typename KEYOPS::KeyType, ForthObject>& b)
+    {
+        return a.first < b.first;
+    }
+
+    // bulkLoad ( keysArray valuesArray -- )
+    // replace contents of map with the elements of valuesArray keyed by the matching elements
+    //   of keysArray, null values are skipped, and if a key appears more than once the
+    //   last value for it is used.  Keys which are already sorted are loaded without sorting.
+    template <class KEYOPS>
+    FORTHOP(oTreeMapBulkLoadMethod)
+    {
+        typedef typename KEYOPS::KeyType KeyType;
+        typedef std::pair<KeyType, ForthObject> EntryType;
+        GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        ForthObject valuesObj;
+        POP_OBJECT(valuesObj);
+        ForthObject keysObj;
+        POP_OBJECT(keysObj);
+        std::vector<KeyType> keys;
+        if (!KEYOPS::GetKeys(keysObj, keys))
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " bulkLoad keys array is wrong type");
+        }
+        else if (!isObjectOfClass(valuesObj, kBCIArray))
+        {
+            GET_ENGINE->SetError(kForthErrorBadParameter, " bulkLoad values must be an Array");
+        }
+        else
+        {
+            oArray& values = *(reinterpret_cast<oArrayStruct *>(valuesObj)->elements);
+            if (values.size() != keys.size())
+            {
+                GET_ENGINE->SetError(kForthErrorBadParameter, " bulkLoad keys and values arrays must be same size");
+            }
+            else
+            {
+                std::vector<EntryType> entries;
+                entries.reserve(keys.size());
+                bool isSorted = true;
+                for (size_t i = 0; i < keys.size(); i++)
+                {
+                    if (values[i] != nullptr)
+                    {
+                        if (!entries.empty() && !(entries.back().first < keys[i]))
+                        {
+                            isSorted = false;
+                        }
+                        entries.push_back(EntryType(KeyType(), values[i]));
+                        std::swap(entries.back().first, keys[i]);
+                    }
+                }
+                if (!isSorted)
+                {
+                    // stable sort keeps duplicate keys in array order, then keep the last of each run
+                    std::stable_sort(entries.begin(), entries.end(), bulkLoadEntryLess<KEYOPS>);
+                    size_t numUnique = 0;
+                    for (size_t i = 0; i < entries.size(); i++)
+                    {
+                        if ((i + 1) < entries.size() && !(entries[i].first < entries[i + 1].first))
+                        {
+                            continue;
+                        }
+                        if (numUnique != i)
+                        {
+                            std::swap(entries[numUnique], entries[i]);
+                        }
+                        numUnique++;
+                    }
+                    entries.resize(numUnique);
+                }
+                // keep new values before releasing old ones, in case they are the same objects
+                for (EntryType& entry : entries)
+                {
+                    SAFE_KEEP(entry.second);
+                }
+                releaseTreeMapEntries(pMap, pCore);
+                pMap->elements->BulkLoad(entries);
+            }
+        }
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapFindValueMethod)
+	{
+        typedef typename TreeMapTypes<KEYOPS>::LeafType LeafType;
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+		long found = 0;
+		ForthObject soughtObj;
+		POP_OBJECT(soughtObj);
+        for (LeafType* pLeaf = pMap->elements->FirstLeaf(); (pLeaf != nullptr) && !found; pLeaf = pLeaf->pNext)
+        {
+            for (int i = 0; i < pLeaf->count; i++)
+            {
+                if (OBJECTS_SAME(pLeaf->values[i], soughtObj))
+                {
+                    found = ~0;
+                    KEYOPS::PushKey(pCore, pLeaf->keys[i]);
+                    break;
+                }
+            }
+        }
+		SPUSH(found);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapRemoveMethod)
+	{
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ForthObject nullObj = nullptr;
+        setTreeMap(pMap, key, nullObj, pCore);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapUnrefMethod)
+	{
+		GET_THIS(oTreeMapStruct<KEYOPS>, pMap);
+        typename KEYOPS::LookupType key;
+        KEYOPS::PopKey(pCore, key);
+        ForthObject fobj;
+        if (pMap->elements->Remove(key, fobj))
+		{
+			unrefObject(fobj);
+			PUSH_OBJECT(fobj);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    bool customTreeMapReader(const std::string& elementName, ForthObjectReader* reader)
+    {
+        if (elementName == "map")
+        {
+            ForthCoreState* pCore = reader->GetCoreState();
+            oTreeMapStruct<KEYOPS> *dstMap = (oTreeMapStruct<KEYOPS> *)(reader->getCustomReaderContext().pData);
+            reader->getRequiredChar('{');
+            std::string keyText;
+            ForthObject obj;
+            while (true)
+            {
+                char ch = reader->getChar();
+                if (ch == '}')
+                {
+                    break;
+                }
+                if (ch != ',')
+                {
+                    reader->ungetChar(ch);
+                }
+                reader->getString(keyText);
+                typename KEYOPS::KeyType key;
+                KEYOPS::ParseKey(keyText, key);
+                reader->getRequiredChar(':');
+                reader->getObjectOrLink(&obj);
+                setTreeMap(dstMap, key, obj, pCore);
+            }
+            return true;
+        }
+        return false;
+    }
+
+#define TREE_MAP_MEMBERS(KEYOPS, ITER_CLASS) \
+		METHOD("__newOp", oTreeMapNew<KEYOPS>), \
+		METHOD("delete", oTreeMapDeleteMethod<KEYOPS>), \
+		METHOD("showInner", oTreeMapShowInnerMethod<KEYOPS>), \
+		METHOD_RET("headIter", oTreeMapHeadIterMethod<KEYOPS>, RETURNS_OBJECT(ITER_CLASS)), \
+		METHOD_RET("tailIter", oTreeMapTailIterMethod<KEYOPS>, RETURNS_OBJECT(ITER_CLASS)), \
+		METHOD_RET("find", oTreeMapFindMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD_RET("count", oTreeMapCountMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD("clear", oTreeMapClearMethod<KEYOPS>), \
+        METHOD_RET("grab", oTreeMapGrabMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD("set", oTreeMapSetMethod<KEYOPS>), \
+        METHOD("load", oTreeMapLoadMethod<KEYOPS>), \
+        METHOD_RET("findValue", oTreeMapFindValueMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD("remove", oTreeMapRemoveMethod<KEYOPS>), \
+		METHOD("unref", oTreeMapUnrefMethod<KEYOPS>), \
+		METHOD_RET("lowerBound", oTreeMapLowerBoundMethod<KEYOPS>, RETURNS_OBJECT(ITER_CLASS)), \
+		METHOD_RET("upperBound", oTreeMapUpperBoundMethod<KEYOPS>, RETURNS_OBJECT(ITER_CLASS)), \
+		METHOD_RET("countRange", oTreeMapCountRangeMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD("removeRange", oTreeMapRemoveRangeMethod<KEYOPS>), \
+		METHOD("bulkLoad", oTreeMapBulkLoadMethod<KEYOPS>), \
+		MEMBER_VAR("__elements", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell))
+
+	baseMethodEntry oIntTreeMapMembers[] =
+	{
+        TREE_MAP_MEMBERS(IntKeyOps, kBCIIntTreeMapIter),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+	baseMethodEntry oLongTreeMapMembers[] =
+	{
+        TREE_MAP_MEMBERS(LongKeyOps, kBCILongTreeMapIter),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+	baseMethodEntry oDoubleTreeMapMembers[] =
+	{
+        TREE_MAP_MEMBERS(DoubleKeyOps, kBCIDoubleTreeMapIter),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+	baseMethodEntry oStringTreeMapMembers[] =
+	{
+        TREE_MAP_MEMBERS(StringKeyOps, kBCIStringTreeMapIter),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+
+	//////////////////////////////////////////////////////////////////////
+	///
+	//                 TreeMapIter family methods
+	//
+    // these have the same behavior as the LongMapIter methods, the cursor resyncs itself
+    //   by key if the map has been changed since the iterator was last used
+
+	FORTHOP(oTreeMapIterNew)
+	{
+		ForthEngine *pEngine = ForthEngine::GetInstance();
+		pEngine->SetError(kForthErrorIllegalOperation, " cannot explicitly create a tree map iterator object");
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapIterDeleteMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+		SAFE_RELEASE(pCore, pIter->parent);
+        delete pIter->cursor;
+		FREE_ITER(pIter);
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    inline typename TreeMapTypes<KEYOPS>::TreeType& getIterTree(oTreeMapIterStruct<KEYOPS>* pIter)
+    {
+        return *(reinterpret_cast<oTreeMapStruct<KEYOPS> *>(pIter->parent)->elements);
+    }
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapIterSeekNextMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        getIterTree(pIter).SeekNext(*(pIter->cursor));
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapIterSeekPrevMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        getIterTree(pIter).SeekPrev(*(pIter->cursor));
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapIterSeekHeadMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        getIterTree(pIter).SeekFirst(*(pIter->cursor));
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapIterSeekTailMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        getIterTree(pIter).SeekEnd(*(pIter->cursor));
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapIterAtHeadMethod)
+    {
+        GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        typename TreeMapTypes<KEYOPS>::TreeType& a = getIterTree(pIter);
+        // an empty map is at head and tail at the same time
+        long retVal = (a.AtFirst(*(pIter->cursor)) || (a.Count() == 0)) ? ~0 : 0;
+        SPUSH(retVal);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapIterAtTailMethod)
+    {
+        GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        long retVal = getIterTree(pIter).IsValid(*(pIter->cursor)) ? 0 : ~0;
+        SPUSH(retVal);
+        METHOD_RETURN;
+    }
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapIterNextMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        typename TreeMapTypes<KEYOPS>::TreeType& a = getIterTree(pIter);
+		if (!a.IsValid(*(pIter->cursor)))
+		{
+			SPUSH(0);
+		}
+		else
+		{
+			ForthObject o = a.CursorValue(*(pIter->cursor));
+			PUSH_OBJECT(o);
+            a.SeekNext(*(pIter->cursor));
+			SPUSH(~0);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapIterPrevMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        typename TreeMapTypes<KEYOPS>::TreeType& a = getIterTree(pIter);
+		if (!a.SeekPrev(*(pIter->cursor)))
+		{
+			SPUSH(0);
+		}
+		else
+		{
+			ForthObject o = a.CursorValue(*(pIter->cursor));
+			PUSH_OBJECT(o);
+			SPUSH(~0);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+	FORTHOP(oTreeMapIterCurrentMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        typename TreeMapTypes<KEYOPS>::TreeType& a = getIterTree(pIter);
+		if (!a.IsValid(*(pIter->cursor)))
+		{
+			SPUSH(0);
+		}
+		else
+		{
+			ForthObject o = a.CursorValue(*(pIter->cursor));
+			PUSH_OBJECT(o);
+			SPUSH(~0);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapIterRemoveMethod)
+	{
+		GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        typename TreeMapTypes<KEYOPS>::TreeType& a = getIterTree(pIter);
+		if (a.IsValid(*(pIter->cursor)))
+		{
+            // cursor will resync to the entry after the removed one
+            typename KEYOPS::KeyType key(a.CursorKey(*(pIter->cursor)));
+            ForthObject oldValue;
+            a.Remove(key, oldValue);
+			SAFE_RELEASE(pCore, oldValue);
+		}
+		METHOD_RETURN;
+	}
+
+    template <class KEYOPS>
+    FORTHOP(oTreeMapIterCurrentPairMethod)
+    {
+        GET_THIS(oTreeMapIterStruct<KEYOPS>, pIter);
+        typename TreeMapTypes<KEYOPS>::TreeType& a = getIterTree(pIter);
+        if (!a.IsValid(*(pIter->cursor)))
+        {
+            SPUSH(0);
+        }
+        else
+        {
+            ForthObject o = a.CursorValue(*(pIter->cursor));
+            PUSH_OBJECT(o);
+            KEYOPS::PushKey(pCore, a.CursorKey(*(pIter->cursor)));
+            SPUSH(~0);
+        }
+        METHOD_RETURN;
+    }
+
+#define TREE_MAP_ITER_MEMBERS(KEYOPS, PARENT_CLASS) \
+		METHOD("__newOp", oTreeMapIterNew), \
+		METHOD("delete", oTreeMapIterDeleteMethod<KEYOPS>), \
+		METHOD("seekNext", oTreeMapIterSeekNextMethod<KEYOPS>), \
+		METHOD("seekPrev", oTreeMapIterSeekPrevMethod<KEYOPS>), \
+		METHOD("seekHead", oTreeMapIterSeekHeadMethod<KEYOPS>), \
+		METHOD("seekTail", oTreeMapIterSeekTailMethod<KEYOPS>), \
+        METHOD_RET("atHead", oTreeMapIterAtHeadMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD_RET("atTail", oTreeMapIterAtTailMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD_RET("next", oTreeMapIterNextMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD_RET("prev", oTreeMapIterPrevMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		METHOD_RET("current", oTreeMapIterCurrentMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+        METHOD("remove", oTreeMapIterRemoveMethod<KEYOPS>), \
+        METHOD_RET("currentPair", oTreeMapIterCurrentPairMethod<KEYOPS>, RETURNS_NATIVE(kBaseTypeInt)), \
+		MEMBER_VAR("parent", OBJECT_TYPE_TO_CODE(0, PARENT_CLASS)), \
+		MEMBER_VAR("__cursor", NATIVE_TYPE_TO_CODE(kDTIsPtr, kBaseTypeUCell))
+
+    baseMethodEntry oIntTreeMapIterMembers[] =
+	{
+        TREE_MAP_ITER_MEMBERS(IntKeyOps, kBCIIntTreeMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+    baseMethodEntry oLongTreeMapIterMembers[] =
+	{
+        TREE_MAP_ITER_MEMBERS(LongKeyOps, kBCILongTreeMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+    baseMethodEntry oDoubleTreeMapIterMembers[] =
+	{
+        TREE_MAP_ITER_MEMBERS(DoubleKeyOps, kBCIDoubleTreeMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+    baseMethodEntry oStringTreeMapIterMembers[] =
+	{
+        TREE_MAP_ITER_MEMBERS(StringKeyOps, kBCIStringTreeMap),
+
+		// following must be last in table
+		END_MEMBERS
+	};
+
+
+	void AddClasses(ForthEngine* pEngine)
+	{
+		ForthClassVocabulary* pVocab = pEngine->AddBuiltinClass("IntTreeMap", kBCIIntTreeMap, kBCIIterable, oIntTreeMapMembers);
+        pVocab->SetCustomObjectReader(customTreeMapReader<IntKeyOps>);
+        pVocab->SetCustomChildVisitor(treeMapChildVisitor<IntKeyOps>);
+        pEngine->AddBuiltinClass("IntTreeMapIter", kBCIIntTreeMapIter, kBCIIter, oIntTreeMapIterMembers);
+
+		pVocab = pEngine->AddBuiltinClass("LongTreeMap", kBCILongTreeMap, kBCIIterable, oLongTreeMapMembers);
+        pVocab->SetCustomObjectReader(customTreeMapReader<LongKeyOps>);
+        pVocab->SetCustomChildVisitor(treeMapChildVisitor<LongKeyOps>);
+        pEngine->AddBuiltinClass("LongTreeMapIter", kBCILongTreeMapIter, kBCIIter, oLongTreeMapIterMembers);
+
+		pVocab = pEngine->AddBuiltinClass("DoubleTreeMap", kBCIDoubleTreeMap, kBCIIterable, oDoubleTreeMapMembers);
+        pVocab->SetCustomObjectReader(customTreeMapReader<DoubleKeyOps>);
+        pVocab->SetCustomChildVisitor(treeMapChildVisitor<DoubleKeyOps>);
+        pEngine->AddBuiltinClass("DoubleTreeMapIter", kBCIDoubleTreeMapIter, kBCIIter, oDoubleTreeMapIterMembers);
+
+		pVocab = pEngine->AddBuiltinClass("StringTreeMap", kBCIStringTreeMap, kBCIIterable, oStringTreeMapMembers);
+        pVocab->SetCustomObjectReader(customTreeMapReader<StringKeyOps>);
+        pVocab->SetCustomChildVisitor(treeMapChildVisitor<StringKeyOps>);
+        pEngine->AddBuiltinClass("StringTreeMapIter", kBCIStringTreeMapIter, kBCIIter, oStringTreeMapIterMembers);
+	}
+
+} // namespace OTreeMap
@@ -0,0 +1,836 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+//
+// OTreeMap.h: builtin B+tree ordered map related classes
+//
+//////////////////////////////////////////////////////////////////////
+
+#include <utility>
+#include <vector>
+
+class ForthClassVocabulary;
+
+// max entries in a leaf, and max children of a branch, both must be even
+#define BTREE_LEAF_CAPACITY         32
+#define BTREE_BRANCH_CAPACITY       32
+// leaves and branches with fewer than this many entries/children are refilled after a removal
+#define BTREE_LEAF_MIN              (BTREE_LEAF_CAPACITY / 2)
+#define BTREE_BRANCH_MIN            (BTREE_BRANCH_CAPACITY / 2)
+
+// ForthBTree is a B+tree map from KEY to ForthObject, entries are only stored in the leaves,
+//   which are doubly linked in key order so scans don't have to go back up the tree.
+// The keys in branch children[i] are all less than keys[i], and keys[i] is less than or
+//   equal to all the keys in children[i+1].
+// Compared to a std::map, an entry takes sizeof(KEY) + sizeof(ForthObject) bytes plus a
+//   share of its leaf overhead, and a scan reads consecutive array elements.
+// Inserting or removing an entry can move other entries between leaves, so any change to
+//   the set of keys bumps the tree version, cursors remember the key they were on and
+//   find their place again by key when the version has changed.
+// LOOKUP types used for Find/Insert/etc must be comparable with KEY using operator <.
+template <class KEY>
+class ForthBTree
+{
+public:
+    struct Node
+    {
+        int             count;
+        bool            isLeaf;
+    };
+
+    struct Leaf : public Node
+    {
+        KEY             keys[BTREE_LEAF_CAPACITY];
+        ForthObject     values[BTREE_LEAF_CAPACITY];
+        Leaf*           pPrev;
+        Leaf*           pNext;
+    };
+
+    // a branch holds count children and count-1 separator keys
+    struct Branch : public Node
+    {
+        KEY             keys[BTREE_BRANCH_CAPACITY - 1];
+        Node*           children[BTREE_BRANCH_CAPACITY];
+    };
+
+    // pLeaf is null when cursor is past the last entry
+    struct Cursor
+    {
+        Leaf*           pLeaf;
+        int             index;
+        ucell           version;
+        KEY             key;
+    };
+
+    ForthBTree()
+        : mpRoot(nullptr)
+        , mpFirstLeaf(nullptr)
+        , mpLastLeaf(nullptr)
+        , mCount(0)
+        , mVersion(0)
+    {
+    }
+
+    ~ForthBTree()
+    {
+        Clear();
+    }
+
+    inline ucell    Count() const { return mCount; }
+    inline Leaf*    FirstLeaf() const { return mpFirstLeaf; }
+
+    // returns pointer to value for key, or null if key isn't in tree
+    template <class LOOKUP>
+    ForthObject* Find(const LOOKUP& key) const
+    {
+        if (mpRoot == nullptr)
+        {
+            return nullptr;
+        }
+        Leaf* pLeaf = FindLeaf(key);
+        int ix = LeafLowerBound(pLeaf, key);
+        if (ix < pLeaf->count && !(key < pLeaf->keys[ix]))
+        {
+            return &(pLeaf->values[ix]);
+        }
+        return nullptr;
+    }
+
+    // returns pointer to value for key, adding an entry with a null value if key isn't already
+    //   in tree, the pointer is only good until the next Insert or Remove
+    template <class LOOKUP>
+    ForthObject* Insert(const LOOKUP& key, bool& isNew)
+    {
+        if (mpRoot == nullptr)
+        {
+            Leaf* pLeaf = NewLeaf();
+            mpRoot = pLeaf;
+            mpFirstLeaf = pLeaf;
+            mpLastLeaf = pLeaf;
+        }
+        KEY splitKey;
+        Node* pSplit = nullptr;
+        isNew = false;
+        ForthObject* pValue = InsertInto(mpRoot, key, isNew, splitKey, pSplit);
+        if (pSplit != nullptr)
+        {
+            Branch* pNewRoot = NewBranch();
+            pNewRoot->count = 2;
+            pNewRoot->children[0] = mpRoot;
+            pNewRoot->children[1] = pSplit;
+            std::swap(pNewRoot->keys[0], splitKey);
+            mpRoot = pNewRoot;
+        }
+        if (isNew)
+        {
+            mCount++;
+            mVersion++;
+        }
+        return pValue;
+    }
+
+    // remove entry for key, returns false if key isn't in tree
+    template <class LOOKUP>
+    bool Remove(const LOOKUP& key, ForthObject& removedValue)
+    {
+        if (mpRoot == nullptr || !RemoveFrom(mpRoot, key, removedValue))
+        {
+            return false;
+        }
+        mCount--;
+        mVersion++;
+        if (mpRoot->isLeaf)
+        {
+            if (mpRoot->count == 0)
+            {
+                delete static_cast<Leaf*>(mpRoot);
+                mpRoot = nullptr;
+                mpFirstLeaf = nullptr;
+                mpLastLeaf = nullptr;
+            }
+        }
+        else if (mpRoot->count == 1)
+        {
+            Branch* pOldRoot = static_cast<Branch*>(mpRoot);
+            mpRoot = pOldRoot->children[0];
+            delete pOldRoot;
+        }
+        return true;
+    }
+
+    // free all nodes, caller is responsible for releasing the values first
+    void Clear()
+    {
+        if (mpRoot != nullptr)
+        {
+            FreeNode(mpRoot);
+        }
+        mpRoot = nullptr;
+        mpFirstLeaf = nullptr;
+        mpLastLeaf = nullptr;
+        mCount = 0;
+        mVersion++;
+    }
+
+    // replace contents of tree with entries, which must have strictly increasing keys,
+    //   the entries are spread evenly over the fewest leaves which can hold them
+    void BulkLoad(std::vector<std::pair<KEY, ForthObject>>& entries)
+    {
+        Clear();
+        size_t numEntries = entries.size();
+        if (numEntries == 0)
+        {
+            return;
+        }
+        // build the leaves, spreading the entries evenly over the fewest possible leaves
+        std::vector<Node*> level;
+        std::vector<KEY> levelMinKeys;
+        size_t numLeaves = (numEntries + BTREE_LEAF_CAPACITY - 1) / BTREE_LEAF_CAPACITY;
+        size_t entryIx = 0;
+        Leaf* pPrevLeaf = nullptr;
+        for (size_t leafIx = 0; leafIx < numLeaves; leafIx++)
+        {
+            Leaf* pLeaf = NewLeaf();
+            size_t leafCount = (numEntries / numLeaves) + ((leafIx < (numEntries % numLeaves)) ? 1 : 0);
+            for (size_t i = 0; i < leafCount; i++)
+            {
+                std::swap(pLeaf->keys[i], entries[entryIx].first);
+                pLeaf->values[i] = entries[entryIx].second;
+                entryIx++;
+            }
+            pLeaf->count = (int)leafCount;
+            pLeaf->pPrev = pPrevLeaf;
+            if (pPrevLeaf != nullptr)
+            {
+                pPrevLeaf->pNext = pLeaf;
+            }
+            else
+            {
+                mpFirstLeaf = pLeaf;
+            }
+            pPrevLeaf = pLeaf;
+            level.push_back(pLeaf);
+            levelMinKeys.push_back(pLeaf->keys[0]);
+        }
+        mpLastLeaf = pPrevLeaf;
+
+        // build branch levels until there is a single node
+        while (level.size() > 1)
+        {
+            std::vector<Node*> parents;
+            std::vector<KEY> parentMinKeys;
+            size_t numNodes = level.size();
+            size_t numParents = (numNodes + BTREE_BRANCH_CAPACITY - 1) / BTREE_BRANCH_CAPACITY;
+            size_t nodeIx = 0;
+            for (size_t parentIx = 0; parentIx < numParents; parentIx++)
+            {
+                Branch* pBranch = NewBranch();
+                size_t branchCount = (numNodes / numParents) + ((parentIx < (numNodes % numParents)) ? 1 : 0);
+                parentMinKeys.push_back(levelMinKeys[nodeIx]);
+                for (size_t i = 0; i < branchCount; i++)
+                {
+                    pBranch->children[i] = level[nodeIx];
+                    if (i > 0)
+                    {
+                        pBranch->keys[i - 1] = levelMinKeys[nodeIx];
+                    }
+                    nodeIx++;
+                }
+                pBranch->count = (int)branchCount;
+                parents.push_back(pBranch);
+            }
+            level.swap(parents);
+            levelMinKeys.swap(parentMinKeys);
+        }
+        mpRoot = level[0];
+        mCount = numEntries;
+        mVersion++;
+    }
+
+    // count entries with keys in [lo, hi)
+    template <class LOOKUP>
+    ucell CountRange(const LOOKUP& lo, const LOOKUP& hi) const
+    {
+        if (mpRoot == nullptr)
+        {
+            return 0;
+        }
+        Leaf* pLoLeaf = FindLeaf(lo);
+        int loIx = LeafLowerBound(pLoLeaf, lo);
+        if (loIx == pLoLeaf->count)
+        {
+            pLoLeaf = pLoLeaf->pNext;
+            loIx = 0;
+        }
+        // this also takes care of hi <= lo, without comparing lo and hi directly
+        if (pLoLeaf == nullptr || !(pLoLeaf->keys[loIx] < hi))
+        {
+            return 0;
+        }
+        Leaf* pHiLeaf = FindLeaf(hi);
+        int hiIx = LeafLowerBound(pHiLeaf, hi);
+        if (pLoLeaf == pHiLeaf)
+        {
+            return hiIx - loIx;
+        }
+        ucell count = pLoLeaf->count - loIx;
+        for (Leaf* pLeaf = pLoLeaf->pNext; pLeaf != pHiLeaf; pLeaf = pLeaf->pNext)
+        {
+            count += pLeaf->count;
+        }
+        return count + hiIx;
+    }
+
+    //
+    // cursor ops, all of these first resync the cursor if tree has changed since cursor was set
+    //
+
+    void SeekFirst(Cursor& cursor) const
+    {
+        SetCursor(cursor, mpFirstLeaf, 0);
+    }
+
+    void SeekEnd(Cursor& cursor) const
+    {
+        SetCursor(cursor, nullptr, 0);
+    }
+
+    // position cursor at first entry with key >= given key
+    template <class LOOKUP>
+    void SeekLowerBound(Cursor& cursor, const LOOKUP& key) const
+    {
+        if (mpRoot == nullptr)
+        {
+            SeekEnd(cursor);
+        }
+        else
+        {
+            Leaf* pLeaf = FindLeaf(key);
+            SetCursor(cursor, pLeaf, LeafLowerBound(pLeaf, key));
+        }
+    }
+
+    // position cursor at first entry with key > given key
+    template <class LOOKUP>
+    void SeekUpperBound(Cursor& cursor, const LOOKUP& key) const
+    {
+        if (mpRoot == nullptr)
+        {
+            SeekEnd(cursor);
+        }
+        else
+        {
+            Leaf* pLeaf = FindLeaf(key);
+            SetCursor(cursor, pLeaf, LeafUpperBound(pLeaf, key));
+        }
+    }
+
+    // returns false if cursor is past last entry
+    bool IsValid(Cursor& cursor) const
+    {
+        Sync(cursor);
+        return cursor.pLeaf != nullptr;
+    }
+
+    bool AtFirst(Cursor& cursor) const
+    {
+        Sync(cursor);
+        return (cursor.pLeaf == mpFirstLeaf) && (cursor.index == 0);
+    }
+
+    // move to next entry, returns false if cursor was already past last entry
+    bool SeekNext(Cursor& cursor) const
+    {
+        Sync(cursor);
+        if (cursor.pLeaf == nullptr)
+        {
+            return false;
+        }
+        SetCursor(cursor, cursor.pLeaf, cursor.index + 1);
+        return true;
+    }
+
+    // move to previous entry, returns false if cursor was already at first entry
+    bool SeekPrev(Cursor& cursor) const
+    {
+        Sync(cursor);
+        if (cursor.pLeaf == nullptr)
+        {
+            if (mpLastLeaf == nullptr)
+            {
+                return false;
+            }
+            SetCursor(cursor, mpLastLeaf, mpLastLeaf->count - 1);
+        }
+        else if (cursor.index > 0)
+        {
+            SetCursor(cursor, cursor.pLeaf, cursor.index - 1);
+        }
+        else if (cursor.pLeaf->pPrev != nullptr)
+        {
+            Leaf* pLeaf = cursor.pLeaf->pPrev;
+            SetCursor(cursor, pLeaf, pLeaf->count - 1);
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    // key and value of entry cursor is on, only valid after IsValid has returned true
+    inline const KEY&   CursorKey(const Cursor& cursor) const { return cursor.pLeaf->keys[cursor.index]; }
+    inline ForthObject& CursorValue(const Cursor& cursor) const { return cursor.pLeaf->values[cursor.index]; }
+
+private:
+    Leaf* NewLeaf()
+    {
+        Leaf* pLeaf = new Leaf;
+        pLeaf->count = 0;
+        pLeaf->isLeaf = true;
+        pLeaf->pPrev = nullptr;
+        pLeaf->pNext = nullptr;
+        return pLeaf;
+    }
+
+    Branch* NewBranch()
+    {
+        Branch* pBranch = new Branch;
+        pBranch->count = 0;
+        pBranch->isLeaf = false;
+        return pBranch;
+    }
+
+    void FreeNode(Node* pNode)
+    {
+        if (pNode->isLeaf)
+        {
+            delete static_cast<Leaf*>(pNode);
+        }
+        else
+        {
+            Branch* pBranch = static_cast<Branch*>(pNode);
+            for (int i = 0; i < pBranch->count; i++)
+            {
+                FreeNode(pBranch->children[i]);
+            }
+            delete pBranch;
+        }
+    }
+
+    // index of first key in leaf >= key
+    template <class LOOKUP>
+    static int LeafLowerBound(const Leaf* pLeaf, const LOOKUP& key)
+    {
+        int lo = 0;
+        int hi = pLeaf->count;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) >> 1;
+            if (pLeaf->keys[mid] < key)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // index of first key in leaf > key
+    template <class LOOKUP>
+    static int LeafUpperBound(const Leaf* pLeaf, const LOOKUP& key)
+    {
+        int lo = 0;
+        int hi = pLeaf->count;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) >> 1;
+            if (key < pLeaf->keys[mid])
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+    // index of child of branch which could hold key
+    template <class LOOKUP>
+    static int ChildIndex(const Branch* pBranch, const LOOKUP& key)
+    {
+        int lo = 0;
+        int hi = pBranch->count - 1;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) >> 1;
+            if (key < pBranch->keys[mid])
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+    template <class LOOKUP>
+    Leaf* FindLeaf(const LOOKUP& key) const
+    {
+        Node* pNode = mpRoot;
+        while (!pNode->isLeaf)
+        {
+            Branch* pBranch = static_cast<Branch*>(pNode);
+            pNode = pBranch->children[ChildIndex(pBranch, key)];
+        }
+        return static_cast<Leaf*>(pNode);
+    }
+
+    // set cursor to entry index in leaf, moving to start of next leaf if index is past end of leaf
+    void SetCursor(Cursor& cursor, Leaf* pLeaf, int index) const
+    {
+        if (pLeaf != nullptr && index >= pLeaf->count)
+        {
+            pLeaf = pLeaf->pNext;
+            index = 0;
+        }
+        cursor.pLeaf = pLeaf;
+        cursor.index = index;
+        cursor.version = mVersion;
+        if (pLeaf != nullptr)
+        {
+            cursor.key = pLeaf->keys[index];
+        }
+    }
+
+    void Sync(Cursor& cursor) const
+    {
+        if (cursor.version != mVersion)
+        {
+            if (cursor.pLeaf == nullptr)
+            {
+                cursor.version = mVersion;
+            }
+            else
+            {
+                KEY key(cursor.key);
+                SeekLowerBound(cursor, key);
+            }
+        }
+    }
+
+    template <class LOOKUP>
+    ForthObject* InsertInto(Node* pNode, const LOOKUP& key, bool& isNew, KEY& splitKey, Node*& pSplit)
+    {
+        if (pNode->isLeaf)
+        {
+            Leaf* pLeaf = static_cast<Leaf*>(pNode);
+            int ix = LeafLowerBound(pLeaf, key);
+            if (ix < pLeaf->count && !(key < pLeaf->keys[ix]))
+            {
+                return &(pLeaf->values[ix]);
+            }
+            isNew = true;
+            if (pLeaf->count < BTREE_LEAF_CAPACITY)
+            {
+                return LeafInsertAt(pLeaf, ix, key);
+            }
+
+            // split leaf, when appending to the last leaf keep it full so that adding keys
+            //   in increasing order packs the leaves
+            Leaf* pRight = NewLeaf();
+            int splitIx = (ix == pLeaf->count && pLeaf->pNext == nullptr) ? pLeaf->count : (BTREE_LEAF_CAPACITY / 2);
+            for (int i = splitIx; i < pLeaf->count; i++)
+            {
+                std::swap(pRight->keys[i - splitIx], pLeaf->keys[i]);
+                pRight->values[i - splitIx] = pLeaf->values[i];
+            }
+            pRight->count = pLeaf->count - splitIx;
+            pLeaf->count = splitIx;
+            pRight->pPrev = pLeaf;
+            pRight->pNext = pLeaf->pNext;
+            if (pLeaf->pNext != nullptr)
+            {
+                pLeaf->pNext->pPrev = pRight;
+            }
+            else
+            {
+                mpLastLeaf = pRight;
+            }
+            pLeaf->pNext = pRight;
+            ForthObject* pValue = (ix < splitIx) ? LeafInsertAt(pLeaf, ix, key) : LeafInsertAt(pRight, ix - splitIx, key);
+            splitKey = pRight->keys[0];
+            pSplit = pRight;
+            return pValue;
+        }
+
+        Branch* pBranch = static_cast<Branch*>(pNode);
+        int childIx = ChildIndex(pBranch, key);
+        KEY childSplitKey;
+        Node* pChildSplit = nullptr;
+        ForthObject* pValue = InsertInto(pBranch->children[childIx], key, isNew, childSplitKey, pChildSplit);
+        if (pChildSplit == nullptr)
+        {
+            return pValue;
+        }
+        if (pBranch->count < BTREE_BRANCH_CAPACITY)
+        {
+            BranchInsertAt(pBranch, childIx, childSplitKey, pChildSplit);
+            return pValue;
+        }
+
+        // split branch, the left half keeps the lower children, the separator between the
+        //   halves moves up to the parent
+        Branch* pRight = NewBranch();
+        int leftCount = BTREE_BRANCH_CAPACITY / 2;
+        int numMoved = pBranch->count - leftCount;
+        for (int i = 0; i < numMoved; i++)
+        {
+            pRight->children[i] = pBranch->children[leftCount + i];
+            if (i > 0)
+            {
+                std::swap(pRight->keys[i - 1], pBranch->keys[leftCount + i - 1]);
+            }
+        }
+        pRight->count = numMoved;
+        std::swap(splitKey, pBranch->keys[leftCount - 1]);
+        pBranch->count = leftCount;
+        if (childIx < leftCount)
+        {
+            BranchInsertAt(pBranch, childIx, childSplitKey, pChildSplit);
+        }
+        else
+        {
+            BranchInsertAt(pRight, childIx - leftCount, childSplitKey, pChildSplit);
+        }
+        pSplit = pRight;
+        return pValue;
+    }
+
+    template <class LOOKUP>
+    ForthObject* LeafInsertAt(Leaf* pLeaf, int ix, const LOOKUP& key)
+    {
+        for (int i = pLeaf->count; i > ix; i--)
+        {
+            std::swap(pLeaf->keys[i], pLeaf->keys[i - 1]);
+            pLeaf->values[i] = pLeaf->values[i - 1];
+        }
+        pLeaf->keys[ix] = key;
+        pLeaf->values[ix] = nullptr;
+        pLeaf->count++;
+        return &(pLeaf->values[ix]);
+    }
+
+    // add child pNew and its separator key just after children[childIx]
+    void BranchInsertAt(Branch* pBranch, int childIx, KEY& key, Node* pNew)
+    {
+        for (int i = pBranch->count; i > childIx + 1; i--)
+        {
+            pBranch->children[i] = pBranch->children[i - 1];
+            std::swap(pBranch->keys[i - 1], pBranch->keys[i - 2]);
+        }
+        pBranch->children[childIx + 1] = pNew;
+        std::swap(pBranch->keys[childIx], key);
+        pBranch->count++;
+    }
+
+    template <class LOOKUP>
+    bool RemoveFrom(Node* pNode, const LOOKUP& key, ForthObject& removedValue)
+    {
+        if (pNode->isLeaf)
+        {
+            Leaf* pLeaf = static_cast<Leaf*>(pNode);
+            int ix = LeafLowerBound(pLeaf, key);
+            if (ix == pLeaf->count || key < pLeaf->keys[ix])
+            {
+                return false;
+            }
+            removedValue = pLeaf->values[ix];
+            for (int i = ix + 1; i < pLeaf->count; i++)
+            {
+                std::swap(pLeaf->keys[i - 1], pLeaf->keys[i]);
+                pLeaf->values[i - 1] = pLeaf->values[i];
+            }
+            pLeaf->count--;
+            pLeaf->keys[pLeaf->count] = KEY();
+            return true;
+        }
+
+        Branch* pBranch = static_cast<Branch*>(pNode);
+        int childIx = ChildIndex(pBranch, key);
+        Node* pChild = pBranch->children[childIx];
+        if (!RemoveFrom(pChild, key, removedValue))
+        {
+            return false;
+        }
+        if (pChild->count < (pChild->isLeaf ? BTREE_LEAF_MIN : BTREE_BRANCH_MIN))
+        {
+            Refill(pBranch, childIx);
+        }
+        return true;
+    }
+
+    // child childIx of branch is underfull, borrow an entry from a sibling which has enough
+    //   to spare, or else merge it with a sibling
+    void Refill(Branch* pBranch, int childIx)
+    {
+        Node* pChild = pBranch->children[childIx];
+        Node* pLeft = (childIx > 0) ? pBranch->children[childIx - 1] : nullptr;
+        Node* pRight = (childIx + 1 < pBranch->count) ? pBranch->children[childIx + 1] : nullptr;
+        if (pChild->isLeaf)
+        {
+            Leaf* pLeaf = static_cast<Leaf*>(pChild);
+            if (pLeft != nullptr && pLeft->count > BTREE_LEAF_MIN)
+            {
+                Leaf* pLeftLeaf = static_cast<Leaf*>(pLeft);
+                LeafInsertAt(pLeaf, 0, pLeftLeaf->keys[pLeftLeaf->count - 1])[0] = pLeftLeaf->values[pLeftLeaf->count - 1];
+                pLeftLeaf->count--;
+                pLeftLeaf->keys[pLeftLeaf->count] = KEY();
+                pBranch->keys[childIx - 1] = pLeaf->keys[0];
+            }
+            else if (pRight != nullptr && pRight->count > BTREE_LEAF_MIN)
+            {
+                Leaf* pRightLeaf = static_cast<Leaf*>(pRight);
+                std::swap(pLeaf->keys[pLeaf->count], pRightLeaf->keys[0]);
+                pLeaf->values[pLeaf->count] = pRightLeaf->values[0];
+                pLeaf->count++;
+                for (int i = 1; i < pRightLeaf->count; i++)
+                {
+                    std::swap(pRightLeaf->keys[i - 1], pRightLeaf->keys[i]);
+                    pRightLeaf->values[i - 1] = pRightLeaf->values[i];
+                }
+                pRightLeaf->count--;
+                pBranch->keys[childIx] = pRightLeaf->keys[0];
+            }
+            else if (pLeft != nullptr)
+            {
+                MergeLeaves(pBranch, childIx - 1);
+            }
+            else if (pRight != nullptr)
+            {
+                MergeLeaves(pBranch, childIx);
+            }
+        }
+        else
+        {
+            Branch* pChildBranch = static_cast<Branch*>(pChild);
+            if (pLeft != nullptr && pLeft->count > BTREE_BRANCH_MIN)
+            {
+                // rotate last child of left sibling through the parent separator
+                Branch* pLeftBranch = static_cast<Branch*>(pLeft);
+                for (int i = pChildBranch->count; i > 0; i--)
+                {
+                    pChildBranch->children[i] = pChildBranch->children[i - 1];
+                    if (i > 1)
+                    {
+                        std::swap(pChildBranch->keys[i - 1], pChildBranch->keys[i - 2]);
+                    }
+                }
+                pChildBranch->children[0] = pLeftBranch->children[pLeftBranch->count - 1];
+                std::swap(pChildBranch->keys[0], pBranch->keys[childIx - 1]);
+                std::swap(pBranch->keys[childIx - 1], pLeftBranch->keys[pLeftBranch->count - 2]);
+                pChildBranch->count++;
+                pLeftBranch->count--;
+            }
+            else if (pRight != nullptr && pRight->count > BTREE_BRANCH_MIN)
+            {
+                // rotate first child of right sibling through the parent separator
+                Branch* pRightBranch = static_cast<Branch*>(pRight);
+                pChildBranch->children[pChildBranch->count] = pRightBranch->children[0];
+                std::swap(pChildBranch->keys[pChildBranch->count - 1], pBranch->keys[childIx]);
+                std::swap(pBranch->keys[childIx], pRightBranch->keys[0]);
+                pChildBranch->count++;
+                for (int i = 1; i < pRightBranch->count; i++)
+                {
+                    pRightBranch->children[i - 1] = pRightBranch->children[i];
+                    if (i > 1)
+                    {
+                        std::swap(pRightBranch->keys[i - 2], pRightBranch->keys[i - 1]);
+                    }
+                }
+                pRightBranch->count--;
+            }
+            else if (pLeft != nullptr)
+            {
+                MergeBranches(pBranch, childIx - 1);
+            }
+            else if (pRight != nullptr)
+            {
+                MergeBranches(pBranch, childIx);
+            }
+        }
+    }
+
+    // remove separator key leftIx and child leftIx+1 from branch, after child has been merged
+    void BranchRemoveRight(Branch* pBranch, int leftIx)
+    {
+        for (int i = leftIx + 1; i < pBranch->count - 1; i++)
+        {
+            pBranch->children[i] = pBranch->children[i + 1];
+            std::swap(pBranch->keys[i - 1], pBranch->keys[i]);
+        }
+        pBranch->count--;
+        pBranch->keys[pBranch->count - 1] = KEY();
+    }
+
+    // merge children leftIx+1 into child leftIx, both are leaves
+    void MergeLeaves(Branch* pBranch, int leftIx)
+    {
+        Leaf* pLeft = static_cast<Leaf*>(pBranch->children[leftIx]);
+        Leaf* pRight = static_cast<Leaf*>(pBranch->children[leftIx + 1]);
+        for (int i = 0; i < pRight->count; i++)
+        {
+            std::swap(pLeft->keys[pLeft->count + i], pRight->keys[i]);
+            pLeft->values[pLeft->count + i] = pRight->values[i];
+        }
+        pLeft->count += pRight->count;
+        pLeft->pNext = pRight->pNext;
+        if (pRight->pNext != nullptr)
+        {
+            pRight->pNext->pPrev = pLeft;
+        }
+        else
+        {
+            mpLastLeaf = pLeft;
+        }
+        delete pRight;
+        BranchRemoveRight(pBranch, leftIx);
+    }
+
+    // merge children leftIx+1 into child leftIx, both are branches
+    void MergeBranches(Branch* pBranch, int leftIx)
+    {
+        Branch* pLeft = static_cast<Branch*>(pBranch->children[leftIx]);
+        Branch* pRight = static_cast<Branch*>(pBranch->children[leftIx + 1]);
+        std::swap(pLeft->keys[pLeft->count - 1], pBranch->keys[leftIx]);
+        for (int i = 0; i < pRight->count; i++)
+        {
+            pLeft->children[pLeft->count + i] = pRight->children[i];
+            if (i > 0)
+            {
+                std::swap(pLeft->keys[pLeft->count + i - 1], pRight->keys[i - 1]);
+            }
+        }
+        pLeft->count += pRight->count;
+        delete pRight;
+        BranchRemoveRight(pBranch, leftIx);
+    }
+
+    Node*       mpRoot;
+    Leaf*       mpFirstLeaf;
+    Leaf*       mpLastLeaf;
+    ucell       mCount;
+    // bumped whenever a key is added or removed
+    ucell       mVersion;
+};
+
+namespace OTreeMap
+{
+	void AddClasses(ForthEngine* pEngine);
+}